@@ -75,6 +75,13 @@ int uart_init_done(void)
 void uart_tx_start(void)
 {
 	stopped = 0;
+
+	/* Emulated interrupts don't nest, so send output from an ISR now */
+	if (in_interrupt_context()) {
+		uart_process_output();
+		return;
+	}
+
 	task_trigger_test_interrupt(uart_interrupt);
 }
 
@@ -7,12 +7,14 @@
 
 #include "clock.h"
 #include "console.h"
-#ifdef CONFIG_EXPERIMENTAL_CONSOLE
+#if defined(CONFIG_EXPERIMENTAL_CONSOLE) || defined(CONFIG_CONSOLE_BATCH)
 #include "crc8.h"
-#endif /* defined(CONFIG_EXPERIMENTAL_CONSOLE) */
+#endif
 #include "link_defs.h"
+#include "printf.h"
 #include "system.h"
 #include "task.h"
+#include "timer.h"
 #include "uart.h"
 #include "usb_console.h"
 #include "util.h"
@@ -26,6 +28,52 @@
 #define EC_ACK 0xC0
 #endif /* defined(CONFIG_EXPERIMENTAL_CONSOLE) */
 
+#ifdef CONFIG_CONSOLE_BATCH
+/*
+ * Batch mode lets a script send several commands at once, and get their
+ * output back in frames it can tell apart from other console output.
+ *
+ * EC_BATCH_SYN asks whether batches are supported; the reply is EC_BATCH_ACK
+ * and the largest batch in 4 hex digits.  A batch is EC_BATCH, then
+ * "LLLLCC&": the length of the commands and their CRC-8 in hex, then the
+ * commands, separated by newlines.  If the batch is corrupted, or the rest
+ * of it doesn't come within BATCH_TIMEOUT_US, the reply is "&&EE".
+ * Otherwise each command is run in turn and replies with:
+ *
+ *   &&OIILLCC&<data>	LL bytes of output from command II, with their CRC-8
+ *   &&RIIRRRR&		command II finished, returning RRRR
+ *
+ * and once all the commands have run, "&&ZNN&" with the number run.  All
+ * numbers are hex.  Batches and their replies only go over the UART.
+ */
+#define EC_BATCH_SYN 0xEA
+#define EC_BATCH_ACK 0xCA
+#define EC_BATCH 0xEB
+
+/* "LLLLCC&" */
+#define BATCH_HEADER_SIZE 7
+/* Give up on a batch if its characters stop coming for this long */
+#define BATCH_TIMEOUT_US (100 * MSEC)
+/* Most command output sent in one frame */
+#define BATCH_OUTPUT_SIZE 64
+
+BUILD_ASSERT(CONFIG_CONSOLE_BATCH <= 0xffff);
+
+static char batch_header[BATCH_HEADER_SIZE + 1];
+static char batch_buf[CONFIG_CONSOLE_BATCH + 1];
+/* Characters of the batch received, with the header; -1 if not in a batch */
+static int batch_pos = -1;
+static int batch_len;
+static uint8_t batch_crc;
+static uint64_t batch_last_char;
+
+/* Command being run from a batch; -1 if none */
+static int batch_index = -1;
+/* Its output, waiting to be sent */
+static char batch_out[BATCH_OUTPUT_SIZE];
+static int batch_out_len;
+#endif /* CONFIG_CONSOLE_BATCH */
+
 /* ASCII control character; for example, CTRL('C') = ^C */
 #define CTRL(c) ((c) - '@')
 
@@ -115,6 +163,65 @@ static int split_words(char *input, int *argc, char **argv)
 	return EC_SUCCESS;
 }
 
+/*
+ * The linker sorts the command table by section name, which is the command
+ * name (see DECLARE_CONSOLE_COMMAND()).  Names are lower case, so the table
+ * is also in case-folded order, and the commands starting with any prefix are
+ * next to each other.
+ */
+
+/**
+ * Find the first command whose name is not before a prefix.
+ *
+ * @param prefix	Start of a command name.
+ * @param len		Length of prefix.
+ * @param after		If non-zero, skip the commands which start with prefix.
+ *
+ * @return A pointer into the command table; __cmds_end if there is none.
+ */
+static const struct console_command *lower_bound(const char *prefix, int len,
+						int after)
+{
+	const struct console_command *lo = __cmds, *hi = __cmds_end, *mid;
+	int diff;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		diff = strncasecmp(mid->name, prefix, len);
+		if (diff < 0 || (after && !diff))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+int console_command_complete(const char *prefix, int len,
+			     const struct console_command **first, int *count)
+{
+	const struct console_command *begin, *last;
+	int n;
+
+	begin = lower_bound(prefix, len, 0);
+	n = lower_bound(prefix, len, 1) - begin;
+
+	if (first)
+		*first = begin;
+	if (count)
+		*count = n;
+	if (!n)
+		return 0;
+
+	/* The first and last matches differ soonest */
+	last = begin + n - 1;
+	while (begin->name[len] &&
+	       tolower(begin->name[len]) == tolower(last->name[len]))
+		len++;
+
+	return len;
+}
+
 /**
  * Find a command by name.
  *
@@ -128,24 +235,40 @@ static int split_words(char *input, int *argc, char **argv)
  */
 static const struct console_command *find_command(char *name)
 {
-	const struct console_command *cmd, *match = NULL;
+	const struct console_command *cmd;
 	int match_length = strlen(name);
+	int count;
+
+	console_command_complete(name, match_length, &cmd, &count);
 
-	for (cmd = __cmds; cmd < __cmds_end; cmd++) {
-		if (!strncasecmp(name, cmd->name, match_length)) {
-			if (match)
-				return NULL;
-			/*
-			 * Check if 'cmd->name' is of the same length as
-			 * 'name'. If yes, then we have a full match.
-			 */
-			if (cmd->name[match_length] == '\0')
-				return cmd;
-			match = cmd;
+	/*
+	 * A full match sorts before the longer names it is the start of, so
+	 * it wins even if the name is ambiguous.
+	 */
+	if (count == 1 || (count && cmd->name[match_length] == '\0'))
+		return cmd;
+
+	return NULL;
+}
+
+/**
+ * Print the names of a run of commands, five to a row.
+ *
+ * @param cmd		First command to print.
+ * @param count		Number of commands.
+ */
+static void __maybe_unused print_commands(const struct console_command *cmd,
+					  int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		ccprintf(" %-14s", cmd[i].name);
+		if (i % 5 == 4 || i == count - 1) {
+			ccputs("\n");
+			cflush();
 		}
 	}
-
-	return match;
 }
 
 
@@ -162,6 +285,55 @@ static const char *const errmsgs[] = {
 	"Not Calibrated",
 };
 
+/**
+ * Run a command.
+ *
+ * @param argc		Number of words in the command.
+ * @param argv		Words of the command.
+ *
+ * @return EC_SUCCESS, or non-zero if error.
+ */
+static int run_command(int argc, char **argv)
+{
+	const struct console_command *cmd;
+	int rv;
+
+	/* If no command, nothing to do */
+	if (!argc)
+		return EC_SUCCESS;
+
+	cmd = find_command(argv[0]);
+	if (!cmd) {
+		ccprintf("Command '%s' not found or ambiguous.\n", argv[0]);
+		return EC_ERROR_UNKNOWN;
+	}
+
+#ifdef CONFIG_RESTRICTED_CONSOLE_COMMANDS
+	if (console_is_restricted() && cmd->flags & CMD_FLAG_RESTRICTED)
+		rv = EC_ERROR_ACCESS_DENIED;
+	else
+#endif
+	rv = cmd->handler(argc, argv);
+	if (rv == EC_SUCCESS)
+		return rv;
+
+	/* Print more info for errors */
+	if (rv < ARRAY_SIZE(errmsgs))
+		ccprintf("%s\n", errmsgs[rv]);
+	else if (rv >= EC_ERROR_PARAM1 && rv < EC_ERROR_PARAM_COUNT)
+		ccprintf("Parameter %d invalid\n", rv - EC_ERROR_PARAM1 + 1);
+	else if (rv == EC_ERROR_PARAM_COUNT)
+		ccputs("Wrong number of params\n");
+	else if (rv != EC_SUCCESS)
+		ccprintf("Command returned error %d\n", rv);
+
+#ifdef CONFIG_CONSOLE_CMDHELP
+	if (cmd->argdesc)
+		ccprintf("Usage: %s %s\n", cmd->name, cmd->argdesc);
+#endif
+	return rv;
+}
+
 /**
  * Handle a line of input containing a single command.
  *
@@ -171,10 +343,8 @@ static const char *const errmsgs[] = {
  */
 static int handle_command(char *input)
 {
-	const struct console_command *cmd;
 	char *argv[MAX_ARGS_PER_COMMAND];
 	int argc = 0;
-	int rv;
 #ifdef CONFIG_EXPERIMENTAL_CONSOLE
 	char *e = NULL;
 	int i = 0;
@@ -230,42 +400,174 @@ command_has_error:
 	split_words(input, &argc, argv);
 #endif /* defined(CONFIG_EXPERIMENTAL_CONSOLE) */
 
-	/* If no command, nothing to do */
-	if (!argc)
-		return EC_SUCCESS;
+	return run_command(argc, argv);
+}
 
-	cmd = find_command(argv[0]);
-	if (!cmd) {
-		ccprintf("Command '%s' not found or ambiguous.\n", argv[0]);
-		return EC_ERROR_UNKNOWN;
+#ifdef CONFIG_CONSOLE_BATCH
+int console_batch_capturing(void)
+{
+	return batch_index >= 0 && !in_interrupt_context() &&
+	       task_get_current() == TASK_ID_CONSOLE;
+}
+
+/* Send the output collected from the command being run */
+static void batch_send_output(void)
+{
+	if (!batch_out_len)
+		return;
+
+	uart_line_begin();
+	uart_printf("&&O%02x%02x%02x&", batch_index & 0xff, batch_out_len,
+		    cros_crc8((const uint8_t *)batch_out, batch_out_len));
+	uart_put_raw(batch_out, batch_out_len);
+	uart_line_end();
+
+	batch_out_len = 0;
+}
+
+static int batch_add_span(void *context, const char *s, int len)
+{
+	int n;
+
+	while (len > 0) {
+		n = MIN(len, BATCH_OUTPUT_SIZE - batch_out_len);
+		memcpy(batch_out + batch_out_len, s, n);
+		batch_out_len += n;
+		s += n;
+		len -= n;
+		if (batch_out_len == BATCH_OUTPUT_SIZE)
+			batch_send_output();
 	}
+	return 0;
+}
 
-#ifdef CONFIG_RESTRICTED_CONSOLE_COMMANDS
-	if (console_is_restricted() && cmd->flags & CMD_FLAG_RESTRICTED)
-		rv = EC_ERROR_ACCESS_DENIED;
-	else
-#endif
-	rv = cmd->handler(argc, argv);
-	if (rv == EC_SUCCESS)
-		return rv;
+static int batch_add_char(void *context, int c)
+{
+	char ch = c;
 
-	/* Print more info for errors */
-	if (rv < ARRAY_SIZE(errmsgs))
-		ccprintf("%s\n", errmsgs[rv]);
-	else if (rv >= EC_ERROR_PARAM1 && rv < EC_ERROR_PARAM_COUNT)
-		ccprintf("Parameter %d invalid\n", rv - EC_ERROR_PARAM1 + 1);
-	else if (rv == EC_ERROR_PARAM_COUNT)
-		ccputs("Wrong number of params\n");
-	else if (rv != EC_SUCCESS)
-		ccprintf("Command returned error %d\n", rv);
+	return batch_add_span(context, &ch, 1);
+}
 
-#ifdef CONFIG_CONSOLE_CMDHELP
-	if (cmd->argdesc)
-		ccprintf("Usage: %s %s\n", cmd->name, cmd->argdesc);
-#endif
-	return rv;
+static const struct printf_sink batch_sink = {
+	.addchar = batch_add_char,
+	.addspan = batch_add_span,
+};
+
+int console_batch_puts(const char *outstr)
+{
+	return batch_add_span(NULL, outstr, strlen(outstr));
+}
+
+int console_batch_vprintf(const char *format, va_list args)
+{
+	return vfnprintf_sink(&batch_sink, NULL, format, args);
+}
+
+/* Run the commands in a batch which has been received */
+static void run_batch(void)
+{
+	char *argv[MAX_ARGS_PER_COMMAND];
+	char *line, *end;
+	int argc, rv;
+	int count = 0;
+
+	batch_pos = -1;
+	if (cros_crc8((const uint8_t *)batch_buf, batch_len) != batch_crc) {
+		uart_puts("&&EE\n");
+		return;
+	}
+
+	for (line = batch_buf; line < batch_buf + batch_len; line = end + 1) {
+		end = memchr(line, '\n', batch_buf + batch_len - line);
+		if (!end)
+			end = batch_buf + batch_len;
+		*end = '\0';
+
+		batch_index = count++;
+		split_words(line, &argc, argv);
+		rv = run_command(argc, argv);
+		batch_send_output();
+		batch_index = -1;
+
+		uart_printf("&&R%02x%04x&", (count - 1) & 0xff, rv & 0xffff);
+	}
+
+	uart_printf("&&Z%02x&", count & 0xff);
 }
 
+/**
+ * Give up on a batch whose characters stopped coming.
+ *
+ * @param now		Current time.
+ */
+static void batch_expire(uint64_t now)
+{
+	if (batch_pos < 0 || now - batch_last_char < BATCH_TIMEOUT_US)
+		return;
+
+	batch_pos = -1;
+	uart_puts("&&EE\n");
+}
+
+/**
+ * Handle a character which may be part of a batch of commands.
+ *
+ * @param c		Received character.
+ * @return 1 if the character was used, or 0 if it should be handled as
+ *	normal console input.
+ */
+static int batch_handle_char(int c)
+{
+	uint64_t now = get_time().val;
+	char *e;
+	int header;
+
+	if (c == EC_BATCH_SYN) {
+		uart_printf("%c%04x", EC_BATCH_ACK, CONFIG_CONSOLE_BATCH);
+		return 1;
+	}
+
+	if (c == EC_BATCH) {
+		batch_pos = 0;
+		batch_last_char = now;
+		return 1;
+	}
+
+	/* If the rest of the batch didn't come, this is something else */
+	batch_expire(now);
+	if (batch_pos < 0)
+		return 0;
+	batch_last_char = now;
+
+	if (batch_pos < BATCH_HEADER_SIZE) {
+		batch_header[batch_pos++] = c;
+		if (batch_pos < BATCH_HEADER_SIZE)
+			return 1;
+
+		/* Replace the '&' with null so we can call strtoi(). */
+		if (batch_header[BATCH_HEADER_SIZE - 1] != '&')
+			goto bad_header;
+		batch_header[BATCH_HEADER_SIZE - 1] = '\0';
+		header = strtoi(batch_header, &e, 16);
+		if (*e || header < 0 || (header >> 8) > CONFIG_CONSOLE_BATCH)
+			goto bad_header;
+		batch_len = header >> 8;
+		batch_crc = header & 0xff;
+	} else {
+		batch_buf[batch_pos++ - BATCH_HEADER_SIZE] = c;
+	}
+
+	if (batch_pos == BATCH_HEADER_SIZE + batch_len)
+		run_batch();
+	return 1;
+
+bad_header:
+	batch_pos = -1;
+	uart_puts("&&EE\n");
+	return 1;
+}
+#endif /* CONFIG_CONSOLE_BATCH */
+
 static void console_init(void)
 {
 	*input_buf = '\0';
@@ -457,10 +759,56 @@ static int handle_esc(int c)
 
 	return -1;
 }
+
+/*
+ * Complete the command name at the start of the line.  If it could be more
+ * than one command and can't be extended, list them instead.
+ */
+static void complete_command(void)
+{
+	const struct console_command *cmd;
+	int count, len, i;
+
+	/* Only complete the command name, with the cursor at its end */
+	if (input_pos != input_len)
+		return;
+	for (i = 0; i < input_len; i++)
+		if (isspace(input_buf[i]))
+			return;
+
+	len = console_command_complete(input_buf, input_len, &cmd, &count);
+	if (!count)
+		return;
+
+	if (len == input_len && count > 1) {
+		ccputs("\n");
+		print_commands(cmd, count);
+		ccputs(PROMPT);
+		ccputs(input_buf);
+		return;
+	}
+
+	/* Leave room for the space after a whole name, and the null */
+	if (len + 2 > sizeof(input_buf))
+		return;
+
+	memcpy(input_buf + input_len, cmd->name + input_len, len - input_len);
+	if (count == 1)
+		input_buf[len++] = ' ';
+	input_buf[len] = '\0';
+
+	ccputs(input_buf + input_len);
+	input_pos = input_len = len;
+}
 #endif /* !defined(CONFIG_EXPERIMENTAL_CONSOLE) */
 
 static void console_handle_char(int c)
 {
+#ifdef CONFIG_CONSOLE_BATCH
+	if (batch_handle_char(c))
+		return;
+#endif
+
 #ifdef CONFIG_EXPERIMENTAL_CONSOLE
 	/*
 	 * If we receive a EC_SYN, we should respond immediately with a EC_ACK.
@@ -572,6 +920,10 @@ static void console_handle_char(int c)
 		input_buf[input_len] = '\0';
 		break;
 
+	case '\t':
+		complete_command();
+		break;
+
 	case CTRL('L'):
 		/* Reprint current */
 		ccputs("\x0c" PROMPT);
@@ -669,7 +1021,13 @@ void console_task(void *u)
 			console_handle_char(c);
 		}
 
+#ifdef CONFIG_CONSOLE_BATCH
+		/* Wait for more input, or for a stalled batch to time out */
+		task_wait_event(batch_pos < 0 ? -1 : BATCH_TIMEOUT_US);
+		batch_expire(get_time().val);
+#else
 		task_wait_event(-1);  /* Wait for more input */
+#endif
 	}
 }
 
@@ -710,8 +1068,16 @@ static int command_help(int argc, char **argv)
 		}
 		cmd = find_command(argv[1]);
 		if (!cmd) {
-			ccprintf("Command '%s' not found or ambiguous.\n",
-				 argv[1]);
+			console_command_complete(argv[1], strlen(argv[1]),
+						 &cmd, &i);
+			if (i > 1) {
+				ccprintf("Command '%s' is ambiguous:\n",
+					 argv[1]);
+				print_commands(cmd, i);
+			} else {
+				ccprintf("Command '%s' not found.\n",
+					 argv[1]);
+			}
 			return EC_ERROR_UNKNOWN;
 		}
 		ccprintf("Usage: %s %s\n", cmd->name,
@@ -6,6 +6,7 @@
 /* Console output module for Chrome EC */
 
 #include "console.h"
+#include "tokenized_log.h"
 #include "uart.h"
 #include "usb_console.h"
 #include "util.h"
@@ -50,6 +51,12 @@ int cputs(enum console_channel channel, const char *outstr)
 		return EC_SUCCESS;
 #endif
 
+#ifdef CONFIG_CONSOLE_BATCH
+	/* Output of a command from a batch is framed for the batch */
+	if (channel == CC_COMMAND && console_batch_capturing())
+		return console_batch_puts(outstr);
+#endif
+
 	rv1 = usb_puts(outstr);
 	rv2 = uart_puts(outstr);
 
@@ -67,6 +74,24 @@ int cprintf(enum console_channel channel, const char *format, ...)
 		return EC_SUCCESS;
 #endif
 
+#ifdef CONFIG_CONSOLE_TOKENIZED_LOG
+	if (channel != CC_COMMAND && tokenized_log_enabled()) {
+		va_start(args, format);
+		tokenized_log_vadd(channel, 0, format, args);
+		va_end(args);
+		return EC_SUCCESS;
+	}
+#endif
+
+#ifdef CONFIG_CONSOLE_BATCH
+	if (channel == CC_COMMAND && console_batch_capturing()) {
+		va_start(args, format);
+		rv1 = console_batch_vprintf(format, args);
+		va_end(args);
+		return rv1;
+	}
+#endif
+
 	usb_va_start(args, format);
 	rv1 = usb_vprintf(format, args);
 	usb_va_end(args);
@@ -89,6 +114,31 @@ int cprints(enum console_channel channel, const char *format, ...)
 		return EC_SUCCESS;
 #endif
 
+#ifdef CONFIG_CONSOLE_TOKENIZED_LOG
+	if (channel != CC_COMMAND && tokenized_log_enabled()) {
+		va_start(args, format);
+		tokenized_log_vadd(channel, TOKENIZED_LOG_CPRINTS, format, args);
+		va_end(args);
+		return EC_SUCCESS;
+	}
+#endif
+
+#ifdef CONFIG_CONSOLE_BATCH
+	if (channel == CC_COMMAND && console_batch_capturing()) {
+		rv = cprintf(channel, "[%pT ", PRINTF_TIMESTAMP_NOW);
+		va_start(args, format);
+		r = console_batch_vprintf(format, args);
+		va_end(args);
+		if (r)
+			rv = r;
+		r = cputs(channel, "]\n");
+		return r ? r : rv;
+	}
+#endif
+
+	/* Keep the line together on the UART */
+	uart_line_begin();
+
 	rv = cprintf(channel, "[%pT ", PRINTF_TIMESTAMP_NOW);
 
 	va_start(args, format);
@@ -104,6 +154,10 @@ int cprints(enum console_channel channel, const char *format, ...)
 	usb_va_end(args);
 
 	r = cputs(channel, "]\n");
+	if (r)
+		rv = r;
+
+	r = uart_line_end();
 	return r ? r : rv;
 }
 
@@ -112,6 +166,38 @@ void cflush(void)
 	uart_flush_output();
 }
 
+#ifdef CONFIG_CONSOLE_CHANNEL
+static int console_channel_name_to_index(const char *name)
+{
+	int i;
+
+	for (i = 0; i < CC_CHANNEL_COUNT; i++) {
+		if (!strcasecmp(name, channel_names[i]))
+			return i;
+	}
+
+	/* Not found */
+	return -1;
+}
+
+void console_channel_enable(const char *name)
+{
+	int index = console_channel_name_to_index(name);
+
+	if (index >= 0)
+		channel_mask |= CC_MASK(index);
+}
+
+void console_channel_disable(const char *name)
+{
+	int index = console_channel_name_to_index(name);
+
+	/* No disabling the command output channel */
+	if (index >= 0 && index != CC_COMMAND)
+		channel_mask &= ~CC_MASK(index);
+}
+#endif /* CONFIG_CONSOLE_CHANNEL */
+
 /*****************************************************************************/
 /* Console commands */
 
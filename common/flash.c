@@ -971,6 +971,64 @@ static void flash_erase_deferred(void)
 DECLARE_DEFERRED(flash_erase_deferred);
 #endif
 
+#ifdef CONFIG_HOSTCMD_ASYNC
+/* Area left to erase for EC_CMD_FLASH_ERASE, while it is in progress */
+static struct ec_params_flash_erase async_erase;
+
+/* Get the length from offset to the end of its bank */
+static uint32_t flash_bank_remaining(uint32_t offset)
+{
+#ifdef CONFIG_FLASH_MULTIPLE_REGION
+	int bank = flash_bank_index(offset);
+
+	/* Leave it to flash_erase() to reject offsets outside any bank */
+	if (bank < 0)
+		return UINT32_MAX;
+	return flash_bank_start_offset(bank) + flash_bank_size(bank) - offset;
+#else
+	return CONFIG_FLASH_BANK_SIZE - offset % CONFIG_FLASH_BANK_SIZE;
+#endif
+}
+
+/*
+ * Erase one bank at a time, so that the hook task can run other hooks in
+ * between.
+ */
+static void flash_erase_async(void);
+DECLARE_DEFERRED(flash_erase_async);
+
+static void flash_erase_async(void)
+{
+	uint32_t size = MIN(async_erase.size,
+			    flash_bank_remaining(async_erase.offset));
+
+	if (flash_erase(async_erase.offset, size)) {
+		async_erase.size = 0;
+		host_command_async_done(EC_CMD_FLASH_ERASE, EC_RES_ERROR);
+		return;
+	}
+
+	async_erase.offset += size;
+	async_erase.size -= size;
+	if (async_erase.size) {
+		hook_call_deferred(&flash_erase_async_data, 0);
+		return;
+	}
+
+	host_command_async_done(EC_CMD_FLASH_ERASE, EC_RES_SUCCESS);
+}
+#endif
+
+/* Check whether flash commands have to wait for an erase to finish */
+static int flash_async_erase_busy(void)
+{
+#ifdef CONFIG_HOSTCMD_ASYNC
+	return async_erase.size != 0;
+#else
+	return 0;
+#endif
+}
+
 /*****************************************************************************/
 /* Console commands */
 
@@ -1324,6 +1382,9 @@ static enum ec_status flash_command_read(struct host_cmd_handler_args *args)
 	if (p->size > args->response_max)
 		return EC_RES_OVERFLOW;
 
+	if (flash_async_erase_busy())
+		return EC_RES_BUSY;
+
 	if (flash_read(offset, p->size, args->response))
 		return EC_RES_ERROR;
 
@@ -1357,6 +1418,9 @@ static enum ec_status flash_command_write(struct host_cmd_handler_args *args)
 		return EC_RES_ACCESS_DENIED;
 #endif
 
+	if (flash_async_erase_busy())
+		return EC_RES_BUSY;
+
 	if (flash_write(offset, p->size, (const uint8_t *)(p + 1)))
 		return EC_RES_ERROR;
 
@@ -1401,8 +1465,21 @@ static enum ec_status flash_command_erase(struct host_cmd_handler_args *args)
 		return EC_RES_ACCESS_DENIED;
 #endif
 
+	if (flash_async_erase_busy())
+		return EC_RES_BUSY;
+
 	switch (cmd) {
 	case FLASH_ERASE_SECTOR:
+#ifdef CONFIG_HOSTCMD_ASYNC
+		/* Erase from the hook task, leaving this one free meanwhile */
+		rc = host_command_async_start(args);
+		if (rc == EC_RES_IN_PROGRESS) {
+			async_erase.offset = offset;
+			async_erase.size = p->size;
+			hook_call_deferred(&flash_erase_async_data, 0);
+		}
+		break;
+#endif
 #if defined(HAS_TASK_HOSTCMD) && defined(CONFIG_HOST_COMMAND_STATUS)
 		args->result = EC_RES_IN_PROGRESS;
 		host_send_response(args);
@@ -1458,8 +1535,11 @@ static enum ec_status flash_command_protect(struct host_cmd_handler_args *args)
 	 * via the flags in the response.  (If we returned error, the caller
 	 * wouldn't get the response.)
 	 */
-	if (p->mask)
+	if (p->mask) {
+		if (flash_async_erase_busy())
+			return EC_RES_BUSY;
 		flash_set_protect(p->mask, p->flags);
+	}
 
 	/*
 	 * Retrieve the current flags.  The caller can use this to determine
@@ -8,7 +8,9 @@
 #include "atomic.h"
 #include "console.h"
 #include "hooks.h"
+#include "host_command.h"
 #include "link_defs.h"
+#include "task.h"
 #include "timer.h"
 #include "util.h"
 
@@ -20,8 +22,6 @@
 #define CPRINTS(format, args...)
 #endif
 
-#define DEFERRED_FUNCS_COUNT (__deferred_funcs_end - __deferred_funcs)
-
 struct hook_ptrs {
 	const struct hook_data *start;
 	const struct hook_data *end;
@@ -68,6 +68,34 @@ static const struct hook_ptrs hook_list[] = {
 static int defer_new_call;
 static int hook_task_started;
 
+/* How late HOOK_TICK and HOOK_SECOND may run; see DECLARE_HOOK_SLACK() */
+static uint32_t hook_tick_slack;
+static uint32_t hook_second_slack;
+
+/* What the hook task did each time it woke up */
+#define HOOK_WAKE_TICK		BIT(0)
+#define HOOK_WAKE_SECOND	BIT(1)
+#define HOOK_WAKE_DEFERRED	BIT(2)
+
+#ifdef CONFIG_HOOK_WAKE_STATS
+static struct ec_response_hook_wake_stats hook_wake_stats;
+
+static void record_hook_wake(uint32_t ran)
+{
+	hook_wake_stats.wakeups++;
+	if (ran & HOOK_WAKE_TICK)
+		hook_wake_stats.tick++;
+	if (ran & HOOK_WAKE_SECOND)
+		hook_wake_stats.second++;
+	if (ran & HOOK_WAKE_DEFERRED)
+		hook_wake_stats.deferred++;
+	if (!ran)
+		hook_wake_stats.idle++;
+	else if (ran & (ran - 1))
+		hook_wake_stats.coalesced++;
+}
+#endif
+
 #ifdef CONFIG_HOOK_DEBUG
 /* Stats for hooks */
 static uint64_t max_hook_tick_delay;
@@ -78,13 +106,20 @@ static uint64_t avg_hook_tick_delay;
 static uint64_t avg_hook_second_delay;
 static uint64_t avg_hook_run_time[ARRAY_SIZE(hook_list)];
 
+static uint64_t max_deferred_delay;
+static uint64_t avg_deferred_delay;
+static uint32_t deferred_call_count;
+static uint32_t deferred_wake_count;
+static uint32_t hook_task_wake_count;
+
 static inline void update_hook_average(uint64_t *avg, uint64_t time)
 {
 	*avg = (*avg * 7 + time) >> 3;
 }
 
 static void record_hook_delay(uint64_t now, uint64_t last, uint64_t interval,
-			      uint64_t *max_delay, uint64_t *avg_delay)
+			      uint64_t slack, uint64_t *max_delay,
+			      uint64_t *avg_delay)
 {
 	uint64_t delayed = now - last - interval;
 	/* Ignore the first call */
@@ -95,18 +130,68 @@ static void record_hook_delay(uint64_t now, uint64_t last, uint64_t interval,
 		*max_delay = delayed;
 	update_hook_average(avg_delay, delayed);
 
-	/* Warn if delayed by more than 10% */
-	if (delayed * 10 > interval)
+	/* Warn if delayed by more than 10% beyond the allowed slack */
+	if (delayed > slack && (delayed - slack) * 10 > interval)
 		CPRINTS("Hook at interval %d us delayed by %d us",
 			(uint32_t)interval, (uint32_t)delayed);
 }
+
+static void record_deferred_delay(uint64_t delayed)
+{
+	if (delayed > max_deferred_delay)
+		max_deferred_delay = delayed;
+	update_hook_average(&avg_deferred_delay, delayed);
+}
 #endif
 
+/*
+ * Set once __hook_order[] holds the call order of every hook type.  Hook data
+ * lives in read-only memory, so instead of sorting the hooks themselves we
+ * sort a table of indices, once, before the first notification.
+ */
+static int hooks_sorted;
+
+/**
+ * Fill in the call order for one type of hook.
+ *
+ * Uses an insertion sort, which is stable, so hooks with the same priority are
+ * still called in link order.
+ *
+ * @param type		Type of hook to sort.
+ */
+static void hook_sort(enum hook_type type)
+{
+	const struct hook_data *start = hook_list[type].start;
+	uint8_t *order = __hook_order + (start - __hooks_init);
+	int count = hook_list[type].end - start;
+	int i, j;
+
+	/* Indices must fit in the uint8_t entries reserved by the linker */
+	ASSERT(count <= UINT8_MAX + 1);
+
+	for (i = 0; i < count; i++) {
+		for (j = i; j > 0 &&
+		     start[order[j - 1]].priority > start[i].priority; j--)
+			order[j] = order[j - 1];
+		order[j] = i;
+	}
+}
+
+static void hook_sort_all(void)
+{
+	int type;
+
+	for (type = 0; type < ARRAY_SIZE(hook_list); type++)
+		hook_sort(type);
+
+	hooks_sorted = 1;
+}
+
 void hook_notify(enum hook_type type)
 {
-	const struct hook_data *start, *end, *p;
-	int count, called = 0;
-	int last_prio = HOOK_PRIO_FIRST - 1, prio;
+	const struct hook_data *start;
+	const uint8_t *order;
+	int count, i;
 #ifdef CONFIG_HOOK_DEBUG
 	uint64_t start_time = get_time().val;
 	uint64_t run_time;
@@ -114,27 +199,20 @@ void hook_notify(enum hook_type type)
 
 	CPRINTS("hook notify %d", type);
 
+	/*
+	 * The first notification comes from pre-task init code or the hook
+	 * task's HOOK_INIT, before other tasks run, so this needs no lock.
+	 */
+	if (!hooks_sorted)
+		hook_sort_all();
+
 	start = hook_list[type].start;
-	end = hook_list[type].end;
-	count = end - start;
+	order = __hook_order + (start - __hooks_init);
+	count = hook_list[type].end - start;
 
 	/* Call all the hooks in priority order */
-	while (called < count) {
-		/* Find the lowest remaining priority */
-		for (p = start, prio = HOOK_PRIO_LAST + 1; p < end; p++) {
-			if (p->priority < prio && p->priority > last_prio)
-				prio = p->priority;
-		}
-		last_prio = prio;
-
-		/* Call all the hooks with that priority */
-		for (p = start; p < end; p++) {
-			if (p->priority == prio) {
-				called++;
-				p->routine();
-			}
-		}
-	}
+	for (i = 0; i < count; i++)
+		start[order[i]].routine();
 
 #ifdef CONFIG_HOOK_DEBUG
 	run_time = get_time().val - start_time;
@@ -144,19 +222,142 @@ void hook_notify(enum hook_type type)
 #endif
 }
 
+/*
+ * Pending deferred routines are kept in a binary min-heap of __deferred_funcs[]
+ * indices, keyed on __deferred_until[].  __deferred_heap_pos[i] is one more
+ * than the heap slot holding routine i, or 0 if routine i isn't pending.  The
+ * heap is modified from any task or interrupt, so it's only touched with
+ * interrupts locked.
+ */
+static int deferred_heap_size;
+
+static inline uint64_t deferred_heap_key(int slot)
+{
+	return __deferred_until[__deferred_heap[slot]];
+}
+
+static inline void deferred_heap_set(int slot, int i)
+{
+	__deferred_heap[slot] = i;
+	__deferred_heap_pos[i] = slot + 1;
+}
+
+/* Restore heap order around a slot whose key changed; return its new slot. */
+static int deferred_heap_fix(int slot)
+{
+	int i = __deferred_heap[slot];
+	uint64_t until = __deferred_until[i];
+	int child;
+
+	/* Sift up */
+	while (slot > 0 && deferred_heap_key((slot - 1) / 2) > until) {
+		deferred_heap_set(slot, __deferred_heap[(slot - 1) / 2]);
+		slot = (slot - 1) / 2;
+	}
+
+	/* Sift down */
+	while ((child = 2 * slot + 1) < deferred_heap_size) {
+		if (child + 1 < deferred_heap_size &&
+		    deferred_heap_key(child + 1) < deferred_heap_key(child))
+			child++;
+		if (deferred_heap_key(child) >= until)
+			break;
+		deferred_heap_set(slot, __deferred_heap[child]);
+		slot = child;
+	}
+
+	deferred_heap_set(slot, i);
+	return slot;
+}
+
+static void deferred_heap_remove(int i)
+{
+	int slot = __deferred_heap_pos[i] - 1;
+
+	__deferred_heap_pos[i] = 0;
+	if (--deferred_heap_size == slot)
+		return;
+
+	/* Move the last entry into the hole and restore heap order */
+	deferred_heap_set(slot, __deferred_heap[deferred_heap_size]);
+	deferred_heap_fix(slot);
+}
+
+/**
+ * Remove the earliest pending deferred routine if it has expired, and clear
+ * its timer.
+ *
+ * @param t	Current time
+ * @return Index of the routine in __deferred_funcs[], or -1 if none expired.
+ */
+static int deferred_pop_expired(uint64_t t)
+{
+	uint32_t key = irq_lock();
+	int i = -1;
+
+	if (deferred_heap_size && deferred_heap_key(0) < t) {
+		i = __deferred_heap[0];
+		deferred_heap_remove(i);
+#ifdef CONFIG_HOOK_DEBUG
+		record_deferred_delay(t - __deferred_until[i]);
+#endif
+		/* Clear timer, so the routine can request itself again */
+		__deferred_until[i] = 0;
+	}
+
+	irq_unlock(key);
+	return i;
+}
+
+/**
+ * Return the deadline of the earliest pending deferred routine, or 0 if none.
+ */
+static uint64_t deferred_next_until(void)
+{
+	uint32_t key = irq_lock();
+	uint64_t until = deferred_heap_size ? deferred_heap_key(0) : 0;
+
+	irq_unlock(key);
+	return until;
+}
+
 int hook_call_deferred(const struct deferred_data *data, int us)
 {
 	int i = data - __deferred_funcs;
+	int new_head = 0;
+	uint32_t key;
 
 	if (data < __deferred_funcs || data >= __deferred_funcs_end)
 		return EC_ERROR_INVAL;  /* Routine not registered */
 
+	key = irq_lock();
+
 	if (us == -1) {
-		/* Cancel */
+		/*
+		 * Cancel.  If this was the earliest deadline the hook task
+		 * will just wake up early, find nothing to do, and re-sleep.
+		 */
+		if (__deferred_heap_pos[i])
+			deferred_heap_remove(i);
 		__deferred_until[i] = 0;
 	} else {
 		/* Set alarm */
 		__deferred_until[i] = get_time().val + us;
+		if (!__deferred_heap_pos[i])
+			deferred_heap_set(deferred_heap_size++, i);
+		new_head = deferred_heap_fix(__deferred_heap_pos[i] - 1) == 0;
+#ifdef CONFIG_HOOK_DEBUG
+		deferred_call_count++;
+#endif
+	}
+
+	irq_unlock(key);
+
+	/*
+	 * Only the earliest deadline decides how long the hook task sleeps,
+	 * so it only needs to wake up if that changed.
+	 */
+	if (new_head) {
 		/*
 		 * Flag that hook_call_deferred() has been called.  If the hook
 		 * task is already active, this will allow it to go through the
@@ -165,13 +366,82 @@ int hook_call_deferred(const struct deferred_data *data, int us)
 		defer_new_call = 1;
 
 		/* Wake task so it can re-sleep for the proper time */
-		if (hook_task_started)
+		if (hook_task_started) {
+#ifdef CONFIG_HOOK_DEBUG
+			deferred_wake_count++;
+#endif
 			task_wake(TASK_ID_HOOKS);
+		}
 	}
 
 	return EC_SUCCESS;
 }
 
+static inline int hook_type_empty(enum hook_type type)
+{
+	return hook_list[type].start == hook_list[type].end;
+}
+
+#ifdef CONFIG_HOOK_TICKLESS
+/**
+ * Return how late hooks of a type may be called.
+ *
+ * Every routine registered with DECLARE_HOOK_SLACK() adds one hook and one
+ * slack record, so a type has slack only if it has as many slack records as
+ * hooks, and then it is the smallest slack of any of them.
+ *
+ * @param type		HOOK_TICK or HOOK_SECOND
+ */
+static uint32_t hook_type_slack(enum hook_type type)
+{
+	const struct hook_slack *p;
+	int count = hook_list[type].end - hook_list[type].start;
+	uint32_t slack = UINT32_MAX;
+
+	for (p = __hook_slack; p < __hook_slack_end; p++) {
+		if (p->type != type)
+			continue;
+		count--;
+		slack = MIN(slack, (uint32_t)p->slack_us);
+	}
+
+	/* No slack if some routine didn't declare any, or there are none */
+	return (count || slack == UINT32_MAX) ? 0 : slack;
+}
+
+/*
+ * Advance a periodic hook's last run time along its nominal schedule, so that
+ * running late within the slack window doesn't make the period drift.  If the
+ * hook fell more than a whole period behind, restart the schedule from now.
+ */
+static void hook_advance_period(uint64_t *last, uint64_t interval, uint64_t t)
+{
+	*last += interval;
+	if (t - *last >= interval)
+		*last = t;
+}
+#else
+static void hook_advance_period(uint64_t *last, uint64_t interval, uint64_t t)
+{
+	*last = t;
+}
+#endif
+
+/**
+ * Reduce *next so that the hook task wakes up by a deadline.
+ *
+ * @param next		Time to sleep, in us; 0 to not sleep
+ * @param deadline	Latest time to wake up
+ * @param t		Current time
+ */
+static void hook_wake_by(int *next, uint64_t deadline, uint64_t t)
+{
+	if (deadline <= t)
+		*next = 0;
+	else if (deadline - t < *next)
+		*next = deadline - t;
+}
+
 void hook_task(void *u)
 {
 	/* Periodic hooks will be called first time through the loop */
@@ -180,6 +450,11 @@ void hook_task(void *u)
 
 	hook_task_started = 1;
 
+#ifdef CONFIG_HOOK_TICKLESS
+	hook_tick_slack = hook_type_slack(HOOK_TICK);
+	hook_second_slack = hook_type_slack(HOOK_SECOND);
+#endif
+
 	/* Call HOOK_INIT hooks. */
 	hook_notify(HOOK_INIT);
 
@@ -188,60 +463,80 @@ void hook_task(void *u)
 
 	while (1) {
 		uint64_t t = get_time().val;
-		int next = 0;
+		uint64_t until;
+		uint32_t ran = 0;
+		int next;
 		int i;
 
-		/* Handle deferred routines */
-		for (i = 0; i < DEFERRED_FUNCS_COUNT; i++) {
-			if (__deferred_until[i] && __deferred_until[i] < t) {
-				CPRINTS("hook call deferred 0x%pP",
-					__deferred_funcs[i].routine);
-				/*
-				 * Call deferred function.  Clear timer first,
-				 * so it can request itself be called later.
-				 */
-				__deferred_until[i] = 0;
-				__deferred_funcs[i].routine();
-			}
+#ifdef CONFIG_HOOK_DEBUG
+		hook_task_wake_count++;
+#endif
+
+		/* Handle expired deferred routines, earliest first */
+		while ((i = deferred_pop_expired(t)) >= 0) {
+			CPRINTS("hook call deferred 0x%pP",
+				__deferred_funcs[i].routine);
+			__deferred_funcs[i].routine();
+			ran |= HOOK_WAKE_DEFERRED;
 		}
 
+		/*
+		 * Periodic hooks run as soon as they are due, even if they
+		 * could still wait out their slack, so that they share this
+		 * wakeup instead of needing one of their own.
+		 */
 		if (t - last_tick >= HOOK_TICK_INTERVAL) {
 #ifdef CONFIG_HOOK_DEBUG
 			record_hook_delay(t, last_tick, HOOK_TICK_INTERVAL,
+					  hook_tick_slack,
 					  &max_hook_tick_delay,
 					  &avg_hook_tick_delay);
 #endif
-			hook_notify(HOOK_TICK);
-			last_tick = t;
+			if (!hook_type_empty(HOOK_TICK)) {
+				hook_notify(HOOK_TICK);
+				ran |= HOOK_WAKE_TICK;
+			}
+			hook_advance_period(&last_tick, HOOK_TICK_INTERVAL, t);
 		}
 
 		if (t - last_second >= SECOND) {
 #ifdef CONFIG_HOOK_DEBUG
 			record_hook_delay(t, last_second, SECOND,
+					  hook_second_slack,
 					  &max_hook_second_delay,
 					  &avg_hook_second_delay);
 #endif
-			hook_notify(HOOK_SECOND);
-			last_second = t;
+			if (!hook_type_empty(HOOK_SECOND)) {
+				hook_notify(HOOK_SECOND);
+				ran |= HOOK_WAKE_SECOND;
+			}
+			hook_advance_period(&last_second, SECOND, t);
 		}
 
-		/* Calculate when next tick needs to occur */
+#ifdef CONFIG_HOOK_WAKE_STATS
+		record_hook_wake(ran);
+#endif
+
+		/*
+		 * Calculate when we next need to wake up: the end of the
+		 * slack window of each periodic hook which has routines to
+		 * call, or the earliest deferred call, whichever comes first.
+		 */
 		t = get_time().val;
-		if (last_tick + HOOK_TICK_INTERVAL > t)
-			next = last_tick + HOOK_TICK_INTERVAL - t;
+		next = SECOND + hook_second_slack;
+		if (!hook_type_empty(HOOK_TICK))
+			hook_wake_by(&next, last_tick + HOOK_TICK_INTERVAL +
+				     hook_tick_slack, t);
+		if (!hook_type_empty(HOOK_SECOND))
+			hook_wake_by(&next, last_second + SECOND +
+				     hook_second_slack, t);
 
 		/* Wake earlier if needed by a deferred routine */
 		defer_new_call = 0;
 
-		for (i = 0; i < DEFERRED_FUNCS_COUNT && next > 0; i++) {
-			if (!__deferred_until[i])
-				continue;
-
-			if (__deferred_until[i] < t)
-				next = 0;
-			else if (__deferred_until[i] - t < next)
-				next = __deferred_until[i] - t;
-		}
+		until = deferred_next_until();
+		if (until)
+			hook_wake_by(&next, until + 1, t);
 
 		/*
 		 * If nothing is immediately pending, and hook_call_deferred()
@@ -253,9 +548,68 @@ void hook_task(void *u)
 	}
 }
 
+#ifdef CONFIG_HOOK_WAKE_STATS
+static void hook_wake_stats_get(struct ec_response_hook_wake_stats *r,
+				int reset)
+{
+	/*
+	 * The hook task may be updating the counters; a reset can lose at
+	 * most the wakeup in progress, which is fine for statistics.
+	 */
+	*r = hook_wake_stats;
+	r->tick_slack_us = hook_tick_slack;
+	r->second_slack_us = hook_second_slack;
+	if (reset)
+		memset(&hook_wake_stats, 0, sizeof(hook_wake_stats));
+}
+
+static enum ec_status
+host_command_hook_wake_stats(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_hook_wake_stats *p = args->params;
+	struct ec_response_hook_wake_stats *r = args->response;
+
+	hook_wake_stats_get(r, p->flags & EC_HOOK_WAKE_STATS_RESET);
+	args->response_size = sizeof(*r);
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_HOOK_WAKE_STATS, host_command_hook_wake_stats,
+		     EC_VER_MASK(0));
+#endif
+
 /*****************************************************************************/
 /* Console commands */
 
+#ifdef CONFIG_HOOK_WAKE_STATS
+static int command_hook_wake(int argc, char **argv)
+{
+	struct ec_response_hook_wake_stats r;
+	int reset = 0;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "reset"))
+			return EC_ERROR_PARAM1;
+		reset = 1;
+	}
+
+	hook_wake_stats_get(&r, reset);
+
+	ccprintf("Wakeups:   %d\n", r.wakeups);
+	ccprintf("  Tick:      %d (slack %d us)\n", r.tick, r.tick_slack_us);
+	ccprintf("  Second:    %d (slack %d us)\n", r.second,
+		 r.second_slack_us);
+	ccprintf("  Deferred:  %d\n", r.deferred);
+	ccprintf("  Coalesced: %d\n", r.coalesced);
+	ccprintf("  Idle:      %d\n", r.idle);
+
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(hookwake, command_hook_wake,
+			"[reset]",
+			"Print hook task wakeup counts");
+#endif
+
 #ifdef CONFIG_HOOK_DEBUG
 static void print_hook_delay(uint32_t interval, uint32_t delay, uint32_t avg)
 {
@@ -278,6 +632,14 @@ static int command_stats(int argc, char **argv)
 	ccprintf("HOOK_SECOND:\n");
 	print_hook_delay(SECOND, max_hook_second_delay, avg_hook_second_delay);
 
+	ccprintf("Deferred calls:\n");
+	ccprintf("  Scheduled:   %7d\n", deferred_call_count);
+	ccprintf("  Hook wakes:  %7d\n", deferred_wake_count);
+	ccprintf("  Max delayed: %7d us\n", (uint32_t)max_deferred_delay);
+	ccprintf("  Average:     %7d us\n\n", (uint32_t)avg_deferred_delay);
+
+	ccprintf("Hook task wakeups: %d\n\n", hook_task_wake_count);
+
 	ccprintf("Max run time for each hook:\n");
 	for (i = 0; i < ARRAY_SIZE(hook_list); ++i)
 		ccprintf("%3d:%6d us (Avg: %5d us)\n", i,
@@ -12,6 +12,7 @@
 #include "host_command.h"
 #include "link_defs.h"
 #include "lpc.h"
+#include "mkbp_event.h"
 #include "shared_mem.h"
 #include "system.h"
 #include "task.h"
@@ -67,6 +68,43 @@ static uint8_t command_pending;
 static uint8_t saved_result = EC_RES_UNAVAILABLE;
 #endif
 
+#ifdef CONFIG_HOSTCMD_ASYNC
+/* Commands which have returned EC_RES_IN_PROGRESS, until the host is told */
+static struct {
+	uint16_t command;
+	uint8_t state;
+	uint8_t result;
+	uint8_t order;	/* Position among finished commands, oldest first */
+} async_cmds[CONFIG_HOSTCMD_ASYNC];
+
+/* Number of finished commands the host hasn't been told about yet */
+static uint8_t async_done_count;
+
+enum {
+	ASYNC_FREE,	/* Slot unused */
+	ASYNC_RUNNING,	/* Handler's work still in progress */
+	ASYNC_DONE,	/* Finished; waiting for the host to read the event */
+};
+
+static struct mutex async_lock;
+
+/* Set when the command being processed was handed off */
+static uint8_t async_started;
+
+static inline int take_async_started(void)
+{
+	int started = async_started;
+
+	async_started = 0;
+	return started;
+}
+#else
+static inline int take_async_started(void)
+{
+	return 0;
+}
+#endif
+
 /*
  * Host command args passed to command handler.  Static to keep it off the
  * stack.  Note this means we can handle only one host command at a time.
@@ -136,7 +174,12 @@ test_mockable void host_send_response(struct host_cmd_handler_args *args)
 			command_pending = 0;
 			return;
 
-		} else if (args->result == EC_RES_IN_PROGRESS) {
+		} else if (args->result == EC_RES_IN_PROGRESS &&
+			   !take_async_started()) {
+			/*
+			 * Commands finished by host_command_async_done() don't
+			 * send a second response, so aren't pending here.
+			 */
 			command_pending = 1;
 			CPRINTS("HC pending");
 		}
@@ -363,12 +406,12 @@ host_packet_bad:
 }
 
 /**
- * Find a command by command number.
+ * Search the command section for a command number.
  *
  * @param command	Command number to find
  * @return The command structure, or NULL if no match found.
  */
-static const struct host_command *find_host_command(int command)
+static const struct host_command *search_host_command(int command)
 {
 	if (IS_ENABLED(CONFIG_ZEPHYR)) {
 		/* TODO(b/172678200): shim host commands for Zephyr */
@@ -407,6 +450,93 @@ static const struct host_command *find_host_command(int command)
 	}
 }
 
+#ifdef CONFIG_HOSTCMD_DISPATCH_PAGES
+/*
+ * Two-level dispatch table, built the first time a command is looked up.
+ * hcmd_page[] maps each page of HCMD_PAGE_SIZE command numbers to a page of
+ * hcmd_slot[], which holds one plus the index in __hcmds of each command in
+ * that page, or 0 if the command isn't implemented.
+ */
+#define HCMD_PAGE_SHIFT 5
+#define HCMD_PAGE_SIZE BIT(HCMD_PAGE_SHIFT)
+#define HCMD_PAGE_COUNT ((EC_CMD_BOARD_SPECIFIC_LAST + 1) >> HCMD_PAGE_SHIFT)
+#define HCMD_SLOT(command) ((command) & (HCMD_PAGE_SIZE - 1))
+
+/* hcmd_page[] value for pages without any command */
+#define HCMD_PAGE_EMPTY 0
+/* hcmd_page[] value for pages which didn't fit in the table; searched */
+#define HCMD_PAGE_SEARCH UINT8_MAX
+
+BUILD_ASSERT(CONFIG_HOSTCMD_DISPATCH_PAGES < HCMD_PAGE_SEARCH);
+
+static uint8_t hcmd_page[HCMD_PAGE_COUNT];
+static uint8_t hcmd_slot[CONFIG_HOSTCMD_DISPATCH_PAGES][HCMD_PAGE_SIZE];
+static int hcmd_table_built;
+
+static void hcmd_table_build(void)
+{
+	const struct host_command *cmd;
+	int pages = 0;
+	int index;
+	uint8_t *page, *slot;
+
+	for (cmd = __hcmds; cmd < __hcmds_end; cmd++) {
+		if (cmd->command > EC_CMD_BOARD_SPECIFIC_LAST)
+			continue;
+
+		page = &hcmd_page[cmd->command >> HCMD_PAGE_SHIFT];
+		index = cmd - __hcmds + 1;
+
+		/* Fall back to searching if we run out of space */
+		if (*page == HCMD_PAGE_EMPTY) {
+			if (pages < CONFIG_HOSTCMD_DISPATCH_PAGES)
+				*page = ++pages;
+			else
+				*page = HCMD_PAGE_SEARCH;
+		}
+		if (index >= UINT8_MAX)
+			*page = HCMD_PAGE_SEARCH;
+		if (*page == HCMD_PAGE_SEARCH)
+			continue;
+
+		/* Like the search, the first handler for a command wins */
+		slot = &hcmd_slot[*page - 1][HCMD_SLOT(cmd->command)];
+		if (!*slot)
+			*slot = index;
+	}
+
+	hcmd_table_built = 1;
+}
+#endif
+
+/**
+ * Find a command by command number.
+ *
+ * @param command	Command number to find
+ * @return The command structure, or NULL if no match found.
+ */
+test_export_static const struct host_command *find_host_command(int command)
+{
+#ifdef CONFIG_HOSTCMD_DISPATCH_PAGES
+	uint8_t page, slot;
+
+	if (!hcmd_table_built)
+		hcmd_table_build();
+
+	if (command >= 0 && command <= EC_CMD_BOARD_SPECIFIC_LAST) {
+		page = hcmd_page[command >> HCMD_PAGE_SHIFT];
+		if (page == HCMD_PAGE_EMPTY)
+			return NULL;
+		if (page != HCMD_PAGE_SEARCH) {
+			slot = hcmd_slot[page - 1][HCMD_SLOT(command)];
+			return slot ? __hcmds + slot - 1 : NULL;
+		}
+	}
+#endif
+
+	return search_host_command(command);
+}
+
 static void host_command_init(void)
 {
 	/* Initialize memory map ID area */
@@ -668,6 +798,46 @@ static void host_command_debug_request(struct host_cmd_handler_args *args)
 		CPRINTS("HC 0x%02x", args->command);
 }
 
+#ifdef CONFIG_HOSTCMD_STATS
+/* Keep the linker scripts' reservation for __hcmd_stats in sync */
+BUILD_ASSERT(sizeof(struct host_command_stats) == 48);
+BUILD_ASSERT(sizeof(struct host_command) ==
+	     sizeof(void *) + 2 * sizeof(int));
+
+/* When the statistics were last cleared */
+static timestamp_t hcmd_stats_reset_time;
+
+static void hcmd_stats_reset(void)
+{
+	memset(__hcmd_stats, 0,
+	       (__hcmds_end - __hcmds) * sizeof(struct host_command_stats));
+	hcmd_stats_reset_time = get_time();
+}
+
+/* Call a command's handler, recording how long it takes. */
+static enum ec_status hcmd_call(const struct host_command *cmd,
+				struct host_cmd_handler_args *args)
+{
+	struct host_command_stats *s = &__hcmd_stats[cmd - __hcmds];
+	timestamp_t t0 = get_time();
+	enum ec_status rv = cmd->handler(args);
+	uint32_t us = get_time().val - t0.val;
+
+	s->latency[latency_bucket(us, EC_HOST_COMMAND_STATS_BUCKETS)]++;
+	s->count++;
+	s->total_us += us;
+	s->max_us = MAX(s->max_us, us);
+
+	return rv;
+}
+#else
+static inline enum ec_status hcmd_call(const struct host_command *cmd,
+				       struct host_cmd_handler_args *args)
+{
+	return cmd->handler(args);
+}
+#endif
+
 uint16_t host_command_process(struct host_cmd_handler_args *args)
 {
 	const struct host_command *cmd;
@@ -690,6 +860,10 @@ uint16_t host_command_process(struct host_cmd_handler_args *args)
 	 */
 	memset(args->response, 0, args->response_max);
 
+#ifdef CONFIG_HOSTCMD_ASYNC
+	async_started = 0;
+#endif
+
 #ifdef CONFIG_HOSTCMD_PD
 	if (args->command >= EC_CMD_PASSTHRU_OFFSET(1) &&
 	    args->command <= EC_CMD_PASSTHRU_MAX(1)) {
@@ -714,7 +888,7 @@ uint16_t host_command_process(struct host_cmd_handler_args *args)
 		else if (!(EC_VER_MASK(args->version) & cmd->version_mask))
 			rv = EC_RES_INVALID_VERSION;
 		else
-			rv = cmd->handler(args);
+			rv = hcmd_call(cmd, args);
 	}
 
 	if (rv != EC_RES_SUCCESS)
@@ -727,6 +901,137 @@ uint16_t host_command_process(struct host_cmd_handler_args *args)
 	return rv;
 }
 
+#ifdef CONFIG_HOSTCMD_ASYNC
+enum ec_status host_command_async_start(struct host_cmd_handler_args *args)
+{
+	int i, free = -1;
+
+	mutex_lock(&async_lock);
+	for (i = 0; i < ARRAY_SIZE(async_cmds); i++) {
+		if (async_cmds[i].state == ASYNC_FREE) {
+			if (free < 0)
+				free = i;
+		} else if (async_cmds[i].command == args->command) {
+			free = -1;
+			break;
+		}
+	}
+	if (free >= 0) {
+		async_cmds[free].command = args->command;
+		async_cmds[free].state = ASYNC_RUNNING;
+		async_started = 1;
+	}
+	mutex_unlock(&async_lock);
+
+	return free < 0 ? EC_RES_BUSY : EC_RES_IN_PROGRESS;
+}
+
+void host_command_async_done(uint16_t command, enum ec_status result)
+{
+	int i;
+
+	mutex_lock(&async_lock);
+	for (i = 0; i < ARRAY_SIZE(async_cmds); i++) {
+		if (async_cmds[i].state == ASYNC_RUNNING &&
+		    async_cmds[i].command == command) {
+			async_cmds[i].result = result;
+			async_cmds[i].state = ASYNC_DONE;
+			async_cmds[i].order = async_done_count++;
+			break;
+		}
+	}
+	mutex_unlock(&async_lock);
+
+	if (i == ARRAY_SIZE(async_cmds))
+		return;
+
+	if (hcdebug)
+		CPRINTS("HC 0x%04x done, result=%d", command, result);
+#ifdef CONFIG_HOST_COMMAND_STATUS
+	/* Also let hosts which poll for the result find it */
+	saved_result = result;
+#endif
+	mkbp_send_event(EC_MKBP_EVENT_HOST_COMMAND_DONE);
+}
+
+static int host_command_async_get_next_event(uint8_t *out)
+{
+	struct ec_response_host_command_done r = { 0 };
+	int i, next, more;
+
+	/* Report commands in the order they finished */
+	mutex_lock(&async_lock);
+	for (next = 0; next < ARRAY_SIZE(async_cmds); next++) {
+		if (async_cmds[next].state == ASYNC_DONE &&
+		    !async_cmds[next].order)
+			break;
+	}
+	if (next == ARRAY_SIZE(async_cmds)) {
+		mutex_unlock(&async_lock);
+		return -EC_ERROR_NOT_HANDLED;
+	}
+
+	r.command = async_cmds[next].command;
+	r.result = async_cmds[next].result;
+	async_cmds[next].state = ASYNC_FREE;
+	for (i = 0; i < ARRAY_SIZE(async_cmds); i++) {
+		if (async_cmds[i].state == ASYNC_DONE)
+			async_cmds[i].order--;
+	}
+	more = --async_done_count;
+	mutex_unlock(&async_lock);
+
+	/* Each completion is a separate event */
+	if (more)
+		mkbp_send_event(EC_MKBP_EVENT_HOST_COMMAND_DONE);
+
+	memcpy(out, &r, sizeof(r));
+	return sizeof(r);
+}
+DECLARE_EVENT_SOURCE(EC_MKBP_EVENT_HOST_COMMAND_DONE,
+		     host_command_async_get_next_event);
+#endif
+
+#ifdef CONFIG_HOSTCMD_STATS
+static enum ec_status
+host_command_stats(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_host_command_stats *p = args->params;
+	struct ec_response_host_command_stats *r = args->response;
+	const int total = __hcmds_end - __hcmds;
+	const int index = p->index;
+	const int reset = p->flags & EC_HOST_COMMAND_STATS_RESET;
+	const struct host_command_stats *s;
+	struct ec_host_command_stats *e;
+	int i;
+
+	if (index > total)
+		return EC_RES_INVALID_PARAM;
+
+	r->elapsed_ms = (get_time().val - hcmd_stats_reset_time.val) / MSEC;
+	r->total = total;
+	r->count = MIN(MIN(total - index, UINT8_MAX),
+		       (args->response_max - sizeof(*r)) / sizeof(*e));
+	for (i = 0; i < r->count; i++) {
+		s = &__hcmd_stats[index + i];
+		e = &r->stats[i];
+		e->command = __hcmds[index + i].command;
+		e->count = s->count;
+		e->total_us = s->total_us;
+		e->max_us = s->max_us;
+		memcpy(e->latency, s->latency, sizeof(e->latency));
+	}
+	args->response_size = sizeof(*r) + r->count * sizeof(*e);
+
+	if (reset)
+		hcmd_stats_reset();
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_HOST_COMMAND_STATS, host_command_stats,
+		     EC_VER_MASK(0));
+#endif
+
 #ifdef CONFIG_HOST_COMMAND_STATUS
 /* Returns current command status (busy or not) */
 static enum ec_status
@@ -735,6 +1040,15 @@ host_command_get_comms_status(struct host_cmd_handler_args *args)
 	struct ec_response_get_comms_status *r = args->response;
 
 	r->flags = command_pending ? EC_COMMS_STATUS_PROCESSING : 0;
+#ifdef CONFIG_HOSTCMD_ASYNC
+	{
+		int i;
+
+		for (i = 0; i < ARRAY_SIZE(async_cmds); i++)
+			if (async_cmds[i].state == ASYNC_RUNNING)
+				r->flags = EC_COMMS_STATUS_PROCESSING;
+	}
+#endif
 	args->response_size = sizeof(*r);
 
 	return EC_RES_SUCCESS;
@@ -903,6 +1217,43 @@ DECLARE_CONSOLE_COMMAND(hostcmd, command_host_command,
 			"Fake host command");
 #endif /* CONFIG_CMD_HOSTCMD */
 
+#ifdef CONFIG_HOSTCMD_STATS
+static int command_hcstats(int argc, char **argv)
+{
+	const struct host_command_stats *s;
+	int i, j;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "reset"))
+			return EC_ERROR_PARAM1;
+		hcmd_stats_reset();
+		return EC_SUCCESS;
+	}
+
+	ccprintf("Over %lld ms:\n",
+		 (long long)(get_time().val - hcmd_stats_reset_time.val) /
+		 MSEC);
+	ccputs("Cmd      Count  Avg (us)  Max (us)  "
+	       "Latency <16/64/256/1k/4k/16k/64k/more us\n");
+	for (i = 0; i < __hcmds_end - __hcmds; i++) {
+		s = &__hcmd_stats[i];
+		if (!s->count)
+			continue;
+		ccprintf("0x%04x %7d %9d %9d ", __hcmds[i].command, s->count,
+			 (int)(s->total_us / s->count), s->max_us);
+		for (j = 0; j < EC_HOST_COMMAND_STATS_BUCKETS; j++)
+			ccprintf(" %d", s->latency[j]);
+		ccputs("\n");
+		cflush();
+	}
+
+	return EC_SUCCESS;
+}
+DECLARE_SAFE_CONSOLE_COMMAND(hcstats, command_hcstats,
+			     "[reset]",
+			     "Print host command handler statistics");
+#endif
+
 #ifdef CONFIG_CMD_HCDEBUG
 static int command_hcdebug(int argc, char **argv)
 {
@@ -16,6 +16,11 @@ static uint32_t lock_count;
 uint32_t irq_lock(void)
 {
 	interrupt_disable();
+
+	/* Blame whoever took the outermost lock, rather than this function */
+	if (lock_count == 0)
+		irq_profile_blame((uintptr_t)__builtin_return_address(0));
+
 	return lock_count++;
 }
 
@@ -0,0 +1,146 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* Interrupt-disabled region profiler */
+
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+#include "host_command.h"
+#include "task.h"
+#include "util.h"
+
+/*
+ * All of this is only updated with interrupts disabled, so needs no other
+ * locking.
+ */
+static struct {
+	uint32_t count;
+	uint32_t histogram[EC_IRQ_PROFILE_BUCKETS];
+	/* The longest regions, longest first */
+	struct ec_irq_profile_region top[CONFIG_IRQ_PROFILE];
+} profile;
+
+/* The current region, if interrupts are disabled */
+static uint32_t region_start;
+static uintptr_t region_caller;
+static int region_open;
+
+static int region_bucket(uint32_t us)
+{
+	if (us < 4)
+		return 0;
+
+	return MIN(__fls(us) / 2, EC_IRQ_PROFILE_BUCKETS - 1);
+}
+
+void irq_profile_disabled(uintptr_t caller, uint32_t now)
+{
+	region_start = now;
+	region_caller = caller;
+	region_open = 1;
+}
+
+void irq_profile_blame(uintptr_t caller)
+{
+	region_caller = caller;
+}
+
+void irq_profile_enabling(uint32_t now)
+{
+	struct ec_irq_profile_region *top = profile.top;
+	uint32_t us = now - region_start;
+	int i;
+
+	if (!region_open)
+		return;
+	region_open = 0;
+
+	profile.count++;
+	profile.histogram[region_bucket(us)]++;
+
+	/* Most regions are short; don't bother looking through the top ones */
+	if (us <= top[CONFIG_IRQ_PROFILE - 1].us)
+		return;
+
+	for (i = CONFIG_IRQ_PROFILE - 1; i > 0 && us > top[i - 1].us; i--)
+		top[i] = top[i - 1];
+	top[i].us = us;
+	top[i].caller = region_caller;
+}
+
+static void irq_profile_get(struct ec_response_irq_profile *r, int max_top,
+			    int reset)
+{
+	int n = MIN(max_top, CONFIG_IRQ_PROFILE);
+
+	/* This is itself a short region, which is counted once it ends. */
+	interrupt_disable();
+
+	r->count = profile.count;
+	r->max_us = profile.top[0].us;
+	memcpy(r->histogram, profile.histogram, sizeof(r->histogram));
+	for (r->top_count = 0; r->top_count < n; r->top_count++)
+		if (!profile.top[r->top_count].us)
+			break;
+	memcpy(r->top, profile.top, r->top_count * sizeof(r->top[0]));
+	memset(r->reserved, 0, sizeof(r->reserved));
+
+	if (reset)
+		memset(&profile, 0, sizeof(profile));
+
+	interrupt_enable();
+}
+
+static enum ec_status
+host_command_irq_profile(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_irq_profile *p = args->params;
+	struct ec_response_irq_profile *r = args->response;
+
+	irq_profile_get(r, (args->response_max - sizeof(*r)) /
+			sizeof(r->top[0]),
+			p->flags & EC_IRQ_PROFILE_RESET);
+	args->response_size = sizeof(*r) + r->top_count * sizeof(r->top[0]);
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_IRQ_PROFILE, host_command_irq_profile,
+		     EC_VER_MASK(0));
+
+/*****************************************************************************/
+/* Console commands */
+
+static int command_irq_profile(int argc, char **argv)
+{
+	struct {
+		struct ec_response_irq_profile r;
+		struct ec_irq_profile_region top[CONFIG_IRQ_PROFILE];
+	} buf;
+	struct ec_response_irq_profile *r = &buf.r;
+	int reset = 0;
+	int i;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "reset"))
+			return EC_ERROR_PARAM1;
+		reset = 1;
+	}
+
+	irq_profile_get(r, CONFIG_IRQ_PROFILE, reset);
+
+	ccprintf("Regions: %d, longest %d us\n", r->count, r->max_us);
+	ccputs("Length <4/16/64/256/1k/4k/16k/more us:");
+	for (i = 0; i < EC_IRQ_PROFILE_BUCKETS; i++)
+		ccprintf(" %d", r->histogram[i]);
+	ccputs("\n\n    Time (us)  Caller\n");
+	for (i = 0; i < r->top_count; i++)
+		ccprintf("%13d  %08x\n", r->top[i].us, r->top[i].caller);
+
+	return EC_SUCCESS;
+}
+DECLARE_SAFE_CONSOLE_COMMAND(irqprof, command_irq_profile,
+			     "[reset]",
+			     "Print the longest interrupt-disabled regions");
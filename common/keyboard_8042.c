@@ -279,7 +279,8 @@ static void i8042_send_to_host(int len, const uint8_t *bytes,
 			       uint8_t chan)
 {
 	int i;
-	struct data_byte data;
+	struct queue_sg sg;
+	struct data_byte *data;
 
 	/* Enqueue output data if there's space */
 	mutex_lock(&to_host_mutex);
@@ -287,13 +288,15 @@ static void i8042_send_to_host(int len, const uint8_t *bytes,
 	for (i = 0; i < len; i++)
 		kblog_put(chan == CHAN_AUX ? 'a' : 's', bytes[i]);
 
-	if (queue_space(&to_host) >= len) {
+	sg = queue_reserve_write(&to_host, len);
+	if (sg.count == len) {
 		kblog_put('t', to_host.state->tail);
 		for (i = 0; i < len; i++) {
-			data.chan = chan;
-			data.byte = bytes[i];
-			queue_add_unit(&to_host, &data);
+			data = queue_sg_unit(&to_host, &sg, i);
+			data->chan = chan;
+			data->byte = bytes[i];
 		}
+		queue_advance_tail(&to_host, len);
 	}
 	mutex_unlock(&to_host_mutex);
 
@@ -1169,6 +1172,7 @@ static int command_keyboard(int argc, char **argv)
 static int command_8042_internal(int argc, char **argv)
 {
 	int i;
+	struct queue_sg sg;
 
 	ccprintf("data_port_state=%d\n", data_port_state);
 	ccprintf("i8042_keyboard_irq_enabled=%d\n", i8042_keyboard_irq_enabled);
@@ -1186,23 +1190,22 @@ static int command_8042_internal(int argc, char **argv)
 	ccprintf("A20_status=%d\n", A20_status);
 
 	ccprintf("from_host[]={");
-	for (i = 0; i < queue_count(&from_host); ++i) {
-		struct host_byte entry;
+	sg = queue_reserve_read(&from_host, queue_count(&from_host));
+	for (i = 0; i < sg.count; ++i) {
+		const struct host_byte *entry = queue_sg_unit(&from_host, &sg,
+							      i);
 
-		queue_peek_units(&from_host, &entry, i, 1);
-
-		ccprintf("0x%02x, 0x%02x, ", entry.type, entry.byte);
+		ccprintf("0x%02x, 0x%02x, ", entry->type, entry->byte);
 	}
 	ccprintf("}\n");
 
 	ccprintf("to_host[]={");
-	for (i = 0; i < queue_count(&to_host); ++i) {
-		struct data_byte entry;
-
-		queue_peek_units(&to_host, &entry, i, 1);
+	sg = queue_reserve_read(&to_host, queue_count(&to_host));
+	for (i = 0; i < sg.count; ++i) {
+		const struct data_byte *entry = queue_sg_unit(&to_host, &sg, i);
 
-		ccprintf("0x%02x%s, ", entry.byte,
-			 entry.chan == CHAN_AUX ? " aux" : "");
+		ccprintf("0x%02x%s, ", entry->byte,
+			 entry->chan == CHAN_AUX ? " aux" : "");
 	}
 	ccprintf("}\n");
 
@@ -422,6 +422,9 @@ static enum ec_status mkbp_get_next_event(struct host_cmd_handler_args *args)
 	if (!set_inactive_if_no_events() && args->version >= 2)
 		resp[0] |= EC_MKBP_HAS_MORE_EVENTS;
 
+	/* The source had nothing to report after all */
+	if (data_size == -EC_ERROR_NOT_HANDLED)
+		return EC_RES_UNAVAILABLE;
 	if (data_size < 0)
 		return EC_RES_ERROR;
 	args->response_size = 1 + data_size;
@@ -49,6 +49,10 @@ static int mock_get_cc(int port, enum tcpc_cc_voltage_status *cc1,
 {
 	*cc1 = mock_tcpc.cc1;
 	*cc2 = mock_tcpc.cc2;
+
+	if (mock_tcpc.callbacks.get_cc)
+		mock_tcpc.callbacks.get_cc(port, cc1, cc2);
+
 	return EC_SUCCESS;
 }
 
@@ -74,6 +74,17 @@ static int tx_retry_cnt = -1;
 static uint8_t rx_buffer[BUFFER_SIZE];
 static int rx_pos = -1;
 
+/*
+ * Messages received while the TCPM hasn't cleared RX status for the one in
+ * rx_buffer yet, as a TCPC with more than one receive buffer holds them.
+ */
+#define RX_QUEUE_DEPTH 3
+static uint8_t rx_queue[RX_QUEUE_DEPTH][BUFFER_SIZE];
+static int rx_queue_count;
+
+/* Number of I2C transactions (from start to stop) with the TCPC */
+static int xfer_count;
+
 static const char * const ctrl_msg_name[] = {
 	[0]                      = "RSVD-C0",
 	[PD_CTRL_GOOD_CRC]       = "GOODCRC",
@@ -229,27 +240,64 @@ int verify_tcpci_tx_retry_count(enum tcpm_transmit_type tx_type,
 void mock_tcpci_receive(enum pd_msg_type sop, uint16_t header,
 			uint32_t *payload)
 {
+	uint8_t *buf = rx_buffer;
 	int i;
 
-	rx_buffer[0] = 3 + (PD_HEADER_CNT(header) * 4);
-	rx_buffer[1] = sop;
-	rx_buffer[2] = header & 0xFF;
-	rx_buffer[3] = (header >> 8) & 0xFF;
+	/*
+	 * Queue the message behind the one the TCPM has yet to clear RX
+	 * status for, or drop it if there's no room, as a TCPC would.
+	 */
+	if (tcpci_regs[TCPC_REG_ALERT].value & TCPC_REG_ALERT_RX_STATUS) {
+		if (rx_queue_count == RX_QUEUE_DEPTH) {
+			ccprints("TCPCI mock RX buffer overflow");
+			tcpci_regs[TCPC_REG_ALERT].value |=
+				TCPC_REG_ALERT_RX_BUF_OVF;
+			return;
+		}
+		buf = rx_queue[rx_queue_count];
+	}
+
+	buf[0] = 3 + (PD_HEADER_CNT(header) * 4);
+	buf[1] = sop;
+	buf[2] = header & 0xFF;
+	buf[3] = (header >> 8) & 0xFF;
 
-	if (rx_buffer[0] >= BUFFER_SIZE) {
+	if (buf[0] >= BUFFER_SIZE) {
 		ccprints("ERROR: rx too large");
 		return;
 	}
 
-	for (i = 4; i < rx_buffer[0]; i += 4) {
-		rx_buffer[i] = *payload & 0xFF;
-		rx_buffer[i+1] = (*payload >> 8) & 0xFF;
-		rx_buffer[i+2] = (*payload >> 16) & 0xFF;
-		rx_buffer[i+3] = (*payload >> 24) & 0xFF;
+	for (i = 4; i < buf[0]; i += 4) {
+		buf[i] = *payload & 0xFF;
+		buf[i+1] = (*payload >> 8) & 0xFF;
+		buf[i+2] = (*payload >> 16) & 0xFF;
+		buf[i+3] = (*payload >> 24) & 0xFF;
 		payload++;
 	}
 
+	if (buf == rx_buffer)
+		rx_pos = 0;
+	else
+		rx_queue_count++;
+}
+
+/* The TCPM cleared RX status, so move on to the next message, if any */
+static void rx_next(void)
+{
+	if (!rx_queue_count)
+		return;
+
+	memcpy(rx_buffer, rx_queue[0], sizeof(rx_buffer));
+	memmove(rx_queue[0], rx_queue[1],
+		(RX_QUEUE_DEPTH - 1) * sizeof(rx_queue[0]));
+	rx_queue_count--;
 	rx_pos = 0;
+	tcpci_regs[TCPC_REG_ALERT].value |= TCPC_REG_ALERT_RX_STATUS;
+}
+
+int mock_tcpci_get_xfer_count(void)
+{
+	return xfer_count;
 }
 
 void mock_tcpci_reset(void)
@@ -258,6 +306,10 @@ void mock_tcpci_reset(void)
 
 	for (i = 0; i < ARRAY_SIZE(tcpci_regs); i++)
 		tcpci_regs[i].value = 0;
+
+	rx_pos = -1;
+	rx_queue_count = 0;
+	xfer_count = 0;
 }
 
 void mock_tcpci_set_reg(int reg_offset, uint16_t value)
@@ -308,6 +360,9 @@ int tcpci_i2c_xfer(int port, uint16_t slave_addr_flags,
 		return EC_ERROR_UNKNOWN;
 	}
 
+	if (flags & I2C_XFER_START)
+		xfer_count++;
+
 	if (rx_pos > 0) {
 		if (rx_pos + in_size > rx_buffer[0] + 1) {
 			ccprints("ERROR: rx in_size");
@@ -398,10 +453,13 @@ int tcpci_i2c_xfer(int port, uint16_t slave_addr_flags,
 		ccprints("%s TCPCI write %s = 0x%x",
 			 task_get_name(task_get_current()),
 			 reg->name, value);
-		if (reg->offset == TCPC_REG_ALERT)
+		if (reg->offset == TCPC_REG_ALERT) {
 			reg->value &= ~value;
-		else
+			if (value & TCPC_REG_ALERT_RX_STATUS)
+				rx_next();
+		} else {
 			reg->value = value;
+		}
 	}
 	return EC_SUCCESS;
 }
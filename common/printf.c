@@ -58,15 +58,49 @@ static int hexdigit(int c)
 #define PF_64BIT	BIT(3)  /* Number is 64-bit */
 #endif
 
+/* Write a span of characters, through addspan() if the sink has one */
+static int out_span(const struct printf_sink *sink, void *context,
+		    const char *s, int len)
+{
+	if (sink->addspan)
+		return sink->addspan(context, s, len) ?
+			EC_ERROR_OVERFLOW : EC_SUCCESS;
+
+	while (len-- > 0)
+		if (sink->addchar(context, *s++))
+			return EC_ERROR_OVERFLOW;
+	return EC_SUCCESS;
+}
+
+/* Write count copies of a padding character, which must be ' ' or '0' */
+static int out_pad(const struct printf_sink *sink, void *context, int c,
+		   int count)
+{
+	static const char spaces[] = "                ";
+	static const char zeros[] = "0000000000000000";
+	const char *pad = c == '0' ? zeros : spaces;
+	int len;
+
+	while (count > 0) {
+		len = MIN(count, sizeof(spaces) - 1);
+		if (out_span(sink, context, pad, len))
+			return EC_ERROR_OVERFLOW;
+		count -= len;
+	}
+	return EC_SUCCESS;
+}
+
 /*
  * Print the buffer as a string of bytes in hex.
  * Returns 0 on success or an error on failure.
  */
-static int print_hex_buffer(int (*addchar)(void *context, int c),
-			    void *context, const char *vstr, int precision,
+static int print_hex_buffer(const struct printf_sink *sink, void *context,
+			    const char *vstr, int precision,
 			    int pad_width, int flags)
 
 {
+	char hex[32];
+	int len;
 
 	/*
 	 * Divide pad_width instead of multiplying precision to avoid overflow
@@ -79,29 +113,29 @@ static int print_hex_buffer(int (*addchar)(void *context, int c),
 	else
 		pad_width = 0;
 
-	while (pad_width > 0 && !(flags & PF_LEFT)) {
-		if (addchar(context, flags & PF_PADZERO ? '0' : ' '))
-			return EC_ERROR_OVERFLOW;
-		pad_width--;
-	}
+	if (!(flags & PF_LEFT) &&
+	    out_pad(sink, context, flags & PF_PADZERO ? '0' : ' ', pad_width))
+		return EC_ERROR_OVERFLOW;
 
-	for (; precision; precision--, vstr++) {
-		if (addchar(context, hexdigit(*vstr >> 4)) ||
-		    addchar(context, hexdigit(*vstr)))
+	/* Convert a chunk of the buffer at a time */
+	while (precision) {
+		for (len = 0; precision && len < sizeof(hex);
+		     precision--, vstr++) {
+			hex[len++] = hexdigit(*vstr >> 4);
+			hex[len++] = hexdigit(*vstr);
+		}
+		if (out_span(sink, context, hex, len))
 			return EC_ERROR_OVERFLOW;
 	}
 
-	while (pad_width > 0 && (flags & PF_LEFT)) {
-		if (addchar(context, ' '))
-			return EC_ERROR_OVERFLOW;
-		pad_width--;
-	}
+	if ((flags & PF_LEFT) && out_pad(sink, context, ' ', pad_width))
+		return EC_ERROR_OVERFLOW;
 
 	return EC_SUCCESS;
 }
 
-int vfnprintf(int (*addchar)(void *context, int c), void *context,
-	      const char *format, va_list args)
+int vfnprintf_sink(const struct printf_sink *sink, void *context,
+		   const char *format, va_list args)
 {
 	/*
 	 * Longest uint64 in decimal = 20
@@ -120,9 +154,13 @@ int vfnprintf(int (*addchar)(void *context, int c), void *context,
 		int c = *format++;
 		char sign = 0;
 
-		/* Copy normal characters */
+		/* Copy normal characters, up to the next format */
 		if (c != '%') {
-			if (addchar(context, c))
+			const char *start = format - 1;
+
+			while (*format && *format != '%')
+				format++;
+			if (out_span(sink, context, start, format - start))
 				return EC_ERROR_OVERFLOW;
 			continue;
 		}
@@ -135,7 +173,7 @@ int vfnprintf(int (*addchar)(void *context, int c), void *context,
 
 		/* Send "%" for "%%" input */
 		if (c == '%' || c == '\0') {
-			if (addchar(context, '%'))
+			if (sink->addchar(context, '%'))
 				return EC_ERROR_OVERFLOW;
 
 			if (c == '\0')
@@ -147,7 +185,7 @@ int vfnprintf(int (*addchar)(void *context, int c), void *context,
 		/* Handle %c */
 		if (c == 'c') {
 			c = va_arg(args, int);
-			if (addchar(context, c))
+			if (sink->addchar(context, c))
 				return EC_ERROR_OVERFLOW;
 			continue;
 		}
@@ -296,7 +334,7 @@ int vfnprintf(int (*addchar)(void *context, int c), void *context,
 						ptrval;
 					int rc;
 
-					rc = print_hex_buffer(addchar,
+					rc = print_hex_buffer(sink,
 							      context,
 							      hexbuf->buffer,
 							      hexbuf->size,
@@ -442,25 +480,29 @@ int vfnprintf(int (*addchar)(void *context, int c), void *context,
 		}
 
 
-		while (vlen < pad_width && !(flags & PF_LEFT)) {
-			if (addchar(context, flags & PF_PADZERO ? '0' : ' '))
-				return EC_ERROR_OVERFLOW;
-			vlen++;
-		}
-		while (--precision >= 0 && *vstr)
-			if (addchar(context, *vstr++))
-				return EC_ERROR_OVERFLOW;
-		while (vlen < pad_width && flags & PF_LEFT) {
-			if (addchar(context, ' '))
-				return EC_ERROR_OVERFLOW;
-			vlen++;
-		}
+		if (!(flags & PF_LEFT) &&
+		    out_pad(sink, context, flags & PF_PADZERO ? '0' : ' ',
+			    pad_width - vlen))
+			return EC_ERROR_OVERFLOW;
+		if (out_span(sink, context, vstr, strnlen(vstr, precision)))
+			return EC_ERROR_OVERFLOW;
+		if ((flags & PF_LEFT) &&
+		    out_pad(sink, context, ' ', pad_width - vlen))
+			return EC_ERROR_OVERFLOW;
 	}
 
 	/* If we're still here, we consumed all output */
 	return EC_SUCCESS;
 }
 
+int vfnprintf(int (*addchar)(void *context, int c), void *context,
+	      const char *format, va_list args)
+{
+	const struct printf_sink sink = { .addchar = addchar };
+
+	return vfnprintf_sink(&sink, context, format, args);
+}
+
 /* Context for snprintf() */
 struct snprintf_context {
 	char *str;
@@ -486,6 +528,30 @@ static int snprintf_addchar(void *context, int c)
 	return 0;
 }
 
+/**
+ * Add a span of characters to the string context.
+ *
+ * @param context	Context receiving characters
+ * @param s		Characters to add
+ * @param len		Number of characters
+ * @return 0 if all were added, 1 if some were dropped because no space.
+ */
+static int snprintf_addspan(void *context, const char *s, int len)
+{
+	struct snprintf_context *ctx = (struct snprintf_context *)context;
+	int n = MIN(len, ctx->size);
+
+	memcpy(ctx->str, s, n);
+	ctx->str += n;
+	ctx->size -= n;
+	return n < len;
+}
+
+static const struct printf_sink snprintf_sink = {
+	.addchar = snprintf_addchar,
+	.addspan = snprintf_addspan,
+};
+
 int snprintf(char *str, int size, const char *format, ...)
 {
 	va_list args;
@@ -509,7 +575,7 @@ int vsnprintf(char *str, int size, const char *format, va_list args)
 	ctx.str = str;
 	ctx.size = size - 1;  /* Reserve space for terminating '\0' */
 
-	rv = vfnprintf(snprintf_addchar, &ctx, format, args);
+	rv = vfnprintf_sink(&snprintf_sink, &ctx, format, args);
 
 	/* Terminate string */
 	*ctx.str = '\0';
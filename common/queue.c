@@ -126,6 +126,58 @@ size_t queue_advance_tail(struct queue const *q, size_t count)
 	return transfer;
 }
 
+struct queue_sg queue_sg_split_buffer(uint8_t *buffer, size_t buffer_units,
+				      size_t unit_bytes, size_t start,
+				      size_t count)
+{
+	size_t index = start & (buffer_units - 1);
+	size_t first = MIN(count, buffer_units - index);
+
+	return ((struct queue_sg) {
+		.count = count,
+		.chunk = {
+			{
+				.count = first,
+				.buffer = buffer + index * unit_bytes,
+			},
+			{
+				.count = count - first,
+				.buffer = buffer,
+			},
+		},
+	});
+}
+
+struct queue_sg queue_reserve_write(struct queue const *q, size_t count)
+{
+	return queue_sg_split_buffer(q->buffer, q->buffer_units, q->unit_bytes,
+				     q->state->tail,
+				     MIN(count, queue_space(q)));
+}
+
+struct queue_sg queue_reserve_read(struct queue const *q, size_t count)
+{
+	return queue_sg_split_buffer(q->buffer, q->buffer_units, q->unit_bytes,
+				     q->state->head,
+				     MIN(count, queue_count(q)));
+}
+
+void *queue_sg_unit_size(struct queue_sg const *sg, size_t unit_bytes,
+			 size_t i)
+{
+	if (i < sg->chunk[0].count)
+		return (uint8_t *)sg->chunk[0].buffer + i * unit_bytes;
+
+	return (uint8_t *)sg->chunk[1].buffer +
+		(i - sg->chunk[0].count) * unit_bytes;
+}
+
+void *queue_sg_unit(struct queue const *q, struct queue_sg const *sg,
+		    size_t i)
+{
+	return queue_sg_unit_size(sg, q->unit_bytes, i);
+}
+
 size_t queue_add_unit(struct queue const *q, const void *src)
 {
 	size_t tail = q->state->tail & q->buffer_units_mask;
@@ -0,0 +1,134 @@
+/* Copyright 2020 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Single-producer, single-consumer queue implementation.
+ */
+#include "queue_spsc.h"
+#include "util.h"
+
+/*
+ * Each side owns one index and only reads the other's.  A side may load its
+ * own index relaxed; the other's it loads with acquire, pairing with the
+ * release store that follows the other side's buffer accesses.
+ */
+static size_t load_own(const size_t *index)
+{
+	return __atomic_load_n(index, __ATOMIC_RELAXED);
+}
+
+static size_t load_other(const size_t *index)
+{
+	return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+}
+
+static void publish(size_t *index, size_t value)
+{
+	__atomic_store_n(index, value, __ATOMIC_RELEASE);
+}
+
+void queue_spsc_init(struct queue_spsc const *q)
+{
+	ASSERT(q->policy);
+	ASSERT(q->policy->add);
+	ASSERT(q->policy->remove);
+
+	publish(&q->state->head, 0);
+	publish(&q->state->tail, 0);
+}
+
+size_t queue_spsc_count(struct queue_spsc const *q)
+{
+	size_t head = load_other(&q->state->head);
+
+	return load_other(&q->state->tail) - head;
+}
+
+size_t queue_spsc_space(struct queue_spsc const *q)
+{
+	return q->buffer_units - queue_spsc_count(q);
+}
+
+/* Split count units starting at (unwrapped) index start into two chunks. */
+static struct queue_sg sg_split(struct queue_spsc const *q, size_t start,
+				size_t count)
+{
+	return queue_sg_split_buffer(q->buffer, q->buffer_units, q->unit_bytes,
+				     start, count);
+}
+
+struct queue_sg queue_spsc_reserve_write(struct queue_spsc const *q,
+					 size_t count)
+{
+	size_t tail = load_own(&q->state->tail);
+	size_t space = q->buffer_units - (tail - load_other(&q->state->head));
+
+	return sg_split(q, tail, MIN(count, space));
+}
+
+size_t queue_spsc_advance_tail(struct queue_spsc const *q, size_t count)
+{
+	size_t tail = load_own(&q->state->tail);
+	size_t space = q->buffer_units - (tail - load_other(&q->state->head));
+	size_t transfer = MIN(count, space);
+
+	publish(&q->state->tail, tail + transfer);
+
+	q->policy->add(q->policy, transfer);
+
+	return transfer;
+}
+
+struct queue_sg queue_spsc_reserve_read(struct queue_spsc const *q,
+					size_t count)
+{
+	size_t head = load_own(&q->state->head);
+	size_t available = load_other(&q->state->tail) - head;
+
+	return sg_split(q, head, MIN(count, available));
+}
+
+size_t queue_spsc_advance_head(struct queue_spsc const *q, size_t count)
+{
+	size_t head = load_own(&q->state->head);
+	size_t available = load_other(&q->state->tail) - head;
+	size_t transfer = MIN(count, available);
+
+	publish(&q->state->head, head + transfer);
+
+	q->policy->remove(q->policy, transfer);
+
+	return transfer;
+}
+
+void *queue_spsc_sg_unit(struct queue_spsc const *q,
+			 struct queue_sg const *sg, size_t i)
+{
+	return queue_sg_unit_size(sg, q->unit_bytes, i);
+}
+
+size_t queue_spsc_add_units(struct queue_spsc const *q, const void *src,
+			    size_t count)
+{
+	struct queue_sg sg = queue_spsc_reserve_write(q, count);
+	size_t first = sg.chunk[0].count * q->unit_bytes;
+
+	memcpy(sg.chunk[0].buffer, src, first);
+	memcpy(sg.chunk[1].buffer, (const uint8_t *)src + first,
+	       sg.chunk[1].count * q->unit_bytes);
+
+	return queue_spsc_advance_tail(q, sg.count);
+}
+
+size_t queue_spsc_remove_units(struct queue_spsc const *q, void *dest,
+			       size_t count)
+{
+	struct queue_sg sg = queue_spsc_reserve_read(q, count);
+	size_t first = sg.chunk[0].count * q->unit_bytes;
+
+	memcpy(dest, sg.chunk[0].buffer, first);
+	memcpy((uint8_t *)dest + first, sg.chunk[1].buffer,
+	       sg.chunk[1].count * q->unit_bytes);
+
+	return queue_spsc_advance_head(q, sg.count);
+}
@@ -27,11 +27,17 @@ int shared_mem_size(void)
 
 int shared_mem_acquire(int size, char **dest_ptr)
 {
-	if (size > shared_mem_size() || size <= 0)
+	uintptr_t caller = (uintptr_t)__builtin_return_address(0);
+
+	if (size > shared_mem_size() || size <= 0) {
+		shared_mem_trace_acquire(NULL, size, caller, EC_ERROR_INVAL);
 		return EC_ERROR_INVAL;
+	}
 
-	if (buf_in_use)
+	if (buf_in_use) {
+		shared_mem_trace_acquire(NULL, size, caller, EC_ERROR_BUSY);
 		return EC_ERROR_BUSY;
+	}
 
 	/*
 	 * We could guard buf_in_use with a mutex, but since shared memory is
@@ -44,11 +50,13 @@ int shared_mem_acquire(int size, char **dest_ptr)
 	if (max_used < size)
 		max_used = size;
 
+	shared_mem_trace_acquire(*dest_ptr, size, caller, EC_SUCCESS);
 	return EC_SUCCESS;
 }
 
 void shared_mem_release(void *ptr)
 {
+	shared_mem_trace_release(ptr);
 	buf_in_use = 0;
 }
 
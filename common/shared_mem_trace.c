@@ -0,0 +1,335 @@
+/* Copyright 2020 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* Shared memory allocation tracing */
+
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+#include "host_command.h"
+#include "shared_mem.h"
+#include "task.h"
+#include "timer.h"
+#include "util.h"
+
+#define CPRINTS(format, args...) cprints(CC_SYSTEM, format, ## args)
+
+#define TRACE_HELD EC_SHARED_MEM_TRACE_HELD
+#define TRACE_FAILED EC_SHARED_MEM_TRACE_FAILED
+
+struct trace_record {
+	uintptr_t caller;
+	void *ptr;
+	uint32_t size;
+	uint32_t acquired;	/* Low word of get_time() when acquired */
+	uint32_t held_us;	/* Once released */
+	uint8_t task;
+	uint8_t flags;
+};
+
+/*
+ * Records, oldest first.  A new record replaces the oldest released one, so
+ * the buffers which are still held - the interesting ones when looking for a
+ * leak - stay in the trace as long as possible.
+ */
+static struct trace_record records[CONFIG_SHAREDMEM_TRACE];
+static int record_count;
+
+/* Held buffers whose records had to be replaced, so are no longer counted. */
+static int untracked;
+
+static struct ec_shared_mem_task_usage usage[TASK_ID_COUNT];
+
+static struct mutex trace_lock;
+
+static uint32_t held_us(const struct trace_record *t, uint32_t now)
+{
+	return (t->flags & TRACE_HELD) ? now - t->acquired : t->held_us;
+}
+
+static void usage_add(int task, int size)
+{
+	if (task >= TASK_ID_COUNT)
+		return;
+
+	usage[task].current += size;
+	if (usage[task].current > usage[task].peak)
+		usage[task].peak = usage[task].current;
+}
+
+static void usage_remove(int task, int size)
+{
+	if (task < TASK_ID_COUNT)
+		usage[task].current -= size;
+}
+
+/* Remove record i, moving the newer ones down. */
+static void record_remove(int i)
+{
+	record_count--;
+	memmove(records + i, records + i + 1,
+		(record_count - i) * sizeof(records[0]));
+}
+
+static struct trace_record *record_new(void)
+{
+	int i;
+
+	if (record_count == ARRAY_SIZE(records)) {
+		for (i = 0; i < record_count; i++)
+			if (!(records[i].flags & TRACE_HELD))
+				break;
+
+		/* Everything is held; forget the oldest. */
+		if (i == record_count) {
+			i = 0;
+			usage_remove(records[0].task, records[0].size);
+			untracked++;
+		}
+		record_remove(i);
+	}
+
+	return records + record_count++;
+}
+
+static void print_holders(uint32_t now)
+{
+	int i;
+
+	for (i = 0; i < record_count; i++) {
+		const struct trace_record *t = records + i;
+
+		if (t->flags & TRACE_HELD)
+			CPRINTS("  %d bytes by %pP in task %d for %d us",
+				t->size, (void *)t->caller, t->task,
+				held_us(t, now));
+	}
+}
+
+void shared_mem_trace_acquire(void *ptr, int size, uintptr_t caller, int rv)
+{
+	struct trace_record *t;
+	uint32_t now;
+
+	if (in_interrupt_context())
+		return;
+
+	mutex_lock(&trace_lock);
+	now = get_time().le.lo;
+
+	t = record_new();
+	t->caller = caller;
+	t->ptr = ptr;
+	t->size = size;
+	t->acquired = now;
+	t->held_us = 0;
+	t->task = task_get_current();
+
+	if (rv == EC_SUCCESS) {
+		t->flags = TRACE_HELD;
+		usage_add(t->task, size);
+	} else {
+		t->flags = TRACE_FAILED;
+		if (rv == EC_ERROR_BUSY) {
+			CPRINTS("shmem: %d bytes for %pP failed, held by:",
+				size, (void *)caller);
+			print_holders(now);
+		}
+	}
+
+	mutex_unlock(&trace_lock);
+}
+
+void shared_mem_trace_release(void *ptr)
+{
+	int i;
+
+	if (in_interrupt_context())
+		return;
+
+	mutex_lock(&trace_lock);
+
+	for (i = record_count - 1; i >= 0; i--) {
+		struct trace_record *t = records + i;
+
+		if (t->ptr == ptr && (t->flags & TRACE_HELD)) {
+			t->held_us = get_time().le.lo - t->acquired;
+			t->flags &= ~TRACE_HELD;
+			usage_remove(t->task, t->size);
+			break;
+		}
+	}
+
+	mutex_unlock(&trace_lock);
+}
+
+int shared_mem_trace_get(int index, struct ec_shared_mem_trace_record *r)
+{
+	const struct trace_record *t;
+	int rv = EC_ERROR_INVAL;
+
+	mutex_lock(&trace_lock);
+
+	if (index >= 0 && index < record_count) {
+		t = records + record_count - 1 - index;
+		r->caller = t->caller;
+		r->size = t->size;
+		r->held_us = held_us(t, get_time().le.lo);
+		r->task_id = t->task;
+		r->flags = t->flags;
+		r->reserved = 0;
+		rv = EC_SUCCESS;
+	}
+
+	mutex_unlock(&trace_lock);
+	return rv;
+}
+
+int shared_mem_trace_usage(int task, int *current, int *peak)
+{
+	if (task < 0 || task >= TASK_ID_COUNT)
+		return EC_ERROR_INVAL;
+
+	mutex_lock(&trace_lock);
+	*current = usage[task].current;
+	*peak = usage[task].peak;
+	mutex_unlock(&trace_lock);
+
+	return EC_SUCCESS;
+}
+
+int shared_mem_trace_leaks(uint32_t min_held_us)
+{
+	uint32_t now;
+	int leaks = 0;
+	int i;
+
+	mutex_lock(&trace_lock);
+	now = get_time().le.lo;
+
+	for (i = 0; i < record_count; i++) {
+		const struct trace_record *t = records + i;
+
+		if (!(t->flags & TRACE_HELD) || held_us(t, now) < min_held_us)
+			continue;
+
+		if (!leaks)
+			CPRINTS("shmem: held for more than %d us:", min_held_us);
+		CPRINTS("  %d bytes by %pP in task %d for %d us",
+			t->size, (void *)t->caller, t->task, held_us(t, now));
+		leaks++;
+	}
+
+	mutex_unlock(&trace_lock);
+	return leaks;
+}
+
+static void trace_reset(void)
+{
+	int i;
+
+	for (i = record_count - 1; i >= 0; i--)
+		if (!(records[i].flags & TRACE_HELD))
+			record_remove(i);
+
+	for (i = 0; i < TASK_ID_COUNT; i++)
+		usage[i].peak = usage[i].current;
+}
+
+void shared_mem_trace_reset(void)
+{
+	mutex_lock(&trace_lock);
+	trace_reset();
+	mutex_unlock(&trace_lock);
+}
+
+/*****************************************************************************/
+/* Host commands */
+
+static enum ec_status
+shared_mem_trace(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_shared_mem_trace *p = args->params;
+	int i;
+
+	if (p->type == EC_SHARED_MEM_TRACE_USAGE) {
+		struct ec_response_shared_mem_trace_usage *r = args->response;
+		int n = MIN(TASK_ID_COUNT,
+			    (args->response_max - sizeof(*r)) /
+				    sizeof(r->usage[0]));
+
+		mutex_lock(&trace_lock);
+		memcpy(r->usage, usage, n * sizeof(r->usage[0]));
+		if (p->flags & EC_SHARED_MEM_TRACE_RESET)
+			for (i = 0; i < TASK_ID_COUNT; i++)
+				usage[i].peak = usage[i].current;
+		mutex_unlock(&trace_lock);
+
+		r->task_count = n;
+		memset(r->reserved, 0, sizeof(r->reserved));
+		args->response_size = sizeof(*r) + n * sizeof(r->usage[0]);
+	} else if (p->type == EC_SHARED_MEM_TRACE_RECORDS) {
+		struct ec_response_shared_mem_trace_records *r =
+			args->response;
+		int room = (args->response_max - sizeof(*r)) /
+			sizeof(r->records[0]);
+
+		for (i = 0; i < room; i++)
+			if (shared_mem_trace_get(p->index + i, r->records + i))
+				break;
+
+		r->total = record_count;
+		r->count = i;
+		memset(r->reserved, 0, sizeof(r->reserved));
+		args->response_size = sizeof(*r) + i * sizeof(r->records[0]);
+	} else {
+		return EC_RES_INVALID_PARAM;
+	}
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_SHARED_MEM_TRACE, shared_mem_trace,
+		     EC_VER_MASK(0));
+
+/*****************************************************************************/
+/* Console commands */
+
+static int command_shmemtrace(int argc, char **argv)
+{
+	struct ec_shared_mem_trace_record r;
+	int current, peak;
+	int i;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "reset"))
+			return EC_ERROR_PARAM1;
+		shared_mem_trace_reset();
+		return EC_SUCCESS;
+	}
+
+	ccprintf("Task Current   Peak\n");
+	for (i = 0; i < TASK_ID_COUNT; i++) {
+		shared_mem_trace_usage(i, &current, &peak);
+		if (peak)
+			ccprintf("%4d %7d %6d\n", i, current, peak);
+	}
+	if (untracked)
+		ccprintf("%d held buffers no longer traced\n", untracked);
+
+	ccprintf("\nCaller      Task   Size  Held (us)\n");
+	for (i = 0; shared_mem_trace_get(i, &r) == EC_SUCCESS; i++) {
+		ccprintf("%08x %4d %6d %10d%s\n", r.caller, r.task_id, r.size,
+			 r.held_us,
+			 (r.flags & EC_SHARED_MEM_TRACE_HELD) ? " held" :
+			 (r.flags & EC_SHARED_MEM_TRACE_FAILED) ? " failed" :
+			 "");
+		cflush();
+	}
+
+	return EC_SUCCESS;
+}
+DECLARE_SAFE_CONSOLE_COMMAND(shmemtrace, command_shmemtrace,
+			     "[reset]",
+			     "Print shared memory allocations and peak usage");
@@ -8,11 +8,14 @@
 #include <stdint.h>
 
 #include "common.h"
+#include "console.h"
 #include "hooks.h"
 #include "link_defs.h"
+#include "printf.h"
 #include "shared_mem.h"
 #include "system.h"
 #include "task.h"
+#include "timer.h"
 #include "util.h"
 
 static struct mutex shmem_lock;
@@ -37,18 +40,36 @@ TEST_GLOBAL struct shm_buffer *allocced_buf_chain;
 /* The size of the biggest ever allocated buffer. */
 static int max_allocated_size;
 
+/* Acquisition counts and times, for the shmem command. */
+struct shmem_timing {
+	uint32_t count;
+	uint32_t total_us;
+	uint32_t max_us;
+};
+
+static struct shmem_timing chain_timing;
+
+static void shmem_timing_add(struct shmem_timing *t, uint32_t us)
+{
+	t->count++;
+	t->total_us += us;
+	if (us > t->max_us)
+		t->max_us = us;
+}
+
 static void shared_mem_init(void)
 {
 	/*
 	 * Use all the RAM we can. The shared memory buffer is the last thing
 	 * allocated from the start of RAM, so we can use everything up to the
-	 * jump data at the end of RAM.
+	 * jump data at the end of RAM.  Buffer sizes are kept multiples of
+	 * sizeof(int), which slab tags rely on, so round it down.
 	 */
 	free_buf_chain = (struct shm_buffer *)__shared_mem_buf;
 	free_buf_chain->next_buffer = NULL;
 	free_buf_chain->prev_buffer = NULL;
-	free_buf_chain->buffer_size = system_usable_ram_end() -
-		(uintptr_t)__shared_mem_buf;
+	free_buf_chain->buffer_size = (system_usable_ram_end() -
+		(uintptr_t)__shared_mem_buf) & ~(sizeof(int) - 1);
 }
 DECLARE_HOOK(HOOK_INIT, shared_mem_init, HOOK_PRIO_FIRST);
 
@@ -286,6 +307,212 @@ static int do_acquire(int size, struct shm_buffer **dest_ptr)
 	return EC_SUCCESS;
 }
 
+/* Called with the mutex lock acquired. */
+static void chain_link_allocated(struct shm_buffer *buf)
+{
+	buf->next_buffer = allocced_buf_chain;
+	buf->prev_buffer = NULL;
+	if (allocced_buf_chain)
+		allocced_buf_chain->prev_buffer = buf;
+
+	allocced_buf_chain = buf;
+}
+
+#ifdef CONFIG_MALLOC_SLAB
+/*
+ * Small requests are served from slabs: buffers of CONFIG_MALLOC_SLAB bytes
+ * acquired from the chains above, each cut into blocks of one size class.
+ * Free blocks are kept on a list in their slab, and slabs with free blocks on
+ * a list in their class, so acquiring and releasing a block doesn't depend on
+ * how fragmented the chains are.
+ *
+ * Each block starts with a tag: its slab's address with bit 0 set.  This sits
+ * where a chain buffer's size would be, just below the pointer returned to the
+ * caller, and sizes are multiples of sizeof(int), so shared_mem_release() can
+ * tell the two apart.
+ */
+#define SLAB_MIN_BLOCK 64
+#define SLAB_CLASSES 6 /* 64 to 2048 byte blocks */
+#define SLAB_TAG 1
+
+struct shm_slab_block {
+	uintptr_t tag;
+	/* The rest is the caller's; while free, the next free block */
+	struct shm_slab_block *next_free;
+};
+
+struct shm_slab {
+	struct shm_slab *next_slab;
+	struct shm_slab *prev_slab;
+	struct shm_slab_block *free_blocks;
+	uint16_t used;
+	uint8_t class;
+};
+
+struct shm_slab_class {
+	/* Slabs with some blocks free */
+	struct shm_slab *partial;
+	/*
+	 * An empty slab kept back from the chains, so a class which
+	 * repeatedly acquires and releases one block doesn't take a slab
+	 * from the chains every time.
+	 */
+	struct shm_slab *spare;
+	uint16_t slabs;
+	uint16_t used;
+	struct shmem_timing timing;
+};
+
+static struct shm_slab_class slab_classes[SLAB_CLASSES];
+
+/* Blocks of a class which fit in one slab */
+static int slab_blocks(int class)
+{
+	return (CONFIG_MALLOC_SLAB - sizeof(struct shm_slab)) /
+		(SLAB_MIN_BLOCK << class);
+}
+
+/* Return the class to serve a request from, or -1 if it's too big. */
+static int slab_class(int size)
+{
+	int class;
+
+	for (class = 0; class < SLAB_CLASSES; class++)
+		if (size <= (SLAB_MIN_BLOCK << class) - sizeof(uintptr_t))
+			return slab_blocks(class) >= 2 ? class : -1;
+	return -1;
+}
+
+static void slab_unlink(struct shm_slab_class *sc, struct shm_slab *slab)
+{
+	if (slab->prev_slab)
+		slab->prev_slab->next_slab = slab->next_slab;
+	else
+		sc->partial = slab->next_slab;
+	if (slab->next_slab)
+		slab->next_slab->prev_slab = slab->prev_slab;
+}
+
+static void slab_link(struct shm_slab_class *sc, struct shm_slab *slab)
+{
+	slab->prev_slab = NULL;
+	slab->next_slab = sc->partial;
+	if (sc->partial)
+		sc->partial->prev_slab = slab;
+	sc->partial = slab;
+}
+
+/* Called with the mutex lock acquired. */
+static void slab_free(struct shm_slab *slab)
+{
+	slab_classes[slab->class].slabs--;
+	do_release((struct shm_buffer *)slab - 1);
+}
+
+/*
+ * Give the spare slabs back to the chains, so they can be merged into larger
+ * buffers.  Called with the mutex lock acquired.
+ */
+static void slab_release_spares(void)
+{
+	int class;
+
+	for (class = 0; class < SLAB_CLASSES; class++) {
+		if (slab_classes[class].spare) {
+			slab_free(slab_classes[class].spare);
+			slab_classes[class].spare = NULL;
+		}
+	}
+}
+
+/* Called with the mutex lock acquired. */
+static struct shm_slab *slab_new(int class)
+{
+	struct shm_buffer *buf;
+	struct shm_slab *slab;
+	struct shm_slab_block *block;
+	int size = SLAB_MIN_BLOCK << class;
+	int i;
+
+	if (do_acquire(CONFIG_MALLOC_SLAB, &buf) != EC_SUCCESS) {
+		/* Maybe other classes' spare slabs are in the way */
+		slab_release_spares();
+		if (do_acquire(CONFIG_MALLOC_SLAB, &buf) != EC_SUCCESS)
+			return NULL;
+	}
+	chain_link_allocated(buf);
+
+	slab = (struct shm_slab *)(buf + 1);
+	slab->class = class;
+	slab->used = 0;
+	slab->free_blocks = NULL;
+	for (i = slab_blocks(class) - 1; i >= 0; i--) {
+		block = (struct shm_slab_block *)((uintptr_t)(slab + 1) +
+						  i * size);
+		block->tag = (uintptr_t)slab | SLAB_TAG;
+		block->next_free = slab->free_blocks;
+		slab->free_blocks = block;
+	}
+	slab_classes[class].slabs++;
+
+	return slab;
+}
+
+/* Called with the mutex lock acquired. */
+static void *slab_acquire(int class)
+{
+	struct shm_slab_class *sc = &slab_classes[class];
+	struct shm_slab *slab = sc->partial;
+	struct shm_slab_block *block;
+
+	if (!slab) {
+		slab = sc->spare;
+		sc->spare = NULL;
+		if (!slab)
+			slab = slab_new(class);
+		if (!slab)
+			return NULL;
+		slab_link(sc, slab);
+	}
+
+	block = slab->free_blocks;
+	slab->free_blocks = block->next_free;
+	slab->used++;
+	sc->used++;
+
+	/* A full slab is off the list until a block is released. */
+	if (!slab->free_blocks)
+		slab_unlink(sc, slab);
+
+	return &block->next_free;
+}
+
+/* Called with the mutex lock acquired. */
+static void slab_release(struct shm_slab_block *block)
+{
+	struct shm_slab *slab = (struct shm_slab *)(block->tag & ~SLAB_TAG);
+	struct shm_slab_class *sc = &slab_classes[slab->class];
+
+	if (!slab->free_blocks)
+		slab_link(sc, slab);
+
+	block->next_free = slab->free_blocks;
+	slab->free_blocks = block;
+	slab->used--;
+	sc->used--;
+
+	if (slab->used)
+		return;
+
+	/* Keep one empty slab per class; return others to the chains. */
+	slab_unlink(sc, slab);
+	if (sc->spare)
+		slab_free(slab);
+	else
+		sc->spare = slab;
+}
+#endif /* CONFIG_MALLOC_SLAB */
+
 int shared_mem_size(void)
 {
 	struct shm_buffer *pfb;
@@ -293,6 +520,11 @@ int shared_mem_size(void)
 
 	mutex_lock(&shmem_lock);
 
+#ifdef CONFIG_MALLOC_SLAB
+	/* The caller may want all of it, so don't hold on to spare slabs. */
+	slab_release_spares();
+#endif
+
 	/* Find the maximum available buffer size. */
 	pfb = free_buf_chain;
 	while (pfb) {
@@ -309,34 +541,60 @@ int shared_mem_size(void)
 
 int shared_mem_acquire(int size, char **dest_ptr)
 {
+	uintptr_t caller = (uintptr_t)__builtin_return_address(0);
 	int rv;
 	struct shm_buffer *new_buf;
+	timestamp_t start;
+	uint32_t us;
+#ifdef CONFIG_MALLOC_SLAB
+	int class = slab_class(size);
+#endif
 
 	*dest_ptr = NULL;
 
 	if (in_interrupt_context())
 		return EC_ERROR_INVAL;
 
-	if (!free_buf_chain)
-		return EC_ERROR_BUSY;
-
 	mutex_lock(&shmem_lock);
+	start = get_time();
+
+#ifdef CONFIG_MALLOC_SLAB
+	if (class >= 0) {
+		*dest_ptr = slab_acquire(class);
+		if (*dest_ptr) {
+			us = get_time().val - start.val;
+			shmem_timing_add(&slab_classes[class].timing, us);
+			if (size > max_allocated_size)
+				max_allocated_size = size;
+			mutex_unlock(&shmem_lock);
+			shared_mem_trace_acquire(*dest_ptr, size, caller,
+						 EC_SUCCESS);
+			return EC_SUCCESS;
+		}
+	}
+#endif
+
 	rv = do_acquire(size, &new_buf);
+#ifdef CONFIG_MALLOC_SLAB
+	if (rv != EC_SUCCESS) {
+		/* Maybe the spare slabs are in the way; try again without */
+		slab_release_spares();
+		rv = do_acquire(size, &new_buf);
+	}
+#endif
 	if (rv == EC_SUCCESS) {
-		new_buf->next_buffer = allocced_buf_chain;
-		new_buf->prev_buffer = NULL;
-		if (allocced_buf_chain)
-			allocced_buf_chain->prev_buffer = new_buf;
-
-		allocced_buf_chain = new_buf;
-
+		chain_link_allocated(new_buf);
 		*dest_ptr = (void *)(new_buf + 1);
 
 		if (size > max_allocated_size)
 			max_allocated_size = size;
+
+		us = get_time().val - start.val;
+		shmem_timing_add(&chain_timing, us);
 	}
 	mutex_unlock(&shmem_lock);
 
+	shared_mem_trace_acquire(*dest_ptr, size, caller, rv);
 	return rv;
 }
 
@@ -345,21 +603,43 @@ void shared_mem_release(void *ptr)
 	if (in_interrupt_context())
 		return;
 
+	shared_mem_trace_release(ptr);
+
 	mutex_lock(&shmem_lock);
+#ifdef CONFIG_MALLOC_SLAB
+	if (((uintptr_t *)ptr)[-1] & SLAB_TAG) {
+		slab_release((struct shm_slab_block *)((uintptr_t *)ptr - 1));
+		mutex_unlock(&shmem_lock);
+		return;
+	}
+#endif
 	do_release((struct shm_buffer *)ptr - 1);
 	mutex_unlock(&shmem_lock);
 }
 
 #ifdef CONFIG_CMD_SHMEM
 
+static void print_timing(const char *name, const struct shmem_timing *t)
+{
+	ccprintf("%-14s %6d acquires, avg %d us, max %d us\n", name,
+		 t->count, t->count ? t->total_us / t->count : 0, t->max_us);
+}
+
 static int command_shmem(int argc, char **argv)
 {
 	size_t allocated_size;
 	size_t free_size;
 	size_t max_free;
+	int free_chunks;
 	struct shm_buffer *buf;
+	struct shmem_timing chain;
+#ifdef CONFIG_MALLOC_SLAB
+	struct shm_slab_class classes[SLAB_CLASSES];
+	int class;
+#endif
 
 	allocated_size = free_size = max_free = 0;
+	free_chunks = 0;
 
 	mutex_lock(&shmem_lock);
 
@@ -369,6 +649,7 @@ static int command_shmem(int argc, char **argv)
 		buf_room = buf->buffer_size;
 
 		free_size += buf_room;
+		free_chunks++;
 		if (buf_room > max_free)
 			max_free = buf_room;
 	}
@@ -377,6 +658,11 @@ static int command_shmem(int argc, char **argv)
 	     buf = buf->next_buffer)
 		allocated_size += buf->buffer_size;
 
+	chain = chain_timing;
+#ifdef CONFIG_MALLOC_SLAB
+	memcpy(classes, slab_classes, sizeof(classes));
+#endif
+
 	mutex_unlock(&shmem_lock);
 
 	ccprintf("Total:         %6zd\n", allocated_size + free_size);
@@ -384,6 +670,27 @@ static int command_shmem(int argc, char **argv)
 	ccprintf("Free:          %6zd\n", free_size);
 	ccprintf("Max free buf:  %6zd\n", max_free);
 	ccprintf("Max allocated: %6d\n", max_allocated_size);
+	/* How much of the free memory is outside the largest free buffer */
+	ccprintf("Free bufs:     %6d (%d%% fragmented)\n", free_chunks,
+		 free_size ? (int)(100 - max_free * 100 / free_size) : 0);
+	print_timing("Chain:", &chain);
+
+#ifdef CONFIG_MALLOC_SLAB
+	ccprintf("Slabs of %d bytes:\n", CONFIG_MALLOC_SLAB);
+	for (class = 0; class < SLAB_CLASSES; class++) {
+		char name[16];
+
+		if (slab_blocks(class) < 2)
+			break;
+		snprintf(name, sizeof(name), "  %4d:", SLAB_MIN_BLOCK << class);
+		ccprintf("%-14s %6d slabs%s, %d/%d blocks used\n", name,
+			 classes[class].slabs,
+			 classes[class].spare ? " (1 spare)" : "",
+			 classes[class].used,
+			 classes[class].slabs * slab_blocks(class));
+		print_timing("", &classes[class].timing);
+	}
+#endif
 	return EC_SUCCESS;
 }
 DECLARE_SAFE_CONSOLE_COMMAND(shmem, command_shmem,
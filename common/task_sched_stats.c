@@ -0,0 +1,141 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* Per-task scheduler statistics */
+
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+#include "host_command.h"
+#include "task.h"
+#include "util.h"
+
+struct task_sched_stats {
+	uint64_t runtime;	/* Time spent running, in us */
+	uint32_t switches;	/* Number of times switched to */
+	uint32_t latency_max;	/* Longest wakeup-to-run latency, in us */
+	uint32_t latency[EC_TASK_SCHED_LATENCY_BUCKETS];
+	uint32_t ready_time;	/* When the pending wakeup was posted */
+	uint8_t ready;		/* Non-zero if a wakeup is pending */
+};
+
+static struct task_sched_stats sched_stats[TASK_ID_COUNT];
+
+/* Time of the last context switch */
+static uint32_t last_switch_time;
+
+void task_sched_stats_ready(task_id_t tskid, uint32_t now)
+{
+	struct task_sched_stats *s = &sched_stats[tskid];
+
+	/* Only the first of several wakeups counts */
+	if (s->ready || tskid == task_get_current())
+		return;
+
+	s->ready_time = now;
+	s->ready = 1;
+}
+
+void task_sched_stats_switch(task_id_t from, task_id_t to, uint32_t now)
+{
+	struct task_sched_stats *s = &sched_stats[to];
+	uint32_t latency;
+
+	/* 32-bit deltas, so wrapping of the low word doesn't matter */
+	if (from < TASK_ID_COUNT)
+		sched_stats[from].runtime += now - last_switch_time;
+	last_switch_time = now;
+
+	s->switches++;
+	if (s->ready) {
+		latency = now - s->ready_time;
+		s->latency[latency_bucket(latency,
+					  EC_TASK_SCHED_LATENCY_BUCKETS)]++;
+		s->latency_max = MAX(s->latency_max, latency);
+		s->ready = 0;
+	}
+}
+
+static void task_sched_stats_get(task_id_t tskid,
+				 struct ec_response_task_sched_stats *r)
+{
+	const struct task_sched_stats *s = &sched_stats[tskid];
+
+	/*
+	 * The scheduler may update the counters while they are copied; that
+	 * can only skew one sample, which is fine for statistics.
+	 */
+	r->runtime_us = s->runtime;
+	r->switches = s->switches;
+	r->latency_max_us = s->latency_max;
+	memcpy(r->latency, s->latency, sizeof(r->latency));
+	r->task_count = TASK_ID_COUNT;
+	strzcpy(r->name, task_get_name(tskid), sizeof(r->name));
+}
+
+static void task_sched_stats_reset(void)
+{
+	int i;
+
+	for (i = 0; i < TASK_ID_COUNT; i++) {
+		sched_stats[i].runtime = 0;
+		sched_stats[i].switches = 0;
+		sched_stats[i].latency_max = 0;
+		memset(sched_stats[i].latency, 0,
+		       sizeof(sched_stats[i].latency));
+	}
+}
+
+static enum ec_status
+host_command_task_sched_stats(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_task_sched_stats *p = args->params;
+	struct ec_response_task_sched_stats *r = args->response;
+
+	if (p->task_id >= TASK_ID_COUNT)
+		return EC_RES_INVALID_PARAM;
+
+	task_sched_stats_get(p->task_id, r);
+	if (p->flags & EC_TASK_SCHED_STATS_RESET)
+		task_sched_stats_reset();
+	args->response_size = sizeof(*r);
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_TASK_SCHED_STATS, host_command_task_sched_stats,
+		     EC_VER_MASK(0));
+
+/*****************************************************************************/
+/* Console commands */
+
+static int command_task_stats(int argc, char **argv)
+{
+	struct ec_response_task_sched_stats r;
+	int i, j;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "reset"))
+			return EC_ERROR_PARAM1;
+		task_sched_stats_reset();
+		return EC_SUCCESS;
+	}
+
+	ccputs("Task Name             Runtime (s) Switches   MaxLat  "
+	       "Latency <16/64/256/1k/4k/16k/64k/more us\n");
+	for (i = 0; i < TASK_ID_COUNT; i++) {
+		task_sched_stats_get(i, &r);
+		ccprintf("%4d %-16s %11.6lld %8d %8d ", i, r.name,
+			 (long long)r.runtime_us, r.switches, r.latency_max_us);
+		for (j = 0; j < EC_TASK_SCHED_LATENCY_BUCKETS; j++)
+			ccprintf(" %d", r.latency[j]);
+		ccputs("\n");
+		cflush();
+	}
+
+	return EC_SUCCESS;
+}
+DECLARE_SAFE_CONSOLE_COMMAND(taskstats, command_task_stats,
+			     "[reset]",
+			     "Print per-task scheduler statistics");
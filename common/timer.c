@@ -14,6 +14,7 @@
 #include "util.h"
 #include "task.h"
 #include "timer.h"
+#include "timer_queue.h"
 #include "watchdog.h"
 
 #ifdef CONFIG_ZEPHYR
@@ -28,24 +29,9 @@ int32_t k_usleep(int32_t);
 /* High 32-bits of the 64-bit timestamp counter. */
 STATIC_IF_NOT(CONFIG_HWTIMER_64BIT) uint32_t clksrc_high;
 
-/* Bitmap of currently running timers */
-static uint32_t timer_running;
-
-/* Deadlines of all timers */
-static timestamp_t timer_deadline[TASK_ID_COUNT];
-static uint32_t next_deadline = 0xffffffff;
-
 /* Hardware timer routine IRQ number */
 static int timer_irq;
 
-static void expire_timer(task_id_t tskid)
-{
-	/* we are done with this timer */
-	atomic_clear_bits(&timer_running, 1 << tskid);
-	/* wake up the taks waiting for this timer */
-	task_set_event(tskid, TASK_EVENT_TIMER);
-}
-
 int timestamp_expired(timestamp_t deadline, const timestamp_t *now)
 {
 	timestamp_t now_val;
@@ -58,48 +44,15 @@ int timestamp_expired(timestamp_t deadline, const timestamp_t *now)
 	return ((int64_t)(now->val - deadline.val) >= 0);
 }
 
-void process_timers(int overflow)
+void timer_count_overflow(void)
 {
-	uint32_t check_timer, running_t0;
-	timestamp_t next;
-	timestamp_t now;
-
-	if (!IS_ENABLED(CONFIG_HWTIMER_64BIT) && overflow)
+	if (!IS_ENABLED(CONFIG_HWTIMER_64BIT))
 		clksrc_high++;
+}
 
-	do {
-		next.val = -1ull;
-		now = get_time();
-		do {
-			/* read atomically the current state of timer running */
-			check_timer = running_t0 = timer_running;
-			while (check_timer) {
-
-				int tskid = __fls(check_timer);
-				/* timer has expired ? */
-				if (timer_deadline[tskid].val <= now.val)
-					expire_timer(tskid);
-				else if ((timer_deadline[tskid].le.hi ==
-					  now.le.hi) &&
-					 (timer_deadline[tskid].le.lo <
-					  next.le.lo))
-					next.val = timer_deadline[tskid].val;
-
-				check_timer &= ~BIT(tskid);
-			}
-		/* if there is a new timer, let's retry */
-		} while (timer_running & ~running_t0);
-
-		if (next.le.hi == 0xffffffff) {
-			/* no deadline to set */
-			__hw_clock_event_clear();
-			next_deadline = 0xffffffff;
-			return;
-		}
-
-		__hw_clock_event_set(next.le.lo);
-		next_deadline = next.le.lo;
-	} while (next.val <= get_time().val);
+void timer_trigger_irq(void)
+{
+	task_trigger_irq(timer_irq);
 }
 
 #ifndef CONFIG_HW_SPECIFIC_UDELAY
@@ -122,37 +75,6 @@ void udelay(unsigned us)
 }
 #endif
 
-int timer_arm(timestamp_t event, task_id_t tskid)
-{
-	timestamp_t now = get_time();
-
-	ASSERT(tskid < TASK_ID_COUNT);
-
-	if (timer_running & BIT(tskid))
-		return EC_ERROR_BUSY;
-
-	timer_deadline[tskid] = event;
-	atomic_or(&timer_running, BIT(tskid));
-
-	/* Modify the next event if needed */
-	if ((event.le.hi < now.le.hi) ||
-	    ((event.le.hi == now.le.hi) && (event.le.lo <= next_deadline)))
-		task_trigger_irq(timer_irq);
-
-	return EC_SUCCESS;
-}
-
-void timer_cancel(task_id_t tskid)
-{
-	ASSERT(tskid < TASK_ID_COUNT);
-
-	atomic_clear_bits(&timer_running, BIT(tskid));
-	/*
-	 * Don't need to cancel the hardware timer interrupt, instead do
-	 * timer-related housekeeping when the next timer interrupt fires.
-	 */
-}
-
 /*
  * For us < (2^31 - task scheduling latency)(~ 2147 sec), this function will
  * sleep for at least us, and no more than 2*us. As us approaches 2^32-1, the
@@ -259,10 +181,11 @@ void timer_print_info(void)
 	cflush();
 
 	for (tskid = 0; tskid < TASK_ID_COUNT; tskid++) {
-		if (timer_running & BIT(tskid)) {
+		if (timer_queue_contains(tskid)) {
+			timestamp_t d = timer_queue_deadline(tskid);
+
 			ccprintf("  Tsk %2d  0x%016llx -> %11.6lld\n", tskid,
-				 timer_deadline[tskid].val,
-				 timer_deadline[tskid].val - t.val);
+				 d.val, d.val - t.val);
 			cflush();
 		}
 	}
@@ -273,8 +196,6 @@ void timer_init(void)
 	const timestamp_t *ts;
 	int size, version;
 
-	BUILD_ASSERT(TASK_ID_COUNT < sizeof(timer_running) * 8);
-
 	/* Restore time from before sysjump */
 	ts = (const timestamp_t *)system_get_jump_tag(TIMER_SYSJUMP_TAG,
 						      &version, &size);
@@ -0,0 +1,185 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* Deadline-ordered queue of task timers */
+
+#include "common.h"
+#include "hwtimer.h"
+#include "task.h"
+#include "timer_queue.h"
+#include "util.h"
+
+/* Deadlines of all timers */
+static timestamp_t timer_deadline[TASK_ID_COUNT];
+
+/* Min-heap of task IDs, keyed on timer_deadline[] */
+static uint8_t timer_heap[TASK_ID_COUNT];
+static int timer_heap_size;
+
+/* One more than the heap slot holding each task, or 0 if it isn't queued */
+static uint8_t timer_heap_pos[TASK_ID_COUNT];
+
+static inline uint64_t timer_heap_key(int slot)
+{
+	return timer_deadline[timer_heap[slot]].val;
+}
+
+static inline void timer_heap_set(int slot, task_id_t tskid)
+{
+	timer_heap[slot] = tskid;
+	timer_heap_pos[tskid] = slot + 1;
+}
+
+/* Restore heap order around a slot whose key changed; return its new slot. */
+static int timer_heap_fix(int slot)
+{
+	task_id_t tskid = timer_heap[slot];
+	uint64_t deadline = timer_deadline[tskid].val;
+	int child;
+
+	/* Sift up */
+	while (slot > 0 && timer_heap_key((slot - 1) / 2) > deadline) {
+		timer_heap_set(slot, timer_heap[(slot - 1) / 2]);
+		slot = (slot - 1) / 2;
+	}
+
+	/* Sift down */
+	while ((child = 2 * slot + 1) < timer_heap_size) {
+		if (child + 1 < timer_heap_size &&
+		    timer_heap_key(child + 1) < timer_heap_key(child))
+			child++;
+		if (timer_heap_key(child) >= deadline)
+			break;
+		timer_heap_set(slot, timer_heap[child]);
+		slot = child;
+	}
+
+	timer_heap_set(slot, tskid);
+	return slot;
+}
+
+int timer_queue_add(task_id_t tskid, timestamp_t deadline)
+{
+	timer_deadline[tskid] = deadline;
+	if (!timer_heap_pos[tskid])
+		timer_heap_set(timer_heap_size++, tskid);
+
+	return timer_heap_fix(timer_heap_pos[tskid] - 1) == 0;
+}
+
+void timer_queue_remove(task_id_t tskid)
+{
+	int slot = timer_heap_pos[tskid] - 1;
+
+	if (slot < 0)
+		return;
+
+	timer_heap_pos[tskid] = 0;
+	if (--timer_heap_size == slot)
+		return;
+
+	/* Move the last entry into the hole and restore heap order */
+	timer_heap_set(slot, timer_heap[timer_heap_size]);
+	timer_heap_fix(slot);
+}
+
+task_id_t timer_queue_peek(timestamp_t *deadline)
+{
+	if (!timer_heap_size)
+		return TASK_ID_INVALID;
+
+	*deadline = timer_deadline[timer_heap[0]];
+	return timer_heap[0];
+}
+
+timestamp_t timer_queue_deadline(task_id_t tskid)
+{
+	return timer_deadline[tskid];
+}
+
+int timer_queue_contains(task_id_t tskid)
+{
+	return timer_heap_pos[tskid] != 0;
+}
+
+static void expire_timer(task_id_t tskid)
+{
+	/* we are done with this timer */
+	timer_queue_remove(tskid);
+	/* wake up the taks waiting for this timer */
+	task_set_event(tskid, TASK_EVENT_TIMER);
+}
+
+void process_timers(int overflow)
+{
+	timestamp_t next;
+	timestamp_t now;
+	task_id_t tskid;
+	uint32_t key;
+
+	if (overflow)
+		timer_count_overflow();
+
+	do {
+		now = get_time();
+
+		/*
+		 * The queue is ordered by deadline, so only the expired timers
+		 * and the next one to expire are ever looked at.
+		 */
+		key = irq_lock();
+		while ((tskid = timer_queue_peek(&next)) != TASK_ID_INVALID &&
+		       next.val <= now.val)
+			expire_timer(tskid);
+		irq_unlock(key);
+
+		if (tskid == TASK_ID_INVALID || next.le.hi != now.le.hi) {
+			/*
+			 * No deadline to set before the counter wraps; the
+			 * overflow interrupt will bring us back here.
+			 */
+			__hw_clock_event_clear();
+			return;
+		}
+
+		__hw_clock_event_set(next.le.lo);
+	} while (next.val <= get_time().val);
+}
+
+int timer_arm(timestamp_t event, task_id_t tskid)
+{
+	uint32_t key;
+	int first;
+
+	ASSERT(tskid < TASK_ID_COUNT);
+
+	if (timer_queue_contains(tskid))
+		return EC_ERROR_BUSY;
+
+	key = irq_lock();
+	first = timer_queue_add(tskid, event);
+	irq_unlock(key);
+
+	/* Modify the next event if this timer is now the earliest one */
+	if (first)
+		timer_trigger_irq();
+
+	return EC_SUCCESS;
+}
+
+void timer_cancel(task_id_t tskid)
+{
+	uint32_t key;
+
+	ASSERT(tskid < TASK_ID_COUNT);
+
+	key = irq_lock();
+	timer_queue_remove(tskid);
+	irq_unlock(key);
+	/*
+	 * Don't need to cancel the hardware timer interrupt, instead do
+	 * timer-related housekeeping when the next timer interrupt fires.
+	 */
+}
@@ -0,0 +1,571 @@
+/* Copyright 2020 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/*
+ * Tokenized console log: cprints() and cprintf() output stored as the format
+ * string's address and the raw arguments, to be formatted only when read.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "host_command.h"
+#include "printf.h"
+#include "task.h"
+#include "timer.h"
+#include "tokenized_log.h"
+#include "util.h"
+
+#define LOG_SIZE CONFIG_CONSOLE_TOKENIZED_LOG_SIZE
+#define LOG_MASK (LOG_SIZE - 1)
+BUILD_ASSERT(POWER_OF_TWO(LOG_SIZE));
+BUILD_ASSERT(TOKENIZED_LOG_ENTRY_MAX <= UINT8_MAX);
+
+static uint8_t log_buf[LOG_SIZE];
+
+/*
+ * Positions of the oldest entry and of the end of the log.  These aren't
+ * wrapped until they are used, so they also identify entries to readers.
+ */
+static uint32_t log_head;
+static uint32_t log_tail;
+
+/* On from boot; see CONFIG_CONSOLE_TOKENIZED_LOG */
+static int log_enabled = 1;
+
+/* Kinds of conversion in a format string */
+enum arg_kind {
+	ARG_NONE,	/* Bad conversion; printed as "ERROR" */
+	ARG_INT,
+	ARG_INT64,
+	ARG_STR,
+	ARG_TIME,	/* %pT */
+	ARG_PTR,	/* %pP */
+	ARG_HEX,	/* %ph */
+	ARG_BIN,	/* %pb */
+};
+
+struct conversion {
+	const char *start;	/* The '%' */
+	const char *end;	/* Just past the conversion */
+	uint8_t star_width;	/* Width is given by an argument */
+	uint8_t star_precision;	/* Precision is given by an argument */
+	uint8_t kind;		/* enum arg_kind */
+};
+
+/*
+ * Find the next conversion in a format string, parsing it the same way as
+ * vfnprintf() does.
+ *
+ * @return where to continue looking, or NULL if there are no more.
+ */
+static const char *next_conversion(const char *format, struct conversion *conv)
+{
+	int c, is64;
+
+	while (*format) {
+		if (*format++ != '%')
+			continue;
+
+		conv->start = format - 1;
+		conv->star_width = 0;
+		conv->star_precision = 0;
+		conv->kind = ARG_NONE;
+
+		c = *format++;
+		if (c == '%')
+			continue;
+		if (c == '\0')
+			return NULL;
+
+		if (c == 'c') {
+			conv->kind = ARG_INT;
+			conv->end = format;
+			return format;
+		}
+
+		if (c == '-')
+			c = *format++;
+		if (c == '+')
+			c = *format++;
+		if (c == '0')
+			c = *format++;
+
+		if (c == '*') {
+			conv->star_width = 1;
+			c = *format++;
+		} else {
+			while (c >= '0' && c <= '9')
+				c = *format++;
+		}
+
+		if (c == '.') {
+			c = *format++;
+			if (c == '*') {
+				conv->star_precision = 1;
+				c = *format++;
+			} else {
+				while (c >= '0' && c <= '9')
+					c = *format++;
+			}
+		}
+
+		if (c == 's') {
+			conv->kind = ARG_STR;
+		} else {
+			is64 = 0;
+			if (c == 'l') {
+				is64 = sizeof(long) == sizeof(uint64_t);
+				c = *format++;
+				if (c == 'l') {
+					is64 = 1;
+					c = *format++;
+				}
+				/* %l on 32-bit systems is an error */
+				if (!is64)
+					c = '\0';
+			} else if (c == 'z') {
+				is64 = sizeof(size_t) == sizeof(uint64_t);
+				c = *format++;
+			}
+
+			if (c == 'p') {
+				switch (*format++) {
+				case 'T':
+					conv->kind = ARG_TIME;
+					break;
+				case 'P':
+					conv->kind = ARG_PTR;
+					break;
+				case 'h':
+					conv->kind = ARG_HEX;
+					break;
+				case 'b':
+					conv->kind = ARG_BIN;
+					break;
+				}
+			} else if (c == 'd' || c == 'u' || c == 'x' ||
+				   c == 'X' || c == 'T' ||
+				   (c == 'i' && IS_ENABLED(
+					   CONFIG_PRINTF_LEGACY_LI_FORMAT))) {
+				conv->kind = is64 ? ARG_INT64 : ARG_INT;
+			}
+		}
+
+		/* Don't step past the end of a bad format string */
+		if (!format[-1])
+			format--;
+		conv->end = format;
+		return format;
+	}
+
+	return NULL;
+}
+
+/*****************************************************************************/
+/* Adding entries */
+
+struct writer {
+	uint8_t *p;
+	uint8_t *end;
+};
+
+static int put(struct writer *w, const void *data, int size)
+{
+	if (w->p + size > w->end)
+		return EC_ERROR_OVERFLOW;
+	memcpy(w->p, data, size);
+	w->p += size;
+	return EC_SUCCESS;
+}
+
+static int put_str(struct writer *w, const char *s)
+{
+	int len = strnlen(s, w->end - w->p);
+
+	if (w->p + len >= w->end)
+		return EC_ERROR_OVERFLOW;
+	memcpy(w->p, s, len);
+	w->p[len] = '\0';
+	w->p += len + 1;
+	return EC_SUCCESS;
+}
+
+static int put_arg(struct writer *w, const struct conversion *conv,
+		   va_list *args)
+{
+	int32_t v;
+	uint64_t v64;
+	uintptr_t ptr;
+	const char *s;
+	const struct hex_buffer_params *hex;
+	const struct binary_print_params *bin;
+	uint8_t len;
+
+	if (conv->star_width) {
+		v = va_arg(*args, int);
+		if (put(w, &v, sizeof(v)))
+			return EC_ERROR_OVERFLOW;
+	}
+	if (conv->star_precision) {
+		v = va_arg(*args, int);
+		if (put(w, &v, sizeof(v)))
+			return EC_ERROR_OVERFLOW;
+	}
+
+	switch (conv->kind) {
+	case ARG_INT:
+		v = va_arg(*args, int);
+		return put(w, &v, sizeof(v));
+	case ARG_INT64:
+		v64 = va_arg(*args, uint64_t);
+		return put(w, &v64, sizeof(v64));
+	case ARG_STR:
+		s = va_arg(*args, const char *);
+		return put_str(w, s ? s : "(NULL)");
+	case ARG_TIME:
+		ptr = (uintptr_t)va_arg(*args, void *);
+		v64 = ptr ? *(const uint64_t *)ptr : get_time().val;
+		return put(w, &v64, sizeof(v64));
+	case ARG_PTR:
+		ptr = (uintptr_t)va_arg(*args, void *);
+		return put(w, &ptr, sizeof(ptr));
+	case ARG_HEX:
+		hex = va_arg(*args, const struct hex_buffer_params *);
+		if (w->p >= w->end)
+			return EC_ERROR_OVERFLOW;
+		len = hex ? MIN(hex->size, w->end - w->p - 1) : 0;
+		put(w, &len, sizeof(len));
+		if (len)
+			put(w, hex->buffer, len);
+		return hex && len < hex->size ? EC_ERROR_OVERFLOW : EC_SUCCESS;
+	case ARG_BIN:
+		bin = va_arg(*args, const struct binary_print_params *);
+		v = bin ? bin->value : 0;
+		len = bin ? bin->count : 0xff;
+		if (put(w, &v, sizeof(v)))
+			return EC_ERROR_OVERFLOW;
+		return put(w, &len, sizeof(len));
+	}
+
+	/* vfnprintf() stops at a bad conversion, so there's nothing more */
+	return EC_ERROR_INVAL;
+}
+
+void tokenized_log_vadd(enum console_channel channel, int flags,
+			const char *format, va_list args)
+{
+	uint8_t buf[TOKENIZED_LOG_ENTRY_MAX];
+	struct tokenized_log_entry *e = (struct tokenized_log_entry *)buf;
+	struct writer w = { .p = e->args, .end = buf + sizeof(buf) };
+	struct conversion conv;
+	const char *f = format;
+	uint32_t key;
+	int i, rv;
+	va_list ap;
+
+	/* va_list may be an array type, so work on a copy we can point to */
+	va_copy(ap, args);
+	while ((f = next_conversion(f, &conv))) {
+		rv = put_arg(&w, &conv, &ap);
+		if (rv == EC_ERROR_OVERFLOW)
+			flags |= TOKENIZED_LOG_TRUNCATED;
+		if (rv)
+			break;
+	}
+	va_end(ap);
+
+	e->size = w.p - buf;
+	e->channel = channel;
+	e->flags = flags;
+	e->timestamp = get_time().le.lo;
+	e->format = (uintptr_t)format;
+
+	key = irq_lock();
+	/* Discard the oldest entries to make room */
+	while (log_tail - log_head + e->size > LOG_SIZE)
+		log_head += log_buf[log_head & LOG_MASK];
+	for (i = 0; i < e->size; i++)
+		log_buf[(log_tail + i) & LOG_MASK] = buf[i];
+	log_tail += e->size;
+	irq_unlock(key);
+}
+
+int tokenized_log_enabled(void)
+{
+	return log_enabled;
+}
+
+/*****************************************************************************/
+/* Reading entries */
+
+int tokenized_log_read(uint32_t *pos, void *entry, int size)
+{
+	uint8_t *out = entry;
+	uint32_t key;
+	int i, n;
+
+	key = irq_lock();
+	if (*pos - log_head > log_tail - log_head)
+		*pos = log_head;
+
+	if (*pos == log_tail) {
+		n = 0;
+	} else {
+		n = log_buf[*pos & LOG_MASK];
+		if (n > size) {
+			n = -1;
+		} else {
+			for (i = 0; i < n; i++)
+				out[i] = log_buf[(*pos + i) & LOG_MASK];
+			*pos += n;
+		}
+	}
+	irq_unlock(key);
+
+	return n;
+}
+
+struct reader {
+	const uint8_t *p;
+	const uint8_t *end;
+};
+
+static int get(struct reader *r, void *data, int size)
+{
+	if (r->p + size > r->end)
+		return EC_ERROR_OVERFLOW;
+	memcpy(data, r->p, size);
+	r->p += size;
+	return EC_SUCCESS;
+}
+
+struct output {
+	char *buf;
+	int size;
+	int len;
+};
+
+/* Append text to the output; returns non-zero once it is full. */
+__attribute__((__format__(__printf__, 2, 3)))
+static int out_printf(struct output *o, const char *format, ...)
+{
+	va_list args;
+	int rv;
+
+	va_start(args, format);
+	rv = vsnprintf(o->buf + o->len, o->size - o->len, format, args);
+	va_end(args);
+
+	if (rv < 0) {
+		o->len = o->size - 1;
+		return EC_ERROR_OVERFLOW;
+	}
+	o->len += rv;
+	return EC_SUCCESS;
+}
+
+/*
+ * Copy a conversion out of the format string, putting any '*' width or
+ * precision from the arguments in place.
+ */
+static int conversion_format(const struct conversion *conv, struct reader *r,
+			     char *buf, int size)
+{
+	const char *c;
+	int32_t v;
+	int n = 0, rv;
+
+	for (c = conv->start; c < conv->end; c++) {
+		if (*c == '*') {
+			if (get(r, &v, sizeof(v)))
+				return EC_ERROR_OVERFLOW;
+			rv = snprintf(buf + n, size - n, "%d", v);
+		} else {
+			rv = snprintf(buf + n, size - n, "%c", *c);
+		}
+		if (rv < 0)
+			return EC_ERROR_INVAL;
+		n += rv;
+	}
+
+	return EC_SUCCESS;
+}
+
+static int format_arg(struct output *o, const struct conversion *conv,
+		      struct reader *r)
+{
+	char spec[24];
+	int32_t v;
+	uint64_t v64;
+	uintptr_t ptr;
+	const char *s;
+	uint8_t len;
+
+	if (conv->kind == ARG_NONE)
+		return out_printf(o, "ERROR") ? EC_ERROR_OVERFLOW :
+			EC_ERROR_INVAL;
+
+	if (conversion_format(conv, r, spec, sizeof(spec)))
+		return EC_ERROR_INVAL;
+
+	switch (conv->kind) {
+	case ARG_INT:
+		if (get(r, &v, sizeof(v)))
+			return EC_ERROR_OVERFLOW;
+		return out_printf(o, spec, v);
+	case ARG_INT64:
+		if (get(r, &v64, sizeof(v64)))
+			return EC_ERROR_OVERFLOW;
+		return out_printf(o, spec, v64);
+	case ARG_STR:
+		s = (const char *)r->p;
+		len = strnlen(s, r->end - r->p);
+		if (r->p + len >= r->end)
+			return EC_ERROR_OVERFLOW;
+		r->p += len + 1;
+		return out_printf(o, spec, s);
+	case ARG_TIME:
+		if (get(r, &v64, sizeof(v64)))
+			return EC_ERROR_OVERFLOW;
+		return out_printf(o, spec, &v64);
+	case ARG_PTR:
+		if (get(r, &ptr, sizeof(ptr)))
+			return EC_ERROR_OVERFLOW;
+		return out_printf(o, spec, (void *)ptr);
+	case ARG_HEX:
+		if (get(r, &len, sizeof(len)) || r->p + len > r->end)
+			return EC_ERROR_OVERFLOW;
+		r->p += len;
+		return out_printf(o, spec, HEX_BUF(r->p - len, len));
+	case ARG_BIN:
+		if (get(r, &v, sizeof(v)) || get(r, &len, sizeof(len)))
+			return EC_ERROR_OVERFLOW;
+		if (len == 0xff)
+			return EC_SUCCESS;
+		return out_printf(o, spec, BINARY_VALUE(v, len));
+	}
+
+	return EC_ERROR_INVAL;
+}
+
+/* Append format string text, which has no conversions, to the output */
+static int format_text(struct output *o, const char *start, const char *end)
+{
+	for (; start < end; start++) {
+		/* "%%" prints one '%' */
+		if (*start == '%' && start + 1 < end)
+			start++;
+		if (out_printf(o, "%c", *start))
+			return EC_ERROR_OVERFLOW;
+	}
+
+	return EC_SUCCESS;
+}
+
+int tokenized_log_format(const void *entry, char *buf, int size)
+{
+	const struct tokenized_log_entry *e = entry;
+	struct reader r = { .p = e->args, .end = (const uint8_t *)e + e->size };
+	struct output o = { .buf = buf, .size = size };
+	const char *format = (const char *)e->format;
+	const char *f = format;
+	struct conversion conv;
+	timestamp_t t;
+	int rv = EC_SUCCESS;
+
+	if (size <= 0)
+		return 0;
+	buf[0] = '\0';
+
+	if (e->flags & TOKENIZED_LOG_CPRINTS) {
+		/* Extend the timestamp, assuming it's from the last hour */
+		t = get_time();
+		t.val -= (uint32_t)(t.le.lo - e->timestamp);
+		out_printf(&o, "[%pT ", &t.val);
+	}
+
+	while ((f = next_conversion(format, &conv))) {
+		rv = format_text(&o, format, conv.start);
+		if (!rv)
+			rv = format_arg(&o, &conv, &r);
+		if (rv)
+			break;
+		format = f;
+	}
+	if (!rv)
+		format_text(&o, format, format + strlen(format));
+	else if (rv == EC_ERROR_OVERFLOW && (e->flags & TOKENIZED_LOG_TRUNCATED))
+		out_printf(&o, "...");
+
+	if (e->flags & TOKENIZED_LOG_CPRINTS)
+		out_printf(&o, "]\n");
+
+	return o.len;
+}
+
+/*****************************************************************************/
+/* Host commands */
+
+static enum ec_status
+console_read_tokenized(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_console_read_tokenized *p = args->params;
+	struct ec_response_console_read_tokenized *r = args->response;
+	uint32_t pos = p->pos;
+	uint8_t *out = r->data;
+	int room = args->response_max - sizeof(*r);
+	int n;
+
+	n = tokenized_log_read(&pos, out, room);
+	r->pos = n > 0 ? pos - n : pos;
+	while (n > 0) {
+		out += n;
+		room -= n;
+		n = tokenized_log_read(&pos, out, room);
+	}
+	r->next = pos;
+	args->response_size = out - (uint8_t *)args->response;
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_CONSOLE_READ_TOKENIZED, console_read_tokenized,
+		     EC_VER_MASK(0));
+
+/*****************************************************************************/
+/* Console commands */
+
+static int command_tlog(int argc, char **argv)
+{
+	uint8_t entry[TOKENIZED_LOG_ENTRY_MAX];
+	char line[160];
+	uint32_t pos = 0;
+
+	if (argc > 1) {
+		if (!strcasecmp(argv[1], "on")) {
+			log_enabled = 1;
+		} else if (!strcasecmp(argv[1], "off")) {
+			log_enabled = 0;
+		} else if (!strcasecmp(argv[1], "clear")) {
+			uint32_t key = irq_lock();
+
+			log_head = log_tail;
+			irq_unlock(key);
+		} else {
+			return EC_ERROR_PARAM1;
+		}
+		return EC_SUCCESS;
+	}
+
+	while (tokenized_log_read(&pos, entry, sizeof(entry)) > 0) {
+		tokenized_log_format(entry, line, sizeof(line));
+		ccputs(line);
+		cflush();
+	}
+
+	return EC_SUCCESS;
+}
+DECLARE_SAFE_CONSOLE_COMMAND(tlog, command_tlog,
+			     "[on | off | clear]",
+			     "Print the tokenized log, or turn it on or off");
@@ -71,61 +71,198 @@ void uart_init_buffer(void)
 	}
 }
 
+#ifndef CONFIG_POLLING_UART
+/*
+ * If we do a READ_RECENT, the buffer may have wrapped around, and we'll drop
+ * most of the logs in this case.  Make sure the place we read from in that
+ * case is always ahead of the new tx_buf_head, by moving a snapshot head which
+ * the characters just written from head onwards have run over.  Stops at
+ * stop, unless that is -1.
+ */
+static int tx_span_move_snapshot(int snapshot, int head, int len, int stop)
+{
+	while (TX_BUF_DIFF(snapshot, head + 1) < len && snapshot != stop)
+		snapshot = TX_BUF_NEXT(snapshot);
+	return snapshot;
+}
+#endif
+
 /**
- * Put a single character into the transmit buffer.
+ * Put a span of characters into the transmit buffer.
  *
- * Does not enable the transmit interrupt; assumes that happens elsewhere.
+ * Copies as many as fit.  Does not enable the transmit interrupt; assumes
+ * that happens elsewhere.  See tx_commit() for locking.
  *
- * @param context	Context; ignored.
- * @param c		Character to write.
- * @return 0 if the character was transmitted, 1 if it was dropped.
+ * @param s		Characters to write
+ * @param len		Number of characters
+ * @return 0 if all were written, 1 if any were dropped.
  */
-static int __tx_char_raw(void *context, int c)
+static int __tx_span_raw(const char *s, int len)
 {
-	int tx_buf_next, tx_buf_new_tail;
-
 #if defined CONFIG_POLLING_UART
-	(void) tx_buf_next;
-	(void) tx_buf_new_tail;
-	uart_write_char(c);
+	int i;
+
+	for (i = 0; i < len; i++)
+		uart_write_char(s[i]);
+	return 0;
 #else
+	int head = tx_buf_head;
+	int n = MIN(len, TX_BUF_DIFF(tx_buf_tail, head + 1));
+	int first = MIN(n, CONFIG_UART_TX_BUF_SIZE - head);
 
-	tx_buf_next = TX_BUF_NEXT(tx_buf_head);
-	if (tx_buf_next == tx_buf_tail)
-		return 1;
+	if (!n)
+		return len > 0;
 
 	/*
-	 * If we do a READ_RECENT, the buffer may have wrapped around, and
-	 * we'll drop most of the logs in this case. Make sure the place
-	 * we read from in that case is always ahead of the new tx_buf_head.
-	 *
 	 * We also want to make sure that the next time we snapshot and want
 	 * to READ_RECENT, we don't start reading from a stale tail.
 	 */
-	tx_buf_new_tail = TX_BUF_NEXT(tx_buf_next);
-	if (tx_buf_next == tx_last_snapshot_head &&
-	    tx_last_snapshot_head != tx_snapshot_head)
-		tx_last_snapshot_head = tx_buf_new_tail;
-	if (tx_buf_next == tx_next_snapshot_head)
-		tx_next_snapshot_head = tx_buf_new_tail;
+	tx_last_snapshot_head = tx_span_move_snapshot(tx_last_snapshot_head,
+						      head, n, tx_snapshot_head);
+	tx_next_snapshot_head = tx_span_move_snapshot(tx_next_snapshot_head,
+						      head, n, -1);
 
-	tx_buf[tx_buf_head] = c;
-	tx_buf_head = tx_buf_next;
+	memcpy((char *)tx_buf + head, s, first);
+	memcpy((char *)tx_buf, s + first, n - first);
+	tx_buf_head = TX_BUF_DIFF(head + n, 0);
 
 	if (IS_ENABLED(CONFIG_PRESERVE_LOGS))
 		tx_checksum = uart_buffer_calc_checksum();
+
+	return n < len;
 #endif
+}
+
+/*
+ * Copy characters into the transmit buffer.  With staging, tasks and
+ * interrupts may all be writing whole lines, so interrupts are locked out for
+ * the copy.
+ */
+static int tx_commit(const char *s, int len)
+{
+#ifdef CONFIG_UART_TX_STAGING
+	uint32_t key = irq_lock();
+	int rv = __tx_span_raw(s, len);
+
+	irq_unlock(key);
+	return rv;
+#else
+	return __tx_span_raw(s, len);
+#endif
+}
+
+#ifdef CONFIG_UART_TX_STAGING
+BUILD_ASSERT(CONFIG_UART_TX_STAGING <= UINT8_MAX);
+
+/* Output from a task, waiting to be copied into the transmit buffer */
+struct tx_staging {
+	uint8_t len;
+	uint8_t hold;	/* Nesting depth of uart_line_begin() */
+	char buf[CONFIG_UART_TX_STAGING];
+};
+
+static struct tx_staging tx_staging[TASK_ID_COUNT];
+
+/* Return the current task's staging buffer, or NULL if it should not stage */
+static struct tx_staging *tx_staging_get(void)
+{
+	task_id_t id;
+
+	if (!task_start_called() || in_interrupt_context())
+		return NULL;
+	id = task_get_current();
+	return id < TASK_ID_COUNT ? &tx_staging[id] : NULL;
+}
+
+static int tx_staging_commit(struct tx_staging *st)
+{
+	int rv = tx_commit(st->buf, st->len);
+
+	st->len = 0;
+	return rv;
+}
+#endif
+
+/**
+ * Write characters to the UART, staging them if the current task does that.
+ *
+ * @return 0 if all were written, 1 if any were dropped.
+ */
+static int tx_write(const char *s, int len)
+{
+#ifdef CONFIG_UART_TX_STAGING
+	struct tx_staging *st = tx_staging_get();
+	int n, rv = 0;
+
+	if (st) {
+		while (len > 0) {
+			n = MIN(len, sizeof(st->buf) - st->len);
+			memcpy(st->buf + st->len, s, n);
+			st->len += n;
+			s += n;
+			len -= n;
+			/* Too long to keep together, so send what we have */
+			if (st->len == sizeof(st->buf))
+				rv |= tx_staging_commit(st);
+		}
+		return rv;
+	}
+#endif
+	return tx_commit(s, len);
+}
+
+/**
+ * Finish an output call: send the current task's staged output, unless it is
+ * being held for uart_line_end(), and start transmitting.
+ *
+ * @return 0 if all output was written, 1 if any was dropped.
+ */
+static int tx_finish(void)
+{
+	int rv = 0;
+#ifdef CONFIG_UART_TX_STAGING
+	struct tx_staging *st = tx_staging_get();
+
+	if (st && !st->hold && st->len)
+		rv = tx_staging_commit(st);
+#endif
+	uart_tx_start();
+	return rv;
+}
+
+/* Write characters to the UART, translating '\n' to '\r\n' */
+static int __tx_span(void *context, const char *s, int len)
+{
+	const char *nl;
+	int n;
+
+	while (len > 0) {
+		nl = memchr(s, '\n', len);
+		n = nl ? nl - s : len;
+		if (tx_write(s, n))
+			return 1;
+		if (!nl)
+			break;
+		if (tx_write("\r\n", 2))
+			return 1;
+		s += n + 1;
+		len -= n + 1;
+	}
 	return 0;
 }
 
 static int __tx_char(void *context, int c)
 {
-	/* Translate '\n' to '\r\n' */
-	if (c == '\n' && __tx_char_raw(NULL, '\r'))
-		return 1;
-	return __tx_char_raw(context, c);
+	char ch = c;
+
+	return __tx_span(context, &ch, 1);
 }
 
+static const struct printf_sink tx_sink = {
+	.addchar = __tx_char,
+	.addspan = __tx_span,
+};
+
 #ifdef CONFIG_UART_TX_DMA
 
 /**
@@ -269,7 +406,7 @@ int uart_putc(int c)
 {
 	int rv = __tx_char(NULL, c);
 
-	uart_tx_start();
+	rv |= tx_finish();
 
 	return rv ? EC_ERROR_OVERFLOW : EC_SUCCESS;
 }
@@ -277,50 +414,42 @@ int uart_putc(int c)
 int uart_puts(const char *outstr)
 {
 	/* Put all characters in the output buffer */
-	while (*outstr) {
-		if (__tx_char(NULL, *outstr++) != 0)
-			break;
-	}
+	int rv = __tx_span(NULL, outstr, strlen(outstr));
 
-	uart_tx_start();
+	rv |= tx_finish();
 
 	/* Successful if we consumed all output */
-	return *outstr ? EC_ERROR_OVERFLOW : EC_SUCCESS;
+	return rv ? EC_ERROR_OVERFLOW : EC_SUCCESS;
 }
 
 int uart_put(const char *out, int len)
 {
 	/* Put all characters in the output buffer */
-	while (len--) {
-		if (__tx_char(NULL, *out++) != 0)
-			break;
-	}
+	int rv = __tx_span(NULL, out, len);
 
-	uart_tx_start();
+	rv |= tx_finish();
 
 	/* Successful if we consumed all output */
-	return len ? EC_ERROR_OVERFLOW : EC_SUCCESS;
+	return rv ? EC_ERROR_OVERFLOW : EC_SUCCESS;
 }
 
 int uart_put_raw(const char *out, int len)
 {
 	/* Put all characters in the output buffer */
-	while (len--) {
-		if (__tx_char_raw(NULL, *out++) != 0)
-			break;
-	}
+	int rv = tx_write(out, len);
 
-	uart_tx_start();
+	rv |= tx_finish();
 
 	/* Successful if we consumed all output */
-	return len ? EC_ERROR_OVERFLOW : EC_SUCCESS;
+	return rv ? EC_ERROR_OVERFLOW : EC_SUCCESS;
 }
 
 int uart_vprintf(const char *format, va_list args)
 {
-	int rv = vfnprintf(__tx_char, NULL, format, args);
+	int rv = vfnprintf_sink(&tx_sink, NULL, format, args);
 
-	uart_tx_start();
+	if (tx_finish())
+		rv = EC_ERROR_OVERFLOW;
 
 	return rv;
 }
@@ -336,8 +465,35 @@ int uart_printf(const char *format, ...)
 	return rv;
 }
 
+#ifdef CONFIG_UART_TX_STAGING
+void uart_line_begin(void)
+{
+	struct tx_staging *st = tx_staging_get();
+
+	if (st)
+		st->hold++;
+}
+
+int uart_line_end(void)
+{
+	struct tx_staging *st = tx_staging_get();
+
+	if (!st || !st->hold || --st->hold)
+		return EC_SUCCESS;
+	return tx_finish() ? EC_ERROR_OVERFLOW : EC_SUCCESS;
+}
+#endif
+
 void uart_flush_output(void)
 {
+#ifdef CONFIG_UART_TX_STAGING
+	struct tx_staging *st = tx_staging_get();
+
+	/* Send anything the current task has staged, even if held */
+	if (st && st->len)
+		tx_staging_commit(st);
+#endif
+
 	/* If UART not initialized ignore flush request. */
 	if (!uart_init_done())
 		return;
@@ -373,7 +529,7 @@ int uart_getc(void)
 {
 	/* Look for a non-flow-control character */
 	while (rx_buf_tail != rx_buf_head) {
-		int c = rx_buf[rx_buf_tail];
+		int c = (unsigned char)rx_buf[rx_buf_tail];
 		rx_buf_tail = RX_BUF_NEXT(rx_buf_tail);
 
 		return c;
@@ -13,6 +13,7 @@
 #include "task.h"
 #include "timer.h"
 #include "usb-stream.h"
+#include "util.h"
 
 #ifdef CONFIG_USB_CONSOLE
 /*
@@ -139,29 +140,68 @@ uint32_t usb_console_crc(void)
 }
 #endif
 
-static int __tx_char(void *context, int c)
+static void tx_put(struct queue_sg const *sg, size_t i, char c)
 {
-	int ret;
-
-	if (c == '\n') {
-		ret = __tx_char(NULL, '\r');
-		if (ret)
-			return ret;
-	}
-
+	*(char *)queue_sg_unit(&tx_q, sg, i) = c;
 #ifdef CONFIG_USB_CONSOLE_CRC
 	crc32_ctx_hash8(&usb_tx_crc_ctx, c);
+#endif
+}
 
-	while (queue_add_unit(&tx_q, &c) != 1)
-		usleep(500);
+/*
+ * Write characters straight into the Tx queue, translating '\n' to '\r\n'.
+ * Each run is committed at once, so the queue is only updated once per run
+ * instead of once per character.
+ */
+static int __tx_span(void *context, const char *s, int len)
+{
+	struct queue_sg sg;
+	const char *end = s + len;
+	const char *p;
+	size_t need = len;
+	size_t n;
+
+	for (p = s; (p = memchr(p, '\n', end - p)) != NULL; p++)
+		need++;
+
+	while (s < end) {
+		sg = queue_reserve_write(&tx_q, need);
+		n = 0;
+
+		/* Only commit whole characters; '\r\n' may span the wrap */
+		while (s < end && n + (*s == '\n' ? 2 : 1) <= sg.count) {
+			if (*s == '\n')
+				tx_put(&sg, n++, '\r');
+			tx_put(&sg, n++, *s++);
+		}
+		queue_advance_tail(&tx_q, n);
+		need -= n;
 
-	return EC_SUCCESS;
+		if (s == end)
+			break;
+#ifdef CONFIG_USB_CONSOLE_CRC
+		/* Wait for room rather than corrupt the checksummed output */
+		usleep(500);
 #else
-	/* Return 0 on success */
-	return queue_add_unit(&tx_q, &c) ? EC_SUCCESS : EC_ERROR_OVERFLOW;
+		return EC_ERROR_OVERFLOW;
 #endif
+	}
+
+	return EC_SUCCESS;
+}
+
+static int __tx_char(void *context, int c)
+{
+	char ch = c;
+
+	return __tx_span(context, &ch, 1);
 }
 
+static const struct printf_sink tx_sink = {
+	.addchar = __tx_char,
+	.addspan = __tx_span,
+};
+
 /*
  * Public USB console implementation below.
  */
@@ -189,11 +229,7 @@ int usb_puts(const char *outstr)
 	if (ret)
 		return ret;
 
-	while (*outstr) {
-		ret = __tx_char(NULL, *outstr++);
-		if (ret)
-			break;
-	}
+	ret = __tx_span(NULL, outstr, strlen(outstr));
 	handle_output();
 
 	return ret;
@@ -219,7 +255,7 @@ int usb_vprintf(const char *format, va_list args)
 	if (ret)
 		return ret;
 
-	ret = vfnprintf(__tx_char, NULL, format, args);
+	ret = vfnprintf_sink(&tx_sink, NULL, format, args);
 
 	handle_output();
 
@@ -9,6 +9,7 @@ _usbc_dir:=$(dir $(lastword $(MAKEFILE_LIST)))
 
 ifneq ($(CONFIG_USB_PD_TCPMV2),)
 all-obj-y+=$(_usbc_dir)usb_sm.o
+all-obj-y+=$(_usbc_dir)usb_pd_timer.o
 all-obj-y+=$(_usbc_dir)usbc_task.o
 
 # Type-C state machines
@@ -21,6 +22,7 @@ endif # CONFIG_USB_TYPEC_SM
 # Protocol state machine
 ifneq ($(CONFIG_USB_PRL_SM),)
 all-obj-y+=$(_usbc_dir)usb_prl_sm.o
+all-obj-$(CONFIG_USB_PD_TRACE)+=$(_usbc_dir)usb_pd_trace.o
 endif # CONFIG_USB_PRL_SM
 
 # Policy Engine state machines
@@ -40,4 +42,6 @@ endif # CONFIG_USB_PD_TCPMV2
 
 # For testing
 all-obj-$(CONFIG_TEST_USB_PE_SM)+=$(_usbc_dir)usb_pe_drp_sm.o
+all-obj-$(CONFIG_TEST_USB_PE_SM)+=$(_usbc_dir)usb_pd_timer.o
 all-obj-$(CONFIG_TEST_SM)+=$(_usbc_dir)usb_sm.o
+all-obj-$(CONFIG_TEST_USB_PD_TIMER)+=$(_usbc_dir)usb_pd_timer.o
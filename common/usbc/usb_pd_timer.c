@@ -0,0 +1,110 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* USB PD per-port timer service */
+
+#include "common.h"
+#include "timer.h"
+#include "usb_pd_timer.h"
+#include "util.h"
+
+/* A deadline no running timer can have */
+#define NO_DEADLINE UINT64_MAX
+
+BUILD_ASSERT(PD_TIMER_COUNT <= 32);
+
+/*
+ * Only the port's PD task uses its timers, so they need no locking.  Timers
+ * which are neither running nor disabled have expired.
+ */
+static struct pd_timers {
+	uint64_t deadline[PD_TIMER_COUNT];
+	uint32_t running;
+	uint32_t disabled;
+	/*
+	 * The earliest deadline of the running timers, or earlier if that
+	 * timer has since been stopped.  Once it passes the running timers
+	 * are checked, and it's brought up to date.
+	 */
+	uint64_t next;
+} timers[CONFIG_USB_PD_PORT_MAX_COUNT];
+
+void pd_timer_init(int port)
+{
+	struct pd_timers *t = &timers[port];
+
+	t->running = 0;
+	t->disabled = 0;
+	t->next = NO_DEADLINE;
+}
+
+void pd_timer_enable(int port, enum pd_task_timer timer, uint32_t expires_us)
+{
+	struct pd_timers *t = &timers[port];
+	uint64_t deadline = get_time().val + expires_us;
+
+	t->disabled &= ~BIT(timer);
+	if (!expires_us) {
+		t->running &= ~BIT(timer);
+		return;
+	}
+
+	t->deadline[timer] = deadline;
+	t->running |= BIT(timer);
+	t->next = MIN(t->next, deadline);
+}
+
+void pd_timer_disable(int port, enum pd_task_timer timer)
+{
+	struct pd_timers *t = &timers[port];
+
+	t->running &= ~BIT(timer);
+	t->disabled |= BIT(timer);
+}
+
+bool pd_timer_is_disabled(int port, enum pd_task_timer timer)
+{
+	return !!(timers[port].disabled & BIT(timer));
+}
+
+bool pd_timer_is_expired(int port, enum pd_task_timer timer)
+{
+	struct pd_timers *t = &timers[port];
+
+	if (t->disabled & BIT(timer))
+		return false;
+
+	if (t->running & BIT(timer)) {
+		if (get_time().val < t->deadline[timer])
+			return false;
+		t->running &= ~BIT(timer);
+	}
+
+	return true;
+}
+
+int pd_timer_next_expiration(int port)
+{
+	struct pd_timers *t = &timers[port];
+	uint64_t now = get_time().val;
+	uint32_t running;
+	int timer;
+
+	if (now >= t->next) {
+		t->next = NO_DEADLINE;
+		for (running = t->running; running; running &= ~BIT(timer)) {
+			timer = __fls(running);
+			if (t->deadline[timer] <= now)
+				t->running &= ~BIT(timer);
+			else
+				t->next = MIN(t->next, t->deadline[timer]);
+		}
+	}
+
+	if (t->next == NO_DEADLINE)
+		return -1;
+
+	return MIN(t->next - now, INT32_MAX);
+}
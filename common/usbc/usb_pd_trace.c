@@ -0,0 +1,202 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* USB PD message trace */
+
+#include "atomic.h"
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+#include "host_command.h"
+#include "timer.h"
+#include "usb_pd.h"
+#include "usb_pd_trace.h"
+#include "util.h"
+
+BUILD_ASSERT(POWER_OF_TWO(CONFIG_USB_PD_TRACE));
+BUILD_ASSERT(sizeof(struct ec_pd_trace_record) == 40);
+
+static struct pd_trace {
+	/*
+	 * Sequence number of the next record to write.  Record n is in
+	 * records[n % CONFIG_USB_PD_TRACE] until record n + CONFIG_USB_PD_TRACE
+	 * starts being written over it, which is while head still equals
+	 * n + CONFIG_USB_PD_TRACE.
+	 */
+	atomic_t head;
+	/* Message passed to the TCPC, waiting for the result */
+	struct ec_pd_trace_record tx;
+	struct ec_pd_trace_record records[CONFIG_USB_PD_TRACE];
+} trace[CONFIG_USB_PD_PORT_MAX_COUNT];
+
+/* Read the head, with a barrier to order it with copying records out */
+static uint32_t trace_head(struct pd_trace *t)
+{
+	return atomic_add(&t->head, 0);
+}
+
+/* The oldest record which can't be in the middle of being overwritten */
+static uint32_t trace_oldest(uint32_t head)
+{
+	return head >= CONFIG_USB_PD_TRACE ? head - CONFIG_USB_PD_TRACE + 1 : 0;
+}
+
+static void trace_fill(struct ec_pd_trace_record *r,
+		       enum tcpm_transmit_type type, uint16_t header,
+		       const uint32_t *data)
+{
+	const uint64_t now = get_time().val;
+	const int cnt = PD_HEADER_CNT(header);
+	int i;
+
+	r->time_lo = (uint32_t)now;
+	r->time_hi = (uint32_t)(now >> 32);
+	r->header = header;
+	r->sop = type;
+	for (i = 0; i < ARRAY_SIZE(r->data); i++)
+		r->data[i] = i < cnt ? data[i] : 0;
+}
+
+static void trace_write(struct pd_trace *t, const struct ec_pd_trace_record *r)
+{
+	t->records[t->head & (CONFIG_USB_PD_TRACE - 1)] = *r;
+
+	/* Publish the record once it's complete */
+	atomic_add(&t->head, 1);
+}
+
+void pd_trace_rx(int port, enum tcpm_transmit_type type, uint16_t header,
+		 const uint32_t *data)
+{
+	struct ec_pd_trace_record r;
+
+	trace_fill(&r, type, header, data);
+	r.event = EC_PD_TRACE_RX;
+	trace_write(&trace[port], &r);
+}
+
+void pd_trace_tx(int port, enum tcpm_transmit_type type, uint16_t header,
+		 const uint32_t *data)
+{
+	trace_fill(&trace[port].tx, type, header, data);
+}
+
+void pd_trace_tx_done(int port, enum ec_pd_trace_event event)
+{
+	trace[port].tx.event = event;
+	trace_write(&trace[port], &trace[port].tx);
+}
+
+int pd_trace_read(int port, uint32_t *seq, struct ec_pd_trace_record *records,
+		  int max)
+{
+	struct pd_trace *t = &trace[port];
+	uint32_t head = trace_head(t);
+	uint32_t oldest = trace_oldest(head);
+	uint32_t first = *seq;
+	int count, lost, i;
+
+	/* Skip records which have been overwritten, or never written */
+	if (first - oldest > head - oldest)
+		first = oldest;
+
+	count = MIN(head - first, max);
+	for (i = 0; i < count; i++)
+		records[i] =
+			t->records[(first + i) & (CONFIG_USB_PD_TRACE - 1)];
+
+	/*
+	 * Drop the records which the port's task may have overwritten while
+	 * they were being copied.
+	 */
+	oldest = trace_oldest(trace_head(t));
+	lost = (int)(oldest - first) > 0 ? MIN(oldest - first, count) : 0;
+	if (lost) {
+		count -= lost;
+		memmove(records, records + lost, count * sizeof(records[0]));
+		first += lost;
+	}
+
+	*seq = first;
+	return count;
+}
+
+/*****************************************************************************/
+/* Host commands */
+
+static enum ec_status pd_trace_hc(struct host_cmd_handler_args *args)
+{
+	const struct ec_params_pd_trace *p = args->params;
+	struct ec_response_pd_trace *r = args->response;
+	uint32_t seq = p->seq;
+	int room = (args->response_max - sizeof(*r)) / sizeof(r->records[0]);
+
+	if (p->port >= board_get_usb_pd_port_count())
+		return EC_RES_INVALID_PARAM;
+
+	r->count = pd_trace_read(p->port, &seq, r->records,
+				 MIN(room, UINT8_MAX));
+	r->first_seq = seq;
+	r->next_seq = seq + r->count;
+	memset(r->reserved, 0, sizeof(r->reserved));
+	args->response_size = sizeof(*r) + r->count * sizeof(r->records[0]);
+
+	return EC_RES_SUCCESS;
+}
+DECLARE_HOST_COMMAND(EC_CMD_PD_TRACE, pd_trace_hc, EC_VER_MASK(0));
+
+/*****************************************************************************/
+/* Console commands */
+
+static int command_pdtrace(int argc, char **argv)
+{
+	static const char * const events[] = {
+		[EC_PD_TRACE_RX] = "RX",
+		[EC_PD_TRACE_TX_SUCCESS] = "TX",
+		[EC_PD_TRACE_TX_DISCARDED] = "TX discarded",
+		[EC_PD_TRACE_TX_FAILED] = "TX failed",
+		[EC_PD_TRACE_TX_TIMEOUT] = "TX timeout",
+	};
+	static const char * const types[] = {
+		[TCPC_TX_SOP] = "SOP",
+		[TCPC_TX_SOP_PRIME] = "SOP'",
+		[TCPC_TX_SOP_PRIME_PRIME] = "SOP''",
+		[TCPC_TX_SOP_DEBUG_PRIME] = "DBG'",
+		[TCPC_TX_SOP_DEBUG_PRIME_PRIME] = "DBG''",
+		[TCPC_TX_HARD_RESET] = "HRST",
+		[TCPC_TX_CABLE_RESET] = "CRST",
+		[TCPC_TX_BIST_MODE_2] = "BIST",
+	};
+	struct ec_pd_trace_record r;
+	uint32_t seq = 0;
+	char *e;
+	int port;
+	int i;
+
+	if (argc != 2)
+		return EC_ERROR_PARAM_COUNT;
+
+	port = strtoi(argv[1], &e, 0);
+	if (*e || port < 0 || port >= board_get_usb_pd_port_count())
+		return EC_ERROR_PARAM1;
+
+	while (pd_trace_read(port, &seq, &r, 1)) {
+		ccprintf("%5d %11lld %-5s %04x %-12s", seq,
+			 (long long)r.time_hi << 32 | r.time_lo,
+			 r.sop < ARRAY_SIZE(types) ? types[r.sop] : "?",
+			 r.header,
+			 r.event < ARRAY_SIZE(events) ? events[r.event] : "?");
+		for (i = 0; i < PD_HEADER_CNT(r.header); i++)
+			ccprintf(" %08x", r.data[i]);
+		ccprintf("\n");
+		cflush();
+		seq++;
+	}
+
+	return EC_SUCCESS;
+}
+DECLARE_SAFE_CONSOLE_COMMAND(pdtrace, command_pdtrace,
+			     "port",
+			     "Print a port's USB PD message trace");
@@ -23,6 +23,7 @@
 #include "usb_pd_dpm.h"
 #include "usb_pd.h"
 #include "usb_pd_tcpm.h"
+#include "usb_pd_timer.h"
 #include "usb_pe_sm.h"
 #include "usb_tbt_alt_mode.h"
 #include "usb_prl_sm.h"
@@ -227,8 +228,6 @@
  */
 #define N_DR_SWAP_ATTEMPT_COUNT 5
 
-#define TIMER_DISABLED 0xffffffffffffffff /* Unreachable time in future */
-
 /*
  * The time that we allow the port partner to send any messages after an
  * explicit contract is established.  200ms was chosen somewhat arbitrarily as
@@ -561,8 +560,6 @@ static struct policy_engine {
 	/* Device Policy Manager Request */
 	uint32_t dpm_request;
 	uint32_t dpm_curr_request;
-	/* state timeout timer */
-	uint64_t timeout;
 	/* last requested voltage PDO index */
 	int requested_idx;
 
@@ -598,123 +595,6 @@ static struct policy_engine {
 	uint32_t vdm_data[VDO_HDR_SIZE + VDO_MAX_SIZE];
 	uint8_t vdm_ack_min_data_objects;
 
-	/* Timers */
-
-	/*
-	 * The NoResponseTimer is used by the Policy Engine in a Source
-	 * to determine that its Port Partner is not responding after a
-	 * Hard Reset.
-	 */
-	uint64_t no_response_timer;
-
-	/*
-	 * Prior to a successful negotiation, a Source Shall use the
-	 * SourceCapabilityTimer to periodically send out a
-	 * Source_Capabilities Message.
-	 */
-	uint64_t source_cap_timer;
-
-	/*
-	 * This timer is started when a request for a new Capability has been
-	 * accepted and will timeout after PD_T_PS_TRANSITION if a PS_RDY
-	 * Message has not been received.
-	 */
-	uint64_t ps_transition_timer;
-
-	/*
-	 * This timer is used to ensure that a Message requesting a response
-	 * (e.g. Get_Source_Cap Message) is responded to within a bounded time
-	 * of PD_T_SENDER_RESPONSE.
-	 */
-	uint64_t sender_response_timer;
-
-	/*
-	 * This timer is used during an Explicit Contract when discovering
-	 * whether a Port Partner is PD Capable using SOP'.
-	 */
-	uint64_t discover_identity_timer;
-
-	/*
-	 * This timer is used in a Source to ensure that the Sink has had
-	 * sufficient time to process Hard Reset Signaling before turning
-	 * off its power supply to VBUS.
-	 */
-	uint64_t ps_hard_reset_timer;
-
-	/*
-	 * This timer is used to ensure that the time before the next Sink
-	 * Request Message, after a Wait Message has been received from the
-	 * Source in response to a Sink Request Message.
-	 */
-	uint64_t sink_request_timer;
-
-	/*
-	 * This timer tracks the time after receiving a Wait message in response
-	 * to a PR_Swap message.
-	 */
-	uint64_t pr_swap_wait_timer;
-
-	/*
-	 * This timer combines the PSSourceOffTimer and PSSourceOnTimer timers.
-	 * For PSSourceOffTimer, when this DRP device is currently acting as a
-	 * Sink, this timer times out on a PS_RDY Message during a Power Role
-	 * Swap sequence.
-	 *
-	 * For PSSourceOnTimer, when this DRP device is currently acting as a
-	 * Source that has just stopped sourcing power and is waiting to start
-	 * sinking power to timeout on a PS_RDY Message during a Power Role
-	 * Swap.
-	 */
-	uint64_t ps_source_timer;
-
-	/*
-	 * In BIST_TX mode, this timer is used by a UUT to ensure that a
-	 * Continuous BIST Mode (i.e. BIST Carrier Mode) is exited in a timely
-	 * fashion.
-	 *
-	 * In BIST_RX mode, this timer is used to give the port partner time
-	 * to respond.
-	 */
-	uint64_t bist_cont_mode_timer;
-	/*
-	 * This timer is used by the new Source, after a Power Role Swap or
-	 * Fast Role Swap, to ensure that it does not send Source_Capabilities
-	 * Message before the new Sink is ready to receive the
-	 * Source_Capabilities Message.
-	 */
-	uint64_t swap_source_start_timer;
-
-	/*
-	 * This timer is used by the Initiator’s Policy Engine to ensure that
-	 * a Structured VDM Command request needing a response (e.g. Discover
-	 * Identity Command request) is responded to within a bounded time of
-	 * tVDMSenderResponse.
-	 */
-	uint64_t vdm_response_timer;
-
-	/*
-	 * This timer is used during a VCONN Swap.
-	 */
-	uint64_t vconn_on_timer;
-
-	/*
-	 * For PD2.0, this timer is used to wait 400ms and add some
-	 * jitter of up to 100ms before sending a message.
-	 * NOTE: This timer is not part of the TypeC/PD spec.
-	 */
-	uint64_t wait_and_add_jitter_timer;
-
-	/*
-	 * PD 3.0, version 2.0, section 6.6.18.1: The ChunkingNotSupportedTimer
-	 * is used by a Source or Sink which does not support multi-chunk
-	 * Chunking but has received a Message Chunk. The
-	 * ChunkingNotSupportedTimer Shall be started when the last bit of the
-	 * EOP of a Message Chunk of a multi-chunk Message is received. The
-	 * Policy Engine Shall Not send its Not_Supported Message before the
-	 * ChunkingNotSupportedTimer expires.
-	 */
-	uint64_t chunking_not_supported_timer;
-
 	/* Counters */
 
 	/*
@@ -844,8 +724,8 @@ static void pe_init(int port)
 	pe[port].flags = 0;
 	pe[port].dpm_request = 0;
 	pe[port].dpm_curr_request = 0;
-	pe[port].source_cap_timer = TIMER_DISABLED;
-	pe[port].no_response_timer = TIMER_DISABLED;
+	pd_timer_disable(port, PE_TIMER_SOURCE_CAP);
+	pd_timer_disable(port, PE_TIMER_NO_RESPONSE);
 	pe[port].data_role = pd_get_data_role(port);
 	pe[port].tx_type = TCPC_TX_INVALID;
 	pe[port].events = 0;
@@ -927,7 +807,7 @@ void pe_message_received(int port)
 	assert(port == TASK_ID_TO_PD_PORT(task_get_current()));
 
 	PE_SET_FLAG(port, PE_FLAGS_MSG_RECEIVED);
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 void pe_hard_reset_sent(int port)
@@ -967,7 +847,7 @@ void pe_got_hard_reset(int port)
 void pd_got_frs_signal(int port)
 {
 	PE_SET_FLAG(port, PE_FLAGS_FAST_ROLE_SWAP_SIGNALED);
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 /*
@@ -1255,7 +1135,7 @@ void pe_report_error(int port, enum pe_error e, enum tcpm_transmit_type type)
 				get_state_pe(port) == PE_VCS_SEND_PS_RDY_SWAP)
 			) {
 		PE_SET_FLAG(port, PE_FLAGS_PROTOCOL_ERROR);
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 		return;
 	}
 
@@ -1382,7 +1262,7 @@ void pe_message_sent(int port)
 	assert(port == TASK_ID_TO_PD_PORT(task_get_current()));
 
 	PE_SET_FLAG(port, PE_FLAGS_TX_COMPLETE);
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 void pd_send_vdm(int port, uint32_t vid, int cmd, const uint32_t *data,
@@ -1399,7 +1279,7 @@ void pd_send_vdm(int port, uint32_t vid, int cmd, const uint32_t *data,
 
 	pe[port].vdm_cnt = count + 1;
 
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 static void pe_handle_detach(void)
@@ -1500,8 +1380,8 @@ static bool common_src_snk_dpm_requests(int port)
 			pd_dfp_discovery_init(port);
 			pe[port].dr_swap_attempt_counter = 0;
 			pe[port].discover_identity_counter = 0;
-			pe[port].discover_identity_timer = get_time().val +
-						PD_T_DISCOVER_IDENTITY;
+			pd_timer_enable(port, PE_TIMER_DISCOVER_IDENTITY,
+					PD_T_DISCOVER_IDENTITY);
 		}
 		return true;
 	} else if (PE_CHK_DPM_REQUEST(port, DPM_REQUEST_VDM)) {
@@ -1692,7 +1572,7 @@ __maybe_unused static bool pe_attempt_port_discovery(int port)
 
 	/* If mode entry was successful, disable the timer */
 	if (PE_CHK_FLAG(port, PE_FLAGS_VDM_SETUP_DONE)) {
-		pe[port].discover_identity_timer = TIMER_DISABLED;
+		pd_timer_disable(port, PE_TIMER_DISCOVER_IDENTITY);
 		return false;
 	}
 
@@ -1700,7 +1580,7 @@ __maybe_unused static bool pe_attempt_port_discovery(int port)
 	 * Run discovery functions when the timer indicating either cable
 	 * discovery spacing or BUSY spacing runs out.
 	 */
-	if (get_time().val > pe[port].discover_identity_timer) {
+	if (pd_timer_is_expired(port, PE_TIMER_DISCOVER_IDENTITY)) {
 		if (pd_get_identity_discovery(port, TCPC_TX_SOP_PRIME) ==
 				PD_DISC_NEEDED) {
 			pe[port].tx_type = TCPC_TX_SOP_PRIME;
@@ -1813,9 +1693,9 @@ static void pe_update_wait_and_add_jitter_timer(int port)
 	 */
 	if (prl_get_rev(port, TCPC_TX_SOP) == PD_REV20 &&
 			PE_CHK_FLAG(port, PE_FLAGS_FIRST_MSG)) {
-		pe[port].wait_and_add_jitter_timer = get_time().val +
+		pd_timer_enable(port, PE_TIMER_WAIT_AND_ADD_JITTER,
 				SRC_SNK_READY_HOLD_OFF_US +
-				(get_time().le.lo & 0xf) * 23 * MSEC;
+				(get_time().le.lo & 0xf) * 23 * MSEC);
 	}
 }
 
@@ -1835,7 +1715,7 @@ static void pe_update_wait_and_add_jitter_timer(int port)
 static void pe_sender_response_msg_entry(const int port)
 {
 	/* Stop sender response timer */
-	pe[port].sender_response_timer = TIMER_DISABLED;
+	pd_timer_disable(port, PE_TIMER_SENDER_RESPONSE);
 }
 
 /*
@@ -1858,7 +1738,7 @@ static void pe_sender_response_msg_entry(const int port)
  */
 static enum pe_msg_check pe_sender_response_msg_run(const int port)
 {
-	if (pe[port].sender_response_timer == TIMER_DISABLED) {
+	if (pd_timer_is_disabled(port, PE_TIMER_SENDER_RESPONSE)) {
 		/* Check for Discard */
 		if (PE_CHK_FLAG(port, PE_FLAGS_MSG_DISCARDED)) {
 			int dpm_request = pe[port].dpm_curr_request;
@@ -1877,8 +1757,8 @@ static enum pe_msg_check pe_sender_response_msg_run(const int port)
 			PE_CLR_FLAG(port, PE_FLAGS_TX_COMPLETE);
 
 			/* Initialize and run the SenderResponseTimer */
-			pe[port].sender_response_timer = get_time().val +
-							PD_T_SENDER_RESPONSE;
+			pd_timer_enable(port, PE_TIMER_SENDER_RESPONSE,
+					PD_T_SENDER_RESPONSE);
 			return PE_MSG_SEND_COMPLETED;
 		}
 		return PE_MSG_SEND_PENDING;
@@ -1912,22 +1792,22 @@ static void pe_src_startup_entry(int port)
 		PE_CLR_FLAG(port, PE_FLAGS_PR_SWAP_COMPLETE);
 
 		/* Start SwapSourceStartTimer */
-		pe[port].swap_source_start_timer = get_time().val +
-			PD_T_SWAP_SOURCE_START;
+		pd_timer_enable(port, PE_TIMER_SWAP_SOURCE_START,
+				PD_T_SWAP_SOURCE_START);
 	} else {
 		/*
 		 * SwapSourceStartTimer delay is not needed, so trigger now.
 		 * We can't use set_state_pe here, since we need to ensure that
 		 * the protocol layer is running again (done in run function).
 		 */
-		pe[port].swap_source_start_timer = get_time().val;
+		pd_timer_enable(port, PE_TIMER_SWAP_SOURCE_START, 0);
 
 		/*
 		 * Set DiscoverIdentityTimer to trigger when we enter
 		 * src_discovery for the first time.  After initial startup
 		 * set, vdm_identity_request_cbl will handle the timer updates.
 		 */
-		pe[port].discover_identity_timer = get_time().val;
+		pd_timer_enable(port, PE_TIMER_DISCOVER_IDENTITY, 0);
 
 		/* Clear port discovery flags */
 		pd_dfp_discovery_init(port);
@@ -1952,7 +1832,7 @@ static void pe_src_startup_run(int port)
 	if (!prl_is_running(port))
 		return;
 
-	if (get_time().val > pe[port].swap_source_start_timer)
+	if (pd_timer_is_expired(port, PE_TIMER_SWAP_SOURCE_START))
 		set_state_pe(port, PE_SRC_SEND_CAPABILITIES);
 }
 
@@ -1975,8 +1855,8 @@ static void pe_src_discovery_entry(int port)
 	 * is in place.  All other probing must happen from ready states.
 	 */
 	if (get_last_state_pe(port) != PE_VDM_IDENTITY_REQUEST_CBL)
-		pe[port].source_cap_timer =
-				get_time().val + PD_T_SEND_SOURCE_CAP;
+		pd_timer_enable(port, PE_TIMER_SOURCE_CAP,
+				PD_T_SEND_SOURCE_CAP);
 }
 
 static void pe_src_discovery_run(int port)
@@ -1995,7 +1875,7 @@ static void pe_src_discovery_run(int port)
 	 *   1) DPM requests the identity of the cable plug and
 	 *   2) DiscoverIdentityCounter < nDiscoverIdentityCount
 	 */
-	if (get_time().val > pe[port].source_cap_timer) {
+	if (pd_timer_is_expired(port, PE_TIMER_SOURCE_CAP)) {
 		if (pe[port].caps_counter <= N_CAPS_COUNT) {
 			set_state_pe(port, PE_SRC_SEND_CAPABILITIES);
 			return;
@@ -2011,7 +1891,7 @@ static void pe_src_discovery_run(int port)
 	 * requests properly.
 	 */
 	if (pd_get_identity_discovery(port, TCPC_TX_SOP_PRIME) == PD_DISC_NEEDED
-			&& get_time().val > pe[port].discover_identity_timer
+			&& pd_timer_is_expired(port, PE_TIMER_DISCOVER_IDENTITY)
 			&& pe_can_send_sop_prime(port)
 			&& (pe[port].discover_identity_counter <
 				N_DISCOVER_IDENTITY_PRECONTRACT_LIMIT)) {
@@ -2027,7 +1907,7 @@ static void pe_src_discovery_run(int port)
 	 *   3) And the HardResetCounter > nHardResetCount.
 	 */
 	if (!PE_CHK_FLAG(port, PE_FLAGS_PD_CONNECTION) &&
-			get_time().val > pe[port].no_response_timer &&
+			pd_timer_is_expired(port, PE_TIMER_NO_RESPONSE) &&
 			pe[port].hard_reset_counter > N_HARD_RESET_COUNT) {
 		set_state_pe(port, PE_SRC_DISABLED);
 		return;
@@ -2083,7 +1963,7 @@ static void pe_src_send_capabilities_run(int port)
 		 *  3) Initialize and run the SenderResponseTimer.
 		 */
 		/* Stop the NoResponseTimer */
-		pe[port].no_response_timer = TIMER_DISABLED;
+		pd_timer_disable(port, PE_TIMER_NO_RESPONSE);
 
 		/* Reset the HardResetCounter to zero */
 		pe[port].hard_reset_counter = 0;
@@ -2177,7 +2057,7 @@ static void pe_src_send_capabilities_run(int port)
 	 *  2) The NoResponseTimer times out
 	 *  3) And the HardResetCounter > nHardResetCount.
 	 */
-	if (get_time().val > pe[port].no_response_timer) {
+	if (pd_timer_is_expired(port, PE_TIMER_NO_RESPONSE)) {
 		if (pe[port].hard_reset_counter <= N_HARD_RESET_COUNT)
 			set_state_pe(port, PE_SRC_HARD_RESET);
 		else if (PE_CHK_FLAG(port, PE_FLAGS_PD_CONNECTION))
@@ -2191,7 +2071,7 @@ static void pe_src_send_capabilities_run(int port)
 	 * Transition to the PE_SRC_Hard_Reset state when:
 	 *  1) The SenderResponseTimer times out.
 	 */
-	if (get_time().val > pe[port].sender_response_timer) {
+	if (pd_timer_is_expired(port, PE_TIMER_SENDER_RESPONSE)) {
 		set_state_pe(port, PE_SRC_HARD_RESET);
 		return;
 	}
@@ -2510,16 +2390,16 @@ static void pe_src_ready_run(int port)
 	}
 
 	if (PE_CHK_FLAG(port, PE_FLAGS_WAITING_PR_SWAP) &&
-		get_time().val > pe[port].pr_swap_wait_timer) {
+		pd_timer_is_expired(port, PE_TIMER_PR_SWAP_WAIT)) {
 		PE_CLR_FLAG(port, PE_FLAGS_WAITING_PR_SWAP);
 		PE_SET_DPM_REQUEST(port, DPM_REQUEST_PR_SWAP);
 	}
 
-	if (pe[port].wait_and_add_jitter_timer == TIMER_DISABLED ||
-		get_time().val > pe[port].wait_and_add_jitter_timer) {
+	if (pd_timer_is_disabled(port, PE_TIMER_WAIT_AND_ADD_JITTER) ||
+		pd_timer_is_expired(port, PE_TIMER_WAIT_AND_ADD_JITTER)) {
 
 		PE_CLR_FLAG(port, PE_FLAGS_FIRST_MSG);
-		pe[port].wait_and_add_jitter_timer = TIMER_DISABLED;
+		pd_timer_disable(port, PE_TIMER_WAIT_AND_ADD_JITTER);
 
 		/*
 		 * Attempt discovery if possible, and return if state was
@@ -2683,10 +2563,10 @@ static void pe_src_hard_reset_entry(int port)
 	pe[port].hard_reset_counter++;
 
 	/* Start NoResponseTimer */
-	pe[port].no_response_timer = get_time().val + PD_T_NO_RESPONSE;
+	pd_timer_enable(port, PE_TIMER_NO_RESPONSE, PD_T_NO_RESPONSE);
 
 	/* Start PSHardResetTimer */
-	pe[port].ps_hard_reset_timer = get_time().val + PD_T_PS_HARD_RESET;
+	pd_timer_enable(port, PE_TIMER_PS_HARD_RESET, PD_T_PS_HARD_RESET);
 
 	/* Clear error flags */
 	PE_CLR_FLAG(port, PE_FLAGS_VDM_REQUEST_NAKED |
@@ -2700,7 +2580,7 @@ static void pe_src_hard_reset_run(int port)
 	 * Transition to the PE_SRC_Transition_to_default state when:
 	 *  1) The PSHardResetTimer times out.
 	 */
-	if (get_time().val > pe[port].ps_hard_reset_timer)
+	if (pd_timer_is_expired(port, PE_TIMER_PS_HARD_RESET))
 		set_state_pe(port, PE_SRC_TRANSITION_TO_DEFAULT);
 }
 
@@ -2712,10 +2592,10 @@ static void pe_src_hard_reset_received_entry(int port)
 	print_current_state(port);
 
 	/* Start NoResponseTimer */
-	pe[port].no_response_timer = get_time().val + PD_T_NO_RESPONSE;
+	pd_timer_enable(port, PE_TIMER_NO_RESPONSE, PD_T_NO_RESPONSE);
 
 	/* Start PSHardResetTimer */
-	pe[port].ps_hard_reset_timer = get_time().val + PD_T_PS_HARD_RESET;
+	pd_timer_enable(port, PE_TIMER_PS_HARD_RESET, PD_T_PS_HARD_RESET);
 }
 
 static void pe_src_hard_reset_received_run(int port)
@@ -2724,7 +2604,7 @@ static void pe_src_hard_reset_received_run(int port)
 	 * Transition to the PE_SRC_Transition_to_default state when:
 	 *  1) The PSHardResetTimer times out.
 	 */
-	if (get_time().val > pe[port].ps_hard_reset_timer)
+	if (pd_timer_is_expired(port, PE_TIMER_PS_HARD_RESET))
 		set_state_pe(port, PE_SRC_TRANSITION_TO_DEFAULT);
 }
 
@@ -2803,7 +2683,7 @@ static void pe_snk_startup_entry(int port)
 		 * Set DiscoverIdentityTimer to trigger when we enter
 		 * snk_ready for the first time.
 		 */
-		pe[port].discover_identity_timer = get_time().val;
+		pd_timer_enable(port, PE_TIMER_DISCOVER_IDENTITY, 0);
 
 		/* Clear port discovery flags */
 		pd_dfp_discovery_init(port);
@@ -2865,7 +2745,7 @@ static void pe_snk_wait_for_capabilities_entry(int port)
 	print_current_state(port);
 
 	/* Initialize and start the SinkWaitCapTimer */
-	pe[port].timeout = get_time().val + PD_T_SINK_WAIT_CAP;
+	pd_timer_enable(port, PE_TIMER_TIMEOUT, PD_T_SINK_WAIT_CAP);
 }
 
 static void pe_snk_wait_for_capabilities_run(int port)
@@ -2892,7 +2772,7 @@ static void pe_snk_wait_for_capabilities_run(int port)
 	}
 
 	/* When the SinkWaitCapTimer times out, perform a Hard Reset. */
-	if (get_time().val > pe[port].timeout) {
+	if (pd_timer_is_expired(port, PE_TIMER_TIMEOUT)) {
 		PE_SET_FLAG(port, PE_FLAGS_SNK_WAIT_CAP_TIMEOUT);
 		set_state_pe(port, PE_SNK_HARD_RESET);
 	}
@@ -3061,7 +2941,7 @@ static void pe_snk_select_capability_run(int port)
 	}
 
 	/* SenderResponsetimer timeout */
-	if (get_time().val > pe[port].sender_response_timer)
+	if (pd_timer_is_expired(port, PE_TIMER_SENDER_RESPONSE))
 		set_state_pe(port, PE_SNK_HARD_RESET);
 }
 
@@ -3073,7 +2953,7 @@ static void pe_snk_transition_sink_entry(int port)
 	print_current_state(port);
 
 	/* Initialize and run PSTransitionTimer */
-	pe[port].ps_transition_timer = get_time().val + PD_T_PS_TRANSITION;
+	pd_timer_enable(port, PE_TIMER_PS_TRANSITION, PD_T_PS_TRANSITION);
 }
 
 static void pe_snk_transition_sink_run(int port)
@@ -3124,7 +3004,7 @@ static void pe_snk_transition_sink_run(int port)
 	/*
 	 * Timeout will lead to a Hard Reset
 	 */
-	if (get_time().val > pe[port].ps_transition_timer &&
+	if (pd_timer_is_expired(port, PE_TIMER_PS_TRANSITION) &&
 			pe[port].hard_reset_counter <= N_HARD_RESET_COUNT) {
 		PE_SET_FLAG(port, PE_FLAGS_PS_TRANSITION_TIMEOUT);
 
@@ -3165,10 +3045,9 @@ static void pe_snk_ready_entry(int port)
 	 */
 	if (PE_CHK_FLAG(port, PE_FLAGS_WAIT)) {
 		PE_CLR_FLAG(port, PE_FLAGS_WAIT);
-		pe[port].sink_request_timer =
-				get_time().val + PD_T_SINK_REQUEST;
+		pd_timer_enable(port, PE_TIMER_SINK_REQUEST, PD_T_SINK_REQUEST);
 	} else {
-		pe[port].sink_request_timer = TIMER_DISABLED;
+		pd_timer_disable(port, PE_TIMER_SINK_REQUEST);
 	}
 
 	/*
@@ -3353,12 +3232,12 @@ static void pe_snk_ready_run(int port)
 		return;
 	}
 
-	if (pe[port].wait_and_add_jitter_timer == TIMER_DISABLED ||
-		get_time().val > pe[port].wait_and_add_jitter_timer) {
+	if (pd_timer_is_disabled(port, PE_TIMER_WAIT_AND_ADD_JITTER) ||
+		pd_timer_is_expired(port, PE_TIMER_WAIT_AND_ADD_JITTER)) {
 		PE_CLR_FLAG(port, PE_FLAGS_FIRST_MSG);
-		pe[port].wait_and_add_jitter_timer = TIMER_DISABLED;
+		pd_timer_disable(port, PE_TIMER_WAIT_AND_ADD_JITTER);
 
-		if (get_time().val > pe[port].sink_request_timer) {
+		if (pd_timer_is_expired(port, PE_TIMER_SINK_REQUEST)) {
 			set_state_pe(port, PE_SNK_SELECT_CAPABILITY);
 			return;
 		}
@@ -3559,7 +3438,7 @@ static void pe_send_soft_reset_entry(int port)
 	/* Reset Protocol Layer (softly) */
 	prl_reset_soft(port);
 
-	pe[port].sender_response_timer = TIMER_DISABLED;
+	pd_timer_disable(port, PE_TIMER_SENDER_RESPONSE);
 }
 
 static void pe_send_soft_reset_run(int port)
@@ -3572,7 +3451,7 @@ static void pe_send_soft_reset_run(int port)
 	if (!prl_is_running(port))
 		return;
 
-	if (pe[port].sender_response_timer == TIMER_DISABLED) {
+	if (pd_timer_is_disabled(port, PE_TIMER_SENDER_RESPONSE)) {
 		/*
 		 * TODO(b/150614211): Soft reset type should match
 		 * unexpected incoming message type
@@ -3582,8 +3461,8 @@ static void pe_send_soft_reset_run(int port)
 			pe[port].soft_reset_sop, PD_CTRL_SOFT_RESET);
 
 		/* Initialize and run SenderResponseTimer */
-		pe[port].sender_response_timer =
-					get_time().val + PD_T_SENDER_RESPONSE;
+		pd_timer_enable(port, PE_TIMER_SENDER_RESPONSE,
+				PD_T_SENDER_RESPONSE);
 	}
 
 	/*
@@ -3613,7 +3492,7 @@ static void pe_send_soft_reset_run(int port)
 	 * Transition to PE_SNK_Hard_Reset or PE_SRC_Hard_Reset on Sender
 	 * Response Timer Timeout or Protocol Layer or Protocol Error
 	 */
-	if (get_time().val > pe[port].sender_response_timer ||
+	if (pd_timer_is_expired(port, PE_TIMER_SENDER_RESPONSE) ||
 			PE_CHK_FLAG(port, PE_FLAGS_PROTOCOL_ERROR)) {
 		PE_CLR_FLAG(port, PE_FLAGS_PROTOCOL_ERROR);
 
@@ -3633,7 +3512,7 @@ static void pe_soft_reset_entry(int port)
 {
 	print_current_state(port);
 
-	pe[port].sender_response_timer = TIMER_DISABLED;
+	pd_timer_disable(port, PE_TIMER_SENDER_RESPONSE);
 
 	send_ctrl_msg(port, TCPC_TX_SOP, PD_CTRL_ACCEPT);
 }
@@ -3707,8 +3586,8 @@ __maybe_unused static void pe_chunk_received_entry(int port)
 		assert(0);
 
 	print_current_state(port);
-	pe[port].chunking_not_supported_timer =
-		get_time().val + PD_T_CHUNKING_NOT_SUPPORTED;
+	pd_timer_enable(port, PE_TIMER_CHUNKING_NOT_SUPPORTED,
+			PD_T_CHUNKING_NOT_SUPPORTED);
 }
 
 __maybe_unused static void pe_chunk_received_run(int port)
@@ -3717,7 +3596,7 @@ __maybe_unused static void pe_chunk_received_run(int port)
 	    IS_ENABLED(CONFIG_USB_PD_EXTENDED_MESSAGES))
 		assert(0);
 
-	if (get_time().val > pe[port].chunking_not_supported_timer)
+	if (pd_timer_is_expired(port, PE_TIMER_CHUNKING_NOT_SUPPORTED))
 		set_state_pe(port, PE_SEND_NOT_SUPPORTED);
 }
 
@@ -4132,7 +4011,7 @@ static void pe_drs_send_swap_run(int port)
 	 *   2) Message was discarded.
 	 */
 	if ((msg_check & PE_MSG_DISCARDED) ||
-	    get_time().val > pe[port].sender_response_timer)
+	    pd_timer_is_expired(port, PE_TIMER_SENDER_RESPONSE))
 		pe_set_ready_state(port);
 }
 
@@ -4187,14 +4066,14 @@ static void pe_prs_src_snk_transition_to_off_entry(int port)
 	/* Tell TypeC to power off the source */
 	tc_src_power_off(port);
 
-	pe[port].ps_source_timer =
-			get_time().val + PD_POWER_SUPPLY_TURN_OFF_DELAY;
+	pd_timer_enable(port, PE_TIMER_PS_SOURCE,
+			PD_POWER_SUPPLY_TURN_OFF_DELAY);
 }
 
 static void pe_prs_src_snk_transition_to_off_run(int port)
 {
 	/* Give time for supply to power off */
-	if (get_time().val > pe[port].ps_source_timer &&
+	if (pd_timer_is_expired(port, PE_TIMER_PS_SOURCE) &&
 	    pd_check_vbus_level(port, VBUS_SAFE0V))
 		set_state_pe(port, PE_PRS_SRC_SNK_ASSERT_RD);
 }
@@ -4224,25 +4103,25 @@ static void pe_prs_src_snk_wait_source_on_entry(int port)
 {
 	print_current_state(port);
 	send_ctrl_msg(port, TCPC_TX_SOP, PD_CTRL_PS_RDY);
-	pe[port].ps_source_timer = TIMER_DISABLED;
+	pd_timer_disable(port, PE_TIMER_PS_SOURCE);
 }
 
 static void pe_prs_src_snk_wait_source_on_run(int port)
 {
-	if (pe[port].ps_source_timer == TIMER_DISABLED &&
+	if (pd_timer_is_disabled(port, PE_TIMER_PS_SOURCE) &&
 			PE_CHK_FLAG(port, PE_FLAGS_TX_COMPLETE)) {
 		PE_CLR_FLAG(port, PE_FLAGS_TX_COMPLETE);
 
 		/* Update pe power role */
 		pe[port].power_role = pd_get_power_role(port);
-		pe[port].ps_source_timer = get_time().val + PD_T_PS_SOURCE_ON;
+		pd_timer_enable(port, PE_TIMER_PS_SOURCE, PD_T_PS_SOURCE_ON);
 	}
 
 	/*
 	 * Transition to PE_SNK_Startup when:
 	 *   1) A PS_RDY Message is received.
 	 */
-	if (pe[port].ps_source_timer != TIMER_DISABLED &&
+	if (!pd_timer_is_disabled(port, PE_TIMER_PS_SOURCE) &&
 	    PE_CHK_FLAG(port, PE_FLAGS_MSG_RECEIVED)) {
 		int type = PD_HEADER_TYPE(rx_emsg[port].header);
 		int cnt = PD_HEADER_CNT(rx_emsg[port].header);
@@ -4251,7 +4130,7 @@ static void pe_prs_src_snk_wait_source_on_run(int port)
 		PE_CLR_FLAG(port, PE_FLAGS_MSG_RECEIVED);
 
 		if ((ext == 0) && (cnt == 0) && (type == PD_CTRL_PS_RDY)) {
-			pe[port].ps_source_timer = TIMER_DISABLED;
+			pd_timer_disable(port, PE_TIMER_PS_SOURCE);
 
 			PE_SET_FLAG(port, PE_FLAGS_PR_SWAP_COMPLETE);
 			set_state_pe(port, PE_SNK_STARTUP);
@@ -4272,7 +4151,7 @@ static void pe_prs_src_snk_wait_source_on_run(int port)
 	 *   1) The PSSourceOnTimer times out.
 	 *   2) PS_RDY not sent after retries.
 	 */
-	if (get_time().val > pe[port].ps_source_timer ||
+	if (pd_timer_is_expired(port, PE_TIMER_PS_SOURCE) ||
 	    PE_CHK_FLAG(port, PE_FLAGS_PROTOCOL_ERROR)) {
 		PE_CLR_FLAG(port, PE_FLAGS_PROTOCOL_ERROR);
 
@@ -4341,9 +4220,9 @@ static void pe_prs_src_snk_send_swap_run(int port)
 				    N_SNK_SRC_PR_SWAP_COUNT) {
 					PE_SET_FLAG(port,
 						PE_FLAGS_WAITING_PR_SWAP);
-					pe[port].pr_swap_wait_timer =
-						get_time().val +
-						PD_T_PR_SWAP_WAIT;
+					pd_timer_enable(port,
+						PE_TIMER_PR_SWAP_WAIT,
+						PD_T_PR_SWAP_WAIT);
 				}
 				pe[port].src_snk_pr_swap_counter++;
 				set_state_pe(port, PE_SRC_READY);
@@ -4358,7 +4237,7 @@ static void pe_prs_src_snk_send_swap_run(int port)
 	 *   2) Message was discarded.
 	 */
 	if ((msg_check & PE_MSG_DISCARDED) ||
-	    get_time().val > pe[port].sender_response_timer)
+	    pd_timer_is_expired(port, PE_TIMER_SENDER_RESPONSE))
 		set_state_pe(port, PE_SRC_READY);
 }
 
@@ -4433,7 +4312,7 @@ static void pe_prs_snk_src_transition_to_off_entry(int port)
 			!PE_CHK_FLAG(port, PE_FLAGS_FAST_ROLE_SWAP_PATH))
 		tc_snk_power_off(port);
 
-	pe[port].ps_source_timer = get_time().val + PD_T_PS_SOURCE_OFF;
+	pd_timer_enable(port, PE_TIMER_PS_SOURCE, PD_T_PS_SOURCE_OFF);
 }
 
 static void pe_prs_snk_src_transition_to_off_run(int port)
@@ -4446,7 +4325,7 @@ static void pe_prs_snk_src_transition_to_off_run(int port)
 	 * Transition to ErrorRecovery state when:
 	 *   1) The PSSourceOffTimer times out.
 	 */
-	if (get_time().val > pe[port].ps_source_timer)
+	if (pd_timer_is_expired(port, PE_TIMER_PS_SOURCE))
 		set_state_pe(port, PE_WAIT_FOR_ERROR_RECOVERY);
 
 	/*
@@ -4515,22 +4394,22 @@ static void pe_prs_snk_src_source_on_entry(int port)
 	 * VBUS was enabled when the TypeC state machine entered
 	 * Attached.SRC state
 	 */
-	pe[port].ps_source_timer = get_time().val +
-					PD_POWER_SUPPLY_TURN_ON_DELAY;
+	pd_timer_enable(port, PE_TIMER_PS_SOURCE,
+			PD_POWER_SUPPLY_TURN_ON_DELAY);
 }
 
 static void pe_prs_snk_src_source_on_run(int port)
 {
 	/* Wait until power supply turns on */
-	if (pe[port].ps_source_timer != TIMER_DISABLED) {
-		if (get_time().val < pe[port].ps_source_timer)
+	if (!pd_timer_is_disabled(port, PE_TIMER_PS_SOURCE)) {
+		if (!pd_timer_is_expired(port, PE_TIMER_PS_SOURCE))
 			return;
 
 		/* update pe power role */
 		pe[port].power_role = pd_get_power_role(port);
 		send_ctrl_msg(port, TCPC_TX_SOP, PD_CTRL_PS_RDY);
 		/* reset timer so PD_CTRL_PS_RDY isn't sent again */
-		pe[port].ps_source_timer = TIMER_DISABLED;
+		pd_timer_disable(port, PE_TIMER_PS_SOURCE);
 	}
 
 	/*
@@ -4653,7 +4532,7 @@ static void pe_prs_snk_src_send_swap_run(int port)
 	 * FRS: Transition to ErrorRecovery state when:
 	 *   1) The SenderResponseTimer times out.
 	 */
-	if (get_time().val > pe[port].sender_response_timer) {
+	if (pd_timer_is_expired(port, PE_TIMER_SENDER_RESPONSE)) {
 		if (IS_ENABLED(CONFIG_USB_PD_REV30))
 			set_state_pe(port,
 				PE_CHK_FLAG(port, PE_FLAGS_FAST_ROLE_SWAP_PATH)
@@ -4735,8 +4614,8 @@ static void pe_bist_tx_entry(int port)
 	 */
 	if (mode == BIST_CARRIER_MODE_2) {
 		send_ctrl_msg(port, TCPC_TX_BIST_MODE_2, 0);
-		pe[port].bist_cont_mode_timer =
-					get_time().val + PD_T_BIST_CONT_MODE;
+		pd_timer_enable(port, PE_TIMER_BIST_CONT_MODE,
+				PD_T_BIST_CONT_MODE);
 	}
 	/*
 	 * See section 6.4.3.9 BIST Test Data:
@@ -4746,12 +4625,12 @@ static void pe_bist_tx_entry(int port)
 	 * Messages.
 	 */
 	else if (mode == BIST_TEST_DATA)
-		pe[port].bist_cont_mode_timer = TIMER_DISABLED;
+		pd_timer_disable(port, PE_TIMER_BIST_CONT_MODE);
 }
 
 static void pe_bist_tx_run(int port)
 {
-	if (get_time().val > pe[port].bist_cont_mode_timer) {
+	if (pd_timer_is_expired(port, PE_TIMER_BIST_CONT_MODE)) {
 
 		if (pe[port].power_role == PD_ROLE_SOURCE)
 			set_state_pe(port, PE_SRC_TRANSITION_TO_DEFAULT);
@@ -4783,13 +4662,12 @@ static void pe_bist_rx_entry(int port)
 	send_data_msg(port, TCPC_TX_SOP, PD_DATA_BIST);
 
 	/* Delay at least enough for partner to finish BIST */
-	pe[port].bist_cont_mode_timer =
-				get_time().val + PD_T_BIST_RECEIVE;
+	pd_timer_enable(port, PE_TIMER_BIST_CONT_MODE, PD_T_BIST_RECEIVE);
 }
 
 static void pe_bist_rx_run(int port)
 {
-	if (get_time().val < pe[port].bist_cont_mode_timer)
+	if (!pd_timer_is_expired(port, PE_TIMER_BIST_CONT_MODE))
 		return;
 
 	if (pe[port].power_role == PD_ROLE_SOURCE)
@@ -4922,8 +4800,8 @@ static enum vdm_response_result parse_vdm_response_common(int port)
 			 */
 			CPRINTS("C%d: Partner BUSY, request will be retried",
 					port);
-			pe[port].discover_identity_timer =
-					get_time().val + PD_T_VDM_BUSY;
+			pd_timer_enable(port, PE_TIMER_DISCOVER_IDENTITY,
+					PD_T_VDM_BUSY);
 
 			return VDM_RESULT_NO_ACTION;
 		} else if (PD_VDO_CMDT(payload[0]) == CMDT_INIT) {
@@ -4983,20 +4861,19 @@ static void pe_vdm_send_request_entry(int port)
 	PE_SET_FLAG(port, PE_FLAGS_LOCALLY_INITIATED_AMS |
 			PE_FLAGS_INTERRUPTIBLE_AMS);
 
-	pe[port].vdm_response_timer = TIMER_DISABLED;
+	pd_timer_disable(port, PE_TIMER_VDM_RESPONSE);
 }
 
 static void pe_vdm_send_request_run(int port)
 {
-	if (pe[port].vdm_response_timer == TIMER_DISABLED &&
+	if (pd_timer_is_disabled(port, PE_TIMER_VDM_RESPONSE) &&
 			PE_CHK_FLAG(port, PE_FLAGS_TX_COMPLETE)) {
 		/* Message was sent */
 		PE_CLR_FLAG(port, PE_FLAGS_TX_COMPLETE);
 
 		/* Start no response timer */
 		/* TODO(b/155890173): Support DPM-supplied timeout */
-		pe[port].vdm_response_timer =
-			get_time().val + PD_T_VDM_SNDR_RSP;
+		pd_timer_enable(port, PE_TIMER_VDM_RESPONSE, PD_T_VDM_SNDR_RSP);
 	}
 
 	if (PE_CHK_FLAG(port, PE_FLAGS_MSG_DISCARDED)) {
@@ -5012,7 +4889,7 @@ static void pe_vdm_send_request_run(int port)
 	 * Check the VDM timer, child will be responsible for processing
 	 * messages and reacting appropriately to unexpected messages.
 	 */
-	if (get_time().val > pe[port].vdm_response_timer) {
+	if (pd_timer_is_expired(port, PE_TIMER_VDM_RESPONSE)) {
 		CPRINTF("VDM %s Response Timeout\n",
 				pe[port].tx_type == TCPC_TX_SOP ?
 				"Port" : "Cable");
@@ -5193,7 +5070,7 @@ static void pe_vdm_identity_request_cbl_exit(int port)
 	 * Set discover identity timer unless BUSY case already did so.
 	 */
 	if (pd_get_identity_discovery(port, pe[port].tx_type) == PD_DISC_NEEDED
-	    && pe[port].discover_identity_timer < get_time().val) {
+	    && pd_timer_is_expired(port, PE_TIMER_DISCOVER_IDENTITY)) {
 		uint64_t timer;
 
 		/*
@@ -5209,7 +5086,7 @@ static void pe_vdm_identity_request_cbl_exit(int port)
 		else
 			timer = PE_T_DISCOVER_IDENTITY_NO_CONTRACT;
 
-		pe[port].discover_identity_timer = get_time().val + timer;
+		pd_timer_enable(port, PE_TIMER_DISCOVER_IDENTITY, timer);
 	}
 
 	/* Do not attempt further discovery if identity discovery failed. */
@@ -5849,7 +5726,7 @@ static void pe_enter_usb_run(int port)
 		return;
 	}
 
-	if (get_time().val > pe[port].sender_response_timer) {
+	if (pd_timer_is_expired(port, PE_TIMER_SENDER_RESPONSE)) {
 		pe_set_ready_state(port);
 		enter_usb_failed(port);
 		return;
@@ -6060,7 +5937,7 @@ static void pe_vcs_send_swap_run(int port)
 	 *   2) Message was discarded.
 	 */
 	if ((msg_check & PE_MSG_DISCARDED) ||
-	    get_time().val > pe[port].sender_response_timer)
+	    pd_timer_is_expired(port, PE_TIMER_SENDER_RESPONSE))
 		pe_set_ready_state(port);
 }
 
@@ -6072,7 +5949,7 @@ static void pe_vcs_wait_for_vconn_swap_entry(int port)
 	print_current_state(port);
 
 	/* Start the VCONNOnTimer */
-	pe[port].vconn_on_timer = get_time().val + PD_T_VCONN_SOURCE_ON;
+	pd_timer_enable(port, PE_TIMER_VCONN_ON, PD_T_VCONN_SOURCE_ON);
 }
 
 static void pe_vcs_wait_for_vconn_swap_run(int port)
@@ -6099,7 +5976,7 @@ static void pe_vcs_wait_for_vconn_swap_run(int port)
 	 * PE_SNK_Hard_Reset state when:
 	 *   1) The VCONNOnTimer times out.
 	 */
-	if (get_time().val > pe[port].vconn_on_timer) {
+	if (pd_timer_is_expired(port, PE_TIMER_VCONN_ON)) {
 		if (pe[port].power_role == PD_ROLE_SOURCE)
 			set_state_pe(port, PE_SRC_HARD_RESET);
 		else
@@ -6116,7 +5993,7 @@ static void pe_vcs_turn_on_vconn_swap_entry(int port)
 
 	/* Request DPM to turn on VCONN */
 	pd_request_vconn_swap_on(port);
-	pe[port].timeout = 0;
+	pd_timer_disable(port, PE_TIMER_TIMEOUT);
 }
 
 static void pe_vcs_turn_on_vconn_swap_run(int port)
@@ -6126,13 +6003,13 @@ static void pe_vcs_turn_on_vconn_swap_run(int port)
 	 * Transition to the PE_VCS_Send_Ps_Rdy state when:
 	 *  1) The Port’s VCONN is on.
 	 */
-	if (pe[port].timeout == 0 &&
+	if (pd_timer_is_disabled(port, PE_TIMER_TIMEOUT) &&
 			PE_CHK_FLAG(port, PE_FLAGS_VCONN_SWAP_COMPLETE)) {
 		PE_CLR_FLAG(port, PE_FLAGS_VCONN_SWAP_COMPLETE);
-		pe[port].timeout = get_time().val + PD_VCONN_SWAP_DELAY;
+		pd_timer_enable(port, PE_TIMER_TIMEOUT, PD_VCONN_SWAP_DELAY);
 	}
 
-	if (pe[port].timeout > 0 && get_time().val > pe[port].timeout)
+	if (pd_timer_is_expired(port, PE_TIMER_TIMEOUT))
 		set_state_pe(port, PE_VCS_SEND_PS_RDY_SWAP);
 }
 
@@ -6145,19 +6022,19 @@ static void pe_vcs_turn_off_vconn_swap_entry(int port)
 
 	/* Request DPM to turn off VCONN */
 	pd_request_vconn_swap_off(port);
-	pe[port].timeout = 0;
+	pd_timer_disable(port, PE_TIMER_TIMEOUT);
 }
 
 static void pe_vcs_turn_off_vconn_swap_run(int port)
 {
 	/* Wait for VCONN to turn off */
-	if (pe[port].timeout == 0 &&
+	if (pd_timer_is_disabled(port, PE_TIMER_TIMEOUT) &&
 			PE_CHK_FLAG(port, PE_FLAGS_VCONN_SWAP_COMPLETE)) {
 		PE_CLR_FLAG(port, PE_FLAGS_VCONN_SWAP_COMPLETE);
-		pe[port].timeout = get_time().val + PD_VCONN_SWAP_DELAY;
+		pd_timer_enable(port, PE_TIMER_TIMEOUT, PD_VCONN_SWAP_DELAY);
 	}
 
-	if (pe[port].timeout > 0 && get_time().val > pe[port].timeout) {
+	if (pd_timer_is_expired(port, PE_TIMER_TIMEOUT)) {
 		/*
 		 * A VCONN Swap Shall reset the DiscoverIdentityCounter
 		 * to zero
@@ -6203,8 +6080,8 @@ static void pe_vcs_send_ps_rdy_swap_run(int port)
 			 * Ensures enough time for transmission completion,
 			 * in the case of more delays.
 			 */
-			pe[port].sender_response_timer = get_time().val +
-							PD_T_SENDER_RESPONSE;
+			pd_timer_enable(port, PE_TIMER_SENDER_RESPONSE,
+					PD_T_SENDER_RESPONSE);
 
 			pe[port].sub = PE_SUB1;
 		}
@@ -6212,13 +6089,13 @@ static void pe_vcs_send_ps_rdy_swap_run(int port)
 	case PE_SUB1:
 		if (PE_CHK_FLAG(port, PE_FLAGS_TX_COMPLETE)) {
 			PE_CLR_FLAG(port, PE_FLAGS_TX_COMPLETE);
-			pe[port].sender_response_timer = get_time().val +
-							PD_T_SENDER_RESPONSE;
+			pd_timer_enable(port, PE_TIMER_SENDER_RESPONSE,
+					PD_T_SENDER_RESPONSE);
 		}
 
 		/* Got ACCEPT or REJECT from Cable Plug */
 		if (PE_CHK_FLAG(port, PE_FLAGS_MSG_RECEIVED) ||
-		    get_time().val > pe[port].sender_response_timer) {
+		    pd_timer_is_expired(port, PE_TIMER_SENDER_RESPONSE)) {
 			PE_CLR_FLAG(port, PE_FLAGS_MSG_RECEIVED);
 			/*
 			 * A VCONN Swap Shall reset the
@@ -6330,7 +6207,7 @@ static void pe_dr_get_sink_cap_run(int port)
 	 *   2) Message was discarded.
 	 */
 	if ((msg_check & PE_MSG_DISCARDED) ||
-	    get_time().val > pe[port].sender_response_timer)
+	    pd_timer_is_expired(port, PE_TIMER_SENDER_RESPONSE))
 		pe_set_ready_state(port);
 }
 
@@ -6436,7 +6313,7 @@ static void pe_dr_src_get_source_cap_run(int port)
 	 *   2) Message was discarded.
 	 */
 	if ((msg_check & PE_MSG_DISCARDED) ||
-	    get_time().val > pe[port].sender_response_timer)
+	    pd_timer_is_expired(port, PE_TIMER_SENDER_RESPONSE))
 		set_state_pe(port, PE_SRC_READY);
 }
 
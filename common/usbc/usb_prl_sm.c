@@ -24,6 +24,8 @@
 #include "usb_charge.h"
 #include "usb_mux.h"
 #include "usb_pd.h"
+#include "usb_pd_timer.h"
+#include "usb_pd_trace.h"
 #include "usb_pe_sm.h"
 #include "usb_prl_sm.h"
 #include "usb_tc_sm.h"
@@ -295,8 +297,6 @@ static struct rx_chunked {
 	struct sm_ctx ctx;
 	/* PRL_FLAGS */
 	uint32_t flags;
-	/* protocol timer */
-	uint64_t chunk_sender_response_timer;
 } rch[CONFIG_USB_PD_PORT_MAX_COUNT];
 
 /* Chunked Tx State Machine Object */
@@ -305,8 +305,6 @@ static struct tx_chunked {
 	struct sm_ctx ctx;
 	/* state machine flags */
 	uint32_t flags;
-	/* protocol timer */
-	uint64_t chunk_sender_request_timer;
 	/* error to report when moving to tch_report_error state */
 	enum pe_error error;
 } tch[CONFIG_USB_PD_PORT_MAX_COUNT];
@@ -325,10 +323,6 @@ static struct protocol_layer_tx {
 	struct sm_ctx ctx;
 	/* state machine flags */
 	uint32_t flags;
-	/* protocol timer */
-	uint64_t sink_tx_timer;
-	/* timeout to limit waiting on TCPC response (not in spec) */
-	uint64_t tcpc_tx_timeout;
 	/* last message type we transmitted */
 	enum tcpm_transmit_type last_xmit_type;
 	/* message id counters for all 6 port partners */
@@ -343,8 +337,6 @@ static struct protocol_hard_reset {
 	struct sm_ctx ctx;
 	/* state machine flags */
 	uint32_t flags;
-	/* protocol timer */
-	uint64_t hard_reset_complete_timer;
 } prl_hr[CONFIG_USB_PD_PORT_MAX_COUNT];
 
 /* Chunking Message Object */
@@ -527,7 +519,7 @@ void pd_execute_hard_reset(int port)
 
 	PRL_HR_SET_FLAG(port, PRL_FLAGS_PORT_PARTNER_HARD_RESET);
 	set_state_prl_hr(port, PRL_HR_RESET_LAYER);
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 void prl_execute_hard_reset(int port)
@@ -538,7 +530,7 @@ void prl_execute_hard_reset(int port)
 
 	PRL_HR_SET_FLAG(port, PRL_FLAGS_PE_HARD_RESET);
 	set_state_prl_hr(port, PRL_HR_RESET_LAYER);
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 int prl_is_running(int port)
@@ -613,7 +605,7 @@ void prl_set_debug_level(enum debug_level debug_level)
 void prl_hard_reset_complete(int port)
 {
 	PRL_HR_SET_FLAG(port, PRL_FLAGS_HARD_RESET_COMPLETE);
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 void prl_send_ctrl_msg(int port,
@@ -633,7 +625,7 @@ void prl_send_ctrl_msg(int port,
 	PRL_TX_SET_FLAG(port, PRL_FLAGS_MSG_XMIT);
 #endif /* CONFIG_USB_PD_REV30 */
 
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 void prl_send_data_msg(int port,
@@ -652,7 +644,7 @@ void prl_send_data_msg(int port,
 	PRL_TX_SET_FLAG(port, PRL_FLAGS_MSG_XMIT);
 #endif /* CONFIG_USB_PD_REV30 */
 
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 #ifdef CONFIG_USB_PD_EXTENDED_MESSAGES
@@ -665,7 +657,7 @@ void prl_send_ext_data_msg(int port,
 	pdmsg[port].ext = 1;
 
 	TCH_SET_FLAG(port, PRL_FLAGS_MSG_XMIT);
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 #endif /* CONFIG_USB_PD_EXTENDED_MESSAGES */
 
@@ -688,7 +680,7 @@ void prl_reset_soft(int port)
 	local_state[port] = SM_INIT;
 
 	/* Ensure we process the reset quickly */
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 void prl_reset(int port)
@@ -697,7 +689,7 @@ void prl_reset(int port)
 	local_state[port] = SM_INIT;
 
 	/* Ensure we process the reset quickly */
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 void prl_run(int port, int evt, int en)
@@ -1064,6 +1056,8 @@ static void prl_tx_construct_message(const int port)
 	 * should not retry those messages. We do not support that and probably
 	 * never will (since we support chunking).
 	 */
+	pd_trace_tx(port, pdmsg[port].xmit_type, header,
+		    pdmsg[port].tx_chk_buf);
 	tcpm_transmit(port, pdmsg[port].xmit_type, header,
 		      pdmsg[port].tx_chk_buf);
 }
@@ -1075,7 +1069,7 @@ static void prl_tx_wait_for_phy_response_entry(const int port)
 {
 	print_current_prl_tx_state(port);
 
-	prl_tx[port].tcpc_tx_timeout = get_time().val + PD_T_TCPC_TX_TIMEOUT;
+	pd_timer_enable(port, PR_TIMER_TCPC_TX_TIMEOUT, PD_T_TCPC_TX_TIMEOUT);
 }
 
 static void prl_tx_wait_for_phy_response_run(const int port)
@@ -1091,6 +1085,8 @@ static void prl_tx_wait_for_phy_response_run(const int port)
 
 	if (prl_tx[port].xmit_status == TCPC_TX_COMPLETE_SUCCESS) {
 		/* NOTE: PRL_TX_Message_Sent State embedded here. */
+		pd_trace_tx_done(port, EC_PD_TRACE_TX_SUCCESS);
+
 		/* Increment messageId counter */
 		increment_msgid_counter(port);
 
@@ -1104,15 +1100,23 @@ static void prl_tx_wait_for_phy_response_run(const int port)
 		 * This event reduces the time of informing the policy engine of
 		 * the transmission by one state machine cycle
 		 */
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 		set_state_prl_tx(port, PRL_TX_WAIT_FOR_MESSAGE_REQUEST);
-	} else if (get_time().val > prl_tx[port].tcpc_tx_timeout ||
+	} else if (pd_timer_is_expired(port, PR_TIMER_TCPC_TX_TIMEOUT) ||
 		   prl_tx[port].xmit_status == TCPC_TX_COMPLETE_FAILED ||
 		   prl_tx[port].xmit_status == TCPC_TX_COMPLETE_DISCARDED) {
 		/*
 		 * NOTE: PRL_Tx_Transmission_Error State embedded
 		 * here.
 		 */
+		if (prl_tx[port].xmit_status == TCPC_TX_COMPLETE_FAILED)
+			pd_trace_tx_done(port, EC_PD_TRACE_TX_FAILED);
+		else if (prl_tx[port].xmit_status ==
+			 TCPC_TX_COMPLETE_DISCARDED)
+			pd_trace_tx_done(port, EC_PD_TRACE_TX_DISCARDED);
+		else
+			pd_trace_tx_done(port, EC_PD_TRACE_TX_TIMEOUT);
+
 
 		if (IS_ENABLED(CONFIG_USB_PD_EXTENDED_MESSAGES)) {
 			/*
@@ -1146,12 +1150,12 @@ static void prl_tx_src_pending_entry(const int port)
 	print_current_prl_tx_state(port);
 
 	/* Start SinkTxTimer */
-	prl_tx[port].sink_tx_timer = get_time().val + PD_T_SINK_TX;
+	pd_timer_enable(port, PR_TIMER_SINK_TX, PD_T_SINK_TX);
 }
 
 static void prl_tx_src_pending_run(const int port)
 {
-	if (get_time().val > prl_tx[port].sink_tx_timer) {
+	if (pd_timer_is_expired(port, PR_TIMER_SINK_TX)) {
 		/*
 		 * We clear the pending XMIT flag here right before we send so
 		 * we can detect if we discarded this message or not
@@ -1292,6 +1296,8 @@ static void prl_hr_reset_layer_run(const int port)
 	 * Hard Reset was initiated by Port Partner
 	 */
 	else {
+		pd_trace_rx(port, TCPC_TX_HARD_RESET, 0, NULL);
+
 		/* Inform Policy Engine of the Hard Reset */
 		pe_got_hard_reset(port);
 		set_state_prl_hr(port, PRL_HR_WAIT_FOR_PE_HARD_RESET_COMPLETE);
@@ -1306,8 +1312,7 @@ static void prl_hr_wait_for_phy_hard_reset_complete_entry(const int port)
 	print_current_prl_hr_state(port);
 
 	/* Start HardResetCompleteTimer */
-	prl_hr[port].hard_reset_complete_timer =
-			get_time().val + PD_T_PS_HARD_RESET;
+	pd_timer_enable(port, PR_TIMER_HARD_RESET_COMPLETE, PD_T_PS_HARD_RESET);
 }
 
 static void prl_hr_wait_for_phy_hard_reset_complete_run(const int port)
@@ -1317,7 +1322,7 @@ static void prl_hr_wait_for_phy_hard_reset_complete_run(const int port)
 	 * or timeout
 	 */
 	if (PDMSG_CHK_FLAG(port, PRL_FLAGS_TX_COMPLETE) ||
-	    (get_time().val > prl_hr[port].hard_reset_complete_timer)) {
+	    pd_timer_is_expired(port, PR_TIMER_HARD_RESET_COMPLETE)) {
 		/* PRL_HR_PHY_Hard_Reset_Requested */
 
 		/* Inform Policy Engine Hard Reset was sent */
@@ -1561,7 +1566,7 @@ static void rch_requesting_chunk_entry(const int port)
 	pdmsg[port].data_objs = 1;
 	pdmsg[port].ext = 1;
 	PRL_TX_SET_FLAG(port, PRL_FLAGS_MSG_XMIT);
-	task_set_event(PD_PORT_TO_TASK_ID(port), PD_EVENT_TX);
+	pd_task_set_event(port, PD_EVENT_TX);
 }
 
 static void rch_requesting_chunk_run(const int port)
@@ -1597,8 +1602,8 @@ static void rch_waiting_chunk_entry(const int port)
 	/*
 	 * Start ChunkSenderResponseTimer
 	 */
-	rch[port].chunk_sender_response_timer =
-		get_time().val + PD_T_CHUNK_SENDER_RESPONSE;
+	pd_timer_enable(port, PR_TIMER_CHUNK_SENDER_RESPONSE,
+			PD_T_CHUNK_SENDER_RESPONSE);
 }
 
 static void rch_waiting_chunk_run(const int port)
@@ -1637,7 +1642,7 @@ static void rch_waiting_chunk_run(const int port)
 	/*
 	 * ChunkSenderResponseTimer Timeout
 	 */
-	else if (get_time().val > rch[port].chunk_sender_response_timer) {
+	else if (pd_timer_is_expired(port, PR_TIMER_CHUNK_SENDER_RESPONSE)) {
 		set_state_rch(port, RCH_REPORT_ERROR);
 	}
 }
@@ -1893,8 +1898,8 @@ static void tch_wait_chunk_request_entry(const int port)
 	/* Increment Chunk Number to Send */
 	pdmsg[port].chunk_number_to_send++;
 	/* Start Chunk Sender Request Timer */
-	tch[port].chunk_sender_request_timer =
-		get_time().val + PD_T_CHUNK_SENDER_REQUEST;
+	pd_timer_enable(port, PR_TIMER_CHUNK_SENDER_REQUEST,
+			PD_T_CHUNK_SENDER_REQUEST);
 }
 
 static void tch_wait_chunk_request_run(const int port)
@@ -1936,8 +1941,7 @@ static void tch_wait_chunk_request_run(const int port)
 	/*
 	 * ChunkSenderRequestTimer timeout
 	 */
-	else if (get_time().val >=
-			tch[port].chunk_sender_request_timer) {
+	else if (pd_timer_is_expired(port, PR_TIMER_CHUNK_SENDER_REQUEST)) {
 		set_state_tch(port, TCH_MESSAGE_SENT);
 	}
 }
@@ -2048,6 +2052,8 @@ static void prl_rx_wait_for_phy_message(const int port, int evt)
 	if (cnt > CHK_BUF_SIZE)
 		cnt = CHK_BUF_SIZE;
 
+	pd_trace_rx(port, prl_rx[port].sop, header, pdmsg[port].rx_chk_buf);
+
 	/* dump received packet content (only dump ping at debug level MAX) */
 	if ((prl_debug_level >= DEBUG_LEVEL_2 && type != PD_CTRL_PING) ||
 		prl_debug_level >= DEBUG_LEVEL_3) {
@@ -2175,7 +2181,7 @@ static void prl_rx_wait_for_phy_message(const int port, int evt)
 		pe_message_received(port);
 	}
 
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 /* All necessary Protocol Transmit States (Section 6.11.2.2) */
@@ -29,86 +29,29 @@ struct internal_ctx {
 BUILD_ASSERT(sizeof(struct internal_ctx) ==
 	     member_size(struct sm_ctx, internal));
 
-/* Gets the first shared parent state between a and b (inclusive) */
-static usb_state_ptr shared_parent_state(usb_state_ptr a, usb_state_ptr b)
+/* Gets the number of states from state out to its outermost parent */
+static int state_depth(usb_state_ptr state)
 {
-	const usb_state_ptr orig_b = b;
-
-	/* There are no common ancestors */
-	if (b == NULL)
-		return NULL;
-
-	/* This assumes that both A and B are NULL terminated without cycles */
-	while (a != NULL) {
-		/* We found a match return */
-		if (a == b)
-			return a;
-
-		/*
-		 * Otherwise, increment b down the list for comparison until we
-		 * run out, then increment a and start over on b for comparison
-		 */
-		if (b->parent == NULL) {
-			a = a->parent;
-			b = orig_b;
-		} else {
-			b = b->parent;
-		}
-	}
-
-	return NULL;
-}
-
-/*
- * Call all entry functions of parents before children. If set_state is called
- * during one of the entry functions, then do not call any remaining entry
- * functions.
- */
-static void call_entry_functions(const int port,
-			       struct internal_ctx *const internal,
-			       const usb_state_ptr stop,
-			       const usb_state_ptr current)
-{
-	if (current == stop)
-		return;
+	int depth = 0;
 
-	call_entry_functions(port, internal, stop, current->parent);
+	for (; state != NULL; state = state->parent)
+		depth++;
 
-	/*
-	 * If the previous entry function called set_state, then don't enter
-	 * remaining states.
-	 */
-	if (!internal->enter)
-		return;
-
-	/* Track the latest state that was entered, so we can exit properly. */
-	internal->last_entered = current;
-	if (current->entry)
-		current->entry(port);
-}
-
-/*
- * Call all exit functions of children before parents. Note set_state is ignored
- * during an exit function.
- */
-static void call_exit_functions(const int port, const usb_state_ptr stop,
-			      const usb_state_ptr current)
-{
-	if (current == stop)
-		return;
-
-	if (current->exit)
-		current->exit(port);
-
-	call_exit_functions(port, stop, current->parent);
+	return depth;
 }
 
 void set_state(const int port, struct sm_ctx *const ctx,
 	       const usb_state_ptr new_state)
 {
 	struct internal_ctx * const internal = (void *) ctx->internal;
+	usb_state_ptr entry_path[USB_SM_MAX_DEPTH];
 	usb_state_ptr last_state;
 	usb_state_ptr shared_parent;
+	usb_state_ptr state;
+	int last_depth;
+	int new_depth;
+	int entries;
+	int i;
 
 	/*
 	 * It does not make sense to call set_state in an exit phase of a state
@@ -128,26 +71,61 @@ void set_state(const int port, struct sm_ctx *const ctx,
 	 */
 	last_state = internal->enter ? internal->last_entered : ctx->current;
 
-	/* We don't exit and re-enter shared parent states */
-	shared_parent = shared_parent_state(last_state, new_state);
+	/*
+	 * We don't exit and re-enter shared parent states. Find the innermost
+	 * one by walking out from both states at the same depth until they
+	 * meet.
+	 */
+	last_depth = state_depth(last_state);
+	new_depth = state_depth(new_state);
+	shared_parent = last_state;
+	state = new_state;
+	for (i = last_depth; i > new_depth; i--)
+		shared_parent = shared_parent->parent;
+	for (entries = 0; new_depth - entries > last_depth; entries++)
+		state = state->parent;
+	for (; shared_parent != state; entries++) {
+		shared_parent = shared_parent->parent;
+		state = state->parent;
+	}
+
+	/* Refuse a transition with more states to enter than entry_path holds */
+	if (entries > USB_SM_MAX_DEPTH) {
+		CPRINTF("C%d: Ignoring set state to 0x%pP, too deep\n",
+			port, new_state);
+		return;
+	}
 
 	/*
-	 * Exit all of the non-common states from the last state.
+	 * Exit all of the non-common states from the last state, children
+	 * before parents.
 	 */
 	internal->exit = true;
-	call_exit_functions(port, shared_parent, last_state);
+	for (state = last_state; state != shared_parent; state = state->parent)
+		if (state->exit)
+			state->exit(port);
 	internal->exit = false;
 
 	ctx->previous = ctx->current;
 	ctx->current = new_state;
 
 	/*
-	 * Enter all new non-common states. last_entered will contain the last
-	 * state that successfully entered before another set_state was called.
+	 * Enter all new non-common states, parents before children. If an
+	 * entry function calls set_state, then that has entered its own states
+	 * and cleared enter, so don't enter any more. last_entered will contain
+	 * the last state that successfully entered before another set_state was
+	 * called.
 	 */
+	for (state = new_state, i = entries; i > 0; state = state->parent)
+		entry_path[--i] = state;
+
 	internal->last_entered = NULL;
 	internal->enter = true;
-	call_entry_functions(port, internal, shared_parent, ctx->current);
+	for (i = 0; i < entries && internal->enter; i++) {
+		internal->last_entered = entry_path[i];
+		if (entry_path[i]->entry)
+			entry_path[i]->entry(port);
+	}
 	/*
 	 * Setting enter to false ensures that all pending entry calls will be
 	 * skipped (in the case of a parent state calling set_state, which means
@@ -167,36 +145,22 @@ void set_state(const int port, struct sm_ctx *const ctx,
 	 * delay important processing until the next task interval.
 	 */
 	if (IS_ENABLED(HAS_TASK_PD_C0))
-		task_wake(PD_PORT_TO_TASK_ID(port));
-}
-
-/*
- * Call all run functions of children before parents. If set_state is called
- * during one of the entry functions, then do not call any remaining entry
- * functions.
- */
-static void call_run_functions(const int port,
-			     const struct internal_ctx *const internal,
-			     const usb_state_ptr current)
-{
-	if (!current)
-		return;
-
-	/* If set_state is called during run, don't call remain functions. */
-	if (!internal->running)
-		return;
-
-	if (current->run)
-		current->run(port);
-
-	call_run_functions(port, internal, current->parent);
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 void run_state(const int port, struct sm_ctx *const ctx)
 {
 	struct internal_ctx * const internal = (void *) ctx->internal;
+	usb_state_ptr state;
 
+	/*
+	 * Call all run functions of children before parents. If set_state is
+	 * called during one of them, then don't call any remaining ones.
+	 */
 	internal->running = true;
-	call_run_functions(port, internal, ctx->current);
+	for (state = ctx->current; state != NULL && internal->running;
+	     state = state->parent)
+		if (state->run)
+			state->run(port);
 	internal->running = false;
 }
@@ -15,6 +15,7 @@
 #include "usb_mux.h"
 #include "usb_pd.h"
 #include "usb_pd_dpm.h"
+#include "usb_pd_timer.h"
 #include "usb_pe_sm.h"
 #include "usb_prl_sm.h"
 #include "usb_sm.h"
@@ -151,9 +152,6 @@ void print_flag(int set_or_clear, int flag);
  */
 #define PD_DISABLED_BY_POLICY       BIT(1)
 
-/* Unreachable time in future */
-#define TIMER_DISABLED 0xffffffffffffffff
-
 enum ps_reset_sequence {
 	PS_STATE0,
 	PS_STATE1,
@@ -381,36 +379,8 @@ static struct type_c {
 	enum tcpc_cc_polarity polarity;
 	/* port flags, see TC_FLAGS_* */
 	uint32_t flags;
-	/* Time a port shall wait before it can determine it is attached */
-	uint64_t cc_debounce;
-	/*
-	 * Time a Sink port shall wait before it can determine it is detached
-	 * due to the potential for USB PD signaling on CC as described in
-	 * the state definitions.
-	 */
-	uint64_t pd_debounce;
-	/*
-	 * Time to ignore Vbus absence due to external IC debounce detection
-	 * logic immediately after a power role swap.
-	 */
-	uint64_t vbus_debounce_time;
-#ifdef CONFIG_USB_PD_TRY_SRC
-	/*
-	 * Time a port shall wait before it can determine it is
-	 * re-attached during the try-wait process.
-	 */
-	uint64_t try_wait_debounce;
-#endif
 	/* The cc state */
 	enum pd_cc_states cc_state;
-	/* Role toggle timer */
-	uint64_t next_role_swap;
-	/* Generic timer */
-	uint64_t timeout;
-	/* Time to enter low power mode */
-	uint64_t low_power_time;
-	/* Time to debounce exit low power mode */
-	uint64_t low_power_exit_time;
 	/* Tasks to notify after TCPC has been reset */
 	int tasks_waiting_on_reset;
 	/* Tasks preventing TCPC from entering low power mode */
@@ -549,7 +519,7 @@ void pd_request_source_voltage(int port, int mv)
 		else
 			pd_dpm_request(port, DPM_REQUEST_PR_SWAP);
 
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 	}
 }
 
@@ -562,7 +532,7 @@ void pd_set_external_voltage_limit(int port, int mv)
 		if (get_state_tc(port) == TC_ATTACHED_SNK)
 			pd_dpm_request(port, DPM_REQUEST_NEW_POWER_LEVEL);
 
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 	}
 }
 
@@ -585,7 +555,7 @@ void tc_request_power_swap(int port)
 			TC_SET_FLAG(port, TC_FLAGS_PR_SWAP_IN_PROGRESS);
 
 			/* Let tc_pr_swap_complete start the Vbus debounce */
-			tc[port].vbus_debounce_time = TIMER_DISABLED;
+			pd_timer_disable(port, TC_TIMER_VBUS_DEBOUNCE);
 		}
 
 		/*
@@ -697,7 +667,7 @@ static inline void pd_set_dual_role_and_event(int port,
 		pd_update_try_source();
 
 	if (event != 0)
-		task_set_event(PD_PORT_TO_TASK_ID(port), event);
+		pd_task_set_event(port, event);
 }
 
 void pd_set_dual_role(int port, enum pd_dual_role_states state)
@@ -719,7 +689,7 @@ void pd_request_data_swap(int port)
 	 */
 	if (IS_ATTACHED_SRC(port) || IS_ATTACHED_SNK(port)) {
 		TC_SET_FLAG(port, TC_FLAGS_REQUEST_DR_SWAP);
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 	}
 }
 
@@ -770,6 +740,21 @@ int tc_is_attached_snk(int port)
 	return IS_ATTACHED_SNK(port);
 }
 
+bool tc_is_idle(int port)
+{
+	const enum usb_tc_state state = get_state_tc(port);
+
+	/*
+	 * Not a switch: states which aren't configured are link-time
+	 * symbols, not constants.
+	 */
+	return state == TC_UNATTACHED_SNK || state == TC_UNATTACHED_SRC ||
+	       (IS_ENABLED(CONFIG_USB_PD_DUAL_ROLE_AUTO_TOGGLE) &&
+		state == TC_DRP_AUTO_TOGGLE) ||
+	       (IS_ENABLED(CONFIG_USB_PD_TCPC_LOW_POWER) &&
+		state == TC_LOW_POWER_MODE);
+}
+
 void tc_pd_connection(int port, int en)
 {
 	if (en) {
@@ -829,7 +814,7 @@ void tc_pr_swap_complete(int port, bool success)
 		 * Note: Swap in progress should not be cleared until the
 		 * debounce is completed.
 		 */
-		tc[port].vbus_debounce_time = get_time().val + PD_T_DEBOUNCE;
+		pd_timer_enable(port, TC_TIMER_VBUS_DEBOUNCE, PD_T_DEBOUNCE);
 	} else {
 		/* PR Swap is no longer in progress */
 		TC_CLR_FLAG(port, TC_FLAGS_PR_SWAP_IN_PROGRESS);
@@ -856,7 +841,7 @@ void tc_prs_src_snk_assert_rd(int port)
 		 * DebugAccessory.SNK assert Rd
 		 */
 		TC_SET_FLAG(port, TC_FLAGS_REQUEST_PR_SWAP);
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 	}
 }
 
@@ -872,7 +857,7 @@ void tc_prs_snk_src_assert_rp(int port)
 		 * UnorientedDebugAccessory.SRC to assert Rp
 		 */
 		TC_SET_FLAG(port, TC_FLAGS_REQUEST_PR_SWAP);
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 	}
 }
 
@@ -893,7 +878,7 @@ void tc_prs_snk_src_assert_rp(int port)
 void tc_hard_reset_request(int port)
 {
 	TC_SET_FLAG(port, TC_FLAGS_HARD_RESET_REQUESTED);
-	task_wake(PD_PORT_TO_TASK_ID(port));
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 }
 
 void tc_disc_ident_in_progress(int port)
@@ -1005,6 +990,12 @@ void pd_set_suspend(int port, int suspend)
 
 		TC_SET_FLAG(port, TC_FLAGS_SUSPEND);
 
+		/*
+		 * Wake the port first: with a shared PD task, the task we are
+		 * running from may be the one which runs it.
+		 */
+		pd_task_set_event(port, TASK_EVENT_WAKE);
+
 		/*
 		 * Avoid deadlock when running from task
 		 * which we are going to suspend
@@ -1012,8 +1003,6 @@ void pd_set_suspend(int port, int suspend)
 		if (PD_PORT_TO_TASK_ID(port) == task_get_current())
 			return;
 
-		task_wake(PD_PORT_TO_TASK_ID(port));
-
 		/* Sleep this task if we are not suspended */
 		while (pd_is_port_enabled(port)) {
 			if (++wait > SUSPEND_SLEEP_RETRIES) {
@@ -1025,7 +1014,7 @@ void pd_set_suspend(int port, int suspend)
 		}
 	} else {
 		TC_CLR_FLAG(port, TC_FLAGS_SUSPEND);
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 	}
 }
 
@@ -1233,7 +1222,7 @@ static bool tc_perform_src_hard_reset(int port)
 		tc_set_data_role(port, PD_ROLE_DFP);
 
 		tc[port].ps_reset_state = PS_STATE1;
-		tc[port].timeout = get_time().val + PD_T_SRC_RECOVER;
+		pd_timer_enable(port, TC_TIMER_TIMEOUT, PD_T_SRC_RECOVER);
 		return false;
 	case PS_STATE1:
 		/* Enable VBUS */
@@ -1246,8 +1235,8 @@ static bool tc_perform_src_hard_reset(int port)
 		set_vconn(port, 1);
 
 		tc[port].ps_reset_state = PS_STATE2;
-		tc[port].timeout = get_time().val +
-				PD_POWER_SUPPLY_TURN_ON_DELAY;
+		pd_timer_enable(port, TC_TIMER_TIMEOUT,
+				PD_POWER_SUPPLY_TURN_ON_DELAY);
 		return false;
 	case PS_STATE2:
 		/* Tell Policy Engine Hard Reset is complete */
@@ -1290,11 +1279,11 @@ static bool tc_perform_snk_hard_reset(int port)
 
 		/* Wait tSafe0V + tSrcRecover, then check for Vbus presence */
 		tc[port].ps_reset_state = PS_STATE1;
-		tc[port].timeout = get_time().val + PD_T_SAFE_0V +
-							PD_T_SRC_RECOVER_MAX;
+		pd_timer_enable(port, TC_TIMER_TIMEOUT,
+				PD_T_SAFE_0V + PD_T_SRC_RECOVER_MAX);
 		return false;
 	case PS_STATE1:
-		if (get_time().val < tc[port].timeout)
+		if (!pd_timer_is_expired(port, TC_TIMER_TIMEOUT))
 			return false;
 
 		/* Power shut off? Disable AutoDischargeDisconnect */
@@ -1303,7 +1292,7 @@ static bool tc_perform_snk_hard_reset(int port)
 
 		/* Watch for Vbus to return */
 		tc[port].ps_reset_state = PS_STATE2;
-		tc[port].timeout = get_time().val + PD_T_SRC_TURN_ON;
+		pd_timer_enable(port, TC_TIMER_TIMEOUT, PD_T_SRC_TURN_ON);
 		return false;
 	case PS_STATE2:
 		if (pd_is_vbus_present(port)) {
@@ -1324,7 +1313,7 @@ static bool tc_perform_snk_hard_reset(int port)
 			 * now, such that we'll actually reset the correct input
 			 * current limit.
 			 */
-			tc[port].cc_debounce = get_time().val;
+			pd_timer_enable(port, TC_TIMER_CC_DEBOUNCE, 0);
 			sink_power_sub_states(port);
 
 			/* Power is back, Enable AutoDischargeDisconnect */
@@ -1334,7 +1323,7 @@ static bool tc_perform_snk_hard_reset(int port)
 		/*
 		 * If Vbus isn't back after wait + tSrcTurnOn, go unattached
 		 */
-		if (get_time().val > tc[port].timeout) {
+		if (pd_timer_is_expired(port, TC_TIMER_TIMEOUT)) {
 			tc[port].ps_reset_state = PS_STATE0;
 			set_state_tc(port, TC_UNATTACHED_SNK);
 			return true;
@@ -1408,14 +1397,13 @@ void tc_state_init(int port)
 {
 	enum usb_tc_state first_state;
 
-	/* For test builds, replicate static initialization */
+	/*
+	 * For test builds, replicate static initialization. Only for this
+	 * port, as a shared PD task initializes its ports one at a time.
+	 */
 	if (IS_ENABLED(TEST_BUILD)) {
-		int i;
-
-		for (i = 0; i < CONFIG_USB_PD_PORT_MAX_COUNT; ++i) {
-			memset(&tc[i], 0, sizeof(tc[i]));
-			drp_state[i] = CONFIG_USB_PD_INITIAL_DRP_STATE;
-		}
+		memset(&tc[port], 0, sizeof(tc[port]));
+		drp_state[port] = CONFIG_USB_PD_INITIAL_DRP_STATE;
 	}
 
 	/* If port is not available, there is nothing to initialize */
@@ -1544,7 +1532,7 @@ static void print_current_state(const int port)
 
 static void handle_device_access(int port)
 {
-	tc[port].low_power_time = get_time().val + PD_LPM_DEBOUNCE_US;
+	pd_timer_enable(port, TC_TIMER_LOW_POWER_TIME, PD_LPM_DEBOUNCE_US);
 }
 
 void tc_event_check(int port, int evt)
@@ -1766,7 +1754,7 @@ void pd_request_vconn_swap_off(int port)
 	if (get_state_tc(port) == TC_ATTACHED_SRC ||
 			get_state_tc(port) == TC_ATTACHED_SNK) {
 		TC_SET_FLAG(port, TC_FLAGS_REQUEST_VC_SWAP_OFF);
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 	}
 }
 
@@ -1775,7 +1763,7 @@ void pd_request_vconn_swap_on(int port)
 	if (get_state_tc(port) == TC_ATTACHED_SRC ||
 			get_state_tc(port) == TC_ATTACHED_SNK) {
 		TC_SET_FLAG(port, TC_FLAGS_REQUEST_VC_SWAP_ON);
-		task_wake(PD_PORT_TO_TASK_ID(port));
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 	}
 }
 
@@ -1844,7 +1832,7 @@ void pd_wait_exit_low_power(int port)
 	if (!TC_CHK_FLAG(port, TC_FLAGS_LPM_ENGAGED))
 		return;
 
-	if (port == TASK_ID_TO_PD_PORT(task_get_current())) {
+	if (task_get_current() == PD_PORT_TO_TASK_ID(port)) {
 		if (!TC_CHK_FLAG(port, TC_FLAGS_LPM_TRANSITION))
 			reset_device_and_notify(port);
 	} else {
@@ -1859,7 +1847,7 @@ void pd_wait_exit_low_power(int port)
 		 * happen much, but it if starts occurring, we can add a guard
 		 * to prevent/reduce it.
 		 */
-		task_set_event(PD_PORT_TO_TASK_ID(port), PD_EVENT_TCPC_RESET);
+		pd_task_set_event(port, PD_EVENT_TCPC_RESET);
 		task_wait_event_mask(TASK_EVENT_PD_AWAKE, -1);
 	}
 }
@@ -1870,11 +1858,10 @@ void pd_wait_exit_low_power(int port)
  */
 void pd_device_accessed(int port)
 {
-	if (port == TASK_ID_TO_PD_PORT(task_get_current()))
+	if (task_get_current() == PD_PORT_TO_TASK_ID(port))
 		handle_device_access(port);
 	else
-		task_set_event(PD_PORT_TO_TASK_ID(port),
-			       PD_EVENT_DEVICE_ACCESSED);
+		pd_task_set_event(port, PD_EVENT_DEVICE_ACCESSED);
 }
 
 /*
@@ -1914,16 +1901,15 @@ static void sink_power_sub_states(int port)
 	/* Debounce the cc state */
 	if (new_cc_voltage != tc[port].cc_voltage) {
 		tc[port].cc_voltage = new_cc_voltage;
-		tc[port].cc_debounce =
-				get_time().val + PD_T_RP_VALUE_CHANGE;
+		pd_timer_enable(port, TC_TIMER_CC_DEBOUNCE,
+				PD_T_RP_VALUE_CHANGE);
 		return;
 	}
 
-	if (tc[port].cc_debounce == 0 ||
-				get_time().val < tc[port].cc_debounce)
+	if (!pd_timer_is_expired(port, TC_TIMER_CC_DEBOUNCE))
 		return;
 
-	tc[port].cc_debounce = 0;
+	pd_timer_disable(port, TC_TIMER_CC_DEBOUNCE);
 
 	if (IS_ENABLED(CONFIG_CHARGE_MANAGER)) {
 		tc[port].typec_curr = usb_get_typec_current_limit(
@@ -1962,7 +1948,9 @@ static void tc_disabled_run(const int port)
 	if (!TC_CHK_FLAG(port, TC_FLAGS_SUSPEND))
 		set_state_tc(port, TC_UNATTACHED_SNK);
 
-	task_wait_event(-1);
+	/* A task shared with other ports mustn't stop for this one */
+	if (!IS_ENABLED(CONFIG_USB_PD_SHARED_TASK))
+		task_wait_event(-1);
 }
 
 static void tc_disabled_exit(const int port)
@@ -1988,12 +1976,12 @@ static void tc_error_recovery_entry(const int port)
 {
 	print_current_state(port);
 
-	tc[port].timeout = get_time().val + PD_T_ERROR_RECOVERY;
+	pd_timer_enable(port, TC_TIMER_TIMEOUT, PD_T_ERROR_RECOVERY);
 }
 
 static void tc_error_recovery_run(const int port)
 {
-	if (get_time().val < tc[port].timeout)
+	if (!pd_timer_is_expired(port, TC_TIMER_TIMEOUT))
 		return;
 
 	/*
@@ -2061,7 +2049,7 @@ static void tc_unattached_snk_entry(const int port)
 	 * can restore state from any previous data swap.
 	 */
 	pd_execute_data_swap(port, PD_ROLE_DISCONNECTED);
-	tc[port].next_role_swap = get_time().val + PD_T_DRP_SNK;
+	pd_timer_enable(port, TC_TIMER_NEXT_ROLE_SWAP, PD_T_DRP_SNK);
 
 	if (IS_ENABLED(CONFIG_USBC_SS_MUX))
 		usb_mux_set(port, USB_PD_MUX_NONE,
@@ -2117,7 +2105,7 @@ static void tc_unattached_snk_run(const int port)
 	if (cc_is_rp(cc1) || cc_is_rp(cc2)) {
 		/* Connection Detected */
 		set_state_tc(port, TC_ATTACH_WAIT_SNK);
-	} else if (get_time().val > tc[port].next_role_swap &&
+	} else if (pd_timer_is_expired(port, TC_TIMER_NEXT_ROLE_SWAP) &&
 		   drp_state[port] == PD_DRP_TOGGLE_ON) {
 		/* DRP Toggle */
 		set_state_tc(port, TC_UNATTACHED_SRC);
@@ -2160,8 +2148,8 @@ static void tc_attach_wait_snk_run(const int port)
 
 	/* Debounce the cc state */
 	if (new_cc_state != tc[port].cc_state) {
-		tc[port].cc_debounce = get_time().val + PD_T_CC_DEBOUNCE;
-		tc[port].pd_debounce = get_time().val + PD_T_PD_DEBOUNCE;
+		pd_timer_enable(port, TC_TIMER_CC_DEBOUNCE, PD_T_CC_DEBOUNCE);
+		pd_timer_enable(port, TC_TIMER_PD_DEBOUNCE, PD_T_PD_DEBOUNCE);
 		tc[port].cc_state = new_cc_state;
 		return;
 	}
@@ -2173,7 +2161,7 @@ static void tc_attach_wait_snk_run(const int port)
 	 * Unattached.SNK.
 	 */
 	if (new_cc_state == PD_CC_NONE &&
-				get_time().val > tc[port].pd_debounce) {
+	    pd_timer_is_expired(port, TC_TIMER_PD_DEBOUNCE)) {
 		if (IS_ENABLED(CONFIG_USB_PE_SM) &&
 				IS_ENABLED(CONFIG_USB_PD_ALT_MODE_DFP)) {
 			pd_dfp_exit_mode(port, TCPC_TX_SOP, 0, 0);
@@ -2192,7 +2180,7 @@ static void tc_attach_wait_snk_run(const int port)
 	}
 
 	/* Wait for CC debounce */
-	if (get_time().val < tc[port].cc_debounce)
+	if (!pd_timer_is_expired(port, TC_TIMER_CC_DEBOUNCE))
 		return;
 
 	/*
@@ -2306,7 +2294,7 @@ static void tc_attached_snk_entry(const int port)
 		tcpm_enable_auto_discharge_disconnect(port, 1);
 	}
 
-	tc[port].cc_debounce = 0;
+	pd_timer_disable(port, TC_TIMER_CC_DEBOUNCE);
 
 	/* Enable PD */
 	if (IS_ENABLED(CONFIG_USB_PE_SM))
@@ -2351,7 +2339,7 @@ static void tc_attached_snk_run(const int port)
 	 * Debounce Vbus before we drop that we are doing a PR_Swap
 	 */
 	if (TC_CHK_FLAG(port, TC_FLAGS_PR_SWAP_IN_PROGRESS) &&
-	    tc[port].vbus_debounce_time < get_time().val) {
+	    pd_timer_is_expired(port, TC_TIMER_VBUS_DEBOUNCE)) {
 		/* PR Swap is no longer in progress */
 		TC_CLR_FLAG(port, TC_FLAGS_PR_SWAP_IN_PROGRESS);
 
@@ -2559,7 +2547,7 @@ static void tc_unattached_src_entry(const int port)
 		tc_enable_pd(port, 0);
 	}
 
-	tc[port].next_role_swap = get_time().val + PD_T_DRP_SRC;
+	pd_timer_enable(port, TC_TIMER_NEXT_ROLE_SWAP, PD_T_DRP_SRC);
 }
 
 static void tc_unattached_src_run(const int port)
@@ -2597,7 +2585,7 @@ static void tc_unattached_src_run(const int port)
 	 */
 	if (cc_is_at_least_one_rd(cc1, cc2) || cc_is_audio_acc(cc1, cc2))
 		set_state_tc(port, TC_ATTACH_WAIT_SRC);
-	else if (get_time().val > tc[port].next_role_swap &&
+	else if (pd_timer_is_expired(port, TC_TIMER_NEXT_ROLE_SWAP) &&
 		 drp_state[port] != PD_DRP_FORCE_SOURCE &&
 		 drp_state[port] != PD_DRP_FREEZE)
 		set_state_tc(port, TC_UNATTACHED_SNK);
@@ -2655,13 +2643,13 @@ static void tc_attach_wait_src_run(const int port)
 
 	/* Debounce the cc state */
 	if (new_cc_state != tc[port].cc_state) {
-		tc[port].cc_debounce = get_time().val + PD_T_CC_DEBOUNCE;
+		pd_timer_enable(port, TC_TIMER_CC_DEBOUNCE, PD_T_CC_DEBOUNCE);
 		tc[port].cc_state = new_cc_state;
 		return;
 	}
 
 	/* Wait for CC debounce */
-	if (get_time().val < tc[port].cc_debounce)
+	if (!pd_timer_is_expired(port, TC_TIMER_CC_DEBOUNCE))
 		return;
 
 	/*
@@ -2696,8 +2684,8 @@ static void tc_attached_src_entry(const int port)
 
 	print_current_state(port);
 
-	/* Run function relies on timeout being 0 or meaningful */
-	tc[port].timeout = 0;
+	/* Run function relies on timeout being disabled or meaningful */
+	pd_timer_disable(port, TC_TIMER_TIMEOUT);
 
 	/*
 	 * Known state of attach is SRC.  We need to apply this pull value
@@ -2772,9 +2760,9 @@ static void tc_attached_src_entry(const int port)
 			typec_update_cc(port);
 
 			tc_enable_pd(port, 0);
-			tc[port].timeout = get_time().val +
-				MAX(PD_POWER_SUPPLY_TURN_ON_DELAY,
-				    PD_T_VCONN_STABLE);
+			pd_timer_enable(port, TC_TIMER_TIMEOUT,
+					MAX(PD_POWER_SUPPLY_TURN_ON_DELAY,
+					    PD_T_VCONN_STABLE));
 		}
 	} else {
 		/* Get connector orientation */
@@ -2885,9 +2873,9 @@ static void tc_attached_src_run(const int port)
 	 * Enable PD communications after power supply has fully
 	 * turned on
 	 */
-	if (tc[port].timeout > 0 && get_time().val > tc[port].timeout) {
+	if (pd_timer_is_expired(port, TC_TIMER_TIMEOUT)) {
 		tc_enable_pd(port, 1);
-		tc[port].timeout = 0;
+		pd_timer_disable(port, TC_TIMER_TIMEOUT);
 	}
 
 	if (!tc_get_pd_enabled(port))
@@ -2898,7 +2886,8 @@ static void tc_attached_src_run(const int port)
 	 */
 	if (TC_CHK_FLAG(port, TC_FLAGS_HARD_RESET_REQUESTED)) {
 		/* Ignoring Hard Resets while the power supply is resetting.*/
-		if (get_time().val < tc[port].timeout)
+		if (!pd_timer_is_disabled(port, TC_TIMER_TIMEOUT) &&
+		    !pd_timer_is_expired(port, TC_TIMER_TIMEOUT))
 			return;
 
 		if (tc_perform_src_hard_reset(port))
@@ -3078,7 +3067,8 @@ __maybe_unused static void tc_drp_auto_toggle_entry(const int port)
 	 * for the minimum of DRP SNK or SRC so the first toggle cause by
 	 * transition into auto toggle doesn't violate spec timing.
 	 */
-	tc[port].timeout = get_time().val + MAX(PD_T_DRP_SNK, PD_T_DRP_SRC);
+	pd_timer_enable(port, TC_TIMER_TIMEOUT,
+			MAX(PD_T_DRP_SNK, PD_T_DRP_SRC));
 }
 
 __maybe_unused static void tc_drp_auto_toggle_run(const int port)
@@ -3093,11 +3083,11 @@ __maybe_unused static void tc_drp_auto_toggle_run(const int port)
 	if (TC_CHK_FLAG(port, TC_FLAGS_CHECK_CONNECTION))
 		check_drp_connection(port);
 
-	else if (tc[port].timeout != TIMER_DISABLED) {
-		if (tc[port].timeout > get_time().val)
+	else if (!pd_timer_is_disabled(port, TC_TIMER_TIMEOUT)) {
+		if (!pd_timer_is_expired(port, TC_TIMER_TIMEOUT))
 			return;
 
-		tc[port].timeout = TIMER_DISABLED;
+		pd_timer_disable(port, TC_TIMER_TIMEOUT);
 		tcpm_enable_drp_toggle(port);
 
 		if (IS_ENABLED(CONFIG_USB_PD_TCPC_LOW_POWER)) {
@@ -3112,8 +3102,8 @@ __maybe_unused static void tc_low_power_mode_entry(const int port)
 		assert(0);
 
 	print_current_state(port);
-	tc[port].low_power_time = get_time().val + PD_LPM_DEBOUNCE_US;
-	tc[port].low_power_exit_time = 0;
+	pd_timer_enable(port, TC_TIMER_LOW_POWER_TIME, PD_LPM_DEBOUNCE_US);
+	pd_timer_disable(port, TC_TIMER_LOW_POWER_EXIT_TIME);
 }
 
 __maybe_unused static void tc_low_power_mode_run(const int port)
@@ -3122,13 +3112,12 @@ __maybe_unused static void tc_low_power_mode_run(const int port)
 		assert(0);
 
 	if (TC_CHK_FLAG(port, TC_FLAGS_CHECK_CONNECTION)) {
-		uint64_t now = get_time().val;
-
 		tc_start_event_loop(port);
-		if (tc[port].low_power_exit_time == 0) {
-			tc[port].low_power_exit_time = now
-				+ PD_LPM_EXIT_DEBOUNCE_US;
-		} else if (now > tc[port].low_power_exit_time) {
+		if (pd_timer_is_disabled(port, TC_TIMER_LOW_POWER_EXIT_TIME)) {
+			pd_timer_enable(port, TC_TIMER_LOW_POWER_EXIT_TIME,
+					PD_LPM_EXIT_DEBOUNCE_US);
+		} else if (pd_timer_is_expired(port,
+					       TC_TIMER_LOW_POWER_EXIT_TIME)) {
 			CPRINTS("C%d: Exit Low Power Mode", port);
 			check_drp_connection(port);
 		}
@@ -3136,9 +3125,10 @@ __maybe_unused static void tc_low_power_mode_run(const int port)
 	}
 
 	if (tc[port].tasks_preventing_lpm)
-		tc[port].low_power_time = get_time().val + PD_LPM_DEBOUNCE_US;
+		pd_timer_enable(port, TC_TIMER_LOW_POWER_TIME,
+				PD_LPM_DEBOUNCE_US);
 
-	if (get_time().val > tc[port].low_power_time) {
+	if (pd_timer_is_expired(port, TC_TIMER_LOW_POWER_TIME)) {
 		CPRINTS("C%d: TCPC Enter Low Power Mode", port);
 		TC_SET_FLAG(port, TC_FLAGS_LPM_ENGAGED);
 		TC_SET_FLAG(port, TC_FLAGS_LPM_TRANSITION);
@@ -3146,7 +3136,7 @@ __maybe_unused static void tc_low_power_mode_run(const int port)
 		TC_CLR_FLAG(port, TC_FLAGS_LPM_TRANSITION);
 		tc_pause_event_loop(port);
 
-		tc[port].low_power_exit_time = 0;
+		pd_timer_disable(port, TC_TIMER_LOW_POWER_EXIT_TIME);
 	}
 }
 
@@ -3165,8 +3155,8 @@ static void tc_try_src_entry(const int port)
 	print_current_state(port);
 
 	tc[port].cc_state = PD_CC_UNSET;
-	tc[port].try_wait_debounce = get_time().val + PD_T_DRP_TRY;
-	tc[port].timeout = get_time().val + PD_T_TRY_TIMEOUT;
+	pd_timer_enable(port, TC_TIMER_TRY_WAIT_DEBOUNCE, PD_T_DRP_TRY);
+	pd_timer_enable(port, TC_TIMER_TIMEOUT, PD_T_TRY_TIMEOUT);
 
 	/*
 	 * We are a SNK but would prefer to be a SRC.  Set the pull to
@@ -3199,7 +3189,7 @@ static void tc_try_src_run(const int port)
 	/* Debounce the cc state */
 	if (new_cc_state != tc[port].cc_state) {
 		tc[port].cc_state = new_cc_state;
-		tc[port].cc_debounce = get_time().val + PD_T_CC_DEBOUNCE;
+		pd_timer_enable(port, TC_TIMER_CC_DEBOUNCE, PD_T_CC_DEBOUNCE);
 	}
 
 	/*
@@ -3207,7 +3197,7 @@ static void tc_try_src_run(const int port)
 	 * detected on exactly one of the CC1 or CC2 pins for at least
 	 * tTryCCDebounce.
 	 */
-	if (get_time().val > tc[port].cc_debounce &&
+	if (pd_timer_is_expired(port, TC_TIMER_CC_DEBOUNCE) &&
 	    new_cc_state == PD_CC_UFP_ATTACHED)
 		set_state_tc(port, TC_ATTACHED_SRC);
 
@@ -3217,9 +3207,9 @@ static void tc_try_src_run(const int port)
 	 * or after tTryTimeout and the SRC.Rd state has not been detected.
 	 */
 	if (new_cc_state == PD_CC_NONE) {
-		if ((get_time().val > tc[port].try_wait_debounce &&
+		if ((pd_timer_is_expired(port, TC_TIMER_TRY_WAIT_DEBOUNCE) &&
 		     pd_check_vbus_level(port, VBUS_SAFE0V)) ||
-		    get_time().val > tc[port].timeout) {
+		    pd_timer_is_expired(port, TC_TIMER_TIMEOUT)) {
 			set_state_tc(port, TC_TRY_WAIT_SNK);
 		}
 	}
@@ -3239,7 +3229,7 @@ static void tc_try_wait_snk_entry(const int port)
 
 	tc_enable_pd(port, 0);
 	tc[port].cc_state = PD_CC_UNSET;
-	tc[port].try_wait_debounce = get_time().val + PD_T_CC_DEBOUNCE;
+	pd_timer_enable(port, TC_TIMER_TRY_WAIT_DEBOUNCE, PD_T_CC_DEBOUNCE);
 
 	/*
 	 * We were a SNK, tried to be a SRC and it didn't work out. Try to
@@ -3272,14 +3262,14 @@ static void tc_try_wait_snk_run(const int port)
 	/* Debounce the cc state */
 	if (new_cc_state != tc[port].cc_state) {
 		tc[port].cc_state = new_cc_state;
-		tc[port].pd_debounce = get_time().val + PD_T_PD_DEBOUNCE;
+		pd_timer_enable(port, TC_TIMER_PD_DEBOUNCE, PD_T_PD_DEBOUNCE);
 	}
 
 	/*
 	 * The port shall transition to Unattached.SNK when the state of both
 	 * of the CC1 and CC2 pins is SNK.Open for at least tPDDebounce.
 	 */
-	if ((get_time().val > tc[port].pd_debounce) &&
+	if ((pd_timer_is_expired(port, TC_TIMER_PD_DEBOUNCE)) &&
 						(new_cc_state == PD_CC_NONE)) {
 		set_state_tc(port, TC_UNATTACHED_SNK);
 		return;
@@ -3289,7 +3279,7 @@ static void tc_try_wait_snk_run(const int port)
 	 * The port shall transition to Attached.SNK after tCCDebounce if or
 	 * when VBUS is detected.
 	 */
-	if (get_time().val > tc[port].try_wait_debounce &&
+	if (pd_timer_is_expired(port, TC_TIMER_TRY_WAIT_DEBOUNCE) &&
 	    pd_is_vbus_present(port))
 		set_state_tc(port, TC_ATTACHED_SNK);
 }
@@ -3325,7 +3315,7 @@ __maybe_unused static void tc_ct_unattached_snk_entry(int port)
 	 */
 	tc_enable_pd(port, 0);
 
-	tc[port].timeout = get_time().val + PD_POWER_SUPPLY_TURN_ON_DELAY;
+	pd_timer_enable(port, TC_TIMER_TIMEOUT, PD_POWER_SUPPLY_TURN_ON_DELAY);
 }
 
 __maybe_unused static void tc_ct_unattached_snk_run(int port)
@@ -3337,12 +3327,12 @@ __maybe_unused static void tc_ct_unattached_snk_run(int port)
 	if (!IS_ENABLED(CONFIG_USB_PE_SM))
 		assert(0);
 
-	if (tc[port].timeout > 0 && get_time().val > tc[port].timeout) {
+	if (pd_timer_is_expired(port, TC_TIMER_TIMEOUT)) {
 		tc_enable_pd(port, 1);
-		tc[port].timeout = 0;
+		pd_timer_disable(port, TC_TIMER_TIMEOUT);
 	}
 
-	if (tc[port].timeout > 0)
+	if (!pd_timer_is_disabled(port, TC_TIMER_TIMEOUT))
 		return;
 
 	/* Wait until Protocol Layer is ready */
@@ -3371,14 +3361,14 @@ __maybe_unused static void tc_ct_unattached_snk_run(int port)
 	/* Debounce the cc state */
 	if (new_cc_state != tc[port].cc_state) {
 		tc[port].cc_state = new_cc_state;
-		tc[port].cc_debounce = get_time().val + PD_T_VPDDETACH;
+		pd_timer_enable(port, TC_TIMER_CC_DEBOUNCE, PD_T_VPDDETACH);
 	}
 
 	/*
 	 * The port shall transition to Unattached.SNK if the state of
 	 * the CC pin is SNK.Open for tVPDDetach after VBUS is vSafe0V.
 	 */
-	if (get_time().val > tc[port].cc_debounce) {
+	if (pd_timer_is_expired(port, TC_TIMER_CC_DEBOUNCE)) {
 		if (new_cc_state == PD_CC_NONE &&
 		    pd_check_vbus_level(port, VBUS_SAFE0V)) {
 			if (IS_ENABLED(CONFIG_USB_PD_ALT_MODE_DFP)) {
@@ -3,6 +3,7 @@
  * found in the LICENSE file.
  */
 
+#include "atomic.h"
 #include "battery.h"
 #include "battery_smart.h"
 #include "board.h"
@@ -23,6 +24,7 @@
 #include "usb_charge.h"
 #include "usb_mux.h"
 #include "usb_pd.h"
+#include "usb_pd_timer.h"
 #include "usb_prl_sm.h"
 #include "tcpm/tcpm.h"
 #include "usb_pe_sm.h"
@@ -32,6 +34,7 @@
 #include "usbc_ppc.h"
 #include "version.h"
 
+/* The longest the PD task sleeps while a port may need polling */
 #define USBC_EVENT_TIMEOUT (5 * MSEC)
 
 #define CPRINTF(format, args...) cprintf(CC_USBPD, format, ## args)
@@ -52,12 +55,13 @@ void tc_start_event_loop(int port)
 	 */
 	if (paused[port]) {
 		paused[port] = 0;
-		task_set_event(PD_PORT_TO_TASK_ID(port), TASK_EVENT_WAKE);
+		pd_task_set_event(port, TASK_EVENT_WAKE);
 	}
 }
 
 static void pd_task_init(int port)
 {
+	pd_timer_init(port);
 	if (IS_ENABLED(CONFIG_USB_TYPEC_SM))
 		tc_state_init(port);
 	paused[port] = 0;
@@ -73,21 +77,37 @@ static void pd_task_init(int port)
 		schedule_deferred_pd_interrupt(port);
 }
 
-static bool pd_task_loop(int port)
+/*
+ * How long the PD task may sleep before one of the port's timers expires.
+ * The state machines still poll some hardware state, so unless the port is
+ * idle this is capped at USBC_EVENT_TIMEOUT.
+ */
+static int pd_task_timeout(int port)
 {
-	/* wait for next event/packet or timeout expiration */
-	const uint32_t evt =
-		task_wait_event(paused[port]
-					? -1
-					: USBC_EVENT_TIMEOUT);
+	int timeout;
 
-	/*
-	 * Re-use TASK_EVENT_RESET_DONE in tests to restart the USB task
-	 * if this code is running in a unit test.
-	 */
-	if (IS_ENABLED(TEST_BUILD) && (evt & TASK_EVENT_RESET_DONE))
-		return false;
+	if (paused[port])
+		return -1;
+
+	/* A disabled port waits for pd_set_suspend() to wake it */
+	if (IS_ENABLED(CONFIG_USB_PD_SHARED_TASK) && !pd_is_port_enabled(port))
+		return -1;
 
+	timeout = pd_timer_next_expiration(port);
+
+	if (IS_ENABLED(CONFIG_USB_PD_IDLE_SLEEP) &&
+	    IS_ENABLED(CONFIG_USB_TYPEC_SM) && tc_is_idle(port))
+		return timeout;
+
+	if (timeout < 0 || timeout > USBC_EVENT_TIMEOUT)
+		return USBC_EVENT_TIMEOUT;
+
+	return timeout;
+}
+
+/* Run the state machines of a port, for the events it's been sent */
+static void pd_port_run(int port, uint32_t evt)
+{
 	/* handle events that affect the state machine as a whole */
 	if (IS_ENABLED(CONFIG_USB_TYPEC_SM))
 		tc_event_check(port, evt);
@@ -110,6 +130,127 @@ static bool pd_task_loop(int port)
 	/* Run TypeC state machine */
 	if (IS_ENABLED(CONFIG_USB_TYPEC_SM))
 		tc_run(port);
+}
+
+#ifdef CONFIG_USB_PD_SHARED_TASK
+
+#define NO_DEADLINE UINT64_MAX
+
+/* Events set for each port, which the PD task hasn't handled yet */
+static atomic_t port_events[CONFIG_USB_PD_PORT_MAX_COUNT];
+/* When each port next needs to run, if it isn't sent events before */
+test_export_static uint64_t port_deadline[CONFIG_USB_PD_PORT_MAX_COUNT];
+/* The port the PD task is running */
+static int current_port;
+
+void pd_task_set_event(int port, uint32_t event)
+{
+	atomic_or(&port_events[port], event);
+	task_set_event(TASK_ID_PD_C0, PD_EVENT_PORT_PENDING);
+}
+
+int pd_task_get_port(void)
+{
+	return current_port;
+}
+
+static void pd_port_set_deadline(int port)
+{
+	const int timeout = pd_task_timeout(port);
+
+	port_deadline[port] = timeout < 0 ? NO_DEADLINE :
+					    get_time().val + timeout;
+}
+
+static bool pd_task_loop(void)
+{
+	const int port_count = board_get_usb_pd_port_count();
+	uint64_t next = NO_DEADLINE;
+	uint64_t now;
+	uint32_t evt = 0;
+	uint32_t port_evt;
+	int port;
+
+	/* wait for the next event, or for the first port's deadline */
+	for (port = 0; port < port_count; port++)
+		next = MIN(next, port_deadline[port]);
+
+	now = get_time().val;
+	if (next == NO_DEADLINE)
+		evt = task_wait_event(-1);
+	else if (next > now)
+		evt = task_wait_event(MIN(next - now, INT32_MAX));
+
+	/*
+	 * Re-use TASK_EVENT_RESET_DONE in tests to restart the USB task
+	 * if this code is running in a unit test.
+	 */
+	if (IS_ENABLED(TEST_BUILD) && (evt & TASK_EVENT_RESET_DONE))
+		return false;
+
+	/*
+	 * Events set on the task itself, rather than through
+	 * pd_task_set_event(), are for every port.
+	 */
+	evt &= ~(PD_EVENT_PORT_PENDING | TASK_EVENT_TIMER);
+
+	/* Run the ports which have events, or have reached their deadline */
+	now = get_time().val;
+	for (port = 0; port < port_count; port++) {
+		port_evt = atomic_clear(&port_events[port]) | evt;
+		if (!port_evt) {
+			if (now < port_deadline[port])
+				continue;
+			port_evt = TASK_EVENT_TIMER;
+		}
+
+		current_port = port;
+		pd_port_run(port, port_evt);
+		pd_port_set_deadline(port);
+	}
+
+	return true;
+}
+
+void pd_task(void *u)
+{
+	const int port_count = board_get_usb_pd_port_count();
+	int port;
+
+	while (1) {
+		for (port = 0; port < port_count; port++) {
+			current_port = port;
+			atomic_clear(&port_events[port]);
+			pd_task_init(port);
+			pd_port_set_deadline(port);
+		}
+
+		/* As long as pd_task_loop returns true, keep running the loop.
+		 * pd_task_loop returns false when the code needs to re-init
+		 * the task, so once the code breaks out of the inner while
+		 * loop, the re-init code at the top of the outer while loop
+		 * will run.
+		 */
+		while (pd_task_loop())
+			continue;
+	}
+}
+
+#else /* !CONFIG_USB_PD_SHARED_TASK */
+
+static bool pd_task_loop(int port)
+{
+	/* wait for next event/packet or timeout expiration */
+	const uint32_t evt = task_wait_event(pd_task_timeout(port));
+
+	/*
+	 * Re-use TASK_EVENT_RESET_DONE in tests to restart the USB task
+	 * if this code is running in a unit test.
+	 */
+	if (IS_ENABLED(TEST_BUILD) && (evt & TASK_EVENT_RESET_DONE))
+		return false;
+
+	pd_port_run(port, evt);
 
 	return true;
 }
@@ -137,3 +278,5 @@ void pd_task(void *u)
 			continue;
 	}
 }
+
+#endif /* CONFIG_USB_PD_SHARED_TASK */
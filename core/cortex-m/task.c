@@ -219,11 +219,25 @@ static inline task_ *__task_id_to_ptr(task_id_t id)
 
 void interrupt_disable(void)
 {
+#ifdef CONFIG_IRQ_PROFILE
+	uint32_t primask;
+
+	/* Only a region which starts here is timed; not nested disables */
+	asm volatile("mrs %0, primask" : "=r"(primask));
+	asm volatile("cpsid i");
+	if (!primask)
+		irq_profile_disabled((uintptr_t)__builtin_return_address(0),
+				     get_time().le.lo);
+#else
 	asm("cpsid i");
+#endif
 }
 
 void interrupt_enable(void)
 {
+#ifdef CONFIG_IRQ_PROFILE
+	irq_profile_enabling(get_time().le.lo);
+#endif
 	asm("cpsie i");
 }
 
@@ -264,6 +278,14 @@ int task_start_called(void)
 	return start_called;
 }
 
+const char *task_get_name(task_id_t tskid)
+{
+	if (tskid < ARRAY_SIZE(task_names))
+		return task_names[tskid];
+
+	return "<< unknown >>";
+}
+
 /**
  * Scheduling system call
  */
@@ -345,6 +367,11 @@ void svc_handler(int desched, task_id_t resched)
 #ifdef CONFIG_TASK_PROFILING
 	task_switches++;
 #endif
+	/* The first switch is away from the scratchpad, not a task */
+	if (IS_ENABLED(CONFIG_TASK_SCHED_STATS))
+		task_sched_stats_switch(current == (task_ *)scratchpad ?
+					TASK_ID_INVALID : current - tasks,
+					next - tasks, get_time().le.lo);
 	current_task = next;
 	__switchto(current, next);
 }
@@ -431,6 +458,11 @@ uint32_t task_set_event(task_id_t tskid, uint32_t event)
 	task_ *receiver = __task_id_to_ptr(tskid);
 	ASSERT(receiver);
 
+	/* Until the first switch, there's no current task to compare with */
+	if (IS_ENABLED(CONFIG_TASK_SCHED_STATS) &&
+	    current_task != (task_ *)scratchpad)
+		task_sched_stats_ready(tskid, get_time().le.lo);
+
 	/* Set the event bit in the receiver message bitmap */
 	atomic_or(&receiver->events, event);
 
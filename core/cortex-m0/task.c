@@ -153,11 +153,25 @@ static inline task_ *__task_id_to_ptr(task_id_t id)
 
 void interrupt_disable(void)
 {
+#ifdef CONFIG_IRQ_PROFILE
+	uint32_t primask;
+
+	/* Only a region which starts here is timed; not nested disables */
+	asm volatile("mrs %0, primask" : "=r"(primask));
+	asm volatile("cpsid i");
+	if (!primask)
+		irq_profile_disabled((uintptr_t)__builtin_return_address(0),
+				     get_time().le.lo);
+#else
 	asm("cpsid i");
+#endif
 }
 
 void interrupt_enable(void)
 {
+#ifdef CONFIG_IRQ_PROFILE
+	irq_profile_enabling(get_time().le.lo);
+#endif
 	asm("cpsie i");
 }
 
@@ -53,6 +53,15 @@ static void (*pending_isr)(void);
 static int generator_sleeping;
 static timestamp_t generator_sleep_deadline;
 static int has_interrupt_generator = 1;
+static pthread_mutex_t generator_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t generator_wake = PTHREAD_COND_INITIALIZER;
+
+/*
+ * How long the interrupt generator sleeps, in real time, before checking the
+ * virtual clock again when nothing wakes it.  This only matters when a task
+ * busy-waits on the clock without ever going back to the scheduler.
+ */
+#define GENERATOR_POLL_NS 100000
 
 /* thread local task id */
 static __thread task_id_t my_task_id = TASK_ID_INVALID;
@@ -126,14 +135,33 @@ int in_interrupt_context(void)
 
 test_mockable void interrupt_disable(void)
 {
+	/*
+	 * Interrupts are already held off while an ISR runs: the thread which
+	 * triggered it holds interrupt_lock until it finishes.
+	 */
+	if (in_interrupt_context())
+		return;
+
 	pthread_mutex_lock(&interrupt_lock);
+#ifdef CONFIG_IRQ_PROFILE
+	if (!interrupt_disabled)
+		irq_profile_disabled((uintptr_t)__builtin_return_address(0),
+				     get_time().le.lo);
+#endif
 	interrupt_disabled = 1;
 	pthread_mutex_unlock(&interrupt_lock);
 }
 
 test_mockable void interrupt_enable(void)
 {
+	if (in_interrupt_context())
+		return;
+
 	pthread_mutex_lock(&interrupt_lock);
+#ifdef CONFIG_IRQ_PROFILE
+	if (interrupt_disabled)
+		irq_profile_enabling(get_time().le.lo);
+#endif
 	interrupt_disabled = 0;
 	pthread_mutex_unlock(&interrupt_lock);
 }
@@ -181,11 +209,38 @@ void task_trigger_test_interrupt(void (*isr)(void))
 
 void interrupt_generator_udelay(unsigned us)
 {
+	struct timespec poll;
+
+	/*
+	 * Sleep until the virtual clock reaches the deadline, instead of
+	 * spinning on get_time(): the spinning itself would advance the clock
+	 * at a rate that depends on how the host schedules our threads.  The
+	 * scheduler wakes us once it moves time past the deadline.
+	 */
+	pthread_mutex_lock(&generator_lock);
 	generator_sleep_deadline.val = get_time().val + us;
 	generator_sleeping = 1;
-	while (get_time().val < generator_sleep_deadline.val)
-		;
+	while (get_time().val < generator_sleep_deadline.val) {
+		clock_gettime(CLOCK_REALTIME, &poll);
+		poll.tv_nsec += GENERATOR_POLL_NS;
+		if (poll.tv_nsec >= 1000000000) {
+			poll.tv_sec++;
+			poll.tv_nsec -= 1000000000;
+		}
+		pthread_cond_timedwait(&generator_wake, &generator_lock,
+				       &poll);
+	}
 	generator_sleeping = 0;
+	pthread_mutex_unlock(&generator_lock);
+}
+
+/* Wake the interrupt generator if the clock has reached its deadline. */
+static void generator_check_wake(timestamp_t now)
+{
+	pthread_mutex_lock(&generator_lock);
+	if (generator_sleeping && now.val >= generator_sleep_deadline.val)
+		pthread_cond_signal(&generator_wake);
+	pthread_mutex_unlock(&generator_lock);
 }
 
 const char *task_get_name(task_id_t tskid)
@@ -200,6 +255,9 @@ pthread_t task_get_thread(task_id_t tskid)
 
 uint32_t task_set_event(task_id_t tskid, uint32_t event)
 {
+	if (IS_ENABLED(CONFIG_TASK_SCHED_STATS))
+		task_sched_stats_ready(tskid, get_time().le.lo);
+
 	atomic_or(&tasks[tskid].event, event);
 	return 0;
 }
@@ -382,6 +440,8 @@ static int fast_forward(void)
 	 *   2. When the next task wakes up
 	 */
 	int task_id = task_get_next_wake();
+	timestamp_t deadline;
+	int sleeping;
 
 	if (!has_interrupt_generator) {
 		if (task_id == TASK_ID_INVALID) {
@@ -392,16 +452,21 @@ static int fast_forward(void)
 		}
 	}
 
-	if (!generator_sleeping)
+	pthread_mutex_lock(&generator_lock);
+	sleeping = generator_sleeping;
+	deadline = generator_sleep_deadline;
+	pthread_mutex_unlock(&generator_lock);
+
+	if (!sleeping)
 		return TASK_ID_IDLE;
 
 	if (task_id != TASK_ID_INVALID &&
 	    tasks[task_id].thread != (pthread_t)NULL &&
-	    tasks[task_id].wake_time.val < generator_sleep_deadline.val) {
+	    tasks[task_id].wake_time.val < deadline.val) {
 		force_time(tasks[task_id].wake_time);
 		return task_id;
 	} else {
-		force_time(generator_sleep_deadline);
+		force_time(deadline);
 		return TASK_ID_IDLE;
 	}
 }
@@ -414,11 +479,13 @@ int task_start_called(void)
 void task_scheduler(void)
 {
 	int i;
+	task_id_t prev;
 	timestamp_t now;
 
 	task_started = 1;
 
 	while (1) {
+		prev = running_task_id;
 		now = get_time();
 		i = TASK_ID_COUNT - 1;
 		while (i >= 0) {
@@ -433,13 +500,25 @@ void task_scheduler(void)
 			}
 			--i;
 		}
-		if (i < 0)
+		if (i < 0) {
+			/* The time skipped by fast_forward() is idle time */
+			if (IS_ENABLED(CONFIG_TASK_SCHED_STATS) &&
+			    prev != TASK_ID_IDLE) {
+				task_sched_stats_switch(prev, TASK_ID_IDLE,
+							now.le.lo);
+				prev = TASK_ID_IDLE;
+			}
 			i = fast_forward();
+		}
 
 		now = get_time();
+		if (has_interrupt_generator)
+			generator_check_wake(now);
 		if (now.val >= tasks[i].wake_time.val)
 			tasks[i].event |= TASK_EVENT_TIMER;
 		tasks[i].wake_time.val = ~0ull;
+		if (IS_ENABLED(CONFIG_TASK_SCHED_STATS) && prev != i)
+			task_sched_stats_switch(prev, i, now.le.lo);
 		running_task_id = i;
 		tasks[i].started = 1;
 		pthread_cond_signal(&tasks[i].resume);
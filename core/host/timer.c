@@ -7,6 +7,7 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <time.h>
 
 #include "task.h"
 #include "test_util.h"
@@ -16,6 +17,9 @@
 static timestamp_t boot_time;
 static int time_set;
 
+/* Virtual clock, in us; see _get_time() */
+static uint64_t virtual_time;
+
 void usleep(unsigned us)
 {
 	if (!task_start_called() || task_get_current() == TASK_ID_INVALID) {
@@ -31,15 +35,18 @@ void usleep(unsigned us)
 
 timestamp_t _get_time(void)
 {
-	static timestamp_t time;
+	timestamp_t time;
 
 	/*
 	 * We just monotonically increase the microsecond every time we check
 	 * the time. Do not depend on host system time as this introduces
 	 * flakyness in tests. The time is periodically fast forwarded with
 	 * force_time() during the host's task scheduler implementation.
+	 *
+	 * The interrupt generator reads the clock from its own thread, so
+	 * the increment must be atomic.
 	 */
-	++time.val;
+	time.val = __atomic_add_fetch(&virtual_time, 1, __ATOMIC_SEQ_CST);
 	return time;
 }
 
@@ -55,6 +62,14 @@ uint32_t __hw_clock_source_read(void)
 	return get_time().le.lo;
 }
 
+uint64_t test_get_wall_clock_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
 void force_time(timestamp_t ts)
 {
 	timestamp_t now = _get_time();
@@ -64,16 +79,16 @@ void force_time(timestamp_t ts)
 
 void udelay(unsigned us)
 {
-	timestamp_t deadline;
-
 	if (!in_interrupt_context() && task_get_current() == TASK_ID_INT_GEN) {
 		interrupt_generator_udelay(us);
 		return;
 	}
 
-	deadline.val = get_time().val + us;
-	while (get_time().val < deadline.val)
-		;
+	/*
+	 * Time only passes when somebody looks at the clock, so there is no
+	 * point in spinning until it reaches the deadline; move it there.
+	 */
+	__atomic_add_fetch(&virtual_time, us, __ATOMIC_SEQ_CST);
 }
 
 int timestamp_expired(timestamp_t deadline, const timestamp_t *now)
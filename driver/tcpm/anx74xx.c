@@ -967,6 +967,7 @@ void anx74xx_tcpc_alert(int port)
 {
 	int reg;
 	int failed_attempts;
+	int rv;
 
 	/* Clear soft irq bit */
 	tcpc_write(port, ANX74XX_REG_IRQ_EXT_SOURCE_3,
@@ -986,7 +987,9 @@ void anx74xx_tcpc_alert(int port)
 	/* Pull all RX messages from TCPC into EC memory */
 	failed_attempts = 0;
 	while (reg & ANX74XX_REG_IRQ_CC_MSG_INT) {
-		if (tcpm_enqueue_message(port))
+		/* A message dropped because the cache is full has been read */
+		rv = tcpm_enqueue_message(port);
+		if (rv && rv != EC_ERROR_OVERFLOW)
 			++failed_attempts;
 		if (tcpc_read(port, ANX74XX_REG_IRQ_SOURCE_RECV_MSG, &reg))
 			++failed_attempts;
@@ -1011,7 +1014,7 @@ void anx74xx_tcpc_alert(int port)
 
 	if (reg & ANX74XX_REG_IRQ_CC_STATUS_INT)
 		/* CC status changed, wake task */
-		task_set_event(PD_PORT_TO_TASK_ID(port), PD_EVENT_CC);
+		pd_task_set_event(port, PD_EVENT_CC);
 
 	/* Read and clear extended alert register 1 */
 	reg = 0;
@@ -1042,8 +1045,7 @@ void anx74xx_tcpc_alert(int port)
 
 	if (reg & ANX74XX_REG_EXT_HARD_RST) {
 		/* hard reset received */
-		task_set_event(PD_PORT_TO_TASK_ID(port),
-			       PD_EVENT_RX_HARD_RESET);
+		pd_task_set_event(port, PD_EVENT_RX_HARD_RESET);
 	}
 }
 
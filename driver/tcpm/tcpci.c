@@ -733,15 +733,21 @@ struct cached_tcpm_message {
 	uint32_t payload[7];
 };
 
-static int tcpci_rev2_0_tcpm_get_message_raw(int port, uint32_t *payload,
-					     int *head)
+int tcpci_tcpm_get_message_raw(int port, uint32_t *payload, int *head)
 {
-	int rv = 0, cnt, reg = TCPC_REG_RX_BUFFER;
+	int rv, cnt, reg = TCPC_REG_RX_BUFFER;
 	int frm;
 	uint8_t tmp[2];
+	/* The header, then the data objects */
+	uint8_t buf[2 + member_size(struct cached_tcpm_message, payload)];
+
 	/*
-	 * Register 0x30 is Readable Byte Count, Buffer frame type, and RX buf
-	 * byte X.
+	 * Read the whole message in one burst.  In TCPCI Rev 1.0 RX_BYTE_CNT,
+	 * RX_BUF_FRAME_TYPE, RX_BUF_HEADER and RX_BUF_OBJ are consecutive
+	 * registers starting at 0x30; in Rev 2.0 they're all read through
+	 * register 0x30, so either way one read starting there gets them all.
+	 * The byte count comes first, so read it and the frame type, then the
+	 * header and data objects in the same transaction.
 	 */
 	tcpc_lock(port, 1);
 	rv = tcpc_xfer_unlocked(port, (uint8_t *)&reg, 1, tmp, 2,
@@ -754,8 +760,8 @@ static int tcpci_rev2_0_tcpm_get_message_raw(int port, uint32_t *payload,
 	frm = tmp[1];
 
 	/*
-	 * READABLE_BYTE_COUNT includes 3 bytes for frame type and header, and
-	 * may be 0 if the TCPC saw a disconnect before the message read
+	 * The byte count includes 3 bytes for frame type and header, and may
+	 * be 0 if the TCPC saw a disconnect before the message read
 	 */
 	cnt -= 3;
 	if ((cnt < 0) ||
@@ -765,19 +771,16 @@ static int tcpci_rev2_0_tcpm_get_message_raw(int port, uint32_t *payload,
 		cnt = 0;
 	}
 
-	/* The next two bytes are the header */
-	rv |= tcpc_xfer_unlocked(port, NULL, 0, (uint8_t *)head, 2,
-				cnt ? 0 : I2C_XFER_STOP);
+	rv |= tcpc_xfer_unlocked(port, NULL, 0, buf, 2 + cnt,
+				 I2C_XFER_STOP);
 
-	/* Encode message address in bits 31 to 28 */
-	*head &= 0x0000ffff;
-	*head |= PD_HEADER_SOP(frm);
+	*head = UINT16_FROM_BYTE_ARRAY_LE(buf, 0);
+	memcpy(payload, buf + 2, cnt);
 
-	/* Execute read and I2C_XFER_STOP, even if header read failed */
-	if (cnt > 0) {
-		tcpc_xfer_unlocked(port, NULL, 0, (uint8_t *)payload, cnt,
-				   I2C_XFER_STOP);
-	}
+	/* Encode message address in bits 31 to 28 */
+	if ((tcpc_config[port].flags & TCPC_FLAGS_TCPCI_REV2_0) ||
+	    IS_ENABLED(CONFIG_USB_PD_DECODE_SOP))
+		*head |= PD_HEADER_SOP(frm);
 
 clear:
 	tcpc_lock(port, 0);
@@ -790,64 +793,10 @@ clear:
 	return EC_SUCCESS;
 }
 
-static int tcpci_rev1_0_tcpm_get_message_raw(int port, uint32_t *payload,
-					     int *head)
-{
-	int rv, cnt, reg = TCPC_REG_RX_DATA;
-	int frm;
-
-	rv = tcpc_read(port, TCPC_REG_RX_BYTE_CNT, &cnt);
-
-	/* RX_BYTE_CNT includes 3 bytes for frame type and header */
-	if (rv != EC_SUCCESS || cnt < 3) {
-		rv = EC_ERROR_UNKNOWN;
-		goto clear;
-	}
-	cnt -= 3;
-	if (cnt > member_size(struct cached_tcpm_message, payload)) {
-		rv = EC_ERROR_UNKNOWN;
-		goto clear;
-	}
-
-	if (IS_ENABLED(CONFIG_USB_PD_DECODE_SOP)) {
-		rv = tcpc_read(port, TCPC_REG_RX_BUF_FRAME_TYPE, &frm);
-		if (rv != EC_SUCCESS) {
-			rv = EC_ERROR_UNKNOWN;
-			goto clear;
-		}
-	}
-
-	rv = tcpc_read16(port, TCPC_REG_RX_HDR, (int *)head);
-
-	if (IS_ENABLED(CONFIG_USB_PD_DECODE_SOP)) {
-		/* Encode message address in bits 31 to 28 */
-		*head &= 0x0000ffff;
-		*head |= PD_HEADER_SOP(frm);
-	}
-
-	if (rv == EC_SUCCESS && cnt > 0) {
-		tcpc_read_block(port, reg, (uint8_t *)payload, cnt);
-	}
-
-clear:
-	/* Read complete, clear RX status alert bit */
-	tcpc_write16(port, TCPC_REG_ALERT, TCPC_REG_ALERT_RX_STATUS);
-
-	return rv;
-}
-
-int tcpci_tcpm_get_message_raw(int port, uint32_t *payload, int *head)
-{
-	if (tcpc_config[port].flags & TCPC_FLAGS_TCPCI_REV2_0)
-		return tcpci_rev2_0_tcpm_get_message_raw(port, payload, head);
-
-	return tcpci_rev1_0_tcpm_get_message_raw(port, payload, head);
-}
-
 /* Cache depth needs to be power of 2 */
-/* TODO: Keep track of the high water mark */
-#define CACHE_DEPTH BIT(3)
+#define CACHE_DEPTH CONFIG_USB_PD_TCPM_RX_CACHE_DEPTH
 #define CACHE_DEPTH_MASK (CACHE_DEPTH - 1)
+BUILD_ASSERT(POWER_OF_TWO(CACHE_DEPTH));
 
 struct queue {
 	/*
@@ -860,6 +809,7 @@ struct queue {
 	 * consume. Must be masked before used in lookup.
 	 */
 	uint32_t tail;
+	struct tcpm_rx_cache_stats stats;
 	struct cached_tcpm_message buffer[CACHE_DEPTH];
 };
 static struct queue cached_messages[CONFIG_USB_PD_PORT_MAX_COUNT];
@@ -868,12 +818,23 @@ static struct queue cached_messages[CONFIG_USB_PD_PORT_MAX_COUNT];
 int tcpm_enqueue_message(const int port)
 {
 	int rv;
+	uint32_t depth;
 	struct queue *const q = &cached_messages[port];
 	struct cached_tcpm_message *const head =
 		&q->buffer[q->head & CACHE_DEPTH_MASK];
 
 	if (q->head - q->tail == CACHE_DEPTH) {
+		struct cached_tcpm_message dropped;
+
+		/*
+		 * The TCPC has already acknowledged the message, so leaving
+		 * it there only holds up the messages behind it.  Read it
+		 * out, and drop it.
+		 */
 		CPRINTS("C%d RX EC Buffer full!", port);
+		tcpc_config[port].drv->get_message_raw(port, dropped.payload,
+						       &dropped.header);
+		q->stats.dropped++;
 		return EC_ERROR_OVERFLOW;
 	}
 
@@ -888,14 +849,27 @@ int tcpm_enqueue_message(const int port)
 	}
 
 	/* Increment atomically to ensure get_message_raw happens-before */
-	atomic_add(&q->head, 1);
+	depth = atomic_add(&q->head, 1) + 1 - q->tail;
+	if (depth > q->stats.high_water)
+		q->stats.high_water = depth;
 
 	/* Wake PD task up so it can process incoming RX messages */
-	task_set_event(PD_PORT_TO_TASK_ID(port), TASK_EVENT_WAKE);
+	pd_task_set_event(port, TASK_EVENT_WAKE);
 
 	return EC_SUCCESS;
 }
 
+void tcpm_get_rx_cache_stats(int port, struct tcpm_rx_cache_stats *stats)
+{
+	*stats = cached_messages[port].stats;
+}
+
+void tcpm_clear_rx_cache_stats(int port)
+{
+	memset(&cached_messages[port].stats, 0,
+	       sizeof(cached_messages[port].stats));
+}
+
 int tcpm_has_pending_message(const int port)
 {
 	const struct queue *const q = &cached_messages[port];
@@ -1137,6 +1111,8 @@ void tcpci_tcpc_alert(int port)
 	int alert = 0;
 	int alert_ext = 0;
 	int failed_attempts;
+	int rx_overflow;
+	int rv;
 	uint32_t pd_event = 0;
 
 	/* Read the Alert register from the TCPC */
@@ -1170,13 +1146,19 @@ void tcpci_tcpc_alert(int port)
 					   TCPC_TX_COMPLETE_SUCCESS :
 					   TCPC_TX_COMPLETE_FAILED);
 
-	/* Pull all RX messages from TCPC into EC memory */
+	/*
+	 * Pull all RX messages from TCPC into EC memory.  A message dropped
+	 * because the EC's cache is full has still been read.
+	 */
 	failed_attempts = 0;
+	rx_overflow = alert & TCPC_REG_ALERT_RX_BUF_OVF;
 	while (alert & TCPC_REG_ALERT_RX_STATUS) {
-		if (tcpm_enqueue_message(port))
+		rv = tcpm_enqueue_message(port);
+		if (rv && rv != EC_ERROR_OVERFLOW)
 			++failed_attempts;
 		if (tcpm_alert_status(port, &alert))
 			++failed_attempts;
+		rx_overflow |= alert & TCPC_REG_ALERT_RX_BUF_OVF;
 
 		/* Ensure we don't loop endlessly */
 		if (failed_attempts >= MAX_ALLOW_FAILED_RX_READS) {
@@ -1202,6 +1184,10 @@ void tcpci_tcpc_alert(int port)
 	if (alert)
 		tcpc_write16(port, TCPC_REG_ALERT, alert);
 
+	/* The TCPC ran out of room for a message before the EC read them */
+	if (rx_overflow)
+		cached_messages[port].stats.tcpc_overflows++;
+
 	if (alert & TCPC_REG_ALERT_CC_STATUS) {
 		if (IS_ENABLED(CONFIG_USB_PD_DUAL_ROLE_AUTO_TOGGLE)) {
 			enum tcpc_cc_voltage_status cc1;
@@ -1263,7 +1249,7 @@ void tcpci_tcpc_alert(int port)
 	 * the next I2C transaction to the TCPC will cause it to wake again.
 	 */
 	if (pd_event)
-		task_set_event(PD_PORT_TO_TASK_ID(port), pd_event);
+		pd_task_set_event(port, pd_event);
 }
 
 /*
@@ -1741,7 +1727,14 @@ static const struct tcpc_reg_dump_map tcpc_regs[] = {
  */
 void tcpc_dump_std_registers(int port)
 {
+	struct tcpm_rx_cache_stats stats;
+
 	tcpc_dump_registers(port, tcpc_regs, ARRAY_SIZE(tcpc_regs));
+
+	tcpm_get_rx_cache_stats(port, &stats);
+	ccprintf("RX cache: depth %d, high water %d, dropped %d, "
+		 "TCPC overflows %d\n", CACHE_DEPTH, stats.high_water,
+		 stats.dropped, stats.tcpc_overflows);
 }
 #endif
 
@@ -1461,6 +1461,12 @@
 /* Provide common core code to handle the operating system timers. */
 #define CONFIG_COMMON_TIMER
 
+/*
+ * Deadline-ordered queue of armed timers.  The common timer uses it, and
+ * enables it.
+ */
+#undef CONFIG_TIMER_QUEUE
+
 /*****************************************************************************/
 
 /*
@@ -1518,6 +1524,23 @@
 /* Enable verbose output to UART console and extra timestamp print precision. */
 #define CONFIG_CONSOLE_VERBOSE
 
+/*
+ * Store cprints() and cprintf() output, other than on the command channel, in
+ * a binary log as the format string's address, a timestamp and the raw
+ * arguments instead of formatting it onto the console.  This is much cheaper
+ * in time and buffer space.  The log is printed by the tlog console command,
+ * or read with EC_CMD_CONSOLE_READ_TOKENIZED and decoded on the host with
+ * util/tlog_decode.py and the EC's ELF file.
+ *
+ * The log is on from boot, so that output no longer appears on the UART or in
+ * EC_CMD_CONSOLE_READ at all; only console command output does.  "tlog off"
+ * goes back to formatting everything onto the console.
+ */
+#undef CONFIG_CONSOLE_TOKENIZED_LOG
+
+/* Size of the tokenized log in bytes; must be a power of two. */
+#define CONFIG_CONSOLE_TOKENIZED_LOG_SIZE 1024
+
 /*****************************************************************************/
 /* Support for EC-EC communication */
 
@@ -1541,6 +1564,14 @@
  */
 #undef CONFIG_EXPERIMENTAL_CONSOLE
 
+/*
+ * Accept a batch of console commands in one packet, and send their output back
+ * in checksummed frames, so scripts such as EC-3PO can run many commands
+ * without waiting for each one.  Define to the largest batch in bytes, not
+ * counting its header.  The format is described in common/console.c.
+ */
+#undef CONFIG_CONSOLE_BATCH
+
 /* Include CRC-8 utility function */
 #undef CONFIG_CRC8
 
@@ -2107,6 +2138,31 @@
  */
 #undef CONFIG_HOSTCMD_SECTION_SORTED
 
+/*
+ * Look up host command handlers in a two-level table instead of searching the
+ * .rodata.hcmds section, so dispatch takes constant time.  The table is built
+ * at run time; define this to the number of 32-command pages to reserve RAM
+ * for (32 bytes each, plus 512 bytes for the first level).  Commands in pages
+ * which don't fit are still found by searching.
+ */
+#undef CONFIG_HOSTCMD_DISPATCH_PAGES
+
+/*
+ * Record the number of calls, total and maximum handler time and a latency
+ * histogram for each host command, and report them with the hcstats console
+ * command and EC_CMD_HOST_COMMAND_STATS.  Costs 48 bytes of RAM per command.
+ */
+#undef CONFIG_HOSTCMD_STATS
+
+/*
+ * Let host command handlers complete later, from another task or a deferred
+ * function, with host_command_async_start() and host_command_async_done().
+ * The host is told of completion with an EC_MKBP_EVENT_HOST_COMMAND_DONE
+ * event, so CONFIG_MKBP_EVENT is needed.  Define this to the number of
+ * commands which may be in progress at once.
+ */
+#undef CONFIG_HOSTCMD_ASYNC
+
 /*
  * Host command parameters and response are 32-bit aligned.  This generates
  * much more efficient code on ARM.
@@ -2222,6 +2278,19 @@
 /* Enable debugging and profiling statistics for hook functions */
 #undef CONFIG_HOOK_DEBUG
 
+/*
+ * Let HOOK_TICK and HOOK_SECOND routines declared with DECLARE_HOOK_SLACK()
+ * run late, so the hook task can merge their wakeups with each other and with
+ * deferred calls.
+ */
+#undef CONFIG_HOOK_TICKLESS
+
+/*
+ * Count hook task wakeups and what they were for, and report them with the
+ * hookwake console command and EC_CMD_HOOK_WAKE_STATS.
+ */
+#undef CONFIG_HOOK_WAKE_STATS
+
 /*****************************************************************************/
 /* CRC configuration */
 
@@ -2905,6 +2974,15 @@
 /* Provide rudimentary malloc/free like services for shared memory. */
 #undef CONFIG_MALLOC
 
+/*
+ * Serve small shared memory requests from slabs of fixed size blocks, with
+ * CONFIG_MALLOC.  Define to the size in bytes of each slab carved from shared
+ * memory.  There are size classes of 64 to 2048 byte blocks; those that fit
+ * at least two blocks in a slab are used, and larger requests are allocated
+ * as before.
+ */
+#undef CONFIG_MALLOC_SLAB
+
 /* Need for a math library */
 #undef CONFIG_MATH_UTIL
 
@@ -3232,6 +3310,12 @@
  */
 #undef CONFIG_PWM_KBLIGHT
 
+/*
+ * Build the single-producer, single-consumer queue (queue_spsc.h), for
+ * queues whose producer and consumer may run at the same time.
+ */
+#undef CONFIG_QUEUE_SPSC
+
 /* Support Real-Time Clock (RTC) */
 #undef CONFIG_RTC
 
@@ -3368,6 +3452,14 @@
 /* Storage  offset of sharedobjects library. */
 #undef CONFIG_SHAREDLIB_STORAGE_OFF
 
+/*
+ * Trace shared memory allocations: who acquired each buffer, from which task,
+ * and how long they held it, plus each task's peak usage.  Define to the
+ * number of allocations to remember.  See the shmemtrace console command and
+ * EC_CMD_SHARED_MEM_TRACE.
+ */
+#undef CONFIG_SHAREDMEM_TRACE
+
 /*
  * If defined, the hash module will save its last computed hash when jumping
  * between EC images.
@@ -3639,6 +3731,24 @@
  */
 #define CONFIG_TASK_PROFILING
 
+/*
+ * Collect per-task run time, context switch counts and wakeup-to-run latency
+ * histograms in the scheduler, and report them with the taskstats console
+ * command and EC_CMD_TASK_SCHED_STATS.  Only the cortex-m and host cores
+ * implement this.
+ */
+#undef CONFIG_TASK_SCHED_STATS
+
+/*
+ * Time each region in which interrupt_disable() holds interrupts off, and
+ * keep a histogram of their lengths along with the longest ones and the code
+ * which disabled interrupts for them.  Define to the number of longest
+ * regions to keep.  Report them with the irqprof console command and
+ * EC_CMD_IRQ_PROFILE.  Only the cortex-m, cortex-m0 and host cores implement
+ * this.
+ */
+#undef CONFIG_IRQ_PROFILE
+
 /*****************************************************************************/
 /* Mock config */
 
@@ -3862,6 +3972,15 @@
  */
 #define CONFIG_UART_TX_BUF_SIZE 512
 
+/*
+ * Size in bytes of a per-task buffer which collects console output until the
+ * end of each line or output call, then copies it into the UART transmit
+ * buffer in one go.  This keeps lines from different tasks and interrupts
+ * from being mixed together, at the cost of this much RAM per task.  Must be
+ * less than 256.  If undefined, output goes straight to the transmit buffer.
+ */
+#undef CONFIG_UART_TX_STAGING
+
 /* Use DMA for UART output */
 #undef CONFIG_UART_TX_DMA
 
@@ -4093,6 +4212,13 @@
 #undef CONFIG_USB_PD_IDENTITY_HW_VERS
 #undef CONFIG_USB_PD_IDENTITY_SW_VERS
 
+/*
+ * With TCPMv2, let the PD task sleep until its next timer expires while the
+ * port is unattached, instead of waking up every few ms to poll.  Only define
+ * this if every TCPC on the board raises an alert when CC changes.
+ */
+#undef CONFIG_USB_PD_IDLE_SLEEP
+
 /* USB PD MCU I2C address for host commands */
 #define CONFIG_USB_PD_I2C_ADDR_FLAGS 0x1E
 
@@ -4120,6 +4246,17 @@
  */
 #undef CONFIG_USB_PD_ITE_ACTIVE_PORT_COUNT
 
+/*
+ * With TCPMv2, run the state machines of every port in one task, PD_C0,
+ * instead of a PD_Cx task per port.  That saves the other tasks' stacks, at
+ * the cost of a port waiting while the task runs the others.  The board's
+ * task list then only has PD_C0; code setting events for a port's PD task
+ * must use pd_task_set_event().  Not supported with the on-chip PD PHYs
+ * (CONFIG_USB_PD_TCPC, CONFIG_USB_PD_TCPM_ITE_ON_CHIP), whose interrupts
+ * signal the end of a transmit to a task per port.
+ */
+#undef CONFIG_USB_PD_SHARED_TASK
+
 /* Simple DFP, such as power adapter, will not send discovery VDM on connect */
 #undef CONFIG_USB_PD_SIMPLE_DFP
 
@@ -4247,6 +4384,14 @@
 #undef CONFIG_USB_PD_TCPM_FUSB307
 #undef CONFIG_USB_PD_TCPM_STM32GX
 
+/*
+ * Number of received messages the TCPM can hold per port until the PD task
+ * handles them (a power of two).  When it's full, further messages read from
+ * the TCPC are dropped.  Ports that see bursts of messages, such as VDMs
+ * during discovery of a dock, may need more.
+ */
+#define CONFIG_USB_PD_TCPM_RX_CACHE_DEPTH 8
+
 /* PS8XXX series are all supported by a single driver with a build time config
  * listed below (CONFIG_USB_PD_TCPM_PS*) defined to enable the specific product.
  *
@@ -4354,6 +4499,16 @@
 /* Define the type-c port controller I2C base address. */
 #define CONFIG_TCPC_I2C_BASE_ADDR_FLAGS 0x4E
 
+/*
+ * Record every message the TCPMv2 Protocol Layer sends and receives, with its
+ * SOP*, timestamp and transmit result, in a ring buffer per port.  Define to
+ * the number of records in each ring (a power of two); each takes 40 bytes.
+ * The next record is written over the oldest, so once the ring has filled
+ * the last CONFIG_USB_PD_TRACE - 1 messages can be read.  See the pdtrace
+ * console command and EC_CMD_PD_TRACE.
+ */
+#undef CONFIG_USB_PD_TRACE
+
 /* Use this option to enable Try.SRC mode for Dual Role devices */
 #undef CONFIG_USB_PD_TRY_SRC
 
@@ -4951,6 +5106,9 @@
 /* Define to enable USB State Machine framework. */
 #undef CONFIG_TEST_SM
 
+/* Define to build the USB PD timer service on its own. */
+#undef CONFIG_TEST_USB_PD_TIMER
+
 /*
  * This build is not a complete platform/ec based EC, but instead
  * using the platform/ec zephyr module.
@@ -5011,6 +5169,14 @@
 #if defined(CONFIG_USB_PD_TCPMV2) && !defined(CONFIG_USB_PD_DECODE_SOP)
 #error CONFIG_USB_PD_DECODE_SOP must be enabled with the TCPMV2 PD state machine
 #endif
+#if defined(CONFIG_USB_PD_SHARED_TASK) && \
+	!defined(CONFIG_USB_TYPEC_DRP_ACC_TRYSRC)
+#error CONFIG_USB_PD_SHARED_TASK needs the TCPMv2 DRP Type-C state machine
+#endif
+#if defined(CONFIG_USB_PD_SHARED_TASK) && \
+	(defined(CONFIG_USB_PD_TCPC) || defined(CONFIG_USB_PD_TCPM_ITE_ON_CHIP))
+#error CONFIG_USB_PD_SHARED_TASK needs a PD task per port with on-chip PHYs
+#endif
 #endif
 
 /******************************************************************************/
@@ -5192,6 +5358,11 @@
 #define CONFIG_CRC8
 #endif /* defined(CONFIG_EXPERIMENTAL_CONSOLE) */
 
+/* Console batches are checked with CRC8 too. */
+#ifdef CONFIG_CONSOLE_BATCH
+#define CONFIG_CRC8
+#endif
+
 
 /******************************************************************************/
 /*
@@ -5396,6 +5567,12 @@
 #define CONFIG_USB_PD_DP_HPD_GPIO
 #endif
 
+/*****************************************************************************/
+/* Define derived config options for the common timer */
+#ifdef CONFIG_COMMON_TIMER
+#define CONFIG_TIMER_QUEUE
+#endif
+
 /*****************************************************************************/
 /* Define derived thermistor common path */
 #ifdef CONFIG_THERMISTOR_NCP15WB
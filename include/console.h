@@ -8,6 +8,8 @@
 #ifndef __CROS_EC_CONSOLE_H
 #define __CROS_EC_CONSOLE_H
 
+#include <stdarg.h>
+
 #include "common.h"
 #include "config.h"
 
@@ -135,6 +137,19 @@ int cprintf(enum console_channel channel, const char *format, ...);
 __attribute__((__format__(__printf__, 2, 3)))
 int cprints(enum console_channel channel, const char *format, ...);
 
+#ifdef CONFIG_CONSOLE_CHANNEL
+/**
+ * Enable or disable output on a console channel.
+ *
+ * @param name		Channel name, as listed by the chan console command
+ */
+void console_channel_enable(const char *name);
+void console_channel_disable(const char *name);
+#else
+static inline void console_channel_enable(const char *name) { }
+static inline void console_channel_disable(const char *name) { }
+#endif
+
 /**
  * Flush the console output for all channels.
  */
@@ -155,13 +170,48 @@ void cflush(void);
  */
 void console_has_input(void);
 
+/**
+ * Find the console commands whose names start with a prefix, for completing
+ * a command name.  Commands are kept sorted by name, so this takes O(log n)
+ * name comparisons, and the matches are consecutive.
+ *
+ * @param prefix	Start of a command name; case-insensitive
+ * @param len		Length of prefix
+ * @param first		If not NULL, set to the first matching command
+ * @param count		If not NULL, set to the number of matching commands
+ *
+ * @return The length of the longest prefix all the matching names share
+ * (at least len), or 0 if no command matches.
+ */
+int console_command_complete(const char *prefix, int len,
+			     const struct console_command **first, int *count);
+
+#ifdef CONFIG_CONSOLE_BATCH
+/**
+ * Return non-zero if command output is being collected for a batch of
+ * commands (see CONFIG_CONSOLE_BATCH).
+ */
+int console_batch_capturing(void);
+
+/**
+ * Add output of the command being run to its batch.  Each time the output
+ * fills the buffer, it's sent, so none is dropped.
+ *
+ * @return EC_SUCCESS
+ */
+int console_batch_puts(const char *outstr);
+int console_batch_vprintf(const char *format, va_list args);
+#endif
+
 /**
  * Register a console command handler.
  *
  * @param name          Command name; must not be the beginning of another
  *                      existing command name.  Must be less than 15 characters
- *                      long (excluding null terminator).  Note this is NOT in
- *                      quotes so it can be concatenated to form a struct name.
+ *                      long (excluding null terminator), and lower case, since
+ *                      commands are looked up in the order the linker sorts
+ *                      them.  Note this is NOT in quotes so it can be
+ *                      concatenated to form a struct name.
  * @param routine       Command handling routine, of the form
  *                      int handler(int argc, char **argv)
  * @param argdesc       String describing arguments to command; NULL if none.
@@ -228,10 +228,38 @@ static inline void tcpm_enable_auto_discharge_disconnect(int port, int enable)
 
 /**
  * Reads a message using get_message_raw driver method and puts it into EC's
- * cache.
+ * cache.  If the cache is full, the message is read and dropped.
+ *
+ * @return EC_SUCCESS, EC_ERROR_OVERFLOW if the message was dropped, or
+ * another error if it couldn't be read
  */
 int tcpm_enqueue_message(int port);
 
+struct tcpm_rx_cache_stats {
+	/* Most messages held in the cache at once */
+	uint32_t high_water;
+	/* Messages dropped because the cache was full */
+	uint32_t dropped;
+	/* Times the TCPC reported it had run out of room for messages */
+	uint32_t tcpc_overflows;
+};
+
+/**
+ * Get the RX message cache statistics of a port, since the last time they
+ * were cleared.
+ *
+ * @param port Type-C port number
+ * @param stats Filled in with the statistics
+ */
+void tcpm_get_rx_cache_stats(int port, struct tcpm_rx_cache_stats *stats);
+
+/**
+ * Clear the RX message cache statistics of a port.
+ *
+ * @param port Type-C port number
+ */
+void tcpm_clear_rx_cache_stats(int port);
+
 static inline int tcpm_transmit(int port, enum tcpm_transmit_type type,
 				uint16_t header, const uint32_t *data)
 {
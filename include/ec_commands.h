@@ -3735,11 +3735,24 @@ enum ec_mkbp_event {
 	/* New online calibration values are available. */
 	EC_MKBP_EVENT_ONLINE_CALIBRATION = 11,
 
+	/*
+	 * A host command which returned EC_RES_IN_PROGRESS has finished.  The
+	 * event data is struct ec_response_host_command_done.
+	 */
+	EC_MKBP_EVENT_HOST_COMMAND_DONE = 12,
+
 	/* Number of MKBP events */
 	EC_MKBP_EVENT_COUNT,
 };
 BUILD_ASSERT(EC_MKBP_EVENT_COUNT <= EC_MKBP_EVENT_TYPE_MASK);
 
+/* Event data for EC_MKBP_EVENT_HOST_COMMAND_DONE */
+struct ec_response_host_command_done {
+	uint16_t command;	/* Command which completed */
+	uint8_t result;		/* Its final result (enum ec_status) */
+	uint8_t reserved;
+} __ec_align1;
+
 union __ec_align_offset1 ec_response_get_next_data {
 	uint8_t key_matrix[13];
 
@@ -3790,6 +3803,8 @@ union __ec_align_offset1 ec_response_get_next_data_v1 {
 	uint32_t cec_events;
 
 	uint8_t cec_message[16];
+
+	struct ec_response_host_command_done host_command_done;
 };
 BUILD_ASSERT(sizeof(union ec_response_get_next_data_v1) == 16);
 
@@ -6706,6 +6721,272 @@ enum pchg_state {
 	[PCHG_STATE_CHARGING] = "CHARGING", \
 	}
 
+/*****************************************************************************/
+/*
+ * Get hook task wakeup statistics.
+ */
+#define EC_CMD_HOOK_WAKE_STATS 0x0136
+
+/* Clear the counters after reading them */
+#define EC_HOOK_WAKE_STATS_RESET BIT(0)
+
+struct ec_params_hook_wake_stats {
+	uint8_t flags;			/* EC_HOOK_WAKE_STATS_* */
+} __ec_align1;
+
+struct ec_response_hook_wake_stats {
+	uint32_t wakeups;		/* Total hook task wakeups */
+	uint32_t tick;			/* Wakeups which ran HOOK_TICK */
+	uint32_t second;		/* Wakeups which ran HOOK_SECOND */
+	uint32_t deferred;		/* Wakeups which ran deferred calls */
+	uint32_t coalesced;		/* Wakeups which ran more than one */
+	uint32_t idle;			/* Wakeups which ran nothing */
+	uint32_t tick_slack_us;		/* HOOK_TICK slack window */
+	uint32_t second_slack_us;	/* HOOK_SECOND slack window */
+} __ec_align4;
+
+/*****************************************************************************/
+/*
+ * Get scheduler statistics for one task.
+ */
+#define EC_CMD_TASK_SCHED_STATS 0x0137
+
+/* Clear the statistics of all tasks after reading them */
+#define EC_TASK_SCHED_STATS_RESET BIT(0)
+
+/*
+ * Wakeup latency histogram buckets.  Bucket 0 counts latencies below 16 us,
+ * bucket n (0 < n < 7) latencies in [4^(n+1), 4^(n+2)) us, and bucket 7
+ * latencies of 65536 us and more.
+ */
+#define EC_TASK_SCHED_LATENCY_BUCKETS 8
+
+struct ec_params_task_sched_stats {
+	uint8_t task_id;
+	uint8_t flags;			/* EC_TASK_SCHED_STATS_* */
+} __ec_align1;
+
+struct ec_response_task_sched_stats {
+	uint64_t runtime_us;		/* Time spent running the task */
+	uint32_t switches;		/* Number of times it was switched to */
+	uint32_t latency_max_us;	/* Longest wakeup-to-run latency */
+	/* Wakeups by wakeup-to-run latency */
+	uint32_t latency[EC_TASK_SCHED_LATENCY_BUCKETS];
+	uint8_t task_count;		/* Number of tasks, including idle */
+	char name[15];			/* Task name, NUL-terminated */
+} __ec_align4;
+
+/*****************************************************************************/
+/*
+ * Get per-host-command handler latency statistics.
+ *
+ * Commands are reported in registration order, starting at the given index;
+ * send the command again with index advanced by count until all total
+ * commands have been read.
+ */
+#define EC_CMD_HOST_COMMAND_STATS 0x0138
+
+/* Clear the statistics of all commands after reading them */
+#define EC_HOST_COMMAND_STATS_RESET BIT(0)
+
+/* Latency histogram buckets, as for EC_TASK_SCHED_LATENCY_BUCKETS */
+#define EC_HOST_COMMAND_STATS_BUCKETS 8
+
+struct ec_params_host_command_stats {
+	uint16_t index;			/* First command to report */
+	uint8_t flags;			/* EC_HOST_COMMAND_STATS_* */
+	uint8_t reserved;
+} __ec_align2;
+
+struct ec_host_command_stats {
+	uint16_t command;		/* Command number */
+	uint16_t reserved;
+	uint32_t count;			/* Number of times it was handled */
+	uint64_t total_us;		/* Total time spent in the handler */
+	uint32_t max_us;		/* Longest time spent in the handler */
+	/* Calls by time spent in the handler */
+	uint32_t latency[EC_HOST_COMMAND_STATS_BUCKETS];
+} __ec_align4;
+
+struct ec_response_host_command_stats {
+	uint32_t elapsed_ms;		/* Time since the last reset */
+	uint16_t total;			/* Number of registered commands */
+	uint8_t count;			/* Number of entries in stats[] */
+	uint8_t reserved;
+	struct ec_host_command_stats stats[];
+} __ec_align4;
+
+/*
+ * Read the tokenized console log (CONFIG_CONSOLE_TOKENIZED_LOG).
+ *
+ * Returns as many whole entries as fit, starting with the oldest one at or
+ * after pos; start with pos 0.  If entries were overwritten before they could
+ * be read, the returned pos is after the requested one.  Read again from next
+ * until no more data is returned.  The entries are unformatted output; see
+ * util/tlog_decode.py to turn them back into text.
+ */
+#define EC_CMD_CONSOLE_READ_TOKENIZED 0x0139
+
+struct ec_params_console_read_tokenized {
+	uint32_t pos;			/* Where to start reading */
+} __ec_align4;
+
+struct ec_response_console_read_tokenized {
+	uint32_t pos;			/* Position of the first entry in data */
+	uint32_t next;			/* Position to read from next */
+	uint8_t data[];			/* Log entries */
+} __ec_align4;
+
+/*
+ * Get shared memory allocation tracing (CONFIG_SHAREDMEM_TRACE).
+ *
+ * EC_SHARED_MEM_TRACE_USAGE returns the shared memory each task holds, and
+ * the most it has held at once.  EC_SHARED_MEM_TRACE_RECORDS returns the
+ * most recent allocations, newest first, starting at index; send the command
+ * again with index advanced by count until all total records have been read.
+ */
+#define EC_CMD_SHARED_MEM_TRACE 0x013A
+
+enum ec_shared_mem_trace_type {
+	EC_SHARED_MEM_TRACE_USAGE = 0,
+	EC_SHARED_MEM_TRACE_RECORDS = 1,
+};
+
+/* Clear the peak usage of all tasks after reading it */
+#define EC_SHARED_MEM_TRACE_RESET BIT(0)
+
+struct ec_params_shared_mem_trace {
+	uint8_t type;			/* enum ec_shared_mem_trace_type */
+	uint8_t index;			/* First record to return */
+	uint8_t flags;			/* EC_SHARED_MEM_TRACE_RESET */
+	uint8_t reserved;
+} __ec_align1;
+
+struct ec_shared_mem_task_usage {
+	uint32_t current;		/* Bytes held now */
+	uint32_t peak;			/* Most bytes held at once */
+} __ec_align4;
+
+struct ec_response_shared_mem_trace_usage {
+	uint8_t task_count;		/* Number of entries in usage[] */
+	uint8_t reserved[3];
+	struct ec_shared_mem_task_usage usage[];
+} __ec_align4;
+
+/* The buffer hasn't been released yet */
+#define EC_SHARED_MEM_TRACE_HELD BIT(0)
+/* The allocation failed */
+#define EC_SHARED_MEM_TRACE_FAILED BIT(1)
+
+struct ec_shared_mem_trace_record {
+	uint32_t caller;		/* Address shared_mem_acquire() was
+					 * called from
+					 */
+	uint32_t size;			/* Bytes requested */
+	uint32_t held_us;		/* Time held, so far if still held */
+	uint8_t task_id;		/* Task which acquired it */
+	uint8_t flags;			/* EC_SHARED_MEM_TRACE_* */
+	uint16_t reserved;
+} __ec_align4;
+
+struct ec_response_shared_mem_trace_records {
+	uint8_t total;			/* Number of records held */
+	uint8_t count;			/* Number of entries in records[] */
+	uint8_t reserved[2];
+	struct ec_shared_mem_trace_record records[];
+} __ec_align4;
+
+/*****************************************************************************/
+/*
+ * Get the interrupt-disabled region profile (CONFIG_IRQ_PROFILE).
+ */
+#define EC_CMD_IRQ_PROFILE 0x013B
+
+/* Clear the profile after reading it */
+#define EC_IRQ_PROFILE_RESET BIT(0)
+
+/*
+ * Region length histogram buckets.  Bucket 0 counts regions shorter than
+ * 4 us, bucket n (0 < n < 7) regions of [4^n, 4^(n+1)) us, and bucket 7
+ * regions of 16384 us and more.
+ */
+#define EC_IRQ_PROFILE_BUCKETS 8
+
+struct ec_params_irq_profile {
+	uint8_t flags;			/* EC_IRQ_PROFILE_* */
+} __ec_align1;
+
+struct ec_irq_profile_region {
+	uint32_t us;			/* Time interrupts were disabled */
+	uint32_t caller;		/* Address interrupt_disable() was
+					 * called from
+					 */
+} __ec_align4;
+
+struct ec_response_irq_profile {
+	uint32_t count;			/* Number of regions */
+	uint32_t max_us;		/* Longest region */
+	uint32_t histogram[EC_IRQ_PROFILE_BUCKETS];
+	uint8_t top_count;		/* Number of entries in top[] */
+	uint8_t reserved[3];
+	/* The longest regions, longest first */
+	struct ec_irq_profile_region top[];
+} __ec_align4;
+
+/*****************************************************************************/
+/*
+ * Read the USB PD message trace of a port (CONFIG_USB_PD_TRACE).
+ *
+ * Each message the port sends or receives is numbered in sequence.  The
+ * response holds the oldest messages still in the trace numbered seq or
+ * later, as many as fit.  Send the command again with seq set to next to
+ * continue; next equals seq once there's nothing more to read.  If the
+ * response's first_seq is past the seq asked for, the messages in between
+ * were overwritten before they could be read.
+ */
+#define EC_CMD_PD_TRACE 0x013C
+
+enum ec_pd_trace_event {
+	/* Received from the port partner or cable */
+	EC_PD_TRACE_RX = 0,
+	/* Sent, and acknowledged with GoodCRC */
+	EC_PD_TRACE_TX_SUCCESS = 1,
+	/* Discarded by the TCPC, because a message was being received */
+	EC_PD_TRACE_TX_DISCARDED = 2,
+	/* Sent, but not acknowledged after all retries */
+	EC_PD_TRACE_TX_FAILED = 3,
+	/* The TCPC didn't report the result of the transmit in time */
+	EC_PD_TRACE_TX_TIMEOUT = 4,
+};
+
+struct ec_params_pd_trace {
+	uint8_t port;
+	uint8_t reserved[3];
+	uint32_t seq;			/* First message to return */
+} __ec_align4;
+
+struct ec_pd_trace_record {
+	uint32_t time_lo;		/* EC uptime in us when the message */
+	uint32_t time_hi;		/* was received or sent */
+	uint16_t header;		/* PD message header */
+	uint8_t sop;			/* enum tcpm_transmit_type; also
+					 * TCPC_TX_HARD_RESET and
+					 * TCPC_TX_CABLE_RESET for signaling
+					 */
+	uint8_t event;			/* enum ec_pd_trace_event */
+	uint32_t data[7];		/* Data objects, as many as the
+					 * header's count
+					 */
+} __ec_align4;
+
+struct ec_response_pd_trace {
+	uint32_t first_seq;		/* Sequence number of records[0] */
+	uint32_t next_seq;		/* seq to ask for next */
+	uint8_t count;			/* Number of entries in records[] */
+	uint8_t reserved[3];
+	struct ec_pd_trace_record records[];
+} __ec_align4;
+
 /*****************************************************************************/
 /* The command range 0x200-0x2FF is reserved for Rotor. */
 
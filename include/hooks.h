@@ -260,6 +260,13 @@ struct hook_data {
 	int priority;
 };
 
+struct hook_slack {
+	/* Type of hook; HOOK_TICK or HOOK_SECOND. */
+	int type;
+	/* How late the hook routine may be called, in microseconds. */
+	int slack_us;
+};
+
 /**
  * Call all the hook routines of a specified type.
  *
@@ -335,6 +342,34 @@ int hook_call_deferred(const struct deferred_data *data, int us);
 	__attribute__((section(".rodata." STRINGIFY(hooktype))))	\
 	     = {routine, priority}
 
+/**
+ * Register a periodic hook routine which tolerates being called late.
+ *
+ * With CONFIG_HOOK_TICKLESS, the hook task may call HOOK_TICK or HOOK_SECOND
+ * routines up to slack_us late, so that it can handle them in the same
+ * wakeup as other periodic hooks or deferred calls.  A hook type is only
+ * delayed if every routine of that type was registered with a slack window,
+ * and then by at most the smallest one.  Without CONFIG_HOOK_TICKLESS this is
+ * the same as DECLARE_HOOK().
+ *
+ * @param hooktype	Type of hook for routine; HOOK_TICK or HOOK_SECOND
+ * @param routine	Hook routine, with prototype void routine(void)
+ * @param priority	Priority, as for DECLARE_HOOK()
+ * @param slack_us	How late the routine may be called, in microseconds
+ */
+#ifdef CONFIG_HOOK_TICKLESS
+#define DECLARE_HOOK_SLACK(hooktype, routine, priority, slack_us)	\
+	DECLARE_HOOK(hooktype, routine, priority);			\
+	BUILD_ASSERT(hooktype == HOOK_TICK || hooktype == HOOK_SECOND);	\
+	const struct hook_slack __keep __no_sanitize_address		\
+	CONCAT4(__hook_slack_, hooktype, _, routine)			\
+	__attribute__((section(".rodata.hook_slack")))			\
+	     = {hooktype, slack_us}
+#else
+#define DECLARE_HOOK_SLACK(hooktype, routine, priority, slack_us)	\
+	DECLARE_HOOK(hooktype, routine, priority)
+#endif
+
 /**
  * Register a deferred function call.
  *
@@ -367,6 +402,8 @@ int hook_call_deferred(const struct deferred_data *data, int us);
 #define hook_call_deferred(unused1, unused2) -1
 #define DECLARE_HOOK(t, func, p)				\
 	void CONCAT2(unused_hook_, func)(void) { func(); }
+#define DECLARE_HOOK_SLACK(t, func, p, s)			\
+	DECLARE_HOOK(t, func, p)
 #define DECLARE_DEFERRED(func)					\
 	void CONCAT2(unused_deferred_, func)(void) { func(); }
 #endif
@@ -128,6 +128,18 @@ struct host_command {
 	int version_mask;
 };
 
+/*
+ * Handler statistics for one host command, kept with CONFIG_HOSTCMD_STATS.
+ * The linker scripts reserve one per host command, so they need updating if
+ * the size of this or of struct host_command changes.
+ */
+struct host_command_stats {
+	uint64_t total_us;
+	uint32_t count;
+	uint32_t max_us;
+	uint32_t latency[EC_HOST_COMMAND_STATS_BUCKETS];
+};
+
 #ifdef CONFIG_HOST_EVENT64
 typedef uint64_t host_event_t;
 #define HOST_EVENT_CPRINTS(str, e)	CPRINTS("%s 0x%016" PRIx64, str, e)
@@ -162,6 +174,33 @@ uint8_t *host_get_memmap(int offset);
  */
 uint16_t host_command_process(struct host_cmd_handler_args *args);
 
+/**
+ * Let the current host command finish later.
+ *
+ * Called by a handler which hands its work to another task or a deferred
+ * function; the handler then returns the result of this call.  The host is
+ * sent EC_RES_IN_PROGRESS and the host command task is free to process other
+ * commands.  Once the work is done, call host_command_async_done().
+ *
+ * Only the result code is returned to the host, not any response data.
+ *
+ * @param args		Command handler args
+ * @return EC_RES_IN_PROGRESS, or EC_RES_BUSY if the same command or too many
+ * other commands are already in progress.
+ */
+enum ec_status host_command_async_start(struct host_cmd_handler_args *args);
+
+/**
+ * Finish a host command started with host_command_async_start().
+ *
+ * Sends the host an EC_MKBP_EVENT_HOST_COMMAND_DONE event with the result.
+ * Must be called from task context.
+ *
+ * @param command	Host command number
+ * @param result	Final result of the command
+ */
+void host_command_async_done(uint16_t command, enum ec_status result);
+
 /**
  * Set a single host event.
  *
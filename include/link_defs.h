@@ -77,11 +77,23 @@ extern const struct hook_data __hooks_usb_pd_disconnect_end[];
 extern const struct hook_data __hooks_usb_pd_connect[];
 extern const struct hook_data __hooks_usb_pd_connect_end[];
 
+/* Priority-sorted hook call order, filled in by hooks.c */
+extern uint8_t __hook_order[];
+extern uint8_t __hook_order_end[];
+
+/* Slack windows for periodic hooks */
+extern const struct hook_slack __hook_slack[];
+extern const struct hook_slack __hook_slack_end[];
+
 /* Deferrable functions and firing times*/
 extern const struct deferred_data __deferred_funcs[];
 extern const struct deferred_data __deferred_funcs_end[];
 extern uint64_t __deferred_until[];
 extern uint64_t __deferred_until_end[];
+extern uint8_t __deferred_heap[];
+extern uint8_t __deferred_heap_end[];
+extern uint8_t __deferred_heap_pos[];
+extern uint8_t __deferred_heap_pos_end[];
 
 /* I2C fake devices for unit testing */
 extern const struct test_i2c_xfer __test_i2c_xfer[];
@@ -90,6 +102,8 @@ extern const struct test_i2c_xfer __test_i2c_xfer_end[];
 /* Host commands */
 extern const struct host_command __hcmds[];
 extern const struct host_command __hcmds_end[];
+extern struct host_command_stats __hcmd_stats[];
+extern struct host_command_stats __hcmd_stats_end[];
 
 /* MKBP events */
 extern const struct mkbp_event_source __mkbp_evt_srcs[];
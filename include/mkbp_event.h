@@ -39,7 +39,8 @@ int mkbp_set_host_active_via_custom(int active, uint32_t *timestamp);
  * The struct to store the event source definition.  The get_data routine is
  * responsible for returning the event data when queried by the AP.  The
  * parameter 'data' points to where the event data needs to be stored, and
- * the size of the event data should be returned.
+ * the size of the event data should be returned, or -EC_ERROR_NOT_HANDLED if
+ * there is no event to report after all.
  */
 struct mkbp_event_source {
 	uint8_t event_type;
@@ -33,4 +33,7 @@ int verify_tcpci_tx_timeout(enum tcpm_transmit_type tx_type,
 void mock_tcpci_receive(enum pd_msg_type sop, uint16_t header,
 			uint32_t *payload);
 
+/* Number of I2C transactions with the TCPC since mock_tcpci_reset() */
+int mock_tcpci_get_xfer_count(void);
+
 void tcpci_register_dump(void);
@@ -76,6 +76,36 @@
 __stdlib_compat int vfnprintf(int (*addchar)(void *context, int c),
 			      void *context, const char *format, va_list args);
 
+/* Output functions for vfnprintf_sink() */
+struct printf_sink {
+	/*
+	 * Add one character.  Should return 0 if the character was accepted
+	 * or non-zero if it was dropped due to overflow.
+	 */
+	int (*addchar)(void *context, int c);
+	/*
+	 * Add len characters at once; optional.  Should add as many as fit,
+	 * then return 0 if all were accepted or non-zero if any were dropped.
+	 * If NULL, addchar() is called for each character.
+	 */
+	int (*addspan)(void *context, const char *s, int len);
+};
+
+/**
+ * Print formatted output to a sink which can take runs of characters at once.
+ *
+ * Like vfnprintf(), but literal text, padding, formatted fields and hex dumps
+ * are passed to sink->addspan() whole instead of a character at a time.
+ *
+ * @param sink		Output functions
+ * @param context	Context pointer to pass to the sink's functions
+ * @param format	Format string (see above for acceptable formats)
+ * @param args		Parameters
+ * @return EC_SUCCESS, or EC_ERROR_OVERFLOW if the output was truncated.
+ */
+int vfnprintf_sink(const struct printf_sink *sink, void *context,
+		   const char *format, va_list args);
+
 /**
  * Print formatted outut to a string.
  *
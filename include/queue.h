@@ -199,6 +199,54 @@ size_t queue_advance_head(struct queue const *q, size_t count);
  */
 size_t queue_advance_tail(struct queue const *q, size_t count);
 
+/*
+ * Scatter-gather queue access.  A queue_sg describes a region of the queue
+ * that may wrap around the end of the buffer, as (at most) two chunks.  The
+ * units of chunk[1], if any, follow those of chunk[0].
+ */
+struct queue_sg {
+	size_t count; /* Total units in both chunks */
+	struct queue_chunk chunk[2];
+};
+
+/*
+ * Reserve up to count units of free space at the tail of the queue, for
+ * filling in place.  Unlike queue_get_write_chunk this includes the free
+ * space past the wrap.  Once the units have been written, commit them with a
+ * single call to queue_advance_tail, which notifies the policy once.  Nothing
+ * is added to the queue until then, so a producer may also give up on a
+ * reservation.
+ *
+ * The same rules apply as for queue_get_write_chunk: only the producer may
+ * reserve space, and it must not commit more than it reserved.
+ */
+struct queue_sg queue_reserve_write(struct queue const *q, size_t count);
+
+/*
+ * Reserve up to count units from the head of the queue, for reading in place.
+ * Commit with queue_advance_head once they have been read; until then this is
+ * just a peek at the queue contents.
+ */
+struct queue_sg queue_reserve_read(struct queue const *q, size_t count);
+
+/* Return a pointer to the i'th unit of a reservation. */
+void *queue_sg_unit(struct queue const *q, struct queue_sg const *sg,
+		    size_t i);
+
+/*
+ * The same, for other queue types laid out like struct queue: a buffer of
+ * buffer_units units, a power of two, of unit_bytes each.
+ *
+ * Describe count units starting at (unwrapped) index start as a queue_sg.
+ */
+struct queue_sg queue_sg_split_buffer(uint8_t *buffer, size_t buffer_units,
+				      size_t unit_bytes, size_t start,
+				      size_t count);
+
+/* Return a pointer to the i'th unit of a reservation of unit_bytes units. */
+void *queue_sg_unit_size(struct queue_sg const *sg, size_t unit_bytes,
+			 size_t i);
+
 /* Add one unit to queue. */
 size_t queue_add_unit(struct queue const *q, const void *src);
 
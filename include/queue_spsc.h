@@ -0,0 +1,140 @@
+/* Copyright 2020 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Single-producer, single-consumer queue.
+ */
+#ifndef __CROS_EC_QUEUE_SPSC_H
+#define __CROS_EC_QUEUE_SPSC_H
+
+#include "common.h"
+#include "queue.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * A queue_spsc is a queue for exactly one producer and one consumer which may
+ * run at the same time: on different cores, or as threads of the host
+ * emulator.  A plain queue only works when they can't, because nothing orders
+ * its buffer accesses against the head and tail updates.
+ *
+ * Here the producer writes units into the buffer, then publishes them with a
+ * release store of the tail.  The consumer loads the tail with acquire
+ * semantics before reading the units, so it is sure to see them.  The head
+ * works the same way in the other direction, so the producer never reuses
+ * space the consumer is still reading.  No locks are needed, and neither side
+ * ever waits for the other.
+ *
+ * Only the producer may call the add, reserve_write and advance_tail
+ * functions, and only the consumer the remove, reserve_read and advance_head
+ * ones.  Either may call queue_spsc_count and queue_spsc_space, but the
+ * other side may move the queue at any time, so the result is a snapshot.
+ * It can only become an underestimate: the consumer's count and the
+ * producer's space never shrink under them.
+ *
+ * The policy is notified from whichever side moved the queue, as for a plain
+ * queue.
+ *
+ * Use a plain queue when the producer and consumer share a core; there the
+ * ordering only costs barriers.
+ */
+
+/*
+ * The head and tail are on separate cache lines on cores with a data cache
+ * and on SMP systems, so the producer and consumer don't pass one line back
+ * and forth.
+ */
+#if defined(CONFIG_ARMV7M_CACHE) || defined(CONFIG_SMP) || defined(CHIP_HOST)
+#define QUEUE_SPSC_ALIGN 64
+#else
+#define QUEUE_SPSC_ALIGN sizeof(size_t)
+#endif
+
+/*
+ * RAM state for a queue_spsc.  As for a queue, the indices aren't wrapped
+ * until they're used to access the buffer.
+ */
+struct queue_spsc_state {
+	size_t head __aligned(QUEUE_SPSC_ALIGN); /* Written by the consumer */
+	size_t tail __aligned(QUEUE_SPSC_ALIGN); /* Written by the producer */
+};
+
+/*
+ * Queue configuration stored in flash.
+ */
+struct queue_spsc {
+	struct queue_spsc_state *state;
+
+	struct queue_policy const *policy;
+
+	size_t  buffer_units; /* size of buffer (in units) */
+	size_t  unit_bytes;   /* size of unit   (in byte) */
+	uint8_t *buffer;
+};
+
+/*
+ * Construct a queue_spsc along with its backing buffer and state, like QUEUE.
+ */
+#define QUEUE_SPSC(SIZE, TYPE, POLICY)				\
+	((struct queue_spsc) {					\
+		.state        = &((struct queue_spsc_state){}),	\
+		.policy       = &POLICY,			\
+		.buffer_units = BUILD_CHECK_INLINE(SIZE, POWER_OF_TWO(SIZE)), \
+		.unit_bytes   = sizeof(TYPE),			\
+		.buffer       = (uint8_t *) &((TYPE[SIZE]){}),	\
+	})
+
+#define QUEUE_SPSC_NULL(SIZE, TYPE) QUEUE_SPSC(SIZE, TYPE, queue_policy_null)
+
+/*
+ * Initialize the queue to empty state.  Neither the producer nor the consumer
+ * may be using the queue at the time.
+ */
+void queue_spsc_init(struct queue_spsc const *q);
+
+/* Return the number of units stored in the queue. */
+size_t queue_spsc_count(struct queue_spsc const *q);
+
+/* Return the number of units worth of free space the queue has. */
+size_t queue_spsc_space(struct queue_spsc const *q);
+
+/*
+ * Reserve up to count units of free space at the tail of the queue, for the
+ * producer to fill in place.  See queue_reserve_write.
+ */
+struct queue_sg queue_spsc_reserve_write(struct queue_spsc const *q,
+					 size_t count);
+
+/*
+ * Publish count units written to a reservation to the consumer.  Returns the
+ * number of units added.
+ */
+size_t queue_spsc_advance_tail(struct queue_spsc const *q, size_t count);
+
+/*
+ * Reserve up to count units from the head of the queue, for the consumer to
+ * read in place.  See queue_reserve_read.
+ */
+struct queue_sg queue_spsc_reserve_read(struct queue_spsc const *q,
+					size_t count);
+
+/*
+ * Hand count units read from a reservation back to the producer.  Returns the
+ * number of units removed.
+ */
+size_t queue_spsc_advance_head(struct queue_spsc const *q, size_t count);
+
+/* Return a pointer to the i'th unit of a reservation. */
+void *queue_spsc_sg_unit(struct queue_spsc const *q,
+			 struct queue_sg const *sg, size_t i);
+
+/* Add multiple units to queue. */
+size_t queue_spsc_add_units(struct queue_spsc const *q, const void *src,
+			    size_t count);
+
+/* Remove multiple units from the begin of the queue. */
+size_t queue_spsc_remove_units(struct queue_spsc const *q, void *dest,
+			       size_t count);
+
+#endif /* __CROS_EC_QUEUE_SPSC_H */
@@ -57,6 +57,54 @@ int shared_mem_acquire(int size, char **dest_ptr);
  */
 void shared_mem_release(void *ptr);
 
+#ifdef CONFIG_SHAREDMEM_TRACE
+struct ec_shared_mem_trace_record;
+
+/*
+ * Record the result of a shared_mem_acquire() call made from caller.  Called
+ * by the shared memory implementation, without its lock held.
+ */
+void shared_mem_trace_acquire(void *ptr, int size, uintptr_t caller, int rv);
+
+/* Record that ptr has been released. */
+void shared_mem_trace_release(void *ptr);
+
+/**
+ * Get a traced allocation.
+ *
+ * @param index		0 for the most recent allocation, 1 for the one before,
+ *			and so on.
+ * @param r		Filled in with the record.
+ * @return EC_SUCCESS, or EC_ERROR_INVAL if there are no more records.
+ */
+int shared_mem_trace_get(int index, struct ec_shared_mem_trace_record *r);
+
+/**
+ * Get the shared memory a task holds, and the most it has held at once.
+ *
+ * @return EC_SUCCESS, or EC_ERROR_INVAL if task isn't a valid task ID.
+ */
+int shared_mem_trace_usage(int task, int *current, int *peak);
+
+/**
+ * Look for leaks: print each traced buffer which has been held for at least
+ * min_held_us.
+ *
+ * @return The number of such buffers.
+ */
+int shared_mem_trace_leaks(uint32_t min_held_us);
+
+/*
+ * Forget the records of released buffers, and reset each task's peak to what
+ * it holds now.
+ */
+void shared_mem_trace_reset(void);
+#else
+static inline void shared_mem_trace_acquire(void *ptr, int size,
+					    uintptr_t caller, int rv) {}
+static inline void shared_mem_trace_release(void *ptr) {}
+#endif
+
 /*
  * This structure is allocated at the base of the free memory chunk and every
  * allocated buffer.
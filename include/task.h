@@ -227,6 +227,68 @@ void task_end_irq_handler(void *excep_return);
 #define task_start_irq_handler(excep_return)
 #endif
 
+#ifdef CONFIG_TASK_SCHED_STATS
+/**
+ * Note that a task was made ready to run.
+ *
+ * Called by the scheduler when an event is posted to a task; the wakeup
+ * latency is measured from here to the next switch to that task.  Safe to
+ * call from interrupt context.
+ *
+ * @param tskid		Task ID
+ * @param now		Low 32 bits of the current time
+ */
+void task_sched_stats_ready(task_id_t tskid, uint32_t now);
+
+/**
+ * Note a context switch.
+ *
+ * Called by the scheduler with interrupts disabled.
+ *
+ * @param from		Task which was running, or TASK_ID_INVALID on the
+ *			first switch
+ * @param to		Task which is about to run
+ * @param now		Low 32 bits of the current time
+ */
+void task_sched_stats_switch(task_id_t from, task_id_t to, uint32_t now);
+#else
+static inline void task_sched_stats_ready(task_id_t tskid, uint32_t now) {}
+static inline void task_sched_stats_switch(task_id_t from, task_id_t to,
+					   uint32_t now) {}
+#endif
+
+#ifdef CONFIG_IRQ_PROFILE
+/**
+ * Note that interrupts have just been disabled.
+ *
+ * Called by interrupt_disable() with interrupts disabled, when they were
+ * enabled before.
+ *
+ * @param caller	Address interrupt_disable() was called from
+ * @param now		Low 32 bits of the current time
+ */
+void irq_profile_disabled(uintptr_t caller, uint32_t now);
+
+/**
+ * Note that interrupts are about to be enabled again.
+ *
+ * Called by interrupt_enable() before it enables interrupts.
+ *
+ * @param now		Low 32 bits of the current time
+ */
+void irq_profile_enabling(uint32_t now);
+
+/**
+ * Blame the current interrupt-disabled region on caller instead of the code
+ * which called interrupt_disable(), for wrappers such as irq_lock().
+ */
+void irq_profile_blame(uintptr_t caller);
+#else
+static inline void irq_profile_disabled(uintptr_t caller, uint32_t now) {}
+static inline void irq_profile_enabling(uint32_t now) {}
+static inline void irq_profile_blame(uintptr_t caller) {}
+#endif
+
 /**
  * Change the task scheduled to run after returning from the exception.
  *
@@ -200,6 +200,12 @@ void interrupt_generator_udelay(unsigned us);
 #ifdef EMU_BUILD
 void wait_for_task_started(void);
 void wait_for_task_started_nosleep(void);
+
+/*
+ * Read the host's monotonic clock in nanoseconds.  The emulator's get_time()
+ * is virtual, so benchmarks must use this to measure real execution time.
+ */
+uint64_t test_get_wall_clock_ns(void);
 #else
 static inline void wait_for_task_started(void) { }
 static inline void wait_for_task_started_nosleep(void) { }
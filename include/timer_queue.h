@@ -0,0 +1,80 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* Deadline-ordered queue of task timers */
+
+#ifndef __CROS_EC_TIMER_QUEUE_H
+#define __CROS_EC_TIMER_QUEUE_H
+
+#include "common.h"
+#include "task_id.h"
+#include "timer.h"
+
+/*
+ * The queue is a binary min-heap of task IDs keyed on their deadlines, so
+ * adding, moving and removing a timer are O(log n) and finding the earliest
+ * deadline is O(1).
+ *
+ * None of the timer_queue_*() functions lock anything; callers that can race
+ * with the timer interrupt must disable interrupts around them.
+ */
+
+/**
+ * Add a task's timer to the queue, or move it if it is already queued.
+ *
+ * @param tskid		Task ID
+ * @param deadline	When the timer expires
+ * @return 1 if the timer is now the earliest in the queue, else 0.
+ */
+int timer_queue_add(task_id_t tskid, timestamp_t deadline);
+
+/**
+ * Remove a task's timer from the queue, if it is queued.
+ *
+ * @param tskid		Task ID
+ */
+void timer_queue_remove(task_id_t tskid);
+
+/**
+ * Get the timer with the earliest deadline.
+ *
+ * @param deadline	Filled with the deadline of that timer, if any
+ * @return Its task ID, or TASK_ID_INVALID if the queue is empty.
+ */
+task_id_t timer_queue_peek(timestamp_t *deadline);
+
+/**
+ * Get the deadline of a queued timer.
+ *
+ * @param tskid		Task ID
+ * @return The deadline last passed to timer_queue_add() for that task.
+ */
+timestamp_t timer_queue_deadline(task_id_t tskid);
+
+/**
+ * Check whether a task's timer is queued.
+ *
+ * @param tskid		Task ID
+ * @return 1 if it is, else 0.
+ */
+int timer_queue_contains(task_id_t tskid);
+
+/*
+ * timer_arm(), timer_cancel() and process_timers() are implemented on top of
+ * the queue, and only need these from the clock source (common/timer.c), so
+ * that they can be tested without it.
+ */
+
+/**
+ * Count a wrap of the 32-bit hardware clock source.
+ */
+void timer_count_overflow(void);
+
+/**
+ * Trigger the timer interrupt, so that process_timers() runs.
+ */
+void timer_trigger_irq(void);
+
+#endif  /* __CROS_EC_TIMER_QUEUE_H */
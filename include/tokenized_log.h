@@ -0,0 +1,89 @@
+/* Copyright 2020 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* Tokenized console log */
+
+#ifndef __CROS_EC_TOKENIZED_LOG_H
+#define __CROS_EC_TOKENIZED_LOG_H
+
+#include <stdarg.h>
+
+#include "common.h"
+#include "console.h"
+
+/*
+ * One log entry: cprints() or cprintf() output, before formatting.
+ *
+ * The arguments follow the header, in the order they're used by the format
+ * string, packed with no padding:
+ *
+ *   - %c, %d, %u, %x, %X and a '*' width or precision: 4-byte integer
+ *   - the same with %ll, or %l or %z on 64-bit builds: 8-byte integer
+ *   - %s: the string's characters, then a NUL
+ *   - %pT: 8-byte timestamp in microseconds
+ *   - %pP: the pointer, sizeof(uintptr_t) bytes
+ *   - %ph: 1-byte length, then that many bytes of the buffer
+ *   - %pb: 4-byte value, then 1-byte digit count (0xff for a NULL pointer)
+ *
+ * Multi-byte values are in the EC's byte order.  If there was no room for all
+ * the arguments, TOKENIZED_LOG_TRUNCATED is set and the arguments stop early.
+ */
+struct tokenized_log_entry {
+	uint8_t size;		/* Size of the entry in bytes, with arguments */
+	uint8_t channel;	/* enum console_channel */
+	uint8_t flags;		/* TOKENIZED_LOG_* */
+	uint32_t timestamp;	/* Low 32 bits of the microsecond clock */
+	uintptr_t format;	/* Address of the format string */
+	uint8_t args[0];
+} __packed;
+
+/* Entry is from cprints(), so is printed with a timestamp and newline */
+#define TOKENIZED_LOG_CPRINTS	BIT(0)
+/* Some arguments didn't fit in the entry */
+#define TOKENIZED_LOG_TRUNCATED	BIT(1)
+
+/* Maximum size of an entry, with its arguments */
+#define TOKENIZED_LOG_ENTRY_MAX 96
+
+/**
+ * Add an entry to the tokenized log.
+ *
+ * @param channel	Console channel the output is for
+ * @param flags		TOKENIZED_LOG_CPRINTS or 0
+ * @param format	Format string; must not be freed or changed
+ * @param args		Arguments for the format string
+ */
+void tokenized_log_vadd(enum console_channel channel, int flags,
+			const char *format, va_list args);
+
+/**
+ * Return non-zero if cprints() and cprintf() output is being tokenized.
+ */
+int tokenized_log_enabled(void);
+
+/**
+ * Copy an entry out of the tokenized log.
+ *
+ * @param pos		Position in the log to read from.  Moved to the oldest
+ *			entry if it is no longer in the log, then past the
+ *			entry which was read.
+ * @param entry		Where to copy the entry
+ * @param size		Size of entry buffer
+ * @return Size of the entry, 0 if there are no more entries, or -1 if the
+ * entry at *pos doesn't fit in size bytes.
+ */
+int tokenized_log_read(uint32_t *pos, void *entry, int size);
+
+/**
+ * Format a tokenized log entry as text, as it would have been printed.
+ *
+ * @param entry		Entry, as returned by tokenized_log_read()
+ * @param buf		Destination string
+ * @param size		Size of buf in bytes
+ * @return Length of the string in buf.
+ */
+int tokenized_log_format(const void *entry, char *buf, int size);
+
+#endif  /* __CROS_EC_TOKENIZED_LOG_H */
@@ -89,6 +89,27 @@ int uart_vprintf(const char *format, va_list args);
  */
 void uart_flush_output(void);
 
+#ifdef CONFIG_UART_TX_STAGING
+/**
+ * Hold the current task's output until the matching uart_line_end().
+ *
+ * Output calls in between are collected and sent as one, so no other output
+ * can appear in the middle of them.  Calls may nest.  Does nothing in
+ * interrupt context.
+ */
+void uart_line_begin(void);
+
+/**
+ * Release output held by uart_line_begin().
+ *
+ * @return EC_SUCCESS, or non-zero if output was truncated.
+ */
+int uart_line_end(void);
+#else
+static inline void uart_line_begin(void) {}
+static inline int uart_line_end(void) { return EC_SUCCESS; }
+#endif
+
 /*
  * Input functions
  *
@@ -23,15 +23,47 @@
  * Define PD_PORT_TO_TASK_ID() and TASK_ID_TO_PD_PORT() macros to
  * go between PD port number and task ID. Assume that TASK_ID_PD_C0 is the
  * lowest task ID and IDs are on a continuous range.
+ *
+ * With CONFIG_USB_PD_SHARED_TASK, PD_C0 is the only PD task, and runs every
+ * port.  In it, TASK_ID_TO_PD_PORT() gives the port being run.
  */
 #if defined(HAS_TASK_PD_C0) && defined(CONFIG_USB_PD_PORT_MAX_COUNT)
+#ifdef CONFIG_USB_PD_SHARED_TASK
+#define PD_PORT_TO_TASK_ID(port) ((void)(port), TASK_ID_PD_C0)
+#define TASK_ID_TO_PD_PORT(id) \
+	((id) == TASK_ID_PD_C0 ? pd_task_get_port() : -1)
+#else
 #define PD_PORT_TO_TASK_ID(port) (TASK_ID_PD_C0 + (port))
 #define TASK_ID_TO_PD_PORT(id) ((id) - TASK_ID_PD_C0)
+#endif /* CONFIG_USB_PD_SHARED_TASK */
 #else
 #define PD_PORT_TO_TASK_ID(port) -1 /* stub task ID */
 #define TASK_ID_TO_PD_PORT(id) 0
 #endif /* CONFIG_USB_PD_PORT_MAX_COUNT && HAS_TASK_PD_C0 */
 
+/**
+ * Set events for a port's PD task.  Use this, rather than setting events on
+ * PD_PORT_TO_TASK_ID(port), so the events reach the port when one task runs
+ * several ports.  Events the PD task waits for with task_wait_event_mask(),
+ * while it's running the port, are still set on PD_PORT_TO_TASK_ID(port).
+ *
+ * @param port USB-C port number
+ * @param event Events to set
+ */
+#ifdef CONFIG_USB_PD_SHARED_TASK
+void pd_task_set_event(int port, uint32_t event);
+
+/**
+ * Get the port the shared PD task is running.
+ *
+ * @return USB-C port number
+ */
+int pd_task_get_port(void);
+#else
+#define pd_task_set_event(port, event) \
+	task_set_event(PD_PORT_TO_TASK_ID(port), (event))
+#endif
+
 enum pd_rx_errors {
 	PD_RX_ERR_INVAL = -1,           /* Invalid packet */
 	PD_RX_ERR_HARD_RESET = -2,      /* Got a Hard-Reset packet */
@@ -66,8 +98,10 @@ enum pd_rx_errors {
 #define PD_EVENT_RX_HARD_RESET		TASK_EVENT_CUSTOM_BIT(11)
 /* MUX configured notification event */
 #define PD_EVENT_AP_MUX_DONE		TASK_EVENT_CUSTOM_BIT(12)
+/* Ports have events for the shared PD task (CONFIG_USB_PD_SHARED_TASK) */
+#define PD_EVENT_PORT_PENDING		TASK_EVENT_CUSTOM_BIT(13)
 /* First free event on PD task */
-#define PD_EVENT_FIRST_FREE_BIT		13
+#define PD_EVENT_FIRST_FREE_BIT		14
 
 /* Ensure TCPC is out of low power mode before handling these events. */
 #define PD_EXIT_LOW_POWER_EVENT_MASK \
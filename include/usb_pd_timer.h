@@ -0,0 +1,226 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* USB PD per-port timer service */
+
+#ifndef __CROS_EC_USB_PD_TIMER_H
+#define __CROS_EC_USB_PD_TIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * The timers of the Type-C, Policy Engine and Protocol Layer state machines
+ * of a port.  Each timer is in one of three states:
+ *
+ *   Running:  enabled, with its deadline in the future
+ *   Expired:  its deadline has passed.  This is the state every timer starts
+ *             in, as if its deadline were the start of time.
+ *   Disabled: it will never expire
+ *
+ * Keeping the timers in one place lets the PD task sleep until the next one
+ * expires, rather than waking up to compare each deadline with the time.
+ */
+enum pd_task_timer {
+	/* Policy Engine */
+
+	/*
+	 * In BIST_TX mode, used by a UUT to ensure that a Continuous BIST Mode
+	 * (i.e. BIST Carrier Mode) is exited in a timely fashion.  In BIST_RX
+	 * mode, used to give the port partner time to respond.
+	 */
+	PE_TIMER_BIST_CONT_MODE,
+
+	/*
+	 * PD 3.0, version 2.0, section 6.6.18.1: The ChunkingNotSupportedTimer
+	 * is used by a Source or Sink which does not support multi-chunk
+	 * Chunking but has received a Message Chunk. The
+	 * ChunkingNotSupportedTimer Shall be started when the last bit of the
+	 * EOP of a Message Chunk of a multi-chunk Message is received. The
+	 * Policy Engine Shall Not send its Not_Supported Message before the
+	 * ChunkingNotSupportedTimer expires.
+	 */
+	PE_TIMER_CHUNKING_NOT_SUPPORTED,
+
+	/*
+	 * Used during an Explicit Contract when discovering whether a Port
+	 * Partner is PD Capable using SOP'.
+	 */
+	PE_TIMER_DISCOVER_IDENTITY,
+
+	/*
+	 * Used by the Policy Engine in a Source to determine that its Port
+	 * Partner is not responding after a Hard Reset.
+	 */
+	PE_TIMER_NO_RESPONSE,
+
+	/* Tracks the time after receiving a Wait message to a PR_Swap. */
+	PE_TIMER_PR_SWAP_WAIT,
+
+	/*
+	 * Used in a Source to ensure that the Sink has had sufficient time to
+	 * process Hard Reset Signaling before turning off its power supply to
+	 * VBUS.
+	 */
+	PE_TIMER_PS_HARD_RESET,
+
+	/*
+	 * Combines the PSSourceOffTimer and PSSourceOnTimer timers.
+	 *
+	 * For PSSourceOffTimer, when this DRP device is currently acting as a
+	 * Sink, this timer times out on a PS_RDY Message during a Power Role
+	 * Swap sequence.
+	 *
+	 * For PSSourceOnTimer, when this DRP device is currently acting as a
+	 * Source that has just stopped sourcing power and is waiting to start
+	 * sinking power to timeout on a PS_RDY Message during a Power Role
+	 * Swap.
+	 */
+	PE_TIMER_PS_SOURCE,
+
+	/*
+	 * Started when a request for a new Capability has been accepted and
+	 * will timeout after PD_T_PS_TRANSITION if a PS_RDY Message has not
+	 * been received.
+	 */
+	PE_TIMER_PS_TRANSITION,
+
+	/*
+	 * Used to ensure that a Message requesting a response (e.g.
+	 * Get_Source_Cap Message) is responded to within a bounded time of
+	 * PD_T_SENDER_RESPONSE.
+	 */
+	PE_TIMER_SENDER_RESPONSE,
+
+	/*
+	 * Used to ensure the time before the next Sink Request Message, after
+	 * a Wait Message has been received from the Source in response to a
+	 * Sink Request Message.
+	 */
+	PE_TIMER_SINK_REQUEST,
+
+	/*
+	 * Prior to a successful negotiation, a Source Shall use the
+	 * SourceCapabilityTimer to periodically send out a
+	 * Source_Capabilities Message.
+	 */
+	PE_TIMER_SOURCE_CAP,
+
+	/*
+	 * Used by the new Source, after a Power Role Swap or Fast Role Swap,
+	 * to ensure that it does not send Source_Capabilities Message before
+	 * the new Sink is ready to receive the Source_Capabilities Message.
+	 */
+	PE_TIMER_SWAP_SOURCE_START,
+
+	/* State timeout timer */
+	PE_TIMER_TIMEOUT,
+
+	/* Used during a VCONN Swap. */
+	PE_TIMER_VCONN_ON,
+
+	/*
+	 * Used by the Initiator's Policy Engine to ensure that a Structured
+	 * VDM Command request needing a response (e.g. Discover Identity
+	 * Command request) is responded to within a bounded time of
+	 * tVDMSenderResponse.
+	 */
+	PE_TIMER_VDM_RESPONSE,
+
+	/*
+	 * For PD2.0, used to wait 400ms and add some jitter of up to 100ms
+	 * before sending a message.
+	 * NOTE: This timer is not part of the TypeC/PD spec.
+	 */
+	PE_TIMER_WAIT_AND_ADD_JITTER,
+
+	/* Protocol Layer */
+	PR_TIMER_CHUNK_SENDER_REQUEST,
+	PR_TIMER_CHUNK_SENDER_RESPONSE,
+	PR_TIMER_HARD_RESET_COMPLETE,
+	PR_TIMER_SINK_TX,
+	/* Limits waiting on the TCPC to report a transmit (not in spec) */
+	PR_TIMER_TCPC_TX_TIMEOUT,
+
+	/* Type-C */
+
+	/* Time a port shall wait before it can determine it is attached */
+	TC_TIMER_CC_DEBOUNCE,
+	/* Time to debounce exit low power mode */
+	TC_TIMER_LOW_POWER_EXIT_TIME,
+	/* Time to enter low power mode */
+	TC_TIMER_LOW_POWER_TIME,
+	/* Role toggle timer */
+	TC_TIMER_NEXT_ROLE_SWAP,
+	/*
+	 * Time a Sink port shall wait before it can determine it is detached
+	 * due to the potential for USB PD signaling on CC as described in
+	 * the state definitions.
+	 */
+	TC_TIMER_PD_DEBOUNCE,
+	/* Generic timer */
+	TC_TIMER_TIMEOUT,
+	/*
+	 * Time a port shall wait before it can determine it is re-attached
+	 * during the try-wait process.
+	 */
+	TC_TIMER_TRY_WAIT_DEBOUNCE,
+	/*
+	 * Time to ignore Vbus absence due to external IC debounce detection
+	 * logic immediately after a power role swap.
+	 */
+	TC_TIMER_VBUS_DEBOUNCE,
+
+	PD_TIMER_COUNT
+};
+
+/**
+ * Reset all of a port's timers to expired.
+ *
+ * @param port USB-C port number
+ */
+void pd_timer_init(int port);
+
+/**
+ * Start a timer, or restart it if it's already running.
+ *
+ * @param port USB-C port number
+ * @param timer Timer to start
+ * @param expires_us Time from now until it expires; 0 expires it now
+ */
+void pd_timer_enable(int port, enum pd_task_timer timer, uint32_t expires_us);
+
+/**
+ * Disable a timer, so that it never expires.
+ *
+ * @param port USB-C port number
+ * @param timer Timer to disable
+ */
+void pd_timer_disable(int port, enum pd_task_timer timer);
+
+/**
+ * @param port USB-C port number
+ * @param timer Timer to check
+ * @return true if the timer is disabled
+ */
+bool pd_timer_is_disabled(int port, enum pd_task_timer timer);
+
+/**
+ * @param port USB-C port number
+ * @param timer Timer to check
+ * @return true if the timer has expired, and hasn't been restarted or
+ * disabled since.
+ */
+bool pd_timer_is_expired(int port, enum pd_task_timer timer);
+
+/**
+ * Get the time until the next of a port's running timers expires.
+ *
+ * @param port USB-C port number
+ * @return Time in us until then, or -1 if no timer is running
+ */
+int pd_timer_next_expiration(int port);
+
+#endif /* __CROS_EC_USB_PD_TIMER_H */
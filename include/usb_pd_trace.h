@@ -0,0 +1,80 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+/* USB PD message trace */
+
+#ifndef __CROS_EC_USB_PD_TRACE_H
+#define __CROS_EC_USB_PD_TRACE_H
+
+#include <stdint.h>
+
+#include "ec_commands.h"
+#include "usb_pd_tcpm.h"
+
+/*
+ * The trace of a port is written only by the task running the port's
+ * Protocol Layer, so recording a message takes no lock: it's a copy into the
+ * ring buffer.  Readers detect, and drop, records overwritten while they
+ * were being copied out.
+ */
+#ifdef CONFIG_USB_PD_TRACE
+
+/**
+ * Record a received message.
+ *
+ * @param port USB-C port number
+ * @param type SOP* the message was received on, or TCPC_TX_HARD_RESET
+ * @param header Message header
+ * @param data Data objects, as many as the header's count
+ */
+void pd_trace_rx(int port, enum tcpm_transmit_type type, uint16_t header,
+		 const uint32_t *data);
+
+/**
+ * Note a message about to be passed to the TCPC.  It's recorded once its
+ * result is known, by pd_trace_tx_done().
+ *
+ * @param port USB-C port number
+ * @param type SOP* the message is sent on, or the signaling to send
+ * @param header Message header
+ * @param data Data objects, as many as the header's count
+ */
+void pd_trace_tx(int port, enum tcpm_transmit_type type, uint16_t header,
+		 const uint32_t *data);
+
+/**
+ * Record the message last passed to pd_trace_tx().
+ *
+ * @param port USB-C port number
+ * @param event The result of sending it, one of EC_PD_TRACE_TX_*
+ */
+void pd_trace_tx_done(int port, enum ec_pd_trace_event event);
+
+/**
+ * Copy records out of the trace.
+ *
+ * @param port USB-C port number
+ * @param seq Sequence number of the first record wanted.  On return, the
+ *            sequence number of the first record copied, which is later if
+ *            the records wanted have been overwritten.
+ * @param records Where to copy the records
+ * @param max Most records to copy
+ * @return Number of records copied
+ */
+int pd_trace_read(int port, uint32_t *seq, struct ec_pd_trace_record *records,
+		  int max);
+
+#else
+
+static inline void pd_trace_rx(int port, enum tcpm_transmit_type type,
+			       uint16_t header, const uint32_t *data) { }
+static inline void pd_trace_tx(int port, enum tcpm_transmit_type type,
+			       uint16_t header, const uint32_t *data) { }
+static inline void pd_trace_tx_done(int port, enum ec_pd_trace_event event)
+{ }
+
+#endif /* CONFIG_USB_PD_TRACE */
+
+#endif /* __CROS_EC_USB_PD_TRACE_H */
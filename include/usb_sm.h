@@ -37,6 +37,9 @@ struct usb_state {
 
 typedef const struct usb_state *usb_state_ptr;
 
+/* The most states in a chain of parents, counting the innermost state */
+#define USB_SM_MAX_DEPTH 4
+
 /* Defines the current context of the usb statemachine. */
 struct sm_ctx {
 	usb_state_ptr current;
@@ -50,6 +50,16 @@ int tc_is_attached_src(int port);
  */
 int tc_is_attached_snk(int port);
 
+/**
+ * Returns true if the TypeC State machine is waiting for a partner to attach,
+ * and only needs to run when one of its timers expires or the TCPC reports a
+ * change on CC.
+ *
+ * @param port USB-C port number
+ * @return true if unattached and waiting for an attach
+ */
+bool tc_is_idle(int port);
+
 /**
  * Get cable plug setting. This should be constant per build. This replaces
  * the power role bit in PD header for SOP' and SOP" packets.
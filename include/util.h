@@ -212,6 +212,25 @@ bool is_aligned(uint32_t addr, uint32_t align);
  */
 int alignment_log2(unsigned int x);
 
+/**
+ * Get the latency histogram bucket for a duration.
+ *
+ * Bucket 0 counts durations below 16 us, bucket n durations in
+ * [4^(n+1), 4^(n+2)) us, and the last bucket everything longer.  This is
+ * the layout of the latency histograms in ec_commands.h.
+ *
+ * @param us		Duration in us
+ * @param buckets	Number of buckets in the histogram
+ * @return The bucket index (0..buckets-1)
+ */
+static inline int latency_bucket(uint32_t us, int buckets)
+{
+	if (us < 16)
+		return 0;
+
+	return MIN((__fls(us) - 4) / 2 + 1, buckets - 1);
+}
+
 /**
  * Reverse's the byte-order of the provided buffer.
  */
@@ -25,6 +25,7 @@ test-list-host += charge_manager
 test-list-host += charge_manager_drp_charging
 test-list-host += charge_ramp
 test-list-host += compile_time_macros
+test-list-host += console_batch
 test-list-host += console_edit
 test-list-host += crc
 test-list-host += entropy
@@ -39,10 +40,12 @@ test-list-host += fpsensor_state
 test-list-host += gyro_cal
 test-list-host += hooks
 test-list-host += host_command
+test-list-host += host_command_async
 test-list-host += i2c_bitbang
 test-list-host += inductive_charging
 test-list-host += interrupt
 test-list-host += irq_locking
+test-list-host += irq_profile
 test-list-host += is_enabled
 test-list-host += is_enabled_error
 test-list-host += kasa
@@ -65,24 +68,33 @@ test-list-host += pingpong
 test-list-host += power_button
 test-list-host += printf
 test-list-host += queue
+test-list-host += queue_spsc
 test-list-host += rsa
 test-list-host += rsa3
 test-list-host += rtc
 test-list-host += sbs_charging_v2
+test-list-host += sched_stats
 test-list-host += sha256
 test-list-host += sha256_unrolled
+test-list-host += shared_mem_trace
 test-list-host += shmalloc
+test-list-host += shmalloc_slab
+test-list-host += shmalloc_slab_large
 test-list-host += static_if
 test-list-host += static_if_error
 test-list-host += system
 test-list-host += thermal
 test-list-host += timer_dos
+test-list-host += timer_queue
+test-list-host += tokenized_log
+test-list-host += uart_tx_stress
 test-list-host += uptime
 test-list-host += usb_common
 test-list-host += usb_pd_int
 test-list-host += usb_pd
 test-list-host += usb_pd_giveback
 test-list-host += usb_pd_rev30
+test-list-host += usb_pd_timer
 test-list-host += usb_ppc
 test-list-host += usb_sm_framework_h3
 test-list-host += usb_sm_framework_h2
@@ -93,6 +105,9 @@ test-list-host += usb_typec_ctvpd
 test-list-host += usb_typec_drp_acc_trysrc
 test-list-host += usb_prl_old
 test-list-host += usb_tcpmv2_compliance
+test-list-host += usb_tcpmv2_compliance_shared
+test-list-host += usb_pd_shared_task
+test-list-host += usb_tcpci_rx
 test-list-host += usb_prl
 test-list-host += usb_prl_noextended
 test-list-host += usb_pe_drp_old
@@ -135,6 +150,7 @@ charge_manager-y=charge_manager.o
 charge_manager_drp_charging-y=charge_manager.o
 charge_ramp-y+=charge_ramp.o
 compile_time_macros-y=compile_time_macros.o
+console_batch-y=console_batch.o
 console_edit-y=console_edit.o
 crc-y=crc.o
 entropy-y=entropy.o
@@ -149,10 +165,12 @@ fpsensor_state-y=fpsensor_state.o
 gyro_cal-y=gyro_cal.o gyro_cal_init_for_test.o
 hooks-y=hooks.o
 host_command-y=host_command.o
+host_command_async-y=host_command_async.o
 i2c_bitbang-y=i2c_bitbang.o
 inductive_charging-y=inductive_charging.o
 interrupt-y=interrupt.o
 irq_locking-y=irq_locking.o
+irq_profile-y=irq_profile.o
 is_enabled-y=is_enabled.o
 kb_8042-y=kb_8042.o
 kb_mkbp-y=kb_mkbp.o
@@ -176,6 +194,7 @@ power_button-y=power_button.o
 powerdemo-y=powerdemo.o
 printf-y=printf.o
 queue-y=queue.o
+queue_spsc-y=queue_spsc.o
 rollback-y=rollback.o
 rollback_entropy-y=rollback_entropy.o
 rsa-y=rsa.o
@@ -184,9 +203,13 @@ rtc-y=rtc.o
 scratchpad-y=scratchpad.o
 sbs_charging-y=sbs_charging.o
 sbs_charging_v2-y=sbs_charging_v2.o
+sched_stats-y=sched_stats.o
 sha256-y=sha256.o
 sha256_unrolled-y=sha256.o
+shared_mem_trace-y=shared_mem_trace.o
 shmalloc-y=shmalloc.o
+shmalloc_slab-y=shmalloc_slab.o
+shmalloc_slab_large-y=shmalloc_slab.o
 static_if-y=static_if.o
 stm32f_rtc-y=stm32f_rtc.o
 stress-y=stress.o
@@ -194,12 +217,16 @@ system-y=system.o
 thermal-y=thermal.o
 timer_calib-y=timer_calib.o
 timer_dos-y=timer_dos.o
+timer_queue-y=timer_queue.o
+tokenized_log-y=tokenized_log.o
+uart_tx_stress-y=uart_tx_stress.o
 uptime-y=uptime.o
 usb_common-y=usb_common_test.o fake_battery.o
 usb_pd_int-y=usb_pd_int.o
 usb_pd-y=usb_pd.o
 usb_pd_giveback-y=usb_pd.o
 usb_pd_rev30-y=usb_pd.o
+usb_pd_timer-y=usb_pd_timer_test.o
 usb_ppc-y=usb_ppc.o
 usb_sm_framework_h3-y=usb_sm_framework_h3.o
 usb_sm_framework_h2-y=usb_sm_framework_h3.o
@@ -222,6 +249,15 @@ usb_tcpmv2_compliance-y=usb_tcpmv2_compliance.o usb_tcpmv2_compliance_common.o \
 	usb_tcpmv2_td_pd_src3_e26.o \
 	usb_tcpmv2_td_pd_snk3_e12.o \
 	usb_tcpmv2_td_pd_other.o
+usb_pd_shared_task-y=usb_pd_shared_task.o
+usb_tcpmv2_compliance_shared-y=usb_tcpmv2_compliance.o \
+	usb_tcpmv2_compliance_common.o \
+	usb_tcpmv2_td_pd_ll_e3.o \
+	usb_tcpmv2_td_pd_ll_e4.o \
+	usb_tcpmv2_td_pd_src3_e26.o \
+	usb_tcpmv2_td_pd_snk3_e12.o \
+	usb_tcpmv2_td_pd_other.o
+usb_tcpci_rx-y=usb_tcpci_rx.o
 utils-y=utils.o
 utils_str-y=utils_str.o
 vboot-y=vboot.o
@@ -0,0 +1,263 @@
+/* Copyright 2020 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test running batches of console commands.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "crc8.h"
+#include "printf.h"
+#include "test_util.h"
+#include "timer.h"
+#include "uart.h"
+#include "util.h"
+
+#define EC_BATCH_SYN "\xea"
+#define EC_BATCH_ACK '\xca'
+#define EC_BATCH "\xeb"
+
+static int echo_count;
+
+static int command_echo(int argc, char **argv)
+{
+	int i;
+
+	echo_count++;
+	for (i = 1; i < argc; i++)
+		ccprintf("%s%s", argv[i], i == argc - 1 ? "\n" : " ");
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(echo, command_echo, NULL, NULL);
+
+static int command_count(int argc, char **argv)
+{
+	char *e;
+	int i, n;
+
+	if (argc != 2)
+		return EC_ERROR_PARAM_COUNT;
+	n = strtoi(argv[1], &e, 0);
+	if (*e)
+		return EC_ERROR_PARAM1;
+
+	for (i = 0; i < n; i++)
+		ccprintf("%d\n", i);
+	ccprints("counted");
+	return EC_SUCCESS;
+}
+DECLARE_CONSOLE_COMMAND(count, command_count, NULL, NULL);
+
+/* Output and return code of each command in the last batch */
+static char outputs[8][512];
+static int results[8];
+static int commands_run;
+
+static int streq(const char *s1, const char *s2)
+{
+	return !strncmp(s1, s2, sizeof(outputs[0]));
+}
+
+/* Send a batch of commands, and return the reply */
+static const char *send_batch(const char *commands)
+{
+	char packet[256];
+	int len = strlen(commands);
+	int n;
+
+	n = snprintf(packet, sizeof(packet), EC_BATCH "%04x%02x&%s", len,
+		     cros_crc8((const uint8_t *)commands, len), commands);
+
+	test_capture_console(1);
+	uart_inject_char(packet, n);
+	msleep(30);
+	test_capture_console(0);
+
+	return test_get_captured_console();
+}
+
+static int hex(const char *s, int digits)
+{
+	char buf[8];
+	char *e;
+	int v;
+
+	memcpy(buf, s, digits);
+	buf[digits] = '\0';
+	v = strtoi(buf, &e, 16);
+	return *e ? -1 : v;
+}
+
+/* Unpack the frames in the reply to a batch */
+static int parse_reply(const char *reply)
+{
+	const char *p = reply;
+	int index, len, crc, n;
+
+	memset(outputs, 0, sizeof(outputs));
+	memset(results, 0xff, sizeof(results));
+	commands_run = -1;
+
+	while (*p) {
+		TEST_ASSERT(!strncmp(p, "&&", 2));
+		index = hex(p + 3, 2);
+		TEST_ASSERT(index >= 0 && index < ARRAY_SIZE(outputs));
+
+		switch (p[2]) {
+		case 'O':
+			len = hex(p + 5, 2);
+			crc = hex(p + 7, 2);
+			TEST_ASSERT(p[9] == '&');
+			p += 10;
+			TEST_ASSERT(len > 0 && strlen(p) >= len);
+			TEST_ASSERT(cros_crc8((const uint8_t *)p, len) == crc);
+			TEST_ASSERT(results[index] == -1);
+			n = strlen(outputs[index]);
+			TEST_ASSERT(n + len < sizeof(outputs[index]));
+			memcpy(outputs[index] + n, p, len);
+			p += len;
+			break;
+		case 'R':
+			TEST_ASSERT(p[9] == '&');
+			results[index] = hex(p + 5, 4);
+			p += 10;
+			break;
+		case 'Z':
+			TEST_ASSERT(p[5] == '&');
+			commands_run = index;
+			p += 6;
+			/* Nothing else follows */
+			TEST_ASSERT(!*p);
+			break;
+		default:
+			TEST_ASSERT(0);
+		}
+	}
+
+	TEST_ASSERT(commands_run >= 0);
+	return EC_SUCCESS;
+}
+
+static int test_probe(void)
+{
+	const char *reply;
+
+	test_capture_console(1);
+	UART_INJECT(EC_BATCH_SYN);
+	msleep(30);
+	test_capture_console(0);
+
+	reply = test_get_captured_console();
+	TEST_EQ(reply[0], EC_BATCH_ACK, "%c");
+	TEST_EQ(hex(reply + 1, 4), CONFIG_CONSOLE_BATCH, "%d");
+	TEST_EQ(reply[5], '\0', "%c");
+
+	return EC_SUCCESS;
+}
+
+static int test_batch(void)
+{
+	echo_count = 0;
+	TEST_ASSERT(parse_reply(send_batch("echo one two\n"
+					   "\n"
+					   "echo three\n"
+					   "count x\n"
+					   "nosuchcommand")) == EC_SUCCESS);
+
+	TEST_EQ(commands_run, 5, "%d");
+	TEST_EQ(echo_count, 2, "%d");
+	TEST_ASSERT(streq(outputs[0], "one two\n"));
+	TEST_EQ(results[0], EC_SUCCESS, "%d");
+	TEST_ASSERT(streq(outputs[1], ""));
+	TEST_EQ(results[1], EC_SUCCESS, "%d");
+	TEST_ASSERT(streq(outputs[2], "three\n"));
+	TEST_ASSERT(streq(outputs[3], "Parameter 1 invalid\n"));
+	TEST_EQ(results[3], EC_ERROR_PARAM1, "%d");
+	TEST_ASSERT(streq(outputs[4],
+			  "Command 'nosuchcommand' not found or ambiguous.\n"));
+	TEST_EQ(results[4], EC_ERROR_UNKNOWN, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_long_output(void)
+{
+	char expect[512];
+	char *p = expect;
+	int i;
+
+	TEST_ASSERT(parse_reply(send_batch("count 50")) == EC_SUCCESS);
+
+	/* Output is split over several frames */
+	for (i = 0; i < 50; i++)
+		p += snprintf(p, expect + sizeof(expect) - p, "%d\n", i);
+	TEST_EQ(commands_run, 1, "%d");
+	TEST_ASSERT(!strncmp(outputs[0], expect, p - expect));
+	TEST_ASSERT(streq(outputs[0] + strlen(outputs[0]) - 10,
+			  " counted]\n"));
+	TEST_EQ(results[0], EC_SUCCESS, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_empty_batch(void)
+{
+	TEST_ASSERT(parse_reply(send_batch("")) == EC_SUCCESS);
+	TEST_EQ(commands_run, 0, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_corrupted(void)
+{
+	char bad_crc[] = EC_BATCH "000500&echo\n";
+	char too_long[] = EC_BATCH "ffff00&";
+
+	echo_count = 0;
+	test_capture_console(1);
+	UART_INJECT(bad_crc);
+	msleep(30);
+	UART_INJECT(too_long);
+	msleep(30);
+	test_capture_console(0);
+
+	TEST_ASSERT(streq(test_get_captured_console(), "&&EE\r\n&&EE\r\n"));
+	TEST_EQ(echo_count, 0, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_timeout(void)
+{
+	/* A batch which stops part way is abandoned, even with no more input */
+	echo_count = 0;
+	test_capture_console(1);
+	UART_INJECT(EC_BATCH "00");
+	msleep(200);
+	test_capture_console(0);
+	TEST_ASSERT(streq(test_get_captured_console(), "&&EE\r\n"));
+
+	UART_INJECT("echo typed\n");
+	msleep(30);
+	TEST_EQ(echo_count, 1, "%d");
+
+	return EC_SUCCESS;
+}
+
+void run_test(int argc, char **argv)
+{
+	test_reset();
+
+	/* Let the console and other tasks finish printing as they start */
+	msleep(30);
+
+	RUN_TEST(test_probe);
+	RUN_TEST(test_batch);
+	RUN_TEST(test_long_output);
+	RUN_TEST(test_empty_batch);
+	RUN_TEST(test_corrupted);
+	RUN_TEST(test_timeout);
+
+	test_print_result();
+}
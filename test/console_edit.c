@@ -7,6 +7,7 @@
 
 #include "common.h"
 #include "console.h"
+#include "link_defs.h"
 #include "test_util.h"
 #include "timer.h"
 #include "util.h"
@@ -273,6 +274,143 @@ static int test_output_channel(void)
 	return EC_SUCCESS;
 }
 
+static int test_command_table_sorted(void)
+{
+	const struct console_command *cmd;
+
+	/* Lookups depend on the linker sorting the commands */
+	for (cmd = __cmds + 1; cmd < __cmds_end; cmd++)
+		TEST_ASSERT(strcasecmp(cmd[-1].name, cmd->name) < 0);
+
+	return EC_SUCCESS;
+}
+
+static int test_complete(void)
+{
+	const struct console_command *cmd;
+	int count;
+
+	TEST_EQ(console_command_complete("tes", 3, &cmd, &count), 4, "%d");
+	TEST_EQ(count, 2, "%d");
+	TEST_ASSERT(!strcasecmp(cmd[0].name, "test1"));
+	TEST_ASSERT(!strcasecmp(cmd[1].name, "test2"));
+
+	TEST_EQ(console_command_complete("TEST2", 5, &cmd, &count), 5, "%d");
+	TEST_EQ(count, 1, "%d");
+	TEST_ASSERT(!strcasecmp(cmd->name, "test2"));
+
+	TEST_EQ(console_command_complete("test3", 5, &cmd, &count), 0, "%d");
+	TEST_EQ(count, 0, "%d");
+
+	console_command_complete("", 0, &cmd, &count);
+	TEST_ASSERT(cmd == __cmds);
+	TEST_EQ(count, (int)(__cmds_end - __cmds), "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_tab_complete(void)
+{
+	cmd_1_call_cnt = 0;
+	cmd_2_call_cnt = 0;
+	UART_INJECT("tes\t1\n");
+	msleep(30);
+	TEST_CHECK(cmd_1_call_cnt == 1);
+	UART_INJECT("hel\t\n");
+	msleep(30);
+	UART_INJECT("TEST2\t\n");
+	msleep(30);
+	TEST_CHECK(cmd_2_call_cnt == 1);
+}
+
+static int test_tab_list(void)
+{
+	const char *exp_output = "test\n"
+				 " test1          test2         \n"
+				 "> test";
+
+	cmd_2_call_cnt = 0;
+	test_capture_console(1);
+	UART_INJECT("test\t");
+	msleep(30);
+	test_capture_console(0);
+	UART_INJECT("2\n");
+	msleep(30);
+	TEST_ASSERT(compare_multiline_string(test_get_captured_console(),
+					     exp_output) == 0);
+	TEST_EQ(cmd_2_call_cnt, 1, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_help_ambiguous(void)
+{
+	const char *exp_output = "help test\n"
+				 "Command 'test' is ambiguous:\n"
+				 " test1          test2         \n"
+				 "Unknown error\n"
+				 "Usage: help [ list | <name> ]\n"
+				 "> ";
+
+	test_capture_console(1);
+	UART_INJECT("help test\n");
+	msleep(30);
+	test_capture_console(0);
+	TEST_ASSERT(compare_multiline_string(test_get_captured_console(),
+					     exp_output) == 0);
+
+	return EC_SUCCESS;
+}
+
+/* What finding a command took before the command table was searched */
+static const struct console_command *linear_find(const char *name)
+{
+	const struct console_command *cmd, *match = NULL;
+	int match_length = strlen(name);
+
+	for (cmd = __cmds; cmd < __cmds_end; cmd++) {
+		if (!strncasecmp(name, cmd->name, match_length)) {
+			if (match)
+				return NULL;
+			if (cmd->name[match_length] == '\0')
+				return cmd;
+			match = cmd;
+		}
+	}
+
+	return match;
+}
+
+static int test_lookup_benchmark(void)
+{
+	const struct console_command *cmd, *found;
+	const int ncmds = __cmds_end - __cmds;
+	const int rounds = 200;
+	uint64_t start, linear_ns, search_ns;
+	int i, count;
+
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < rounds; i++)
+		for (cmd = __cmds; cmd < __cmds_end; cmd++)
+			TEST_ASSERT(linear_find(cmd->name) == cmd);
+	linear_ns = test_get_wall_clock_ns() - start;
+
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < rounds; i++)
+		for (cmd = __cmds; cmd < __cmds_end; cmd++) {
+			console_command_complete(cmd->name, strlen(cmd->name),
+						 &found, &count);
+			TEST_ASSERT(found == cmd);
+		}
+	search_ns = test_get_wall_clock_ns() - start;
+
+	ccprintf("%d commands: linear scan %d ns/lookup, search %d ns/lookup\n",
+		 ncmds, (int)(linear_ns / rounds / ncmds),
+		 (int)(search_ns / rounds / ncmds));
+
+	return EC_SUCCESS;
+}
+
 void run_test(int argc, char **argv)
 {
 	test_reset();
@@ -290,6 +428,12 @@ void run_test(int argc, char **argv)
 	RUN_TEST(test_history_stash);
 	RUN_TEST(test_history_list);
 	RUN_TEST(test_output_channel);
+	RUN_TEST(test_command_table_sorted);
+	RUN_TEST(test_complete);
+	RUN_TEST(test_tab_complete);
+	RUN_TEST(test_tab_list);
+	RUN_TEST(test_help_ambiguous);
+	RUN_TEST(test_lookup_benchmark);
 
 	test_print_result();
 }
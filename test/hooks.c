@@ -7,11 +7,15 @@
 
 #include "common.h"
 #include "console.h"
+#include "ec_commands.h"
 #include "hooks.h"
 #include "test_util.h"
 #include "timer.h"
 #include "util.h"
 
+/* HOOK_TICK may run this late; must stay within test_ticks() tolerance */
+#define TICK_SLACK (20 * MSEC)
+
 static int init_hook_count;
 static int tick_hook_count;
 static int tick2_hook_count;
@@ -33,7 +37,7 @@ static void tick_hook(void)
 	tick_time[0] = tick_time[1];
 	tick_time[1] = get_time();
 }
-DECLARE_HOOK(HOOK_TICK, tick_hook, HOOK_PRIO_DEFAULT);
+DECLARE_HOOK_SLACK(HOOK_TICK, tick_hook, HOOK_PRIO_DEFAULT, TICK_SLACK);
 
 static void tick2_hook(void)
 {
@@ -41,7 +45,8 @@ static void tick2_hook(void)
 	tick_count_seen_by_tick2 = tick_hook_count;
 }
 /* tick2_hook() prio means it should be called after tick_hook() */
-DECLARE_HOOK(HOOK_TICK, tick2_hook, HOOK_PRIO_DEFAULT+1);
+DECLARE_HOOK_SLACK(HOOK_TICK, tick2_hook, HOOK_PRIO_DEFAULT+1,
+		   TICK_SLACK * 2);
 
 static void second_hook(void)
 {
@@ -49,7 +54,8 @@ static void second_hook(void)
 	second_time[0] = second_time[1];
 	second_time[1] = get_time();
 }
-DECLARE_HOOK(HOOK_SECOND, second_hook, HOOK_PRIO_DEFAULT);
+DECLARE_HOOK_SLACK(HOOK_SECOND, second_hook, HOOK_PRIO_DEFAULT,
+		   100 * MSEC);
 
 static void deferred_func(void)
 {
@@ -134,6 +140,128 @@ static int test_deferred(void)
 	return EC_SUCCESS;
 }
 
+static int deferred_order[3];
+static int deferred_order_count;
+
+static void deferred_order_record(int id)
+{
+	if (deferred_order_count < ARRAY_SIZE(deferred_order))
+		deferred_order[deferred_order_count] = id;
+	deferred_order_count++;
+}
+
+static void deferred_a(void)
+{
+	deferred_order_record(0);
+}
+DECLARE_DEFERRED(deferred_a);
+
+static void deferred_b(void)
+{
+	deferred_order_record(1);
+}
+DECLARE_DEFERRED(deferred_b);
+
+static void deferred_c(void)
+{
+	deferred_order_record(2);
+}
+DECLARE_DEFERRED(deferred_c);
+
+static int test_deferred_order(void)
+{
+	deferred_order_count = 0;
+
+	/* Scheduled out of order, and rescheduled both earlier and later */
+	hook_call_deferred(&deferred_a_data, 30 * MSEC);
+	hook_call_deferred(&deferred_b_data, 10 * MSEC);
+	hook_call_deferred(&deferred_c_data, 50 * MSEC);
+	hook_call_deferred(&deferred_c_data, 20 * MSEC);
+	hook_call_deferred(&deferred_b_data, 40 * MSEC);
+	usleep(100 * MSEC);
+
+	TEST_EQ(deferred_order_count, 3, "%d");
+	TEST_EQ(deferred_order[0], 2, "%d");
+	TEST_EQ(deferred_order[1], 0, "%d");
+	TEST_EQ(deferred_order[2], 1, "%d");
+
+	/* Cancelling the earliest deadline leaves the others pending */
+	deferred_order_count = 0;
+	hook_call_deferred(&deferred_a_data, 10 * MSEC);
+	hook_call_deferred(&deferred_b_data, 20 * MSEC);
+	hook_call_deferred(&deferred_c_data, 30 * MSEC);
+	hook_call_deferred(&deferred_a_data, -1);
+	usleep(100 * MSEC);
+
+	TEST_EQ(deferred_order_count, 2, "%d");
+	TEST_EQ(deferred_order[0], 1, "%d");
+	TEST_EQ(deferred_order[1], 2, "%d");
+
+	return EC_SUCCESS;
+}
+
+static void get_wake_stats(struct ec_response_hook_wake_stats *r, int reset)
+{
+	struct ec_params_hook_wake_stats p = {
+		.flags = reset ? EC_HOOK_WAKE_STATS_RESET : 0,
+	};
+
+	test_send_host_command(EC_CMD_HOOK_WAKE_STATS, 0, &p, sizeof(p),
+			       r, sizeof(*r));
+}
+
+static timestamp_t coalesce_time;
+
+static void deferred_coalesce(void)
+{
+	coalesce_time = get_time();
+}
+DECLARE_DEFERRED(deferred_coalesce);
+
+static int test_tickless(void)
+{
+	struct ec_response_hook_wake_stats r;
+	uint64_t target;
+	int count;
+
+	get_wake_stats(&r, 1);
+	TEST_EQ(r.tick_slack_us, TICK_SLACK, "%d");
+	TEST_EQ(r.second_slack_us, 100 * MSEC, "%d");
+
+	/*
+	 * HOOK_SECOND is due at the same time as a HOOK_TICK, which has less
+	 * slack, so it never needs a wakeup of its own.
+	 */
+	usleep(2500 * MSEC);
+	get_wake_stats(&r, 0);
+	TEST_ASSERT(r.second >= 2);
+	TEST_ASSERT(r.coalesced >= r.second);
+
+	/*
+	 * With nothing else to do, a tick runs at the end of its slack
+	 * window.  A deferred call due inside the next window should pull the
+	 * tick forward into the same wakeup.
+	 */
+	count = tick_hook_count;
+	while (tick_hook_count == count)
+		usleep(MSEC);
+	target = tick_time[1].val - TICK_SLACK + HOOK_TICK_INTERVAL +
+		 TICK_SLACK / 2;
+
+	count = r.coalesced;
+	hook_call_deferred(&deferred_coalesce_data,
+			   target - get_time().val);
+	usleep(HOOK_TICK_INTERVAL);
+
+	TEST_ASSERT(coalesce_time.val >= target);
+	TEST_ASSERT(tick_time[1].val >= coalesce_time.val);
+	TEST_ASSERT(tick_time[1].val - coalesce_time.val < MSEC);
+	get_wake_stats(&r, 0);
+	TEST_ASSERT(r.coalesced > count);
+
+	return EC_SUCCESS;
+}
+
 static int repeating_deferred_count;
 static void deferred_repeating_func(void);
 DECLARE_DEFERRED(deferred_repeating_func);
@@ -159,6 +287,83 @@ static int test_repeating_deferred(void)
 	return EC_SUCCESS;
 }
 
+/*
+ * Synthetic hooks for checking call order and dispatch cost with a realistic
+ * number of handlers.  Priorities are scattered so that link order and
+ * priority order disagree.
+ */
+#define SYNTH_HOOK_COUNT 200
+#define SYNTH_PRIO(n) (HOOK_PRIO_FIRST + ((n) * 7919) % 97)
+#define SYNTH_NOTIFY_COUNT 1000
+
+static int synth_call_count;
+static int synth_prio[SYNTH_HOOK_COUNT];
+
+static void synth_hook_called(int prio)
+{
+	if (synth_call_count < SYNTH_HOOK_COUNT)
+		synth_prio[synth_call_count] = prio;
+	synth_call_count++;
+}
+
+#define SYNTH_HOOK(t, u)						\
+	static void synth_hook_##t##_##u(void)				\
+	{								\
+		synth_hook_called(SYNTH_PRIO((t) * 10 + (u)));		\
+	}								\
+	DECLARE_HOOK(HOOK_CHIPSET_RESET, synth_hook_##t##_##u,		\
+		     SYNTH_PRIO((t) * 10 + (u)))
+
+#define SYNTH_HOOK10(t)							\
+	SYNTH_HOOK(t, 0); SYNTH_HOOK(t, 1); SYNTH_HOOK(t, 2);		\
+	SYNTH_HOOK(t, 3); SYNTH_HOOK(t, 4); SYNTH_HOOK(t, 5);		\
+	SYNTH_HOOK(t, 6); SYNTH_HOOK(t, 7); SYNTH_HOOK(t, 8);		\
+	SYNTH_HOOK(t, 9)
+
+SYNTH_HOOK10(0); SYNTH_HOOK10(1); SYNTH_HOOK10(2); SYNTH_HOOK10(3);
+SYNTH_HOOK10(4); SYNTH_HOOK10(5); SYNTH_HOOK10(6); SYNTH_HOOK10(7);
+SYNTH_HOOK10(8); SYNTH_HOOK10(9); SYNTH_HOOK10(10); SYNTH_HOOK10(11);
+SYNTH_HOOK10(12); SYNTH_HOOK10(13); SYNTH_HOOK10(14); SYNTH_HOOK10(15);
+SYNTH_HOOK10(16); SYNTH_HOOK10(17); SYNTH_HOOK10(18); SYNTH_HOOK10(19);
+
+static int test_notify_order(void)
+{
+	int i;
+
+	synth_call_count = 0;
+	hook_notify(HOOK_CHIPSET_RESET);
+	TEST_EQ(synth_call_count, SYNTH_HOOK_COUNT, "%d");
+
+	for (i = 1; i < SYNTH_HOOK_COUNT; i++)
+		TEST_ASSERT(synth_prio[i - 1] <= synth_prio[i]);
+
+	return EC_SUCCESS;
+}
+
+static int test_notify_cost(void)
+{
+	uint64_t start, elapsed;
+	int i;
+
+	/* Don't time CONFIG_HOOK_DEBUG output */
+	console_channel_disable("hook");
+
+	synth_call_count = 0;
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < SYNTH_NOTIFY_COUNT; i++)
+		hook_notify(HOOK_CHIPSET_RESET);
+	elapsed = test_get_wall_clock_ns() - start;
+
+	console_channel_enable("hook");
+
+	TEST_EQ(synth_call_count, SYNTH_HOOK_COUNT * SYNTH_NOTIFY_COUNT, "%d");
+	ccprintf("%d notifications of %d hooks: %d ns/notify\n",
+		 SYNTH_NOTIFY_COUNT, SYNTH_HOOK_COUNT,
+		 (int)(elapsed / SYNTH_NOTIFY_COUNT));
+
+	return EC_SUCCESS;
+}
+
 void run_test(int argc, char **argv)
 {
 	test_reset();
@@ -166,8 +371,12 @@ void run_test(int argc, char **argv)
 	RUN_TEST(test_init_hook);
 	RUN_TEST(test_ticks);
 	RUN_TEST(test_priority);
+	RUN_TEST(test_notify_order);
+	RUN_TEST(test_notify_cost);
 	RUN_TEST(test_deferred);
+	RUN_TEST(test_deferred_order);
 	RUN_TEST(test_repeating_deferred);
+	RUN_TEST(test_tickless);
 
 	test_print_result();
 }
@@ -8,6 +8,7 @@
 #include "common.h"
 #include "console.h"
 #include "host_command.h"
+#include "link_defs.h"
 #include "task.h"
 #include "test_util.h"
 #include "timer.h"
@@ -16,6 +17,9 @@
 /* Request/response buffer size (and maximum command length) */
 #define BUFFER_SIZE 128
 
+/* Number of command lookups in the benchmark */
+#define DISPATCH_COUNT 1000000
+
 struct host_packet pkt;
 static char resp_buf[BUFFER_SIZE];
 static char req_buf[BUFFER_SIZE + 4];
@@ -300,6 +304,158 @@ static int test_hostcmd_clears_unused_data(void)
 	return EC_SUCCESS;
 }
 
+static int test_hostcmd_lookup_all(void)
+{
+	const struct host_command *cmd;
+	struct ec_params_get_cmd_versions_v1 p;
+	struct ec_response_get_cmd_versions r;
+	int i;
+
+	/* Every registered command is found, with its own version mask */
+	for (cmd = __hcmds; cmd < __hcmds_end; cmd++) {
+		p.cmd = cmd->command;
+		TEST_EQ(test_send_host_command(EC_CMD_GET_CMD_VERSIONS, 1, &p,
+					       sizeof(p), &r, sizeof(r)),
+			EC_RES_SUCCESS, "%d");
+		TEST_EQ(r.version_mask, cmd->version_mask, "0x%x");
+	}
+
+	/* Unused numbers in and around used pages aren't; don't log them */
+	console_channel_disable("hostcmd");
+	for (i = 0; i <= EC_CMD_BOARD_SPECIFIC_LAST + 0x40; i++) {
+		for (cmd = __hcmds; cmd < __hcmds_end; cmd++)
+			if (cmd->command == i)
+				break;
+		if (cmd < __hcmds_end)
+			continue;
+		p.cmd = i;
+		if (test_send_host_command(EC_CMD_GET_CMD_VERSIONS, 1, &p,
+					   sizeof(p), &r, sizeof(r)) !=
+		    EC_RES_INVALID_PARAM)
+			break;
+	}
+	console_channel_enable("hostcmd");
+	TEST_EQ(i, EC_CMD_BOARD_SPECIFIC_LAST + 0x41, "0x%x");
+
+	return EC_SUCCESS;
+}
+
+/* Defined in common/host_command.c */
+const struct host_command *find_host_command(int command);
+
+/* Reference linear search, as used without CONFIG_HOSTCMD_DISPATCH_PAGES */
+static const struct host_command *search_host_command(int command)
+{
+	const struct host_command *cmd;
+
+	for (cmd = __hcmds; cmd < __hcmds_end; cmd++) {
+		if (command == cmd->command)
+			return cmd;
+	}
+
+	return NULL;
+}
+
+static int test_hostcmd_dispatch_cost(void)
+{
+	/* Spread the lookups over the first, middle and last commands */
+	const uint16_t commands[] = {
+		__hcmds->command, EC_CMD_HELLO,
+		__hcmds[(__hcmds_end - __hcmds) / 2].command,
+		(__hcmds_end - 1)->command,
+	};
+	uint64_t start, table_ns, search_ns;
+	int i, found;
+
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < DISPATCH_COUNT; i++) {
+		if (!find_host_command(commands[i % ARRAY_SIZE(commands)]))
+			break;
+	}
+	table_ns = test_get_wall_clock_ns() - start;
+	found = i;
+
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < DISPATCH_COUNT; i++) {
+		if (!search_host_command(commands[i % ARRAY_SIZE(commands)]))
+			break;
+	}
+	search_ns = test_get_wall_clock_ns() - start;
+	TEST_EQ(found, DISPATCH_COUNT, "%d");
+	TEST_EQ(i, DISPATCH_COUNT, "%d");
+
+	ccprintf("%d lookups of %d commands: table %d ns/lookup, "
+		 "linear search %d ns/lookup\n", DISPATCH_COUNT,
+		 (int)(__hcmds_end - __hcmds),
+		 (int)(table_ns / DISPATCH_COUNT),
+		 (int)(search_ns / DISPATCH_COUNT));
+
+	return EC_SUCCESS;
+}
+
+#define STATS_HELLO_COUNT 25
+
+static int test_hostcmd_stats(void)
+{
+	struct ec_params_host_command_stats p = {
+		.flags = EC_HOST_COMMAND_STATS_RESET,
+	};
+	/* Room for only a few entries, so that paging is exercised */
+	uint8_t buf[sizeof(struct ec_response_host_command_stats) +
+		    4 * sizeof(struct ec_host_command_stats)];
+	struct ec_response_host_command_stats *r = (void *)buf;
+	const struct ec_host_command_stats *e, *hello = NULL;
+	struct ec_params_hello hp = { .in_data = 0xa0b0c0d0 };
+	struct ec_response_hello hr;
+	uint32_t sum;
+	int i, j, seen = 0;
+
+	TEST_EQ(test_send_host_command(EC_CMD_HOST_COMMAND_STATS, 0, &p,
+				       sizeof(p), buf, sizeof(buf)),
+		EC_RES_SUCCESS, "%d");
+	TEST_EQ(r->total, (int)(__hcmds_end - __hcmds), "%d");
+	TEST_EQ(r->count, 4, "%d");
+
+	for (i = 0; i < STATS_HELLO_COUNT; i++)
+		TEST_EQ(test_send_host_command(EC_CMD_HELLO, 0, &hp,
+					       sizeof(hp), &hr, sizeof(hr)),
+			EC_RES_SUCCESS, "%d");
+
+	p.flags = 0;
+	for (p.index = 0; p.index < r->total; p.index += r->count) {
+		TEST_EQ(test_send_host_command(EC_CMD_HOST_COMMAND_STATS, 0,
+					       &p, sizeof(p), buf, sizeof(buf)),
+			EC_RES_SUCCESS, "%d");
+		TEST_ASSERT(r->count > 0 && r->count <= 4);
+		for (i = 0; i < r->count; i++) {
+			e = &r->stats[i];
+			TEST_EQ(e->command, __hcmds[p.index + i].command,
+				"0x%x");
+			for (sum = 0, j = 0; j < EC_HOST_COMMAND_STATS_BUCKETS;
+			     j++)
+				sum += e->latency[j];
+			TEST_EQ(sum, e->count, "%d");
+			TEST_ASSERT(e->max_us <= e->total_us);
+			if (e->command == EC_CMD_HELLO)
+				hello = e;
+			seen++;
+		}
+		if (hello) {
+			TEST_EQ(hello->count, STATS_HELLO_COUNT, "%d");
+			hello = NULL;
+		}
+	}
+	TEST_EQ(seen, (int)(__hcmds_end - __hcmds), "%d");
+
+	/* Reading past the end of the table is an error */
+	p.index = r->total + 1;
+	TEST_EQ(test_send_host_command(EC_CMD_HOST_COMMAND_STATS, 0, &p,
+				       sizeof(p), buf, sizeof(buf)),
+		EC_RES_INVALID_PARAM, "%d");
+
+	return EC_SUCCESS;
+}
+
 void run_test(int argc, char **argv)
 {
 	wait_for_task_started();
@@ -315,6 +471,9 @@ void run_test(int argc, char **argv)
 	RUN_TEST(test_hostcmd_invalid_checksum);
 	RUN_TEST(test_hostcmd_reuse_response_buffer);
 	RUN_TEST(test_hostcmd_clears_unused_data);
+	RUN_TEST(test_hostcmd_lookup_all);
+	RUN_TEST(test_hostcmd_dispatch_cost);
+	RUN_TEST(test_hostcmd_stats);
 
 	test_print_result();
 }
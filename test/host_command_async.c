@@ -0,0 +1,297 @@
+/* Copyright 2020 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for host commands which complete asynchronously.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+#include "flash.h"
+#include "host_command.h"
+#include "mkbp_event.h"
+#include "system.h"
+#include "task.h"
+#include "test_util.h"
+#include "timer.h"
+#include "util.h"
+
+#define ERASE_OFFSET CONFIG_RW_STORAGE_OFF
+
+/* A command of our own, completed by the test itself */
+#define TEST_ASYNC 0x0000
+#define EC_CMD_TEST_ASYNC EC_PRIVATE_HOST_COMMAND_VALUE(TEST_ASYNC)
+
+/* Hold flash erases in the hook task until this is cleared */
+static volatile int erase_hold;
+static int mock_flash_op_fail = EC_SUCCESS;
+static int flash_op_count;
+
+/*****************************************************************************/
+/* Mock functions */
+
+int system_unsafe_to_overwrite(uint32_t offset, uint32_t size)
+{
+	return 0;
+}
+
+int flash_pre_op(void)
+{
+	while (erase_hold)
+		msleep(1);
+	flash_op_count++;
+	return mock_flash_op_fail;
+}
+
+static enum ec_status test_async(struct host_cmd_handler_args *args)
+{
+	return host_command_async_start(args);
+}
+DECLARE_PRIVATE_HOST_COMMAND(TEST_ASYNC, test_async, EC_VER_MASK(0));
+
+/*****************************************************************************/
+/* Test utilities */
+
+static int send_erase_size(uint32_t size)
+{
+	struct ec_params_flash_erase p = {
+		.offset = ERASE_OFFSET,
+		.size = size,
+	};
+
+	return test_send_host_command(EC_CMD_FLASH_ERASE, 0, &p, sizeof(p),
+				      NULL, 0);
+}
+
+static int send_erase(void)
+{
+	return send_erase_size(CONFIG_FLASH_ERASE_SIZE);
+}
+
+static int send_read(void)
+{
+	struct ec_params_flash_read p = {
+		.offset = ERASE_OFFSET,
+		.size = CONFIG_FLASH_WRITE_SIZE,
+	};
+	uint8_t r[CONFIG_FLASH_WRITE_SIZE];
+
+	return test_send_host_command(EC_CMD_FLASH_READ, 0, &p, sizeof(p),
+				      r, sizeof(r));
+}
+
+static int send_protect(uint32_t mask)
+{
+	struct ec_params_flash_protect p = {
+		.mask = mask,
+		.flags = 0,
+	};
+	struct ec_response_flash_protect r;
+
+	return test_send_host_command(EC_CMD_FLASH_PROTECT, 1, &p, sizeof(p),
+				      &r, sizeof(r));
+}
+
+static int send_write(void)
+{
+	struct {
+		struct ec_params_flash_write p;
+		uint8_t data[CONFIG_FLASH_WRITE_SIZE];
+	} w = {
+		.p.offset = ERASE_OFFSET,
+		.p.size = CONFIG_FLASH_WRITE_SIZE,
+	};
+
+	return test_send_host_command(EC_CMD_FLASH_WRITE, 0, &w, sizeof(w),
+				      NULL, 0);
+}
+
+static int send_hello(void)
+{
+	struct ec_params_hello p = { .in_data = 0xa0b0c0d0 };
+	struct ec_response_hello r;
+
+	return test_send_host_command(EC_CMD_HELLO, 0, &p, sizeof(p),
+				      &r, sizeof(r));
+}
+
+static int comms_processing(void)
+{
+	struct ec_response_get_comms_status r;
+
+	if (test_send_host_command(EC_CMD_GET_COMMS_STATUS, 0, NULL, 0,
+				   &r, sizeof(r)) != EC_RES_SUCCESS)
+		return -1;
+	return !!(r.flags & EC_COMMS_STATUS_PROCESSING);
+}
+
+/* Read the next MKBP event; return its type or -1 if there is none */
+static int get_event(struct ec_response_host_command_done *done,
+		     int *has_more)
+{
+	struct ec_response_get_next_event_v1 r;
+
+	if (test_send_host_command(EC_CMD_GET_NEXT_EVENT, 2, NULL, 0,
+				   &r, sizeof(r)) != EC_RES_SUCCESS)
+		return -1;
+	memcpy(done, &r.data.host_command_done, sizeof(*done));
+	*has_more = !!(r.event_type & EC_MKBP_HAS_MORE_EVENTS);
+	return r.event_type & EC_MKBP_EVENT_TYPE_MASK;
+}
+
+/*****************************************************************************/
+/* Tests */
+
+static int test_async_erase(void)
+{
+	struct ec_response_host_command_done done;
+	int more;
+
+	/* Throw away any events from boot */
+	while (get_event(&done, &more) >= 0)
+		;
+
+	TEST_EQ(send_write(), EC_RES_SUCCESS, "%d");
+	TEST_ASSERT(!flash_is_erased(ERASE_OFFSET, CONFIG_FLASH_ERASE_SIZE));
+
+	erase_hold = 1;
+	TEST_EQ(send_erase(), EC_RES_IN_PROGRESS, "%d");
+
+	/* Other commands are processed while the erase is in progress */
+	TEST_EQ(send_hello(), EC_RES_SUCCESS, "%d");
+	TEST_EQ(comms_processing(), 1, "%d");
+	TEST_EQ(get_event(&done, &more), -1, "%d");
+
+	erase_hold = 0;
+	msleep(10);
+	TEST_ASSERT(flash_is_erased(ERASE_OFFSET, CONFIG_FLASH_ERASE_SIZE));
+	TEST_EQ(comms_processing(), 0, "%d");
+	TEST_EQ(get_event(&done, &more), EC_MKBP_EVENT_HOST_COMMAND_DONE,
+		"%d");
+	TEST_EQ(done.command, EC_CMD_FLASH_ERASE, "0x%x");
+	TEST_EQ(done.result, EC_RES_SUCCESS, "%d");
+	TEST_EQ(more, 0, "%d");
+	TEST_EQ(get_event(&done, &more), -1, "%d");
+
+	/* Commands can be started again once the host knows they're done */
+	TEST_EQ(send_write(), EC_RES_SUCCESS, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_async_erase_lockout(void)
+{
+	struct ec_response_host_command_done done;
+	int more;
+
+	TEST_EQ(send_write(), EC_RES_SUCCESS, "%d");
+	erase_hold = 1;
+	TEST_EQ(send_erase_size(2 * CONFIG_FLASH_BANK_SIZE),
+		EC_RES_IN_PROGRESS, "%d");
+
+	/* Nothing else may touch flash until the erase is done */
+	TEST_EQ(send_erase(), EC_RES_BUSY, "%d");
+	TEST_EQ(send_write(), EC_RES_BUSY, "%d");
+	TEST_EQ(send_read(), EC_RES_BUSY, "%d");
+	TEST_EQ(send_protect(EC_FLASH_PROTECT_RO_AT_BOOT), EC_RES_BUSY,
+		"%d");
+	TEST_EQ(send_protect(0), EC_RES_SUCCESS, "%d");
+
+	/* One bank is erased per deferred call */
+	flash_op_count = 0;
+	erase_hold = 0;
+	msleep(10);
+	TEST_EQ(flash_op_count, 2, "%d");
+	TEST_ASSERT(flash_is_erased(ERASE_OFFSET, 2 * CONFIG_FLASH_BANK_SIZE));
+
+	TEST_EQ(get_event(&done, &more), EC_MKBP_EVENT_HOST_COMMAND_DONE,
+		"%d");
+	TEST_EQ(done.command, EC_CMD_FLASH_ERASE, "0x%x");
+	TEST_EQ(done.result, EC_RES_SUCCESS, "%d");
+	TEST_EQ(send_read(), EC_RES_SUCCESS, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_async_erase_failure(void)
+{
+	struct ec_response_host_command_done done;
+	int more;
+
+	mock_flash_op_fail = EC_ERROR_UNKNOWN;
+	TEST_EQ(send_erase(), EC_RES_IN_PROGRESS, "%d");
+	msleep(10);
+	mock_flash_op_fail = EC_SUCCESS;
+
+	TEST_EQ(get_event(&done, &more), EC_MKBP_EVENT_HOST_COMMAND_DONE,
+		"%d");
+	TEST_EQ(done.command, EC_CMD_FLASH_ERASE, "0x%x");
+	TEST_EQ(done.result, EC_RES_ERROR, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_async_several(void)
+{
+	struct ec_response_host_command_done done;
+	int more;
+
+	erase_hold = 1;
+	TEST_EQ(send_erase(), EC_RES_IN_PROGRESS, "%d");
+	TEST_EQ(test_send_host_command(EC_CMD_TEST_ASYNC, 0, NULL, 0, NULL, 0),
+		EC_RES_IN_PROGRESS, "%d");
+
+	/* Only CONFIG_HOSTCMD_ASYNC commands may be in progress at once */
+	TEST_EQ(test_send_host_command(EC_CMD_TEST_ASYNC, 0, NULL, 0, NULL, 0),
+		EC_RES_BUSY, "%d");
+
+	/* Completing an unknown command does nothing */
+	host_command_async_done(EC_CMD_HELLO, EC_RES_SUCCESS);
+	TEST_EQ(get_event(&done, &more), -1, "%d");
+
+	host_command_async_done(EC_CMD_TEST_ASYNC, EC_RES_OVERFLOW);
+	erase_hold = 0;
+	msleep(10);
+
+	/* Each completion is reported in its own event */
+	TEST_EQ(get_event(&done, &more), EC_MKBP_EVENT_HOST_COMMAND_DONE,
+		"%d");
+	TEST_EQ(more, 1, "%d");
+	TEST_EQ(done.command, EC_CMD_TEST_ASYNC, "0x%x");
+	TEST_EQ(done.result, EC_RES_OVERFLOW, "%d");
+	TEST_EQ(get_event(&done, &more), EC_MKBP_EVENT_HOST_COMMAND_DONE,
+		"%d");
+	TEST_EQ(more, 0, "%d");
+	TEST_EQ(done.command, EC_CMD_FLASH_ERASE, "0x%x");
+	TEST_EQ(done.result, EC_RES_SUCCESS, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_async_no_event(void)
+{
+	struct ec_response_get_next_event_v1 r;
+
+	/* A stray event with no finished command reports nothing */
+	mkbp_send_event(EC_MKBP_EVENT_HOST_COMMAND_DONE);
+	TEST_EQ(test_send_host_command(EC_CMD_GET_NEXT_EVENT, 2, NULL, 0,
+				       &r, sizeof(r)),
+		EC_RES_UNAVAILABLE, "%d");
+
+	return EC_SUCCESS;
+}
+
+void run_test(int argc, char **argv)
+{
+	wait_for_task_started();
+	test_reset();
+
+	RUN_TEST(test_async_erase);
+	RUN_TEST(test_async_erase_lockout);
+	RUN_TEST(test_async_erase_failure);
+	RUN_TEST(test_async_several);
+	RUN_TEST(test_async_no_event);
+
+	test_print_result();
+}
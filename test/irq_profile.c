@@ -0,0 +1,183 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for the interrupt-disabled region profiler.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+#include "task.h"
+#include "test_util.h"
+#include "timer.h"
+#include "util.h"
+
+#define TOP_COUNT CONFIG_IRQ_PROFILE
+
+static struct {
+	struct ec_response_irq_profile r;
+	struct ec_irq_profile_region top[TOP_COUNT];
+} buf;
+
+static struct ec_response_irq_profile *const r = &buf.r;
+
+static int get_profile(int reset)
+{
+	struct ec_params_irq_profile p = {
+		.flags = reset ? EC_IRQ_PROFILE_RESET : 0,
+	};
+
+	return test_send_host_command(EC_CMD_IRQ_PROFILE, 0, &p, sizeof(p),
+				      &buf, sizeof(buf));
+}
+
+static void __attribute__((noinline)) disable_for(int us)
+{
+	interrupt_disable();
+	udelay(us);
+	interrupt_enable();
+}
+
+static void __attribute__((noinline)) nested_for(int us)
+{
+	interrupt_disable();
+	udelay(us / 2);
+	interrupt_disable();
+	udelay(us / 2);
+	interrupt_enable();
+	interrupt_enable();
+}
+
+static void __attribute__((noinline)) lock_for(int us)
+{
+	uint32_t key = irq_lock();
+
+	udelay(us);
+	irq_unlock(key);
+}
+
+/* The host clock ticks each time it's read, so allow a little slack. */
+static int about(uint32_t us, uint32_t expected)
+{
+	return us >= expected && us < expected + 10;
+}
+
+static int called_from(uint32_t caller, void (*fn)(int))
+{
+	uint32_t start = (uintptr_t)fn;
+
+	return caller > start && caller < start + 64;
+}
+
+static int test_regions(void)
+{
+	static const int lengths[] = { 1, 10, 100, 1000, 20000 };
+	int i;
+
+	TEST_EQ(get_profile(1), EC_RES_SUCCESS, "%d");
+
+	for (i = 0; i < ARRAY_SIZE(lengths); i++)
+		disable_for(lengths[i]);
+
+	TEST_EQ(get_profile(0), EC_RES_SUCCESS, "%d");
+
+	/* Including the one which read the profile when it was reset */
+	TEST_EQ(r->count, 6, "%d");
+	TEST_ASSERT(about(r->max_us, 20000));
+	TEST_EQ(r->histogram[0], 2, "%d");
+	TEST_EQ(r->histogram[1], 1, "%d");
+	TEST_EQ(r->histogram[3], 1, "%d");
+	TEST_EQ(r->histogram[4], 1, "%d");
+	TEST_EQ(r->histogram[7], 1, "%d");
+
+	TEST_EQ(r->top_count, TOP_COUNT, "%d");
+	for (i = 0; i < TOP_COUNT; i++) {
+		TEST_ASSERT(about(r->top[i].us,
+				  lengths[ARRAY_SIZE(lengths) - 1 - i]));
+		TEST_ASSERT(called_from(r->top[i].caller, disable_for));
+	}
+
+	return EC_SUCCESS;
+}
+
+static int test_nested(void)
+{
+	TEST_EQ(get_profile(1), EC_RES_SUCCESS, "%d");
+
+	nested_for(6000);
+
+	/*
+	 * The second disable doesn't start another region, and the second
+	 * enable doesn't end one.
+	 */
+	TEST_EQ(get_profile(0), EC_RES_SUCCESS, "%d");
+	TEST_EQ(r->count, 2, "%d");
+	TEST_ASSERT(about(r->top[0].us, 6000));
+	TEST_ASSERT(called_from(r->top[0].caller, nested_for));
+
+	return EC_SUCCESS;
+}
+
+static int test_irq_lock(void)
+{
+	TEST_EQ(get_profile(1), EC_RES_SUCCESS, "%d");
+
+	lock_for(2000);
+
+	TEST_EQ(get_profile(0), EC_RES_SUCCESS, "%d");
+	TEST_ASSERT(about(r->top[0].us, 2000));
+	TEST_ASSERT(called_from(r->top[0].caller, lock_for));
+
+	return EC_SUCCESS;
+}
+
+static int test_short_response(void)
+{
+	struct ec_params_irq_profile p = { 0 };
+
+	TEST_EQ(test_send_host_command(EC_CMD_IRQ_PROFILE, 0, &p, sizeof(p),
+				       &buf, sizeof(buf.r) + sizeof(buf.top[0])),
+		EC_RES_SUCCESS, "%d");
+	TEST_EQ(r->top_count, 1, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_console_command(void)
+{
+	const char *out;
+
+	disable_for(30000);
+
+	test_capture_console(1);
+	UART_INJECT("irqprof reset\n");
+	msleep(30);
+	test_capture_console(0);
+
+	out = test_get_captured_console();
+	TEST_ASSERT(strstr(out, "Regions: "));
+	TEST_ASSERT(strstr(out, "longest 3000"));
+	TEST_ASSERT(strstr(out, "Time (us)  Caller"));
+
+	TEST_EQ(get_profile(0), EC_RES_SUCCESS, "%d");
+	TEST_ASSERT(r->max_us < 30000);
+
+	return EC_SUCCESS;
+}
+
+void run_test(int argc, char **argv)
+{
+	test_reset();
+
+	/* Let the console task finish printing as it starts */
+	msleep(30);
+
+	RUN_TEST(test_regions);
+	RUN_TEST(test_nested);
+	RUN_TEST(test_irq_lock);
+	RUN_TEST(test_short_response);
+	RUN_TEST(test_console_command);
+
+	test_print_result();
+}
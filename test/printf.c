@@ -258,6 +258,11 @@ test_static int test_vsnprintf_strings(void)
 	T(expect_success("ab",        "%5.2s",   "abc"));
 	T(expect_success("abc",        "%.4s",   "abc"));
 
+	/* Padding longer than is written at once */
+	T(expect_success("                 abc", "%20s", "abc"));
+	T(expect_success("abc                 |", "%-20s|", "abc"));
+	T(expect_success("00000000000000000042", "%020d", 42));
+
 	/*
 	 * Given a malformed string (address 0x1 is a good example),
 	 * if we ask for zero precision, expect no bytes to be read
@@ -283,10 +288,19 @@ test_static int test_vsnprintf_timestamps(void)
 test_static int test_vsnprintf_hexdump(void)
 {
 	const char bytes[] = {0x00, 0x5E};
+	char counting[21];
+	int i;
+
+	for (i = 0; i < sizeof(counting); i++)
+		counting[i] = i;
 
 	T(expect_success("005e",      "%ph",      HEX_BUF(bytes, 2)));
 	T(expect_success("",          "%ph",      HEX_BUF(bytes, 0)));
 	T(expect_success("00",        "%ph",      HEX_BUF(bytes, 1)));
+
+	/* Longer than is converted at once */
+	T(expect_success("000102030405060708090a0b0c0d0e0f1011121314",
+			 "%ph", HEX_BUF(counting, sizeof(counting))));
 	return EC_SUCCESS;
 }
 
@@ -294,6 +308,83 @@ test_static int test_vsnprintf_combined(void)
 {
 	T(expect_success("abc",       "%c%s",    'a', "bc"));
 	T(expect_success("12\tbc",    "%d\t%s",  12, "bc"));
+
+	/* Output is cut off part way through a run of text or a field */
+	T(expect(EC_ERROR_OVERFLOW, "hel",
+		 false, 4, "hello %d", 1));
+	T(expect(EC_ERROR_OVERFLOW, "ab   ",
+		 false, 6, "ab%8s", "cd"));
+	T(expect(EC_ERROR_OVERFLOW, "abcd",
+		 false, 5, "ab%s", "cdef"));
+	return EC_SUCCESS;
+}
+
+/* Context for counting_addchar() */
+struct counting_context {
+	char *str;
+	int size;
+};
+
+static int counting_addchar(void *context, int c)
+{
+	struct counting_context *ctx = context;
+
+	if (!ctx->size)
+		return 1;
+	*ctx->str++ = c;
+	ctx->size--;
+	return 0;
+}
+
+static int vfnprintf_by_char(char *str, int size, const char *format, ...)
+{
+	struct counting_context ctx = { .str = str, .size = size - 1 };
+	va_list args;
+	int rv;
+
+	va_start(args, format);
+	rv = vfnprintf(counting_addchar, &ctx, format, args);
+	va_end(args);
+	*ctx.str = '\0';
+
+	return rv == EC_SUCCESS ? ctx.str - str : -rv;
+}
+
+#define BENCHMARK_COUNT 20000
+#define BENCHMARK_FORMAT "[%pT C%d: PE %s -> %s, msg 0x%04x len %d] %ph\n"
+#define BENCHMARK_ARGS &ts, 1, "SRC_READY", "SRC_TRANSITION_SUPPLY", \
+	0x11a1, 28, HEX_BUF(payload, sizeof(payload))
+
+test_static int test_vsnprintf_benchmark(void)
+{
+	const uint64_t ts = 12345678;
+	const char payload[16] = "0123456789abcde";
+	char by_char[128];
+	uint64_t start, char_ns, span_ns;
+	int i, len = 0;
+
+	/* A character at a time through vfnprintf(), as uart_vprintf() did */
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < BENCHMARK_COUNT; i++)
+		len = vfnprintf_by_char(by_char, sizeof(by_char),
+					BENCHMARK_FORMAT, BENCHMARK_ARGS);
+	char_ns = test_get_wall_clock_ns() - start;
+
+	/* In spans, through vsnprintf() */
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < BENCHMARK_COUNT; i++)
+		snprintf(output, sizeof(output), BENCHMARK_FORMAT,
+			 BENCHMARK_ARGS);
+	span_ns = test_get_wall_clock_ns() - start;
+
+	TEST_ASSERT(len > 0);
+	TEST_ASSERT_ARRAY_EQ(output, by_char, len + 1);
+
+	ccprintf("%d bytes x %d: by character %d bytes/ms, by span %d bytes/ms\n",
+		 len, BENCHMARK_COUNT,
+		 (int)(1000000LL * len * BENCHMARK_COUNT / MAX(char_ns, 1)),
+		 (int)(1000000LL * len * BENCHMARK_COUNT / MAX(span_ns, 1)));
+
 	return EC_SUCCESS;
 }
 
@@ -309,6 +400,7 @@ void run_test(int argc, char **argv)
 	RUN_TEST(test_vsnprintf_timestamps);
 	RUN_TEST(test_vsnprintf_hexdump);
 	RUN_TEST(test_vsnprintf_combined);
+	RUN_TEST(test_vsnprintf_benchmark);
 
 	test_print_result();
 }
@@ -16,6 +16,30 @@
 static struct queue const test_queue8 = QUEUE_NULL(8, char);
 static struct queue const test_queue2 = QUEUE_NULL(2, int16_t);
 
+/* Count how often a queue's policy is notified */
+static int policy_adds;
+
+static void policy_count_add(struct queue_policy const *policy, size_t count)
+{
+	policy_adds++;
+}
+
+static void policy_count_remove(struct queue_policy const *policy,
+				size_t count)
+{
+}
+
+static struct queue_policy const counting_policy = {
+	.add    = policy_count_add,
+	.remove = policy_count_remove,
+};
+
+#define BENCH_QUEUE_SIZE 256
+#define BENCH_LINES 20000
+
+static struct queue const bench_queue = QUEUE(BENCH_QUEUE_SIZE, uint8_t,
+					      counting_policy);
+
 static int test_queue8_empty(void)
 {
 	char tmp = 1;
@@ -410,6 +434,159 @@ static int test_queue8_iterate_next_reset_on_change(void)
 	return EC_SUCCESS;
 }
 
+static int test_queue8_sg_write(void)
+{
+	static uint8_t const data[5] = {1, 2, 3, 4, 5};
+	uint8_t buf[5];
+	struct queue_sg sg;
+	int i;
+
+	/* Move near the end of the queue */
+	TEST_ASSERT(queue_advance_tail(&test_queue8, 6) == 6);
+	TEST_ASSERT(queue_advance_head(&test_queue8, 6) == 6);
+
+	/* A reservation covers the free space on both sides of the wrap */
+	sg = queue_reserve_write(&test_queue8, 5);
+	TEST_ASSERT(sg.count == 5);
+	TEST_ASSERT(sg.chunk[0].count == 2);
+	TEST_ASSERT(sg.chunk[0].buffer == test_queue8.buffer + 6);
+	TEST_ASSERT(sg.chunk[1].count == 3);
+	TEST_ASSERT(sg.chunk[1].buffer == test_queue8.buffer);
+
+	for (i = 0; i < 5; i++)
+		*(uint8_t *)queue_sg_unit(&test_queue8, &sg, i) = data[i];
+
+	/* Nothing is added until the reservation is committed */
+	TEST_ASSERT(queue_is_empty(&test_queue8));
+	TEST_ASSERT(queue_advance_tail(&test_queue8, sg.count) == 5);
+
+	TEST_ASSERT(queue_remove_units(&test_queue8, buf, 5) == 5);
+	TEST_ASSERT_ARRAY_EQ(buf, data, 5);
+
+	/* Reservations are limited to the free space */
+	TEST_ASSERT(queue_advance_tail(&test_queue8, 3) == 3);
+	sg = queue_reserve_write(&test_queue8, 10);
+	TEST_ASSERT(sg.count == 5);
+	TEST_ASSERT(sg.chunk[0].count + sg.chunk[1].count == 5);
+
+	return EC_SUCCESS;
+}
+
+static int test_queue8_sg_read(void)
+{
+	static uint8_t const data[7] = {1, 2, 3, 4, 5, 6, 7};
+	struct queue_sg sg;
+	int i;
+
+	/* Move near the end of the queue, then wrap */
+	TEST_ASSERT(queue_advance_tail(&test_queue8, 5) == 5);
+	TEST_ASSERT(queue_advance_head(&test_queue8, 5) == 5);
+	TEST_ASSERT(queue_add_units(&test_queue8, data, 7) == 7);
+
+	sg = queue_reserve_read(&test_queue8, 8);
+	TEST_ASSERT(sg.count == 7);
+	TEST_ASSERT(sg.chunk[0].count == 3);
+	TEST_ASSERT(sg.chunk[1].count == 4);
+	for (i = 0; i < 7; i++)
+		TEST_ASSERT(*(uint8_t *)queue_sg_unit(&test_queue8, &sg, i) ==
+			    data[i]);
+
+	/* Reading in place is a peek until the head is advanced */
+	TEST_ASSERT(queue_count(&test_queue8) == 7);
+	TEST_ASSERT(queue_advance_head(&test_queue8, sg.count) == 7);
+	TEST_ASSERT(queue_is_empty(&test_queue8));
+
+	sg = queue_reserve_read(&test_queue8, 8);
+	TEST_ASSERT(sg.count == 0);
+
+	return EC_SUCCESS;
+}
+
+static int test_queue2_sg_unit(void)
+{
+	int16_t data = 0x1234;
+	struct queue_sg sg;
+
+	/* Units larger than a byte are addressed by unit, not byte */
+	TEST_ASSERT(queue_advance_tail(&test_queue2, 1) == 1);
+	TEST_ASSERT(queue_advance_head(&test_queue2, 1) == 1);
+
+	sg = queue_reserve_write(&test_queue2, 2);
+	TEST_ASSERT(sg.count == 2);
+	TEST_ASSERT(queue_sg_unit(&test_queue2, &sg, 0) ==
+		    test_queue2.buffer + 2);
+	TEST_ASSERT(queue_sg_unit(&test_queue2, &sg, 1) ==
+		    test_queue2.buffer);
+
+	memcpy(queue_sg_unit(&test_queue2, &sg, 1), &data, sizeof(data));
+	TEST_ASSERT(queue_advance_tail(&test_queue2, 2) == 2);
+	TEST_ASSERT(queue_peek_units(&test_queue2, &data, 1, 1) == 1);
+	TEST_ASSERT(data == 0x1234);
+
+	return EC_SUCCESS;
+}
+
+/*
+ * Compare adding a console line to a queue a unit at a time, with adding it
+ * in place through a reservation.  Both translate '\n' to '\r\n' on the way,
+ * as the USB console does.
+ */
+static const char bench_line[] = "[12.345678 C0: PE SNK_READY -> "
+				 "SNK_EVALUATE_CAPABILITY]\n";
+
+static int test_queue_sg_benchmark(void)
+{
+	struct queue const *q = &bench_queue;
+	struct queue_sg sg;
+	uint64_t start, unit_ns, sg_ns;
+	int unit_adds, sg_adds;
+	const char *s;
+	char cr = '\r';
+	size_t n;
+	int i;
+
+	queue_init(q);
+	policy_adds = 0;
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < BENCH_LINES; i++) {
+		for (s = bench_line; *s; s++) {
+			if (*s == '\n')
+				queue_add_unit(q, &cr);
+			queue_add_unit(q, s);
+		}
+		queue_advance_head(q, queue_count(q));
+	}
+	unit_ns = test_get_wall_clock_ns() - start;
+	unit_adds = policy_adds;
+
+	queue_init(q);
+	policy_adds = 0;
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < BENCH_LINES; i++) {
+		sg = queue_reserve_write(q, sizeof(bench_line));
+		n = 0;
+		for (s = bench_line; *s; s++) {
+			if (*s == '\n')
+				*(char *)queue_sg_unit(q, &sg, n++) = '\r';
+			*(char *)queue_sg_unit(q, &sg, n++) = *s;
+		}
+		queue_advance_tail(q, n);
+		queue_advance_head(q, queue_count(q));
+	}
+	sg_ns = test_get_wall_clock_ns() - start;
+	sg_adds = policy_adds;
+
+	ccprintf("%d lines: by unit %d ns/line, %d notifications; "
+		 "in place %d ns/line, %d notifications\n", BENCH_LINES,
+		 (int)(unit_ns / BENCH_LINES), unit_adds,
+		 (int)(sg_ns / BENCH_LINES), sg_adds);
+
+	TEST_EQ(sg_adds, BENCH_LINES, "%d");
+	TEST_EQ(unit_adds, BENCH_LINES * (int)sizeof(bench_line), "%d");
+
+	return EC_SUCCESS;
+}
+
 void before_test(void)
 {
 	queue_init(&test_queue2);
@@ -433,10 +610,14 @@ void run_test(int argc, char **argv)
 	RUN_TEST(test_queue8_chunks_empty);
 	RUN_TEST(test_queue8_chunks_advance);
 	RUN_TEST(test_queue8_chunks_offset);
+	RUN_TEST(test_queue8_sg_write);
+	RUN_TEST(test_queue8_sg_read);
+	RUN_TEST(test_queue2_sg_unit);
 	RUN_TEST(test_queue8_iterate_begin);
 	RUN_TEST(test_queue8_iterate_next);
 	RUN_TEST(test_queue2_iterate_next_full);
 	RUN_TEST(test_queue8_iterate_next_reset_on_change);
+	RUN_TEST(test_queue_sg_benchmark);
 
 	test_print_result();
 }
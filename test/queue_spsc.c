@@ -0,0 +1,239 @@
+/* Copyright 2020 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test the single-producer, single-consumer queue.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "queue_spsc.h"
+#include "test_util.h"
+#include "util.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+/* Units passed between the threads */
+#define THREAD_UNITS 2000000
+/* Largest batch added or removed at once */
+#define THREAD_BATCH 24
+
+static int policy_adds;
+static int policy_removes;
+/* Set if a unit arrives out of order; both threads stop */
+static volatile int threads_failed;
+
+static void policy_count_add(struct queue_policy const *policy, size_t count)
+{
+	__atomic_fetch_add(&policy_adds, 1, __ATOMIC_RELAXED);
+}
+
+static void policy_count_remove(struct queue_policy const *policy,
+				size_t count)
+{
+	__atomic_fetch_add(&policy_removes, 1, __ATOMIC_RELAXED);
+}
+
+static struct queue_policy const counting_policy = {
+	.add    = policy_count_add,
+	.remove = policy_count_remove,
+};
+
+static struct queue_spsc const test_queue8 = QUEUE_SPSC_NULL(8, uint8_t);
+static struct queue_spsc const thread_queue = QUEUE_SPSC(64, uint32_t,
+							 counting_policy);
+
+static int test_spsc_fifo(void)
+{
+	static uint8_t const data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+	uint8_t buf[8];
+
+	TEST_ASSERT(queue_spsc_count(&test_queue8) == 0);
+	TEST_ASSERT(queue_spsc_add_units(&test_queue8, data, 5) == 5);
+	TEST_ASSERT(queue_spsc_remove_units(&test_queue8, buf, 3) == 3);
+	TEST_ASSERT_ARRAY_EQ(buf, data, 3);
+
+	/* Wrap, and fill the queue */
+	TEST_ASSERT(queue_spsc_space(&test_queue8) == 6);
+	TEST_ASSERT(queue_spsc_add_units(&test_queue8, data, 8) == 6);
+	TEST_ASSERT(queue_spsc_space(&test_queue8) == 0);
+	TEST_ASSERT(queue_spsc_add_units(&test_queue8, data, 1) == 0);
+
+	TEST_ASSERT(queue_spsc_remove_units(&test_queue8, buf, 8) == 8);
+	TEST_ASSERT_ARRAY_EQ(buf, data + 3, 2);
+	TEST_ASSERT_ARRAY_EQ(buf + 2, data, 6);
+	TEST_ASSERT(queue_spsc_count(&test_queue8) == 0);
+	TEST_ASSERT(queue_spsc_remove_units(&test_queue8, buf, 1) == 0);
+
+	return EC_SUCCESS;
+}
+
+static int test_spsc_reserve(void)
+{
+	struct queue_sg sg;
+	int i;
+
+	TEST_ASSERT(queue_spsc_advance_tail(&test_queue8, 6) == 6);
+	TEST_ASSERT(queue_spsc_advance_head(&test_queue8, 6) == 6);
+
+	/* Reservations span the wrap, and add nothing until committed */
+	sg = queue_spsc_reserve_write(&test_queue8, 10);
+	TEST_ASSERT(sg.count == 8);
+	TEST_ASSERT(sg.chunk[0].count == 2);
+	TEST_ASSERT(sg.chunk[1].count == 6);
+	for (i = 0; i < 4; i++)
+		*(uint8_t *)queue_spsc_sg_unit(&test_queue8, &sg, i) = i;
+	TEST_ASSERT(queue_spsc_count(&test_queue8) == 0);
+	TEST_ASSERT(queue_spsc_advance_tail(&test_queue8, 4) == 4);
+
+	sg = queue_spsc_reserve_read(&test_queue8, 8);
+	TEST_ASSERT(sg.count == 4);
+	for (i = 0; i < 4; i++)
+		TEST_ASSERT(*(uint8_t *)queue_spsc_sg_unit(&test_queue8, &sg,
+							   i) == i);
+	TEST_ASSERT(queue_spsc_count(&test_queue8) == 4);
+	TEST_ASSERT(queue_spsc_advance_head(&test_queue8, 10) == 4);
+	TEST_ASSERT(queue_spsc_count(&test_queue8) == 0);
+
+	return EC_SUCCESS;
+}
+
+static int test_spsc_layout(void)
+{
+	struct queue_spsc_state *state = thread_queue.state;
+
+	/* The host has a data cache, so head and tail don't share a line */
+	TEST_ASSERT((uintptr_t)&state->tail - (uintptr_t)&state->head >= 64);
+	TEST_ASSERT((uintptr_t)state % 64 == 0);
+
+	return EC_SUCCESS;
+}
+
+/*
+ * The threads below don't use any EC functions, which aren't safe to call
+ * from outside an EC task.
+ */
+static uint32_t next_random(uint32_t *seed)
+{
+	*seed ^= *seed << 13;
+	*seed ^= *seed >> 17;
+	*seed ^= *seed << 5;
+	return *seed;
+}
+
+static void *producer(void *arg)
+{
+	uint32_t batch[THREAD_BATCH];
+	uint32_t seed = 1;
+	uint32_t next = 0;
+	struct queue_sg sg;
+	uint32_t *unit;
+	size_t i, n;
+
+	while (next < THREAD_UNITS && !threads_failed) {
+		n = MIN(next_random(&seed) % THREAD_BATCH + 1,
+			THREAD_UNITS - next);
+
+		if (next_random(&seed) & 1) {
+			/* Fill in place */
+			sg = queue_spsc_reserve_write(&thread_queue, n);
+			for (i = 0; i < sg.count; i++) {
+				unit = queue_spsc_sg_unit(&thread_queue, &sg,
+							  i);
+				*unit = next + i;
+			}
+			n = queue_spsc_advance_tail(&thread_queue, sg.count);
+		} else {
+			for (i = 0; i < n; i++)
+				batch[i] = next + i;
+			n = queue_spsc_add_units(&thread_queue, batch, n);
+		}
+
+		next += n;
+		if (!n)
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+static void *consumer(void *arg)
+{
+	uint32_t batch[THREAD_BATCH];
+	uint32_t seed = 2;
+	uint32_t next = 0;
+	struct queue_sg sg;
+	uint32_t *unit;
+	size_t i, n;
+
+	while (next < THREAD_UNITS && !threads_failed) {
+		n = next_random(&seed) % THREAD_BATCH + 1;
+
+		if (next_random(&seed) & 1) {
+			/* Read in place */
+			sg = queue_spsc_reserve_read(&thread_queue, n);
+			for (i = 0; i < sg.count; i++) {
+				unit = queue_spsc_sg_unit(&thread_queue, &sg,
+							  i);
+				if (*unit != next + i)
+					threads_failed = 1;
+			}
+			n = queue_spsc_advance_head(&thread_queue, sg.count);
+		} else {
+			n = queue_spsc_remove_units(&thread_queue, batch, n);
+			for (i = 0; i < n; i++)
+				if (batch[i] != next + i)
+					threads_failed = 1;
+		}
+
+		next += n;
+		if (!n)
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+static int test_spsc_threads(void)
+{
+	pthread_t producer_thread, consumer_thread;
+
+	queue_spsc_init(&thread_queue);
+	policy_adds = 0;
+	policy_removes = 0;
+	threads_failed = 0;
+
+	TEST_ASSERT(!pthread_create(&consumer_thread, NULL, consumer, NULL));
+	TEST_ASSERT(!pthread_create(&producer_thread, NULL, producer, NULL));
+
+	TEST_ASSERT(!pthread_join(producer_thread, NULL));
+	TEST_ASSERT(!pthread_join(consumer_thread, NULL));
+
+	/* Every unit arrived, in order */
+	TEST_ASSERT(!threads_failed);
+	TEST_ASSERT(queue_spsc_count(&thread_queue) == 0);
+
+	ccprintf("%d units: %d adds, %d removes\n", THREAD_UNITS, policy_adds,
+		 policy_removes);
+	TEST_ASSERT(policy_adds > 0 && policy_removes > 0);
+
+	return EC_SUCCESS;
+}
+
+void before_test(void)
+{
+	queue_spsc_init(&test_queue8);
+}
+
+void run_test(int argc, char **argv)
+{
+	test_reset();
+
+	RUN_TEST(test_spsc_fifo);
+	RUN_TEST(test_spsc_reserve);
+	RUN_TEST(test_spsc_layout);
+	RUN_TEST(test_spsc_threads);
+
+	test_print_result();
+}
@@ -0,0 +1,99 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for per-task scheduler statistics.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+#include "task.h"
+#include "test_util.h"
+#include "timer.h"
+#include "util.h"
+
+#define WAKE_COUNT 20
+#define BUSY_US 2000
+#define PERIOD_US (10 * MSEC)
+
+static int busy_runs;
+
+void task_busy(void *unused)
+{
+	while (1) {
+		task_wait_event(-1);
+		udelay(BUSY_US);
+		busy_runs++;
+	}
+}
+
+static int get_stats(task_id_t tskid, int reset,
+		     struct ec_response_task_sched_stats *r)
+{
+	struct ec_params_task_sched_stats p = {
+		.task_id = tskid,
+		.flags = reset ? EC_TASK_SCHED_STATS_RESET : 0,
+	};
+
+	return test_send_host_command(EC_CMD_TASK_SCHED_STATS, 0, &p,
+				      sizeof(p), r, sizeof(*r));
+}
+
+static int test_stats_reset(void)
+{
+	struct ec_response_task_sched_stats r;
+
+	TEST_EQ(get_stats(TASK_ID_BUSY, 1, &r), EC_RES_SUCCESS, "%d");
+	TEST_EQ(r.task_count, TASK_ID_COUNT, "%d");
+	TEST_ASSERT(strncmp(r.name, "BUSY", sizeof(r.name)) == 0);
+
+	TEST_EQ(get_stats(TASK_ID_BUSY, 0, &r), EC_RES_SUCCESS, "%d");
+	TEST_EQ(r.switches, 0, "%d");
+	TEST_EQ(r.latency_max_us, 0, "%d");
+	TEST_ASSERT(r.runtime_us == 0);
+
+	TEST_EQ(get_stats(TASK_ID_COUNT, 0, &r), EC_RES_INVALID_PARAM, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_busy_task(void)
+{
+	struct ec_response_task_sched_stats r;
+	int i, wakeups = 0;
+
+	get_stats(TASK_ID_BUSY, 1, &r);
+	busy_runs = 0;
+
+	for (i = 0; i < WAKE_COUNT; i++) {
+		task_wake(TASK_ID_BUSY);
+		usleep(PERIOD_US);
+	}
+	TEST_EQ(busy_runs, WAKE_COUNT, "%d");
+
+	TEST_EQ(get_stats(TASK_ID_BUSY, 0, &r), EC_RES_SUCCESS, "%d");
+	TEST_EQ(r.switches, WAKE_COUNT, "%d");
+	for (i = 0; i < EC_TASK_SCHED_LATENCY_BUCKETS; i++)
+		wakeups += r.latency[i];
+	TEST_EQ(wakeups, WAKE_COUNT, "%d");
+	TEST_ASSERT(r.runtime_us >= WAKE_COUNT * BUSY_US);
+	TEST_ASSERT(r.runtime_us < WAKE_COUNT * PERIOD_US);
+
+	/* The rest of each period is spent idle, not in the busy task */
+	TEST_EQ(get_stats(TASK_ID_IDLE, 0, &r), EC_RES_SUCCESS, "%d");
+	TEST_ASSERT(r.runtime_us >= WAKE_COUNT * (PERIOD_US - BUSY_US) / 2);
+
+	return EC_SUCCESS;
+}
+
+void run_test(int argc, char **argv)
+{
+	test_reset();
+	wait_for_task_started();
+
+	RUN_TEST(test_stats_reset);
+	RUN_TEST(test_busy_task);
+
+	test_print_result();
+}
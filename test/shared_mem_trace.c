@@ -0,0 +1,293 @@
+/* Copyright 2020 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test shared memory allocation tracing.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+#include "shared_mem.h"
+#include "task.h"
+#include "test_util.h"
+#include "timer.h"
+#include "util.h"
+
+#define TRACE_RECORDS CONFIG_SHAREDMEM_TRACE
+
+#define ALLOC_SIZE 300
+
+static char *alloc_ptr;
+
+/* Acquire a buffer when woken, and release it when woken again. */
+void alloc_task(void *u)
+{
+	while (1) {
+		task_wait_event(-1);
+		shared_mem_acquire(ALLOC_SIZE, &alloc_ptr);
+		task_wait_event(-1);
+		shared_mem_release(alloc_ptr);
+		alloc_ptr = NULL;
+	}
+}
+
+static int __attribute__((noinline)) acquire_here(int size, char **ptr)
+{
+	return shared_mem_acquire(size, ptr);
+}
+
+static int caller_is_acquire_here(uint32_t caller)
+{
+	uint32_t fn = (uintptr_t)acquire_here;
+
+	return caller > fn && caller < fn + 256;
+}
+
+static int current_usage(int task)
+{
+	int current, peak;
+
+	shared_mem_trace_usage(task, &current, &peak);
+	return current;
+}
+
+static int peak_usage(int task)
+{
+	int current, peak;
+
+	shared_mem_trace_usage(task, &current, &peak);
+	return peak;
+}
+
+static int test_records(void)
+{
+	struct ec_shared_mem_trace_record r;
+	char *ptr;
+
+	TEST_ASSERT(acquire_here(100, &ptr) == EC_SUCCESS);
+
+	TEST_ASSERT(shared_mem_trace_get(0, &r) == EC_SUCCESS);
+	TEST_EQ(r.size, 100, "%d");
+	TEST_EQ(r.task_id, TASK_ID_TEST_RUNNER, "%d");
+	TEST_EQ(r.flags, EC_SHARED_MEM_TRACE_HELD, "%d");
+	TEST_ASSERT(caller_is_acquire_here(r.caller));
+	TEST_EQ(current_usage(TASK_ID_TEST_RUNNER), 100, "%d");
+
+	msleep(5);
+	shared_mem_release(ptr);
+
+	TEST_ASSERT(shared_mem_trace_get(0, &r) == EC_SUCCESS);
+	TEST_EQ(r.flags, 0, "%d");
+	TEST_ASSERT(r.held_us >= 5 * MSEC);
+	TEST_EQ(current_usage(TASK_ID_TEST_RUNNER), 0, "%d");
+	TEST_EQ(peak_usage(TASK_ID_TEST_RUNNER), 100, "%d");
+
+	TEST_ASSERT(shared_mem_trace_get(-1, &r) == EC_ERROR_INVAL);
+	TEST_ASSERT(shared_mem_trace_get(TRACE_RECORDS, &r) ==
+		    EC_ERROR_INVAL);
+	TEST_ASSERT(shared_mem_trace_usage(TASK_ID_COUNT, NULL, NULL) ==
+		    EC_ERROR_INVAL);
+
+	return EC_SUCCESS;
+}
+
+static int test_peak(void)
+{
+	char *ptr[4];
+	int i;
+
+	shared_mem_trace_reset();
+	TEST_EQ(peak_usage(TASK_ID_TEST_RUNNER), 0, "%d");
+
+	for (i = 0; i < 3; i++)
+		TEST_ASSERT(acquire_here(200, &ptr[i]) == EC_SUCCESS);
+	shared_mem_release(ptr[0]);
+	TEST_ASSERT(acquire_here(50, &ptr[3]) == EC_SUCCESS);
+
+	TEST_EQ(current_usage(TASK_ID_TEST_RUNNER), 450, "%d");
+	TEST_EQ(peak_usage(TASK_ID_TEST_RUNNER), 600, "%d");
+
+	for (i = 1; i < 4; i++)
+		shared_mem_release(ptr[i]);
+
+	TEST_EQ(current_usage(TASK_ID_TEST_RUNNER), 0, "%d");
+	TEST_EQ(peak_usage(TASK_ID_TEST_RUNNER), 600, "%d");
+
+	/* Another task's usage is counted separately */
+	TEST_EQ(peak_usage(TASK_ID_ALLOC), 0, "%d");
+
+	shared_mem_trace_reset();
+	TEST_EQ(peak_usage(TASK_ID_TEST_RUNNER), 0, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_leak(void)
+{
+	const char *out;
+
+	task_wake(TASK_ID_ALLOC);
+	msleep(20);
+	TEST_ASSERT(alloc_ptr);
+	TEST_EQ(current_usage(TASK_ID_ALLOC), ALLOC_SIZE, "%d");
+
+	test_capture_console(1);
+	TEST_EQ(shared_mem_trace_leaks(100 * MSEC), 0, "%d");
+	TEST_EQ(shared_mem_trace_leaks(10 * MSEC), 1, "%d");
+	test_capture_console(0);
+
+	out = test_get_captured_console();
+	TEST_ASSERT(strstr(out, "held for more than 10000 us"));
+	TEST_ASSERT(strstr(out, "300 bytes by"));
+
+	task_wake(TASK_ID_ALLOC);
+	msleep(20);
+	TEST_ASSERT(!alloc_ptr);
+	TEST_EQ(current_usage(TASK_ID_ALLOC), 0, "%d");
+	TEST_EQ(peak_usage(TASK_ID_ALLOC), ALLOC_SIZE, "%d");
+	TEST_EQ(shared_mem_trace_leaks(0), 0, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_busy(void)
+{
+	struct ec_shared_mem_trace_record r;
+	const char *out;
+	char *all, *ptr;
+
+	TEST_ASSERT(acquire_here(shared_mem_size(), &all) == EC_SUCCESS);
+
+	test_capture_console(1);
+	TEST_EQ(shared_mem_acquire(10, &ptr), EC_ERROR_BUSY, "%d");
+	test_capture_console(0);
+
+	out = test_get_captured_console();
+	TEST_ASSERT(strstr(out, "10 bytes for"));
+	TEST_ASSERT(strstr(out, "failed, held by:"));
+	TEST_ASSERT(strstr(out, "in task"));
+
+	TEST_ASSERT(shared_mem_trace_get(0, &r) == EC_SUCCESS);
+	TEST_EQ(r.size, 10, "%d");
+	TEST_EQ(r.flags, EC_SHARED_MEM_TRACE_FAILED, "%d");
+
+	shared_mem_release(all);
+
+	return EC_SUCCESS;
+}
+
+/* Released records make way for new ones; held ones stay. */
+static int test_wrap(void)
+{
+	struct ec_shared_mem_trace_record r;
+	char *ptr;
+	int i;
+
+	task_wake(TASK_ID_ALLOC);
+	msleep(20);
+	TEST_ASSERT(alloc_ptr);
+
+	for (i = 0; i < TRACE_RECORDS * 2; i++) {
+		TEST_ASSERT(acquire_here(20 + i, &ptr) == EC_SUCCESS);
+		shared_mem_release(ptr);
+	}
+
+	TEST_ASSERT(shared_mem_trace_get(0, &r) == EC_SUCCESS);
+	TEST_EQ(r.size, 20 + TRACE_RECORDS * 2 - 1, "%d");
+
+	TEST_ASSERT(shared_mem_trace_get(TRACE_RECORDS - 1, &r) ==
+		    EC_SUCCESS);
+	TEST_EQ(r.size, ALLOC_SIZE, "%d");
+	TEST_EQ(r.task_id, TASK_ID_ALLOC, "%d");
+	TEST_EQ(r.flags, EC_SHARED_MEM_TRACE_HELD, "%d");
+
+	task_wake(TASK_ID_ALLOC);
+	msleep(20);
+	TEST_ASSERT(!alloc_ptr);
+
+	return EC_SUCCESS;
+}
+
+static int test_host_command(void)
+{
+	struct ec_params_shared_mem_trace p = {
+		.type = EC_SHARED_MEM_TRACE_USAGE,
+	};
+	struct ec_response_shared_mem_trace_usage *usage;
+	struct ec_response_shared_mem_trace_records *records;
+	struct ec_shared_mem_trace_record r;
+	uint8_t resp[128];
+	int i;
+
+	usage = (void *)resp;
+	TEST_EQ(test_send_host_command(EC_CMD_SHARED_MEM_TRACE, 0, &p,
+				       sizeof(p), resp, sizeof(resp)),
+		EC_RES_SUCCESS, "%d");
+	TEST_EQ(usage->task_count, TASK_ID_COUNT, "%d");
+	TEST_EQ(usage->usage[TASK_ID_ALLOC].current, 0, "%d");
+	TEST_EQ(usage->usage[TASK_ID_ALLOC].peak, ALLOC_SIZE, "%d");
+
+	/* Page through the records, a few at a time */
+	records = (void *)resp;
+	p.type = EC_SHARED_MEM_TRACE_RECORDS;
+	for (i = 0; i < TRACE_RECORDS; i += records->count) {
+		p.index = i;
+		TEST_EQ(test_send_host_command(EC_CMD_SHARED_MEM_TRACE, 0, &p,
+					       sizeof(p), resp, 4 + 3 * 16),
+			EC_RES_SUCCESS, "%d");
+		TEST_EQ(records->total, TRACE_RECORDS, "%d");
+		TEST_ASSERT(records->count > 0 && records->count <= 3);
+
+		TEST_ASSERT(shared_mem_trace_get(i, &r) == EC_SUCCESS);
+		TEST_EQ(records->records[0].size, r.size, "%d");
+		TEST_EQ(records->records[0].caller, r.caller, "%d");
+	}
+
+	p.type = 2;
+	TEST_EQ(test_send_host_command(EC_CMD_SHARED_MEM_TRACE, 0, &p,
+				       sizeof(p), resp, sizeof(resp)),
+		EC_RES_INVALID_PARAM, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_console_command(void)
+{
+	const char *out;
+
+	test_capture_console(1);
+	UART_INJECT("shmemtrace\n");
+	msleep(30);
+	test_capture_console(0);
+
+	out = test_get_captured_console();
+	TEST_ASSERT(strstr(out, "Task Current   Peak"));
+	TEST_ASSERT(strstr(out, "      0    300\n"));
+	TEST_ASSERT(strstr(out, "Held (us)"));
+
+	UART_INJECT("shmemtrace reset\n");
+	msleep(30);
+	TEST_EQ(peak_usage(TASK_ID_ALLOC), 0, "%d");
+	TEST_ASSERT(shared_mem_trace_get(0, NULL) == EC_ERROR_INVAL);
+
+	return EC_SUCCESS;
+}
+
+void run_test(int argc, char **argv)
+{
+	test_reset();
+
+	/* Let the console task finish printing as it starts */
+	msleep(30);
+
+	RUN_TEST(test_records);
+	RUN_TEST(test_peak);
+	RUN_TEST(test_leak);
+	RUN_TEST(test_busy);
+	RUN_TEST(test_wrap);
+	RUN_TEST(test_host_command);
+	RUN_TEST(test_console_command);
+
+	test_print_result();
+}
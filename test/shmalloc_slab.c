@@ -0,0 +1,318 @@
+/* Copyright 2020 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test the slab front-end of the shared memory allocator.
+ *
+ * shmalloc_slab_large has slabs with room for two 2 KB blocks, so it tests
+ * the 1 KB and 2 KB size classes as well.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "shared_mem.h"
+#include "test_util.h"
+#include "timer.h"
+#include "uart.h"
+#include "util.h"
+
+#define BENCHMARK_COUNT 20000
+
+/* Largest block with two to a slab; see CONFIG_MALLOC_SLAB */
+#ifdef TEST_SHMALLOC_SLAB_LARGE
+#define SLAB_MAX_BLOCK 2048
+#else
+#define SLAB_MAX_BLOCK 512
+#endif
+
+/* Largest request served from a slab */
+#define SLAB_MAX_SIZE (SLAB_MAX_BLOCK - sizeof(uintptr_t))
+
+static int shmem_size;
+
+/* Slab blocks are tagged with bit 0 set where a buffer keeps its size */
+static int from_slab(const void *ptr)
+{
+	return ((const uintptr_t *)ptr)[-1] & 1;
+}
+
+static char *acquire(int size)
+{
+	char *ptr;
+
+	if (shared_mem_acquire(size, &ptr) != EC_SUCCESS)
+		return NULL;
+	return ptr;
+}
+
+static int test_size_classes(void)
+{
+	static const int sizes[] = {
+		0, 1, 56, 57, 120, 250, 500, SLAB_MAX_SIZE,
+#ifdef TEST_SHMALLOC_SLAB_LARGE
+		504, 1000, 1016, 1017, 2000,
+#endif
+	};
+	char *ptr;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sizes); i++) {
+		ptr = acquire(sizes[i]);
+		TEST_ASSERT(ptr);
+		TEST_ASSERT(from_slab(ptr));
+		shared_mem_release(ptr);
+	}
+
+	/* Larger requests come from the chains */
+	ptr = acquire(SLAB_MAX_SIZE + 1);
+	TEST_ASSERT(ptr);
+	TEST_ASSERT(!from_slab(ptr));
+	shared_mem_release(ptr);
+
+	/* Nothing is held once the spare slabs are given back */
+	TEST_EQ(shared_mem_size(), shmem_size, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_slab_blocks(void)
+{
+	char *a, *b, *c;
+
+	/* Blocks of a class are carved from the same slab, in order */
+	a = acquire(10);
+	b = acquire(20);
+	c = acquire(100);
+	TEST_ASSERT(a && b && c);
+	TEST_EQ((int)(b - a), 64, "%d");
+	TEST_ASSERT(c - a >= 128 || a - c >= 128);
+
+	/* A released block is the next one acquired */
+	shared_mem_release(a);
+	TEST_ASSERT(acquire(30) == a);
+
+	shared_mem_release(a);
+	shared_mem_release(b);
+	shared_mem_release(c);
+
+	/* The empty slab is kept, so the last block released comes back */
+	a = acquire(10);
+	TEST_ASSERT(a == b);
+	shared_mem_release(a);
+
+	TEST_EQ(shared_mem_size(), shmem_size, "%d");
+
+	return EC_SUCCESS;
+}
+
+#ifdef TEST_SHMALLOC_SLAB_LARGE
+static int test_large_blocks(void)
+{
+	char *a, *b, *c, *d;
+
+	/* A slab holds two 2 KB blocks */
+	a = acquire(2000);
+	b = acquire(SLAB_MAX_SIZE);
+	TEST_ASSERT(a && b);
+	TEST_ASSERT(from_slab(a) && from_slab(b));
+	TEST_EQ((int)(b - a), 2048, "%d");
+
+	/* The next one takes another slab */
+	c = acquire(2000);
+	TEST_ASSERT(c);
+	TEST_ASSERT(from_slab(c));
+
+	/* Blocks are written up to their size without touching the others */
+	memset(a, 0xaa, 2000);
+	memset(b, 0xbb, SLAB_MAX_SIZE);
+	memset(c, 0xcc, 2000);
+	TEST_EQ((uint8_t)a[1999], 0xaa, "0x%x");
+	TEST_EQ((uint8_t)b[0], 0xbb, "0x%x");
+	TEST_EQ((uint8_t)b[SLAB_MAX_SIZE - 1], 0xbb, "0x%x");
+
+	shared_mem_release(c);
+	shared_mem_release(a);
+	shared_mem_release(b);
+
+	/* The 1 KB class has four blocks to a slab */
+	a = acquire(1000);
+	b = acquire(1000);
+	c = acquire(1016);
+	d = acquire(1016);
+	TEST_ASSERT(a && b && c && d);
+	TEST_ASSERT(from_slab(a) && from_slab(d));
+	TEST_EQ((int)(b - a), 1024, "%d");
+	TEST_EQ((int)(d - a), 3 * 1024, "%d");
+
+	shared_mem_release(a);
+	shared_mem_release(b);
+	shared_mem_release(c);
+	shared_mem_release(d);
+
+	TEST_EQ(shared_mem_size(), shmem_size, "%d");
+
+	return EC_SUCCESS;
+}
+#endif
+
+static int test_spare_released(void)
+{
+	char *ptr;
+
+	/* Leave a spare slab of each of two classes behind */
+	ptr = acquire(10);
+	TEST_ASSERT(ptr);
+	shared_mem_release(ptr);
+	ptr = acquire(500);
+	TEST_ASSERT(ptr);
+	shared_mem_release(ptr);
+
+	/* A request for all of shared memory still succeeds */
+	ptr = acquire(shmem_size);
+	TEST_ASSERT(ptr);
+	shared_mem_release(ptr);
+
+	return EC_SUCCESS;
+}
+
+static uint32_t seed = 127;
+
+static uint32_t myrand(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return (seed / 65536) % 32768;
+}
+
+static int test_random(void)
+{
+	struct {
+		char *ptr;
+		int size;
+	} allocations[16] = {};
+	int i, n, slot, size;
+
+	for (n = 0; n < 20000; n++) {
+		slot = myrand() % ARRAY_SIZE(allocations);
+
+		if (allocations[slot].ptr) {
+			/* Nobody else wrote over it */
+			for (i = 0; i < allocations[slot].size; i++)
+				TEST_ASSERT(allocations[slot].ptr[i] ==
+					    (char)slot);
+			shared_mem_release(allocations[slot].ptr);
+			allocations[slot].ptr = NULL;
+			continue;
+		}
+
+		/* Mostly small requests, as in practice */
+		size = myrand() % (myrand() % 8 ? 128 : 1024);
+		allocations[slot].ptr = acquire(size);
+		allocations[slot].size = size;
+		if (allocations[slot].ptr)
+			memset(allocations[slot].ptr, slot, size);
+	}
+
+	for (slot = 0; slot < ARRAY_SIZE(allocations); slot++)
+		if (allocations[slot].ptr)
+			shared_mem_release(allocations[slot].ptr);
+
+	TEST_EQ(shared_mem_size(), shmem_size, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_shmem_command(void)
+{
+	const char *out;
+
+	test_capture_console(1);
+	UART_INJECT("shmem\n");
+	msleep(30);
+	test_capture_console(0);
+
+	out = test_get_captured_console();
+	TEST_ASSERT(strstr(out, "fragmented)"));
+	TEST_ASSERT(strstr(out, "Slabs of " STRINGIFY(CONFIG_MALLOC_SLAB)
+			   " bytes:"));
+#ifdef TEST_SHMALLOC_SLAB_LARGE
+	TEST_ASSERT(strstr(out, "  1024:"));
+	TEST_ASSERT(strstr(out, "  2048:"));
+#else
+	TEST_ASSERT(strstr(out, "   512:"));
+	TEST_ASSERT(!strstr(out, "  1024:"));
+#endif
+
+	return EC_SUCCESS;
+}
+
+#ifndef TEST_SHMALLOC_SLAB_LARGE
+/*
+ * Time acquiring and releasing a small buffer from a slab, against a buffer
+ * from the chains when they're fragmented.  Not with large slabs, as the
+ * chain buffers it holds are then too large to fit in shared memory.
+ */
+static int test_benchmark(void)
+{
+	char *hold[8];
+	char *ptr;
+	uint64_t start, slab_ns, chain_ns;
+	int i, chunks;
+
+	/* Leave a run of holes in the free chain */
+	for (i = 0; i < ARRAY_SIZE(hold); i++) {
+		hold[i] = acquire(SLAB_MAX_SIZE + 1 + i * 16);
+		TEST_ASSERT(hold[i]);
+	}
+	for (i = 0; i < ARRAY_SIZE(hold); i += 2)
+		shared_mem_release(hold[i]);
+	chunks = ARRAY_SIZE(hold) / 2 + 1;
+
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < BENCHMARK_COUNT; i++) {
+		ptr = acquire(100);
+		shared_mem_release(ptr);
+	}
+	slab_ns = test_get_wall_clock_ns() - start;
+
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < BENCHMARK_COUNT; i++) {
+		ptr = acquire(SLAB_MAX_SIZE + 1);
+		shared_mem_release(ptr);
+	}
+	chain_ns = test_get_wall_clock_ns() - start;
+
+	ccprintf("%d acquire/release pairs: slab %d ns, "
+		 "chain with %d free bufs %d ns\n", BENCHMARK_COUNT,
+		 (int)(slab_ns / BENCHMARK_COUNT), chunks,
+		 (int)(chain_ns / BENCHMARK_COUNT));
+
+	for (i = 1; i < ARRAY_SIZE(hold); i += 2)
+		shared_mem_release(hold[i]);
+	TEST_EQ(shared_mem_size(), shmem_size, "%d");
+
+	return EC_SUCCESS;
+}
+#endif
+
+void run_test(int argc, char **argv)
+{
+	test_reset();
+
+	/* Let the console task finish printing as it starts */
+	msleep(30);
+	shmem_size = shared_mem_size();
+
+	RUN_TEST(test_size_classes);
+	RUN_TEST(test_slab_blocks);
+#ifdef TEST_SHMALLOC_SLAB_LARGE
+	RUN_TEST(test_large_blocks);
+#endif
+	RUN_TEST(test_spare_released);
+	RUN_TEST(test_random);
+	RUN_TEST(test_shmem_command);
+#ifndef TEST_SHMALLOC_SLAB_LARGE
+	RUN_TEST(test_benchmark);
+#endif
+
+	test_print_result();
+}
@@ -40,6 +40,10 @@
 #define CONFIG_BACKLIGHT_REQ_GPIO GPIO_PCH_BKLTEN
 #endif
 
+#ifdef TEST_CONSOLE_BATCH
+#define CONFIG_CONSOLE_BATCH 256
+#endif
+
 #ifdef TEST_FLASH_LOG
 #define CONFIG_CRC8
 #define CONFIG_FLASH_ERASED_VALUE32 (-1U)
@@ -49,6 +53,28 @@
 #define CONFIG_MALLOC
 #endif
 
+#ifdef TEST_HOOKS
+#define CONFIG_HOOK_DEBUG
+#define CONFIG_HOOK_TICKLESS
+#define CONFIG_HOOK_WAKE_STATS
+#endif
+
+#ifdef TEST_HOST_COMMAND
+#define CONFIG_HOSTCMD_DISPATCH_PAGES 8
+#define CONFIG_HOSTCMD_STATS
+#endif
+
+#ifdef TEST_HOST_COMMAND_ASYNC
+#define CONFIG_HOSTCMD_ASYNC 2
+#define CONFIG_HOST_COMMAND_STATUS
+#define CONFIG_MKBP_EVENT
+#define CONFIG_MKBP_USE_GPIO
+#endif
+
+#ifdef TEST_IRQ_PROFILE
+#define CONFIG_IRQ_PROFILE 4
+#endif
+
 #ifdef TEST_KB_8042
 #define CONFIG_KEYBOARD_PROTOCOL_8042
 #endif
@@ -201,6 +227,10 @@ enum sensor_id {
 #define CONFIG_BODY_DETECTION_SENSOR BASE
 #endif
 
+#ifdef TEST_QUEUE_SPSC
+#define CONFIG_QUEUE_SPSC
+#endif
+
 #ifdef TEST_RMA_AUTH
 
 /* Test server public and private keys */
@@ -247,6 +277,10 @@ enum sensor_id {
 #define CONFIG_RWSIG_TYPE_RWSIG
 #endif
 
+#ifdef TEST_SCHED_STATS
+#define CONFIG_TASK_SCHED_STATS
+#endif
+
 #ifdef TEST_SHA256
 #define CONFIG_SHA256
 #endif
@@ -256,10 +290,25 @@ enum sensor_id {
 #define CONFIG_SHA256_UNROLLED
 #endif
 
+#ifdef TEST_SHARED_MEM_TRACE
+#define CONFIG_MALLOC
+#define CONFIG_SHAREDMEM_TRACE 8
+#endif
+
 #ifdef TEST_SHMALLOC
 #define CONFIG_MALLOC
 #endif
 
+#ifdef TEST_SHMALLOC_SLAB
+#define CONFIG_MALLOC
+#define CONFIG_MALLOC_SLAB 1152
+#endif
+
+#ifdef TEST_SHMALLOC_SLAB_LARGE
+#define CONFIG_MALLOC
+#define CONFIG_MALLOC_SLAB 4160
+#endif
+
 #ifdef TEST_SBS_CHARGING_V2
 #define CONFIG_BATTERY
 #define CONFIG_BATTERY_MOCK
@@ -294,6 +343,20 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #define CONFIG_FANS 1
 #endif
 
+#ifdef TEST_TIMER_QUEUE
+#define CONFIG_TIMER_QUEUE
+#endif
+
+#ifdef TEST_TOKENIZED_LOG
+#define CONFIG_CONSOLE_TOKENIZED_LOG
+#undef CONFIG_CONSOLE_TOKENIZED_LOG_SIZE
+#define CONFIG_CONSOLE_TOKENIZED_LOG_SIZE 512
+#endif
+
+#ifdef TEST_UART_TX_STRESS
+#define CONFIG_UART_TX_STAGING 80
+#endif
+
 #ifdef TEST_BUTTON
 #define CONFIG_KEYBOARD_PROTOCOL_8042
 #undef CONFIG_KEYBOARD_VIVALDI
@@ -333,6 +396,11 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #define CONFIG_SW_CRC
 #endif
 
+#ifdef TEST_USB_PD_TIMER
+#define CONFIG_TEST_USB_PD_TIMER
+#define CONFIG_USB_PD_PORT_MAX_COUNT 2
+#endif
+
 #if defined(TEST_USB_SM_FRAMEWORK_H3) || \
 	defined(TEST_USB_SM_FRAMEWORK_H2) || \
 	defined(TEST_USB_SM_FRAMEWORK_H1) || \
@@ -346,6 +414,7 @@ int ncp15wb_calculate_temp(uint16_t adc);
 
 #if defined(TEST_USB_PRL_OLD)
 #define CONFIG_USB_PD_EXTENDED_MESSAGES
+#define CONFIG_USB_PD_TRACE 8
 #endif
 
 #define CONFIG_USB_PD_TCPMV2
@@ -472,7 +541,8 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #undef CONFIG_USB_PD_HOST_CMD
 #endif
 
-#ifdef TEST_USB_TCPMV2_COMPLIANCE
+#if defined(TEST_USB_TCPMV2_COMPLIANCE) || \
+	defined(TEST_USB_TCPMV2_COMPLIANCE_SHARED) || defined(TEST_USB_TCPCI_RX)
 #define CONFIG_USB_DRP_ACC_TRYSRC
 #define CONFIG_USB_PD_DUAL_ROLE
 #define CONFIG_USB_PD_DUAL_ROLE_AUTO_TOGGLE
@@ -500,6 +570,32 @@ int ncp15wb_calculate_temp(uint16_t adc);
 #define CONFIG_USB_PD_3A_PORTS 0 /* Host does not define a 3.0 A PDO */
 #endif
 
+#ifdef TEST_USB_TCPMV2_COMPLIANCE_SHARED
+#define CONFIG_USB_PD_SHARED_TASK
+#endif
+
+#ifdef TEST_USB_PD_SHARED_TASK
+#define CONFIG_USB_DRP_ACC_TRYSRC
+#define CONFIG_USB_PD_DUAL_ROLE
+#define CONFIG_USB_PD_TRY_SRC
+#define CONFIG_USB_TYPEC_SM
+#define CONFIG_USB_PD_TCPMV2
+#define CONFIG_USB_PD_PORT_MAX_COUNT 2
+#define CONFIG_USB_PD_SHARED_TASK
+#define CONFIG_USBC_SS_MUX
+#define CONFIG_USB_PD_VBUS_DETECT_TCPC
+#define CONFIG_USB_POWER_DELIVERY
+#undef CONFIG_USB_PRL_SM
+#undef CONFIG_USB_PE_SM
+#undef CONFIG_USB_PD_HOST_CMD
+#endif
+
+#ifdef TEST_USB_TCPCI_RX
+#define CONFIG_USB_PD_TCPC_RUNTIME_CONFIG
+#undef CONFIG_USB_PD_TCPM_RX_CACHE_DEPTH
+#define CONFIG_USB_PD_TCPM_RX_CACHE_DEPTH 4
+#endif
+
 #ifdef TEST_USB_PD_INT
 #define CONFIG_USB_POWER_DELIVERY
 #define CONFIG_USB_PD_TCPMV1
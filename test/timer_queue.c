@@ -0,0 +1,360 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests and benchmark for the deadline-ordered timer queue.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "hwtimer.h"
+#include "task.h"
+#include "test_util.h"
+#include "timer.h"
+#include "timer_queue.h"
+#include "util.h"
+
+/* period between 500us and 128ms, as in the timer_dos test */
+#define PERIOD_US(num) (((num % 256) + 1) * 500)
+
+#define EXPIRY_COUNT 200000
+
+/*
+ * The emulator has its own timer implementation, so these tasks only exist to
+ * give the queue a realistic number of task IDs to order.
+ */
+int task_timer(void *unused)
+{
+	while (1)
+		task_wait_event(-1);
+
+	return EC_SUCCESS;
+}
+
+/*
+ * Stand in for the clock source, so timer_arm(), timer_cancel() and
+ * process_timers() can be tested on the emulator's clock.
+ */
+static int irq_count;
+static int event_set;
+static uint32_t event_deadline;
+
+void timer_count_overflow(void)
+{
+}
+
+void timer_trigger_irq(void)
+{
+	irq_count++;
+}
+
+void __hw_clock_event_set(uint32_t deadline)
+{
+	event_set = 1;
+	event_deadline = deadline;
+}
+
+void __hw_clock_event_clear(void)
+{
+	event_set = 0;
+}
+
+static void queue_clear(void)
+{
+	timestamp_t t;
+	task_id_t tskid;
+
+	while ((tskid = timer_queue_peek(&t)) != TASK_ID_INVALID)
+		timer_queue_remove(tskid);
+}
+
+static int test_queue_order(void)
+{
+	uint32_t seed = 1234;
+	timestamp_t prev, t;
+	task_id_t tskid;
+	int i, count = 0;
+
+	queue_clear();
+	TEST_EQ(timer_queue_peek(&t), TASK_ID_INVALID, "%d");
+
+	/* Include deadlines on both sides of a 32-bit epoch */
+	for (i = 0; i < TASK_ID_COUNT; i++) {
+		seed = prng(seed);
+		t.val = 0xfff00000ull + (uint64_t)PERIOD_US(seed) * 10;
+		timer_queue_add(i, t);
+	}
+
+	/* Moving and removing entries keeps the order */
+	t.val = 1;
+	TEST_EQ(timer_queue_add(TASK_ID_TMR7, t), 1, "%d");
+	TEST_EQ(timer_queue_peek(&t), TASK_ID_TMR7, "%d");
+	t.val = -1ull;
+	TEST_EQ(timer_queue_add(TASK_ID_TMR7, t), 0, "%d");
+	timer_queue_remove(TASK_ID_TMR3);
+	timer_queue_remove(TASK_ID_TMR3);
+
+	prev.val = 0;
+	while ((tskid = timer_queue_peek(&t)) != TASK_ID_INVALID) {
+		TEST_ASSERT(t.val >= prev.val);
+		TEST_ASSERT(timer_queue_deadline(tskid).val == t.val);
+		TEST_NE(tskid, TASK_ID_TMR3, "%d");
+		timer_queue_remove(tskid);
+		prev = t;
+		count++;
+	}
+	TEST_EQ(count, TASK_ID_COUNT - 1, "%d");
+	TEST_ASSERT(prev.val == -1ull);
+
+	return EC_SUCCESS;
+}
+
+/* Run process_timers() once the clock reaches a deadline */
+static void process_timers_at(uint64_t t)
+{
+	timestamp_t now = { .val = t };
+
+	force_time(now);
+	process_timers(0);
+}
+
+static int test_timer_rearm(void)
+{
+	timestamp_t now = get_time();
+	timestamp_t t;
+
+	queue_clear();
+	irq_count = 0;
+
+	t.val = now.val + 1000;
+	TEST_EQ(timer_arm(t, TASK_ID_TMR1), EC_SUCCESS, "%d");
+	TEST_EQ(irq_count, 1, "%d");
+
+	/* An armed timer can't be armed again until it's cancelled */
+	t.val = now.val + 500;
+	TEST_EQ(timer_arm(t, TASK_ID_TMR1), EC_ERROR_BUSY, "%d");
+	timer_cancel(TASK_ID_TMR1);
+	TEST_EQ(timer_arm(t, TASK_ID_TMR1), EC_SUCCESS, "%d");
+	TEST_EQ(irq_count, 2, "%d");
+
+	process_timers_at(now.val + 100);
+	TEST_ASSERT(event_set);
+	TEST_EQ(event_deadline, (uint32_t)(now.val + 500), "0x%08x");
+
+	/* ... or until it has expired */
+	process_timers_at(now.val + 500);
+	TEST_ASSERT(!event_set);
+	TEST_ASSERT(!timer_queue_contains(TASK_ID_TMR1));
+	t.val = now.val + 2000;
+	TEST_EQ(timer_arm(t, TASK_ID_TMR1), EC_SUCCESS, "%d");
+
+	process_timers_at(now.val + 600);
+	TEST_EQ(event_deadline, (uint32_t)(now.val + 2000), "0x%08x");
+	timer_cancel(TASK_ID_TMR1);
+
+	return EC_SUCCESS;
+}
+
+static int test_timer_cancel_head(void)
+{
+	timestamp_t now = get_time();
+	timestamp_t t;
+
+	queue_clear();
+	irq_count = 0;
+
+	t.val = now.val + 1000;
+	TEST_EQ(timer_arm(t, TASK_ID_TMR1), EC_SUCCESS, "%d");
+	t.val = now.val + 2000;
+	TEST_EQ(timer_arm(t, TASK_ID_TMR2), EC_SUCCESS, "%d");
+	t.val = now.val + 3000;
+	TEST_EQ(timer_arm(t, TASK_ID_TMR3), EC_SUCCESS, "%d");
+
+	/* Only the timer which became the earliest kicks the interrupt */
+	TEST_EQ(irq_count, 1, "%d");
+
+	process_timers_at(now.val + 100);
+	TEST_EQ(event_deadline, (uint32_t)(now.val + 1000), "0x%08x");
+
+	/* The next interrupt moves the hardware event to the new head */
+	timer_cancel(TASK_ID_TMR1);
+	process_timers_at(now.val + 1000);
+	TEST_EQ(event_deadline, (uint32_t)(now.val + 2000), "0x%08x");
+	TEST_ASSERT(timer_queue_contains(TASK_ID_TMR2));
+
+	/* Cancelling a timer behind the head doesn't change it */
+	timer_cancel(TASK_ID_TMR3);
+	process_timers_at(now.val + 1500);
+	TEST_EQ(event_deadline, (uint32_t)(now.val + 2000), "0x%08x");
+
+	timer_cancel(TASK_ID_TMR2);
+	process_timers_at(now.val + 2500);
+	TEST_ASSERT(!event_set);
+
+	return EC_SUCCESS;
+}
+
+static int test_timer_same_deadline(void)
+{
+	timestamp_t now = get_time();
+	timestamp_t t;
+	int i;
+
+	queue_clear();
+	irq_count = 0;
+
+	t.val = now.val + 1000;
+	for (i = TASK_ID_TMR1; i <= TASK_ID_TMR5; i++)
+		TEST_EQ(timer_arm(t, i), EC_SUCCESS, "%d");
+	t.val = now.val + 2000;
+	TEST_EQ(timer_arm(t, TASK_ID_TMR6), EC_SUCCESS, "%d");
+
+	/* Ties don't displace the timer already at the head */
+	TEST_EQ(irq_count, 1, "%d");
+	TEST_EQ(timer_queue_peek(&t), TASK_ID_TMR1, "%d");
+
+	/* A timer armed ahead of the tie becomes the head */
+	t.val = now.val + 500;
+	TEST_EQ(timer_arm(t, TASK_ID_TMR7), EC_SUCCESS, "%d");
+	TEST_EQ(irq_count, 2, "%d");
+
+	process_timers_at(now.val + 500);
+	TEST_EQ(event_deadline, (uint32_t)(now.val + 1000), "0x%08x");
+	TEST_ASSERT(!timer_queue_contains(TASK_ID_TMR7));
+
+	/* All the timers sharing a deadline expire together */
+	process_timers_at(now.val + 1000);
+	for (i = TASK_ID_TMR1; i <= TASK_ID_TMR5; i++)
+		TEST_ASSERT(!timer_queue_contains(i));
+	TEST_EQ(event_deadline, (uint32_t)(now.val + 2000), "0x%08x");
+
+	/* A deadline past the next 32-bit epoch waits for the overflow */
+	timer_cancel(TASK_ID_TMR6);
+	t.val = ((now.val >> 32) + 1) << 32;
+	TEST_EQ(timer_arm(t, TASK_ID_TMR6), EC_SUCCESS, "%d");
+	process_timers_at(now.val + 3000);
+	TEST_ASSERT(!event_set);
+	timer_cancel(TASK_ID_TMR6);
+
+	return EC_SUCCESS;
+}
+
+/*
+ * Reference copy of the previous process_timers() selection: scan every
+ * running timer to find the ones that expired and the next deadline.
+ */
+static uint32_t ref_running;
+static timestamp_t ref_deadline[TASK_ID_COUNT];
+
+static task_id_t ref_next(timestamp_t *next)
+{
+	uint32_t check_timer = ref_running;
+	task_id_t next_id = TASK_ID_INVALID;
+
+	next->val = -1ull;
+	while (check_timer) {
+		int tskid = __fls(check_timer);
+
+		if (ref_deadline[tskid].val < next->val) {
+			next->val = ref_deadline[tskid].val;
+			next_id = tskid;
+		}
+		check_timer &= ~BIT(tskid);
+	}
+
+	return next_id;
+}
+
+/*
+ * Replay the timer_dos workload: every task rearms its timer for a
+ * pseudo-random period each time it expires.  Return a checksum of the
+ * expired deadlines so both implementations can be compared; it doesn't
+ * depend on how ties between equal deadlines are broken.
+ */
+static uint32_t run_queue(uint64_t *ns)
+{
+	uint32_t num[TASK_ID_COUNT];
+	uint32_t sum = 0;
+	uint64_t start;
+	timestamp_t t;
+	task_id_t tskid;
+	int i;
+
+	queue_clear();
+	for (i = 0; i < TASK_ID_COUNT; i++) {
+		num[i] = prng(i + 1);
+		t.val = PERIOD_US(num[i]);
+		timer_queue_add(i, t);
+	}
+
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < EXPIRY_COUNT; i++) {
+		tskid = timer_queue_peek(&t);
+		timer_queue_remove(tskid);
+		sum = sum * 31 + t.le.lo;
+		num[tskid] = prng(num[tskid]);
+		t.val += PERIOD_US(num[tskid]);
+		timer_queue_add(tskid, t);
+	}
+	*ns = test_get_wall_clock_ns() - start;
+
+	queue_clear();
+	return sum;
+}
+
+static uint32_t run_ref(uint64_t *ns)
+{
+	uint32_t num[TASK_ID_COUNT];
+	uint32_t sum = 0;
+	uint64_t start;
+	timestamp_t t;
+	task_id_t tskid;
+	int i;
+
+	ref_running = 0;
+	for (i = 0; i < TASK_ID_COUNT; i++) {
+		num[i] = prng(i + 1);
+		ref_deadline[i].val = PERIOD_US(num[i]);
+		ref_running |= BIT(i);
+	}
+
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < EXPIRY_COUNT; i++) {
+		tskid = ref_next(&t);
+		ref_running &= ~BIT(tskid);
+		sum = sum * 31 + t.le.lo;
+		num[tskid] = prng(num[tskid]);
+		ref_deadline[tskid].val = t.val + PERIOD_US(num[tskid]);
+		ref_running |= BIT(tskid);
+	}
+	*ns = test_get_wall_clock_ns() - start;
+
+	return sum;
+}
+
+static int test_queue_cost(void)
+{
+	uint64_t queue_ns, ref_ns;
+
+	TEST_EQ(run_queue(&queue_ns), run_ref(&ref_ns), "0x%08x");
+
+	ccprintf("%d expiries of %d timers: queue %d ns/expiry, "
+		 "scan %d ns/expiry\n", EXPIRY_COUNT, TASK_ID_COUNT,
+		 (int)(queue_ns / EXPIRY_COUNT), (int)(ref_ns / EXPIRY_COUNT));
+
+	return EC_SUCCESS;
+}
+
+void run_test(int argc, char **argv)
+{
+	test_reset();
+	wait_for_task_started();
+
+	RUN_TEST(test_queue_order);
+	RUN_TEST(test_timer_rearm);
+	RUN_TEST(test_timer_cancel_head);
+	RUN_TEST(test_timer_same_deadline);
+	RUN_TEST(test_queue_cost);
+
+	test_print_result();
+}
@@ -0,0 +1,266 @@
+/* Copyright 2020 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for the tokenized console log.
+ */
+
+#include "common.h"
+#include "console.h"
+#include "ec_commands.h"
+#include "host_command.h"
+#include "printf.h"
+#include "test_util.h"
+#include "timer.h"
+#include "tokenized_log.h"
+#include "util.h"
+
+#define BENCHMARK_COUNT 20000
+
+/* Position after the last entry read */
+static uint32_t read_pos;
+
+/* Format the next entry in the log; return its length, or -1 if none */
+static int next_line(char *line, int size)
+{
+	uint8_t entry[TOKENIZED_LOG_ENTRY_MAX];
+
+	if (tokenized_log_read(&read_pos, entry, sizeof(entry)) <= 0)
+		return -1;
+	return tokenized_log_format(entry, line, size);
+}
+
+static int skip_to_end(void)
+{
+	char line[160];
+
+	while (next_line(line, sizeof(line)) >= 0)
+		;
+	return EC_SUCCESS;
+}
+
+/*
+ * Log with cprintf() and check the decoded entry matches what snprintf()
+ * makes of the same format and arguments.
+ */
+#define CHECK_FORMAT(fmt, args...) do {					\
+		char expect[160], line[160];				\
+		skip_to_end();						\
+		cprintf(CC_SYSTEM, fmt, ## args);			\
+		snprintf(expect, sizeof(expect), fmt, ## args);		\
+		TEST_ASSERT(next_line(line, sizeof(line)) >= 0);	\
+		if (strncmp(line, expect, sizeof(line)))		\
+			ccprintf("'%s' != '%s'\n", line, expect);	\
+		TEST_ASSERT(!strncmp(line, expect, sizeof(line)));	\
+	} while (0)
+
+static int test_formats(void)
+{
+	const uint8_t bytes[] = { 0x01, 0x23, 0xab, 0xcd };
+	const uint64_t t = 12345678;
+	char dynamic[8];
+
+	CHECK_FORMAT("no arguments\n");
+	CHECK_FORMAT("100%% %d %u %x %X %c\n", -5, 5, 0xbeef, 0xbeef, 'q');
+	CHECK_FORMAT("[%5d|%-5d|%05d|%+d]\n", 42, 42, 42, 42);
+	CHECK_FORMAT("%lld %llx %.6lld\n", -1234567890123LL,
+		     0x123456789abcdefULL, 1234567LL);
+	CHECK_FORMAT("%zu %.3d\n", sizeof(bytes), 1234);
+	CHECK_FORMAT("%s|%.3s|%10s|%-6s|\n", "abc", "abcdef", "right",
+		     "left");
+	CHECK_FORMAT("%*d|%-*d|%.*s\n", 6, 1, 4, 2, 2, "xyz");
+	CHECK_FORMAT("%ph %pP\n", HEX_BUF(bytes, sizeof(bytes)), bytes);
+	CHECK_FORMAT("%pb %pT\n", BINARY_VALUE(5, 8), &t);
+
+	/* Strings are copied, so may change after they're logged */
+	strzcpy(dynamic, "before", sizeof(dynamic));
+	skip_to_end();
+	cprintf(CC_SYSTEM, "%s", dynamic);
+	strzcpy(dynamic, "after", sizeof(dynamic));
+	{
+		char line[32];
+
+		TEST_ASSERT(next_line(line, sizeof(line)) >= 0);
+		TEST_ASSERT(!strncmp(line, "before", sizeof(line)));
+	}
+
+	return EC_SUCCESS;
+}
+
+static int test_cprints(void)
+{
+	char line[160];
+	int len;
+
+	skip_to_end();
+	cprints(CC_SYSTEM, "port %d: %s", 1, "attached");
+	len = next_line(line, sizeof(line));
+	TEST_ASSERT(len > 0);
+	TEST_ASSERT(line[0] == '[');
+	TEST_ASSERT(len > 20);
+	TEST_ASSERT(!strncmp(line + len - 19, " port 1: attached]\n", 19));
+
+	return EC_SUCCESS;
+}
+
+static int test_truncated(void)
+{
+	char big[TOKENIZED_LOG_ENTRY_MAX * 2];
+	char line[160];
+
+	memset(big, 'x', sizeof(big) - 1);
+	big[sizeof(big) - 1] = '\0';
+
+	skip_to_end();
+	cprintf(CC_SYSTEM, "%d %s %d", 1, big, 2);
+	TEST_ASSERT(next_line(line, sizeof(line)) >= 0);
+	TEST_ASSERT(!strncmp(line, "1 ...", sizeof(line)));
+
+	return EC_SUCCESS;
+}
+
+static int test_channels(void)
+{
+	char line[160];
+
+	/* Disabled channels aren't logged */
+	skip_to_end();
+	console_channel_disable("system");
+	cprints(CC_SYSTEM, "hidden");
+	console_channel_enable("system");
+	TEST_EQ(next_line(line, sizeof(line)), -1, "%d");
+
+	/* Console command output is still printed as text */
+	ccprintf("command output\n");
+	TEST_EQ(next_line(line, sizeof(line)), -1, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_overwrite(void)
+{
+	char line[160];
+	uint32_t pos = read_pos;
+	int i, first = -1, last = -1, n;
+
+	/* Fill the log several times over */
+	for (i = 0; i < CONFIG_CONSOLE_TOKENIZED_LOG_SIZE / 4; i++)
+		cprintf(CC_SYSTEM, "%d", i);
+
+	/* The oldest entries are gone; the rest are intact and in order */
+	while (next_line(line, sizeof(line)) >= 0) {
+		n = atoi(line);
+		if (first < 0)
+			first = n;
+		else
+			TEST_EQ(n, last + 1, "%d");
+		last = n;
+	}
+	TEST_ASSERT(first > 0);
+	TEST_EQ(last, i - 1, "%d");
+	TEST_ASSERT(read_pos - pos > CONFIG_CONSOLE_TOKENIZED_LOG_SIZE);
+
+	return EC_SUCCESS;
+}
+
+static int test_host_command(void)
+{
+	struct ec_params_console_read_tokenized p;
+	uint8_t buf[sizeof(struct ec_response_console_read_tokenized) + 64];
+	struct ec_response_console_read_tokenized *r = (void *)buf;
+	const struct tokenized_log_entry *e;
+	char line[32];
+	int i, seen = 0;
+
+	for (i = 0; i < 20; i++)
+		cprintf(CC_SYSTEM, "entry %d", i);
+
+	/* Start too far back; the response says where the entries begin */
+	p.pos = 0;
+	do {
+		TEST_EQ(test_send_host_command(EC_CMD_CONSOLE_READ_TOKENIZED, 0,
+					       &p, sizeof(p), buf, sizeof(buf)),
+			EC_RES_SUCCESS, "%d");
+		TEST_ASSERT(r->pos >= p.pos);
+		for (e = (const void *)r->data;
+		     (uint8_t *)e < r->data + r->next - r->pos;
+		     e = (const void *)((uint8_t *)e + e->size))
+			if (tokenized_log_format(e, line, sizeof(line)) &&
+			    !strncmp(line, "entry 19", sizeof(line)))
+				seen = 1;
+		p.pos = r->next;
+	} while (r->next != r->pos);
+	TEST_ASSERT(seen);
+
+	return EC_SUCCESS;
+}
+
+static int addchar(void *context, int c)
+{
+	return 0;
+}
+
+static int vlog_text(const char *format, ...)
+{
+	va_list args;
+	int rv;
+
+	va_start(args, format);
+	rv = vfnprintf(addchar, NULL, format, args);
+	va_end(args);
+
+	return rv;
+}
+
+static int test_benchmark(void)
+{
+	uint32_t pos;
+	char line[160];
+	uint64_t start, text_ns, token_ns;
+	int i, text_bytes, token_bytes;
+
+	skip_to_end();
+	pos = read_pos;
+
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < BENCHMARK_COUNT; i++)
+		vlog_text("C%d: PE %s -> %s, msg 0x%04x len %d\n", 0,
+			  "SNK_READY", "SNK_EVALUATE_CAPABILITY", 0x11a1, 28);
+	text_ns = test_get_wall_clock_ns() - start;
+
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < BENCHMARK_COUNT; i++)
+		cprintf(CC_USB, "C%d: PE %s -> %s, msg 0x%04x len %d\n", 0,
+			"SNK_READY", "SNK_EVALUATE_CAPABILITY", 0x11a1, 28);
+	token_ns = test_get_wall_clock_ns() - start;
+
+	text_bytes = snprintf(line, sizeof(line),
+			      "C%d: PE %s -> %s, msg 0x%04x len %d\n", 0,
+			      "SNK_READY", "SNK_EVALUATE_CAPABILITY", 0x11a1,
+			      28);
+	tokenized_log_read(&pos, line, sizeof(line));
+	token_bytes = ((struct tokenized_log_entry *)line)->size;
+
+	ccprintf("%d lines: formatted %d ns/line, %d bytes; "
+		 "tokenized %d ns/line, %d bytes\n", BENCHMARK_COUNT,
+		 (int)(text_ns / BENCHMARK_COUNT), text_bytes,
+		 (int)(token_ns / BENCHMARK_COUNT), token_bytes);
+	TEST_ASSERT(token_bytes < text_bytes);
+
+	return EC_SUCCESS;
+}
+
+void run_test(int argc, char **argv)
+{
+	test_reset();
+
+	RUN_TEST(test_formats);
+	RUN_TEST(test_cprints);
+	RUN_TEST(test_truncated);
+	RUN_TEST(test_channels);
+	RUN_TEST(test_overwrite);
+	RUN_TEST(test_host_command);
+	RUN_TEST(test_benchmark);
+
+	test_print_result();
+}
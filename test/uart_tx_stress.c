@@ -0,0 +1,179 @@
+/* Copyright 2020 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Stress test for console output from several tasks and an interrupt at once.
+ */
+
+#include "atomic.h"
+#include "common.h"
+#include "console.h"
+#include "printf.h"
+#include "task.h"
+#include "test_util.h"
+#include "timer.h"
+#include "uart.h"
+#include "util.h"
+
+#define LOGGER_COUNT 3
+#define ROUNDS 100
+/* Lines printed by each logger per round, besides the held one */
+#define LINES_PER_ROUND 3
+
+#define LOGGER_FORMAT "log%d %d abcdefghij klmnopqrst"
+#define HELD_FORMAT "held%d %d first second"
+#define ISR_FORMAT "isr %d"
+
+/* period between 50us and 3.2ms */
+#define PERIOD_US(num) (((num % 64) + 1) * 50)
+
+static atomic_t loggers_done;
+static int isr_count;
+static int round_lines[LOGGER_COUNT];
+
+static void isr_log(void)
+{
+	cprints(CC_SYSTEM, ISR_FORMAT, isr_count++);
+}
+
+void interrupt_generator(void)
+{
+	while (1) {
+		udelay(PERIOD_US(prng_no_seed()));
+		task_trigger_test_interrupt(isr_log);
+	}
+}
+
+void logger_task(void *unused)
+{
+	int n = task_get_current() - TASK_ID_LOG1;
+	int line = 0;
+	int i;
+
+	while (1) {
+		/* Ready for the next round */
+		atomic_add(&loggers_done, 1);
+		task_wait_event(-1);
+
+		for (i = 0; i < LINES_PER_ROUND; i++) {
+			cprints(CC_SYSTEM, LOGGER_FORMAT, n, line++);
+			usleep(PERIOD_US(prng_no_seed()) / 10);
+		}
+
+		/* A line printed in pieces, with other tasks running between */
+		uart_line_begin();
+		cprintf(CC_SYSTEM, "held%d %d first", n, line++);
+		usleep(PERIOD_US(prng_no_seed()) / 10);
+		cprintf(CC_SYSTEM, " second\n");
+		uart_line_end();
+	}
+}
+
+/*
+ * Check one line of output.  Lines from cprints() must be whole, and the
+ * loggers' lines must be in order.
+ */
+static int check_line(const char *line, int len)
+{
+	char expect[64];
+	const char *body = line;
+	char *e;
+	int n, num;
+
+	if (line[0] == '[') {
+		/* "[<timestamp> <body>]" */
+		TEST_ASSERT(line[len - 1] == ']');
+		for (n = 1; n < len - 1; n++)
+			TEST_ASSERT(line[n] != '[' && line[n] != ']');
+		while (*body != ' ' && body < line + len)
+			body++;
+		body++;
+		len -= body - line + 1;
+	}
+
+	if (!strncmp(body, "isr ", 4)) {
+		snprintf(expect, sizeof(expect), ISR_FORMAT,
+			 strtoi(body + 4, NULL, 10));
+	} else if (!strncmp(body, "log", 3) || !strncmp(body, "held", 4)) {
+		n = strtoi(body + (body[0] == 'l' ? 3 : 4), &e, 10);
+		TEST_ASSERT(n >= 0 && n < LOGGER_COUNT);
+		num = strtoi(e, NULL, 10);
+		TEST_ASSERT(num == round_lines[n]);
+		round_lines[n]++;
+		snprintf(expect, sizeof(expect),
+			 body[0] == 'l' ? LOGGER_FORMAT : HELD_FORMAT, n, num);
+	} else {
+		/* Something else printed by the system; it's whole, so fine */
+		TEST_ASSERT(line[0] == '[');
+		return EC_SUCCESS;
+	}
+
+	TEST_ASSERT(len == strlen(expect));
+	TEST_ASSERT(!strncmp(body, expect, len));
+
+	return EC_SUCCESS;
+}
+
+static int check_output(const char *out)
+{
+	const char *end;
+
+	while (*out) {
+		end = strstr(out, "\r\n");
+		TEST_ASSERT(end);
+		TEST_ASSERT(end > out);
+		TEST_ASSERT(check_line(out, end - out) == EC_SUCCESS);
+		out = end + 2;
+	}
+
+	return EC_SUCCESS;
+}
+
+static int test_concurrent_lines(void)
+{
+	int expect_lines[LOGGER_COUNT];
+	int round, i;
+
+	/* Wait for the loggers to start */
+	while (loggers_done < LOGGER_COUNT)
+		usleep(100);
+
+	for (round = 0; round < ROUNDS; round++) {
+		for (i = 0; i < LOGGER_COUNT; i++)
+			expect_lines[i] = round_lines[i] + LINES_PER_ROUND + 1;
+
+		/* Start and stop capturing between interrupts' lines */
+		interrupt_disable();
+		test_capture_console(1);
+		interrupt_enable();
+
+		loggers_done = 0;
+		for (i = 0; i < LOGGER_COUNT; i++)
+			task_wake(TASK_ID_LOG1 + i);
+		while (loggers_done < LOGGER_COUNT)
+			usleep(100);
+
+		interrupt_disable();
+		test_capture_console(0);
+		interrupt_enable();
+
+		TEST_ASSERT(check_output(test_get_captured_console()) ==
+			    EC_SUCCESS);
+		for (i = 0; i < LOGGER_COUNT; i++)
+			TEST_ASSERT(round_lines[i] == expect_lines[i]);
+	}
+
+	ccprintf("%d rounds, %d interrupt lines\n", ROUNDS, isr_count);
+	TEST_ASSERT(isr_count > 0);
+
+	return EC_SUCCESS;
+}
+
+void run_test(int argc, char **argv)
+{
+	test_reset();
+
+	RUN_TEST(test_concurrent_lines);
+
+	test_print_result();
+}
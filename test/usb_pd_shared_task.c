@@ -0,0 +1,318 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test one PD task running several ports (CONFIG_USB_PD_SHARED_TASK).
+ */
+#include "charge_manager.h"
+#include "console.h"
+#include "mock/tcpc_mock.h"
+#include "mock/usb_mux_mock.h"
+#include "task.h"
+#include "test_util.h"
+#include "timer.h"
+#include "usb_mux.h"
+#include "usb_pd.h"
+#include "usb_pd_tcpm.h"
+#include "usb_tc_sm.h"
+
+#define PORT0 0
+#define PORT1 1
+
+/* How long a port may go without running (USBC_EVENT_TIMEOUT) */
+#define EVENT_TIMEOUT (5 * MSEC)
+
+/* How long each port's pass takes in the latency test */
+#define BUSY_US 500
+#define LATENCY_SAMPLES 20
+
+/* From usbc_task.c */
+extern uint64_t port_deadline[CONFIG_USB_PD_PORT_MAX_COUNT];
+
+/* Install Mock TCPC and MUX drivers */
+const struct tcpc_config_t tcpc_config[CONFIG_USB_PD_PORT_MAX_COUNT] = {
+	{
+		.drv = &mock_tcpc_driver,
+	},
+	{
+		.drv = &mock_tcpc_driver,
+	},
+};
+
+const struct usb_mux usb_muxes[CONFIG_USB_PD_PORT_MAX_COUNT] = {
+	{
+		.driver = &mock_usb_mux_driver,
+	},
+	{
+		.driver = &mock_usb_mux_driver,
+	},
+};
+
+void charge_manager_set_ceil(int port, enum ceil_requestor requestor, int ceil)
+{
+	/* Do Nothing, but needed for linking */
+}
+
+void pd_resume_check_pr_swap_needed(int port)
+{
+	/* Do Nothing, but needed for linking */
+}
+
+/*
+ * The unattached Type-C states read CC each time they run, so each read is
+ * taken as a run of the port.
+ */
+#define RUN_LOG_SIZE 64
+
+static struct {
+	int port;
+	uint64_t time;
+} run_log[RUN_LOG_SIZE];
+static int run_log_len;
+static int runs[CONFIG_USB_PD_PORT_MAX_COUNT];
+/* Runs whose port the PD task didn't report as the one it was running */
+static int wrong_port;
+/* Port to set PD_EVENT_CC for, on port 0's next run */
+static int kick_port = -1;
+static uint64_t kick_time;
+/* Port to suspend, on port 0's next run */
+static int suspend_port = -1;
+static int busy_us;
+
+static int count_run(int port, enum tcpc_cc_voltage_status *cc1,
+		     enum tcpc_cc_voltage_status *cc2)
+{
+	const task_id_t task = task_get_current();
+
+	if (task != TASK_ID_PD_C0 || TASK_ID_TO_PD_PORT(task) != port ||
+	    PD_PORT_TO_TASK_ID(port) != TASK_ID_PD_C0)
+		wrong_port++;
+
+	runs[port]++;
+	if (run_log_len < RUN_LOG_SIZE) {
+		run_log[run_log_len].port = port;
+		run_log[run_log_len].time = get_time().val;
+		run_log_len++;
+	}
+
+	if (port == PORT0 && kick_port >= 0) {
+		kick_time = get_time().val;
+		pd_task_set_event(kick_port, PD_EVENT_CC);
+		kick_port = -1;
+	}
+
+	if (port == PORT0 && suspend_port >= 0) {
+		pd_set_suspend(suspend_port, 1);
+		suspend_port = -1;
+	}
+
+	if (busy_us)
+		udelay(busy_us);
+
+	return EC_SUCCESS;
+}
+
+static void clear_run_log(void)
+{
+	run_log_len = 0;
+	memset(runs, 0, sizeof(runs));
+}
+
+/* Find the first logged run of port at or after time */
+static bool find_run(int port, uint64_t time, uint64_t *run_time)
+{
+	int i;
+
+	for (i = 0; i < run_log_len; i++) {
+		if (run_log[i].port == port && run_log[i].time >= time) {
+			*run_time = run_log[i].time;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Run both ports now, so their deadlines are a full timeout away */
+static void run_both_ports(void)
+{
+	pd_task_set_event(PORT0, PD_EVENT_CC);
+	pd_task_set_event(PORT1, PD_EVENT_CC);
+	msleep(1);
+}
+
+static int test_ports_share_task(void)
+{
+	clear_run_log();
+	msleep(50);
+
+	/* Each port runs at least every EVENT_TIMEOUT */
+	TEST_GE(runs[PORT0], 5, "%d");
+	TEST_GE(runs[PORT1], 5, "%d");
+	TEST_EQ(wrong_port, 0, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_cross_port_event(void)
+{
+	uint64_t deadline, start, t;
+
+	run_both_ports();
+	msleep(2);
+	deadline = port_deadline[PORT1];
+
+	/* Port 0 wakes port 1, which runs in the same pass */
+	clear_run_log();
+	start = get_time().val;
+	kick_port = PORT1;
+	pd_task_set_event(PORT0, PD_EVENT_CC);
+	msleep(1);
+
+	TEST_EQ(kick_port, -1, "%d");
+	TEST_ASSERT(find_run(PORT1, kick_time, &t));
+	TEST_ASSERT(t < deadline);
+	TEST_ASSERT(t - start < MSEC);
+	TEST_ASSERT(port_deadline[PORT1] != deadline);
+	TEST_EQ(wrong_port, 0, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_per_port_deadlines(void)
+{
+	uint64_t deadline0, deadline1, sent, t;
+
+	run_both_ports();
+	deadline0 = port_deadline[PORT0];
+
+	/* An event for port 1 moves only its deadline */
+	msleep(2);
+	clear_run_log();
+	sent = get_time().val;
+	pd_task_set_event(PORT1, PD_EVENT_CC);
+	msleep(1);
+	TEST_ASSERT(port_deadline[PORT0] == deadline0);
+	TEST_ASSERT(find_run(PORT1, sent, &t));
+	deadline1 = port_deadline[PORT1];
+	TEST_ASSERT(deadline1 > deadline0);
+
+	/* Each port then runs at its own deadline, and not before */
+	msleep(2 * EVENT_TIMEOUT / MSEC);
+	TEST_ASSERT(find_run(PORT0, sent, &t));
+	TEST_ASSERT(t >= deadline0);
+	TEST_ASSERT(find_run(PORT1, t + 1, &t));
+	TEST_ASSERT(t >= deadline1);
+
+	return EC_SUCCESS;
+}
+
+static int test_disabled_port(void)
+{
+	pd_set_suspend(PORT1, 1);
+	TEST_ASSERT(!pd_is_port_enabled(PORT1));
+	TEST_ASSERT(pd_is_port_enabled(PORT0));
+
+	/* A disabled port has no deadline, and doesn't hold up the other */
+	TEST_ASSERT(port_deadline[PORT1] == UINT64_MAX);
+	msleep(1);
+	clear_run_log();
+	msleep(50);
+	TEST_GE(runs[PORT0], 5, "%d");
+	TEST_EQ(runs[PORT1], 0, "%d");
+
+	/* It runs again once it's enabled */
+	pd_set_suspend(PORT1, 0);
+	msleep(50);
+	TEST_ASSERT(pd_is_port_enabled(PORT1));
+	TEST_ASSERT(port_deadline[PORT1] != UINT64_MAX);
+	TEST_GE(runs[PORT1], 5, "%d");
+	TEST_EQ(wrong_port, 0, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_suspend_from_other_port(void)
+{
+	run_both_ports();
+	msleep(1);
+
+	/* Port 1 suspends without waiting for its deadline */
+	suspend_port = PORT1;
+	pd_task_set_event(PORT0, PD_EVENT_CC);
+	msleep(1);
+
+	TEST_EQ(suspend_port, -1, "%d");
+	TEST_ASSERT(!pd_is_port_enabled(PORT1));
+	TEST_ASSERT(port_deadline[PORT1] == UINT64_MAX);
+	TEST_ASSERT(pd_is_port_enabled(PORT0));
+
+	pd_set_suspend(PORT1, 0);
+
+	return EC_SUCCESS;
+}
+
+static int test_latency_both_busy(void)
+{
+	uint64_t sent, t;
+	int latency, max = 0, total = 0;
+	int i;
+
+	busy_us = BUSY_US;
+	for (i = 0; i < LATENCY_SAMPLES; i++) {
+		msleep(2);
+		clear_run_log();
+
+		/* Port 1 waits for port 0's pass */
+		sent = get_time().val;
+		pd_task_set_event(PORT0, PD_EVENT_CC);
+		pd_task_set_event(PORT1, PD_EVENT_CC);
+		msleep(3);
+
+		TEST_ASSERT(find_run(PORT0, sent, &t));
+		TEST_ASSERT(find_run(PORT1, sent, &t));
+		latency = t - sent;
+		TEST_GE(latency, BUSY_US, "%d");
+		max = MAX(max, latency);
+		total += latency;
+	}
+	busy_us = 0;
+
+	ccprintf("Port 1 event latency with both ports busy: "
+		 "avg %d us, max %d us\n", total / LATENCY_SAMPLES, max);
+
+	/* At most a pass over each port, with slack for the host */
+	TEST_LT(max, 2 * BUSY_US + EVENT_TIMEOUT, "%d");
+
+	return EC_SUCCESS;
+}
+
+void before_test(void)
+{
+	mock_usb_mux_reset();
+	mock_tcpc_reset();
+	mock_tcpc.callbacks.get_cc = count_run;
+
+	busy_us = 0;
+	kick_port = -1;
+	suspend_port = -1;
+	wrong_port = 0;
+
+	/* Restart the PD task and let it settle */
+	task_set_event(TASK_ID_PD_C0, TASK_EVENT_RESET_DONE);
+	task_wait_event(SECOND);
+}
+
+void run_test(int argc, char **argv)
+{
+	test_reset();
+
+	RUN_TEST(test_ports_share_task);
+	RUN_TEST(test_cross_port_event);
+	RUN_TEST(test_per_port_deadlines);
+	RUN_TEST(test_disabled_port);
+	RUN_TEST(test_suspend_from_other_port);
+	RUN_TEST(test_latency_both_busy);
+
+	test_print_result();
+}
@@ -0,0 +1,146 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Tests for the USB PD per-port timer service.
+ */
+
+#include "common.h"
+#include "test_util.h"
+#include "timer.h"
+#include "usb_pd_timer.h"
+#include "util.h"
+
+#define PORT0 0
+#define PORT1 1
+
+static int test_initial_state(void)
+{
+	int timer;
+
+	pd_timer_init(PORT0);
+
+	/* Every timer starts out expired, as if it had been started at 0 */
+	for (timer = 0; timer < PD_TIMER_COUNT; timer++) {
+		TEST_ASSERT(pd_timer_is_expired(PORT0, timer));
+		TEST_ASSERT(!pd_timer_is_disabled(PORT0, timer));
+	}
+	TEST_EQ(pd_timer_next_expiration(PORT0), -1, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_enable_expire(void)
+{
+	int next;
+
+	pd_timer_init(PORT0);
+
+	pd_timer_enable(PORT0, TC_TIMER_TIMEOUT, 1000);
+	TEST_ASSERT(!pd_timer_is_expired(PORT0, TC_TIMER_TIMEOUT));
+	TEST_ASSERT(!pd_timer_is_disabled(PORT0, TC_TIMER_TIMEOUT));
+
+	next = pd_timer_next_expiration(PORT0);
+	TEST_ASSERT(next > 0 && next <= 1000);
+
+	udelay(1000);
+	TEST_ASSERT(pd_timer_is_expired(PORT0, TC_TIMER_TIMEOUT));
+	TEST_EQ(pd_timer_next_expiration(PORT0), -1, "%d");
+
+	/* A timer started with no time left has already expired */
+	pd_timer_enable(PORT0, PE_TIMER_SENDER_RESPONSE, 0);
+	TEST_ASSERT(pd_timer_is_expired(PORT0, PE_TIMER_SENDER_RESPONSE));
+	TEST_EQ(pd_timer_next_expiration(PORT0), -1, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_disable(void)
+{
+	pd_timer_init(PORT0);
+
+	pd_timer_disable(PORT0, PE_TIMER_NO_RESPONSE);
+	TEST_ASSERT(pd_timer_is_disabled(PORT0, PE_TIMER_NO_RESPONSE));
+	TEST_ASSERT(!pd_timer_is_expired(PORT0, PE_TIMER_NO_RESPONSE));
+	TEST_EQ(pd_timer_next_expiration(PORT0), -1, "%d");
+
+	/* Disabling a running timer stops it */
+	pd_timer_enable(PORT0, PE_TIMER_NO_RESPONSE, 500);
+	TEST_ASSERT(!pd_timer_is_disabled(PORT0, PE_TIMER_NO_RESPONSE));
+	pd_timer_disable(PORT0, PE_TIMER_NO_RESPONSE);
+	udelay(500);
+	TEST_ASSERT(!pd_timer_is_expired(PORT0, PE_TIMER_NO_RESPONSE));
+	TEST_EQ(pd_timer_next_expiration(PORT0), -1, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_next_expiration(void)
+{
+	int next;
+
+	pd_timer_init(PORT0);
+
+	pd_timer_enable(PORT0, PR_TIMER_SINK_TX, 3000);
+	pd_timer_enable(PORT0, TC_TIMER_CC_DEBOUNCE, 1000);
+	pd_timer_enable(PORT0, PE_TIMER_SOURCE_CAP, 2000);
+
+	next = pd_timer_next_expiration(PORT0);
+	TEST_ASSERT(next > 0 && next <= 1000);
+
+	/* Restarting a timer for longer pushes its deadline back */
+	pd_timer_enable(PORT0, TC_TIMER_CC_DEBOUNCE, 5000);
+	udelay(1000);
+	TEST_ASSERT(!pd_timer_is_expired(PORT0, TC_TIMER_CC_DEBOUNCE));
+	next = pd_timer_next_expiration(PORT0);
+	TEST_ASSERT(next > 0 && next <= 1000);
+
+	udelay(1000);
+	TEST_ASSERT(pd_timer_is_expired(PORT0, PE_TIMER_SOURCE_CAP));
+	next = pd_timer_next_expiration(PORT0);
+	TEST_ASSERT(next > 0 && next <= 1000);
+
+	/* A stopped timer doesn't hold up the next expiration for long */
+	pd_timer_disable(PORT0, PR_TIMER_SINK_TX);
+	udelay(1000);
+	next = pd_timer_next_expiration(PORT0);
+	TEST_ASSERT(next > 1000 && next <= 2000);
+
+	udelay(2000);
+	TEST_ASSERT(pd_timer_is_expired(PORT0, TC_TIMER_CC_DEBOUNCE));
+	TEST_EQ(pd_timer_next_expiration(PORT0), -1, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_ports(void)
+{
+	pd_timer_init(PORT0);
+	pd_timer_init(PORT1);
+
+	pd_timer_enable(PORT0, PE_TIMER_VCONN_ON, 1000);
+	pd_timer_disable(PORT1, PE_TIMER_VCONN_ON);
+
+	TEST_ASSERT(!pd_timer_is_expired(PORT0, PE_TIMER_VCONN_ON));
+	TEST_ASSERT(pd_timer_is_disabled(PORT1, PE_TIMER_VCONN_ON));
+	TEST_EQ(pd_timer_next_expiration(PORT1), -1, "%d");
+
+	udelay(1000);
+	TEST_ASSERT(pd_timer_is_expired(PORT0, PE_TIMER_VCONN_ON));
+	TEST_ASSERT(!pd_timer_is_expired(PORT1, PE_TIMER_VCONN_ON));
+
+	return EC_SUCCESS;
+}
+
+void run_test(int argc, char **argv)
+{
+	test_reset();
+
+	RUN_TEST(test_initial_state);
+	RUN_TEST(test_enable_expire);
+	RUN_TEST(test_disable);
+	RUN_TEST(test_next_expiration);
+	RUN_TEST(test_ports);
+
+	test_print_result();
+}
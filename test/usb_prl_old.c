@@ -6,6 +6,8 @@
  */
 #include "common.h"
 #include "crc.h"
+#include "ec_commands.h"
+#include "printf.h"
 #include "task.h"
 #include "tcpm/tcpm.h"
 #include "test_util.h"
@@ -13,6 +15,7 @@
 #include "usb_emsg.h"
 #include "usb_pd_test_util.h"
 #include "usb_pd.h"
+#include "usb_pd_trace.h"
 #include "usb_pe_sm.h"
 #include "usb_prl_sm.h"
 #include "usb_sm_checks.h"
@@ -1255,6 +1258,160 @@ static int test_phy_execute_hard_reset_msg(void)
 	return EC_SUCCESS;
 }
 
+#ifdef CONFIG_USB_PD_TRACE
+/* Read the trace from seq on, as the AP would */
+static int read_trace(int port, uint32_t seq, struct ec_response_pd_trace *r,
+		      int size)
+{
+	struct ec_params_pd_trace p = {
+		.port = port,
+		.seq = seq,
+	};
+
+	return test_send_host_command(EC_CMD_PD_TRACE, 0, &p, sizeof(p),
+				      r, size);
+}
+
+static int test_trace(void)
+{
+	int port = PORT0;
+	uint8_t buf[sizeof(struct ec_response_pd_trace) +
+		    CONFIG_USB_PD_TRACE * sizeof(struct ec_pd_trace_record)];
+	struct ec_response_pd_trace *r = (struct ec_response_pd_trace *)buf;
+	const struct ec_pd_trace_record *t = r->records;
+	uint16_t header;
+	uint32_t seq;
+	int i;
+
+	enable_prl(port, 1);
+
+	task_wake(PD_PORT_TO_TASK_ID(port));
+	task_wait_event(40 * MSEC);
+
+	/* Skip what earlier tests left in the trace */
+	TEST_EQ(read_trace(port, 0, r, sizeof(buf)), EC_RES_SUCCESS, "%d");
+	seq = r->next_seq;
+	TEST_EQ(r->first_seq + r->count, seq, "%d");
+	TEST_LE(r->count, CONFIG_USB_PD_TRACE, "%d");
+
+	/* A message sent and acknowledged */
+	header = PD_HEADER(PD_CTRL_ACCEPT, pd_port[port].power_role,
+			   pd_port[port].data_role, pd_port[port].msg_tx_id,
+			   0, pd_port[port].rev, 0);
+	TEST_NE(simulate_send_ctrl_msg_request_from_pe(port,
+			TCPC_TX_SOP, PD_CTRL_ACCEPT), 0, "%d");
+	cycle_through_state_machine(port, 1, MSEC);
+	simulate_goodcrc(port, pd_port[port].power_role,
+			 pd_port[port].msg_tx_id);
+	inc_tx_id(port);
+	cycle_through_state_machine(port, 10, MSEC);
+
+	/* A message received */
+	TEST_NE(simulate_receive_data(port, PD_DATA_BATTERY_STATUS, 8), 0,
+		"%d");
+
+	/* Hard Reset signaling received */
+	pd_execute_hard_reset(port);
+	cycle_through_state_machine(port, 1, 10 * MSEC);
+	prl_hard_reset_complete(port);
+	cycle_through_state_machine(port, 1, 10 * MSEC);
+
+	TEST_EQ(read_trace(port, seq, r, sizeof(buf)), EC_RES_SUCCESS, "%d");
+	TEST_EQ(r->first_seq, seq, "%d");
+	TEST_EQ(r->count, 3, "%d");
+	TEST_EQ(r->next_seq, seq + 3, "%d");
+
+	TEST_EQ(t[0].event, EC_PD_TRACE_TX_SUCCESS, "%d");
+	TEST_EQ(t[0].sop, TCPC_TX_SOP, "%d");
+	TEST_EQ(t[0].header, header, "0x%04x");
+
+	TEST_EQ(t[1].event, EC_PD_TRACE_RX, "%d");
+	TEST_EQ(t[1].sop, TCPC_TX_SOP, "%d");
+	TEST_EQ(PD_HEADER_TYPE(t[1].header), PD_DATA_BATTERY_STATUS, "%d");
+	TEST_EQ(PD_HEADER_CNT(t[1].header), 2, "%d");
+	TEST_EQ(t[1].data[0], test_data[0], "0x%08x");
+	TEST_EQ(t[1].data[1], test_data[1], "0x%08x");
+	TEST_EQ(t[1].data[2], 0, "0x%08x");
+	TEST_GE(t[1].time_lo, t[0].time_lo, "%u");
+
+	TEST_EQ(t[2].event, EC_PD_TRACE_RX, "%d");
+	TEST_EQ(t[2].sop, TCPC_TX_HARD_RESET, "%d");
+
+	/* Nothing more to read */
+	seq = r->next_seq;
+	TEST_EQ(read_trace(port, seq, r, sizeof(buf)), EC_RES_SUCCESS, "%d");
+	TEST_EQ(r->count, 0, "%d");
+	TEST_EQ(r->next_seq, seq, "%d");
+
+	/* Messages overwritten before they're read are skipped */
+	for (i = 0; i < CONFIG_USB_PD_TRACE + 2; i++) {
+		TEST_NE(simulate_receive_data(port, PD_DATA_BATTERY_STATUS, 4),
+			0, "%d");
+		task_wake(PD_PORT_TO_TASK_ID(port));
+		task_wait_event(40 * MSEC);
+	}
+	TEST_EQ(read_trace(port, seq, r, sizeof(buf)), EC_RES_SUCCESS, "%d");
+	TEST_EQ(r->first_seq, seq + 3, "%d");
+	TEST_EQ(r->count, CONFIG_USB_PD_TRACE - 1, "%d");
+	TEST_EQ(r->next_seq, seq + CONFIG_USB_PD_TRACE + 2, "%d");
+
+	/*
+	 * The record in the slot the next message goes in isn't returned,
+	 * even when asked for, since it may be partly overwritten.
+	 */
+	TEST_EQ(read_trace(port, seq + 2, r, sizeof(buf)), EC_RES_SUCCESS,
+		"%d");
+	TEST_EQ(r->first_seq, seq + 3, "%d");
+
+	/* Records are read in pages as large as the response allows */
+	TEST_EQ(read_trace(port, seq + 4, r, sizeof(*r) + 3 * sizeof(*t)),
+		EC_RES_SUCCESS, "%d");
+	TEST_EQ(r->first_seq, seq + 4, "%d");
+	TEST_EQ(r->count, 3, "%d");
+	TEST_EQ(r->next_seq, seq + 7, "%d");
+
+	enable_prl(port, 0);
+
+	return EC_SUCCESS;
+}
+
+#define BENCH_MESSAGES 10000
+
+/*
+ * Compare tracing a received message with formatting it the way the
+ * Protocol Layer prints it at debug level 2.
+ */
+static int test_trace_benchmark(void)
+{
+	const uint16_t header = PD_HEADER(PD_DATA_SOURCE_CAP, PD_ROLE_SOURCE,
+					  PD_ROLE_DFP, 0, 7, PD_REV30, 0);
+	uint64_t start, trace_ns, print_ns;
+	char line[128];
+	int i, p, n;
+
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < BENCH_MESSAGES; i++)
+		pd_trace_rx(PORT0, TCPC_TX_SOP, header, test_data);
+	trace_ns = test_get_wall_clock_ns() - start;
+
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < BENCH_MESSAGES; i++) {
+		n = snprintf(line, sizeof(line), "C%d: RECV %04x/%d ", PORT0,
+			     header, PD_HEADER_CNT(header));
+		for (p = 0; p < PD_HEADER_CNT(header); p++)
+			n += snprintf(line + n, sizeof(line) - n,
+				      "[%d]%08x ", p, test_data[p]);
+	}
+	print_ns = test_get_wall_clock_ns() - start;
+
+	ccprintf("%d messages: traced %d ns/message, formatted %d ns/message\n",
+		 BENCH_MESSAGES, (int)(trace_ns / BENCH_MESSAGES),
+		 (int)(print_ns / BENCH_MESSAGES));
+
+	return EC_SUCCESS;
+}
+#endif /* CONFIG_USB_PD_TRACE */
+
 /* Reset the state machine between each test */
 void before_test(void)
 {
@@ -1309,6 +1466,10 @@ void run_test(int argc, char **argv)
 	RUN_TEST(test_send_soft_reset_msg);
 	RUN_TEST(test_pe_execute_hard_reset_msg);
 	RUN_TEST(test_phy_execute_hard_reset_msg);
+#ifdef CONFIG_USB_PD_TRACE
+	RUN_TEST(test_trace);
+	RUN_TEST(test_trace_benchmark);
+#endif
 
 	/* TODO(shurst): More PD 3.0 Tests */
 
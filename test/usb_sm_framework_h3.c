@@ -5,6 +5,7 @@
  * Test USB Type-C VPD and CTVPD module.
  */
 #include "common.h"
+#include "console.h"
 #include "task.h"
 #include "test_util.h"
 #include "timer.h"
@@ -963,6 +964,127 @@ static const struct usb_state states[] = {
 	},
 };
 
+/*
+ * Benchmark states: two leaves in separate hierarchies as deep as the test's,
+ * so that every transition exits and enters every level.
+ */
+#if defined(TEST_AT_LEAST_3)
+#define BENCH_DEPTH 4
+#elif defined(TEST_AT_LEAST_2)
+#define BENCH_DEPTH 3
+#elif defined(TEST_AT_LEAST_1)
+#define BENCH_DEPTH 2
+#else
+#define BENCH_DEPTH 1
+#endif
+
+#define BENCH_TRANSITIONS 1000000
+
+enum bench_state {
+	BENCH_SUPER_A1,
+	BENCH_SUPER_A2,
+	BENCH_SUPER_A3,
+	BENCH_SUPER_B1,
+	BENCH_SUPER_B2,
+	BENCH_SUPER_B3,
+	BENCH_A,
+	BENCH_B,
+};
+
+static int bench_calls;
+
+static void bench_count(const int port)
+{
+	bench_calls++;
+}
+
+#define BENCH_STATE(p) {		\
+		.entry  = bench_count,	\
+		.run    = bench_count,	\
+		.exit   = bench_count,	\
+		.parent = p,		\
+	}
+
+static const struct usb_state bench_states[] = {
+	[BENCH_SUPER_A1] = BENCH_STATE(NULL),
+	[BENCH_SUPER_B1] = BENCH_STATE(NULL),
+#ifdef TEST_AT_LEAST_3
+	[BENCH_SUPER_A2] = BENCH_STATE(&bench_states[BENCH_SUPER_A1]),
+	[BENCH_SUPER_B2] = BENCH_STATE(&bench_states[BENCH_SUPER_B1]),
+#else
+	[BENCH_SUPER_A2] = BENCH_STATE(NULL),
+	[BENCH_SUPER_B2] = BENCH_STATE(NULL),
+#endif
+#ifdef TEST_AT_LEAST_2
+	[BENCH_SUPER_A3] = BENCH_STATE(&bench_states[BENCH_SUPER_A2]),
+	[BENCH_SUPER_B3] = BENCH_STATE(&bench_states[BENCH_SUPER_B2]),
+#else
+	[BENCH_SUPER_A3] = BENCH_STATE(NULL),
+	[BENCH_SUPER_B3] = BENCH_STATE(NULL),
+#endif
+#ifdef TEST_AT_LEAST_1
+	[BENCH_A] = BENCH_STATE(&bench_states[BENCH_SUPER_A3]),
+	[BENCH_B] = BENCH_STATE(&bench_states[BENCH_SUPER_B3]),
+#else
+	[BENCH_A] = BENCH_STATE(NULL),
+	[BENCH_B] = BENCH_STATE(NULL),
+#endif
+};
+
+test_static int test_benchmark(void)
+{
+	struct sm_ctx ctx = { 0 };
+	uint64_t start, ns;
+	int i;
+
+	bench_calls = 0;
+	start = test_get_wall_clock_ns();
+	for (i = 0; i < BENCH_TRANSITIONS; i++) {
+		set_state(PORT0, &ctx,
+			  &bench_states[i & 1 ? BENCH_B : BENCH_A]);
+		run_state(PORT0, &ctx);
+	}
+	ns = test_get_wall_clock_ns() - start;
+	set_state(PORT0, &ctx, NULL);
+
+	ccprintf("Depth %d: %d transitions/s\n", BENCH_DEPTH,
+		 (int)(BENCH_TRANSITIONS * 1000000000ULL / MAX(ns, 1)));
+
+	/* Each state is entered, run and exited once per visit */
+	TEST_EQ(bench_calls, 3 * BENCH_DEPTH * BENCH_TRANSITIONS, "%d");
+
+	return EC_SUCCESS;
+}
+
+/* A chain of states one deeper than the framework supports */
+static const struct usb_state deep_states[USB_SM_MAX_DEPTH + 1] = {
+	BENCH_STATE(NULL),
+	BENCH_STATE(&deep_states[0]),
+	BENCH_STATE(&deep_states[1]),
+	BENCH_STATE(&deep_states[2]),
+	BENCH_STATE(&deep_states[3]),
+};
+BUILD_ASSERT(USB_SM_MAX_DEPTH == 4);
+
+test_static int test_too_deep(void)
+{
+	struct sm_ctx ctx = { 0 };
+
+	/* The transition is refused, so nothing is exited or entered */
+	bench_calls = 0;
+	set_state(PORT0, &ctx, &bench_states[BENCH_A]);
+	set_state(PORT0, &ctx, &deep_states[USB_SM_MAX_DEPTH]);
+	TEST_EQ(bench_calls, BENCH_DEPTH, "%d");
+	TEST_ASSERT(ctx.current == &bench_states[BENCH_A]);
+
+	/* Entering the deepest supported state still works */
+	set_state(PORT0, &ctx, &deep_states[USB_SM_MAX_DEPTH - 1]);
+	TEST_EQ(bench_calls, 2 * BENCH_DEPTH + USB_SM_MAX_DEPTH, "%d");
+	TEST_ASSERT(ctx.current == &deep_states[USB_SM_MAX_DEPTH - 1]);
+
+	return EC_SUCCESS;
+}
+
 /* Run before each RUN_TEST line */
 void before_test(void)
 {
@@ -998,5 +1120,7 @@ void run_test(int argc, char **argv)
 #else
 	RUN_TEST(test_hierarchy_0);
 #endif
+	RUN_TEST(test_benchmark);
+	RUN_TEST(test_too_deep);
 	test_print_result();
 }
@@ -0,0 +1,246 @@
+/* Copyright 2021 The Chromium OS Authors. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Test the TCPCI driver reading received messages into the RX cache.
+ */
+
+#include "common.h"
+#include "mock/tcpci_i2c_mock.h"
+#include "mock/usb_mux_mock.h"
+#include "task.h"
+#include "tcpci.h"
+#include "tcpm/tcpm.h"
+#include "test_util.h"
+#include "timer.h"
+#include "usb_mux.h"
+#include "usb_pd.h"
+#include "usb_tc_sm.h"
+
+#define PORT0 0
+
+struct tcpc_config_t tcpc_config[CONFIG_USB_PD_PORT_MAX_COUNT] = {
+	{
+		.bus_type = EC_BUS_TYPE_I2C,
+		.i2c_info = {
+			.port = I2C_PORT_HOST_TCPC,
+			.addr_flags = MOCK_TCPCI_I2C_ADDR_FLAGS,
+		},
+		.drv = &tcpci_tcpm_drv,
+		.flags = TCPC_FLAGS_TCPCI_REV2_0,
+	},
+};
+
+const struct usb_mux usb_muxes[CONFIG_USB_PD_PORT_MAX_COUNT] = {
+	{
+		.driver = &mock_usb_mux_driver,
+	}
+};
+
+/* The tests service alerts themselves */
+uint16_t tcpc_get_alert_status(void)
+{
+	return 0;
+}
+
+bool vboot_allow_usb_pd(void)
+{
+	return 1;
+}
+
+int pd_check_vconn_swap(int port)
+{
+	return 1;
+}
+
+void board_reset_pd_mcu(void) {}
+
+static uint32_t payload[7] = {
+	0xff008001, 0x11223344, 0x55667788, 0x99aabbcc,
+	0xddeeff00, 0x01020304, 0x05060708,
+};
+
+static uint16_t vdm_header(int id, int cnt)
+{
+	return PD_HEADER(PD_DATA_VENDOR_DEF, PD_ROLE_SOURCE, PD_ROLE_DFP, id,
+			 cnt, PD_REV30, 0);
+}
+
+/*
+ * Have the TCPC receive messages, as it would while the alert is pending.
+ * The first message received sets RX status.
+ */
+static void receive_vdms(int first_id, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		mock_tcpci_receive(PD_MSG_SOP, vdm_header(first_id + i, 7),
+				   payload);
+		mock_tcpci_set_reg_bits(TCPC_REG_ALERT,
+					TCPC_REG_ALERT_RX_STATUS);
+	}
+}
+
+/*
+ * Service the alert, and return how many I2C transactions that took.
+ * Besides reading messages, that's reading ALERT, and reading the masks to
+ * check whether the TCPC has reset.
+ */
+#define ALERT_XFERS 3
+
+static int service_alert(void)
+{
+	int xfers = mock_tcpci_get_xfer_count();
+
+	tcpci_tcpc_alert(PORT0);
+
+	return mock_tcpci_get_xfer_count() - xfers;
+}
+
+static int verify_vdm(int id)
+{
+	uint32_t data[7];
+	int header;
+
+	TEST_ASSERT(tcpm_has_pending_message(PORT0));
+	TEST_EQ(tcpm_dequeue_message(PORT0, data, &header), EC_SUCCESS,
+		"%d");
+	TEST_EQ(header, vdm_header(id, 7) | PD_HEADER_SOP(PD_MSG_SOP),
+		"0x%x");
+	TEST_ASSERT_ARRAY_EQ(data, payload, ARRAY_SIZE(payload));
+
+	return EC_SUCCESS;
+}
+
+static int test_rx_burst(void)
+{
+	struct tcpm_rx_cache_stats stats;
+	int i;
+
+	receive_vdms(0, 3);
+
+	/*
+	 * For each message, one transaction to read it, one to clear RX status
+	 * and one to read ALERT again.
+	 */
+	TEST_EQ(service_alert(), ALERT_XFERS + 3 * 3, "%d");
+	TEST_EQ(mock_tcpci_get_reg(TCPC_REG_ALERT), 0, "0x%x");
+
+	for (i = 0; i < 3; i++)
+		TEST_EQ(verify_vdm(i), EC_SUCCESS, "%d");
+	TEST_ASSERT(!tcpm_has_pending_message(PORT0));
+
+	tcpm_get_rx_cache_stats(PORT0, &stats);
+	TEST_EQ(stats.high_water, 3, "%d");
+	TEST_EQ(stats.dropped, 0, "%d");
+	TEST_EQ(stats.tcpc_overflows, 0, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_rx_burst_rev1(void)
+{
+	uint32_t data[7];
+	int header;
+
+	/* The registers are at the same place in Rev 1.0 */
+	tcpc_config[PORT0].flags = 0;
+
+	mock_tcpci_receive(PD_MSG_SOP_PRIME, vdm_header(0, 2), payload);
+	mock_tcpci_set_reg_bits(TCPC_REG_ALERT, TCPC_REG_ALERT_RX_STATUS);
+	TEST_EQ(service_alert(), ALERT_XFERS + 3, "%d");
+
+	TEST_EQ(tcpm_dequeue_message(PORT0, data, &header), EC_SUCCESS,
+		"%d");
+	TEST_EQ(header, vdm_header(0, 2) | PD_HEADER_SOP(PD_MSG_SOP_PRIME),
+		"0x%x");
+	TEST_ASSERT_ARRAY_EQ(data, payload, 2);
+
+	tcpc_config[PORT0].flags = TCPC_FLAGS_TCPCI_REV2_0;
+
+	return EC_SUCCESS;
+}
+
+static int test_rx_cache_full(void)
+{
+	struct tcpm_rx_cache_stats stats;
+	int i;
+
+	receive_vdms(0, CONFIG_USB_PD_TCPM_RX_CACHE_DEPTH);
+	service_alert();
+
+	/*
+	 * Messages the cache has no room for are still read from the TCPC,
+	 * so they don't hold up the port, and are dropped.
+	 */
+	receive_vdms(CONFIG_USB_PD_TCPM_RX_CACHE_DEPTH, 2);
+	service_alert();
+	TEST_EQ(mock_tcpci_get_reg(TCPC_REG_ALERT), 0, "0x%x");
+	TEST_ASSERT(pd_is_port_enabled(PORT0));
+
+	for (i = 0; i < CONFIG_USB_PD_TCPM_RX_CACHE_DEPTH; i++)
+		TEST_EQ(verify_vdm(i), EC_SUCCESS, "%d");
+	TEST_ASSERT(!tcpm_has_pending_message(PORT0));
+
+	tcpm_get_rx_cache_stats(PORT0, &stats);
+	TEST_EQ(stats.high_water, CONFIG_USB_PD_TCPM_RX_CACHE_DEPTH, "%d");
+	TEST_EQ(stats.dropped, 2, "%d");
+	TEST_EQ(stats.tcpc_overflows, 0, "%d");
+
+	/* The cache is usable again once it's been emptied */
+	receive_vdms(0, 1);
+	service_alert();
+	TEST_EQ(verify_vdm(0), EC_SUCCESS, "%d");
+
+	return EC_SUCCESS;
+}
+
+static int test_rx_tcpc_overflow(void)
+{
+	struct tcpm_rx_cache_stats stats;
+	int i;
+
+	/* The mock TCPC holds 4 messages, so it drops the last one */
+	receive_vdms(0, 5);
+	TEST_ASSERT(mock_tcpci_get_reg(TCPC_REG_ALERT) &
+		    TCPC_REG_ALERT_RX_BUF_OVF);
+	service_alert();
+	TEST_EQ(mock_tcpci_get_reg(TCPC_REG_ALERT), 0, "0x%x");
+
+	for (i = 0; i < 4; i++)
+		TEST_EQ(verify_vdm(i), EC_SUCCESS, "%d");
+	TEST_ASSERT(!tcpm_has_pending_message(PORT0));
+
+	tcpm_get_rx_cache_stats(PORT0, &stats);
+	TEST_EQ(stats.high_water, 4, "%d");
+	TEST_EQ(stats.dropped, 0, "%d");
+	TEST_EQ(stats.tcpc_overflows, 1, "%d");
+
+	return EC_SUCCESS;
+}
+
+void before_test(void)
+{
+	mock_usb_mux_reset();
+	mock_tcpci_reset();
+
+	/* Keep the PD task from handling the messages */
+	tc_pause_event_loop(PORT0);
+	task_wait_event(10 * MSEC);
+
+	tcpm_clear_pending_messages(PORT0);
+	tcpm_clear_rx_cache_stats(PORT0);
+}
+
+void run_test(int argc, char **argv)
+{
+	test_reset();
+
+	RUN_TEST(test_rx_burst);
+	RUN_TEST(test_rx_burst_rev1);
+	RUN_TEST(test_rx_cache_full);
+	RUN_TEST(test_rx_tcpc_overflow);
+
+	test_print_result();
+}
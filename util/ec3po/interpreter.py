@@ -22,6 +22,7 @@ import copy
 import logging
 import os
 import select
+import time
 import traceback
 
 import six
@@ -31,6 +32,10 @@ COMMAND_RETRIES = 3  # Number of attempts to retry a command.
 EC_MAX_READ = 1024  # Max bytes to read at a time from the EC.
 EC_SYN = b'\xec'  # Byte indicating EC interrogation.
 EC_ACK = b'\xc0'  # Byte representing correct EC response to interrogation.
+EC_BATCH_SYN = b'\xea'  # Byte asking if the EC supports batches of commands.
+EC_BATCH_ACK = b'\xca'  # Response to EC_BATCH_SYN, then the max batch size.
+EC_BATCH = b'\xeb'  # Byte starting a batch of commands.
+BATCH_TIMEOUT = 5  # Seconds to wait for more output from a batch.
 
 
 class LoggerAdapter(logging.LoggerAdapter):
@@ -77,6 +82,18 @@ class Interpreter(object):
       the EC.
     connected: A boolean indicating if the interpreter is actually connected to
       the UART and listening.
+    batch_size: An integer with the largest batch of commands the EC accepts,
+      0 if it doesn't support batches, or None if it hasn't been asked yet.
+    batch_probing: A boolean indicating if we have asked the EC whether it
+      supports batches and are waiting for the answer.
+    batches_pending: An integer with the number of batches sent whose output
+      hasn't all been received.
+    batch_data: A string of data from the EC which may be the start of a frame
+      of batch output.
+    batch_deadline: A float with the time by which more batch output must
+      arrive, after which the pending batches are given up on.
+    batch_failed: A boolean indicating if some of the output of the current
+      batch was corrupted.
   """
   def __init__(self, ec_uart_pty, cmd_pipe, dbg_pipe, log_level=logging.INFO,
                name=None):
@@ -114,6 +131,12 @@ class Interpreter(object):
     self.enhanced_ec = False
     self.interrogating = False
     self.connected = True
+    self.batch_size = None
+    self.batch_probing = False
+    self.batches_pending = 0
+    self.batch_data = b''
+    self.batch_deadline = 0
+    self.batch_failed = False
 
   def __str__(self):
     """Show internal state of the Interpreter object.
@@ -134,6 +157,8 @@ class Interpreter(object):
     string.append('last_cmd: \'%s\'' % self.last_cmd)
     string.append('enhanced_ec: %r' % self.enhanced_ec)
     string.append('interrogating: %r' % self.interrogating)
+    string.append('batch_size: %r' % self.batch_size)
+    string.append('batches_pending: %d' % self.batches_pending)
     return '\n'.join(string)
 
   def EnqueueCmd(self, command):
@@ -187,6 +212,47 @@ class Interpreter(object):
     else:
       return raw_cmd
 
+  def PackBatches(self, raw_cmds):
+    r"""Packs several commands into as few batches as the EC accepts.
+
+    The batch format is as follows:
+
+      \xeb[x][x][x][x][x][x]&{cmd}\n{cmd}...
+        ^  ^          ^^    ^^  ^-- the raw console commands, separated by
+        |  |          ||    ||      newlines.
+        |  |          ||    ||-- 1 ampersand.
+        |  |          ||____|-- 2 hex digits representing the CRC8 of the
+        |  |          |         commands.
+        |  |__________|-- 4 hex digits representing the length of the
+        |                 commands.
+        |-- EC_BATCH
+
+    Args:
+      raw_cmds: A list of strings which contain the raw commands.
+
+    Returns:
+      A list of strings which contain the packed batches.  A command which
+      doesn't fit in a batch by itself is packed with PackCommand().
+    """
+    packed = []
+    batch = []
+
+    def Flush():
+      if len(batch) == 1:
+        packed.append(self.PackCommand(batch[0]))
+      elif batch:
+        payload = b'\n'.join(batch)
+        packed.append(EC_BATCH + b'%04x%02x&' % (len(payload), Crc8(payload)) +
+                      payload)
+      del batch[:]
+
+    for raw_cmd in raw_cmds:
+      if len(b'\n'.join(batch + [raw_cmd])) > self.batch_size:
+        Flush()
+      batch.append(raw_cmd)
+    Flush()
+    return packed
+
   def ProcessCommand(self, command):
     """Captures the input determines what actions to take.
 
@@ -236,6 +302,8 @@ class Interpreter(object):
 
     elif command.startswith(b'enhanced'):
       self.enhanced_ec = command.split(b' ')[1] == b'True'
+      if not self.enhanced_ec:
+        self.batch_size = None
       return
 
     # Ignore any other commands while in the disconnected state.
@@ -269,6 +337,22 @@ class Interpreter(object):
       self.interrogating = True
       # Assume the EC isn't enhanced until we get a response.
       self.enhanced_ec = False
+    elif self.enhanced_ec and b'\n' in command:
+      # Several commands at once.  Send them in batches if the EC can take
+      # them; the first time, ask whether it can.
+      raw_cmds = [c.strip(b' ') for c in command.split(b'\n')]
+      raw_cmds = [c for c in raw_cmds if c]
+      if self.batch_size:
+        packed = self.PackBatches(raw_cmds)
+      else:
+        if self.batch_size is None and not self.batch_probing:
+          self.logger.debug('Asking if the EC supports batches.')
+          self.batch_probing = True
+          self.EnqueueCmd(EC_BATCH_SYN)
+        packed = [self.PackCommand(c) for c in raw_cmds]
+      for c in packed:
+        self.EnqueueCmd(c)
+      return
     elif self.enhanced_ec:
       # Enhanced EC images require the plaintext commands to be packed.
       command = self.PackCommand(command)
@@ -312,7 +396,11 @@ class Interpreter(object):
     self.ec_uart_pty.flush()
     self.logger.log(1, 'Sent command to EC.')
 
-    if self.enhanced_ec and cmd != EC_SYN:
+    if cmd.startswith(EC_BATCH):
+      self.batches_pending += 1
+      self.batch_deadline = time.time() + BATCH_TIMEOUT
+
+    if self.enhanced_ec and cmd not in (EC_SYN, EC_BATCH_SYN):
       # Now, that we've sent the command, store the current command as the last
       # command sent.  If we encounter an error string, we will attempt to retry
       # this command.
@@ -334,7 +422,14 @@ class Interpreter(object):
     # Read what the EC sent us.
     data = os.read(self.ec_uart_pty.fileno(), EC_MAX_READ)
     self.logger.log(1, 'got: \'%s\'', binascii.hexlify(data))
-    if b'&E' in data and self.enhanced_ec:
+
+    if self.batch_probing:
+      data = self.CheckBatchAck(data)
+
+    # Batch output comes in frames, which may hold any text, so errors are
+    # found while unpacking them.
+    batching = self.batches_pending or self.batch_data
+    if b'&E' in data and self.enhanced_ec and not batching:
       # We received an error, so we should retry it if possible.
       self.logger.warning('Error string found in data.')
       self.HandleCmdRetries()
@@ -348,12 +443,177 @@ class Interpreter(object):
         self.logger.debug('The current EC image seems enhanced.')
       else:
         self.logger.debug('The current EC image does NOT seem enhanced.')
+        # It may not support batches either.
+        self.batch_size = None
       # Done interrogating.
       self.interrogating = False
+
+    if batching:
+      self.batch_deadline = time.time() + BATCH_TIMEOUT
+      data = self.HandleBatchData(data)
+      if not data:
+        return
     # For now, just forward everything the EC sends us.
     self.logger.log(1, 'Forwarding to user...')
     self.dbg_pipe.send(data)
 
+  def CheckBatchAck(self, data):
+    """Look for the EC's answer to whether it supports batches.
+
+    Args:
+      data: A string of data from the EC.
+
+    Returns:
+      The data, without the answer.
+    """
+    pos = data.find(EC_BATCH_ACK)
+    if pos < 0 or len(data) < pos + 5:
+      return data
+    try:
+      self.batch_size = int(data[pos + 1:pos + 5], 16)
+    except ValueError:
+      return data
+    self.batch_probing = False
+    self.logger.debug('The EC supports batches of up to %d bytes.',
+                      self.batch_size)
+    return data[:pos] + data[pos + 5:]
+
+  def HandleBatchData(self, data):
+    """Unpack the output of batches of commands.
+
+    The EC replies to a batch with these frames, with numbers in hex:
+
+      &&OIILLCC&{data}  LL bytes of output from command II, with their CRC8.
+      &&RIIRRRR&        Command II finished, returning RRRR.
+      &&ZNN&            The batch is done, after NN commands.
+
+    or with &&EE if the batch was corrupted, or stalled on its way to the
+    EC.  Anything else is ordinary
+    console output.
+
+    Args:
+      data: A string of data from the EC.
+
+    Returns:
+      A string with the data to forward to the user.
+    """
+    buf = self.batch_data + data
+    out = []
+
+    while True:
+      start = buf.find(b'&&')
+      if start < 0:
+        # A trailing '&' may be the start of a frame.
+        keep = 1 if buf.endswith(b'&') else 0
+        out.append(buf[:len(buf) - keep])
+        buf = buf[len(buf) - keep:]
+        break
+      out.append(buf[:start])
+      buf = buf[start:]
+      size = self.HandleBatchFrame(buf, out)
+      if size is None:
+        # Wait for the rest of the frame.
+        break
+      if size == 0:
+        # Not a frame after all.
+        out.append(buf[:2])
+        size = 2
+      buf = buf[size:]
+
+    self.batch_data = buf
+    if not self.batches_pending and not buf.startswith(b'&&'):
+      out.append(buf)
+      self.batch_data = b''
+    return b''.join(out)
+
+  def HandleBatchFrame(self, buf, out):
+    """Handle a frame of batch output.
+
+    Args:
+      buf: A string of data from the EC, starting with '&&'.
+      out: A list of strings to forward to the user, added to if the frame has
+        command output.
+
+    Returns:
+      The length of the frame, 0 if buf doesn't start with one, or None if buf
+      may hold the start of a frame.
+    """
+    sizes = {b'E': 4, b'O': 10, b'R': 10, b'Z': 6}
+    if len(buf) < 3:
+      return None
+    kind = buf[2:3]
+    if kind not in sizes:
+      return 0
+    size = sizes[kind]
+    if len(buf) < size:
+      return None
+
+    if kind == b'E':
+      if buf[3:4] != b'E':
+        return 0
+      self.logger.warning('Error string found in data.')
+      self.batches_pending = max(self.batches_pending - 1, 0)
+      self.batch_failed = False
+      self.HandleCmdRetries()
+      return size
+
+    try:
+      numbers = int(buf[3:size - 1], 16)
+    except ValueError:
+      return 0
+    if buf[size - 1:size] != b'&':
+      return 0
+
+    if kind == b'O':
+      length = (numbers >> 8) & 0xff
+      if len(buf) < size + length:
+        return None
+      output = buf[size:size + length]
+      if Crc8(output) != numbers & 0xff:
+        # Drop the output, and send the batch again once it's done.
+        self.logger.warning('Bad checksum on output of command %d.',
+                            numbers >> 16)
+        self.batch_failed = True
+      else:
+        out.append(output)
+      return size + length
+
+    if kind == b'R':
+      if numbers & 0xffff:
+        self.logger.debug('Command %d returned %d.', numbers >> 16,
+                          numbers & 0xffff)
+    else:
+      self.batches_pending = max(self.batches_pending - 1, 0)
+      if self.batch_failed:
+        self.batch_failed = False
+        self.HandleCmdRetries()
+    return size
+
+  def BatchTimeout(self):
+    """Returns how long to wait for more batch output.
+
+    Returns:
+      The number of seconds until the pending batches time out, or None if
+      there are none.
+    """
+    if not self.batches_pending:
+      return None
+    return max(self.batch_deadline - time.time(), 0)
+
+  def CheckBatchTimeout(self):
+    """Gives up on the pending batches if the EC has stopped replying."""
+    if not self.batches_pending or time.time() < self.batch_deadline:
+      return
+
+    self.logger.warning('Timed out waiting for batch output.')
+    self.batches_pending = 0
+    self.batch_failed = False
+    # Whatever was held back waiting for the rest of a frame isn't one.
+    if self.batch_data:
+      self.dbg_pipe.send(self.batch_data)
+      self.batch_data = b''
+    self.HandleCmdRetries()
+
   def HandleUserData(self):
     """Handle any incoming commands from the user.
 
@@ -421,7 +681,9 @@ def StartLoop(interp, shutdown_pipe=None):
         inputs = list(interp.inputs)
         inputs.append(shutdown_pipe)
 
-      readable, writeable, _ = select.select(inputs, interp.outputs, [])
+      readable, writeable, _ = select.select(inputs, interp.outputs, [],
+                                             interp.BatchTimeout())
+      interp.CheckBatchTimeout()
 
       for obj in readable:
         # Handle any debug prints from the EC.
@@ -264,6 +264,182 @@ class TestEnhancedECBehaviour(unittest.TestCase):
                      'enhanced_ec should still be False.')
 
 
+  def test_PackBatches(self):
+    """Verify that commands are packed into batches the EC can take."""
+    self.itpr.batch_size = 16
+    batches = self.itpr.PackBatches([b'rw 0x10', b'rw 0x14', b'rw 0x18',
+                                     b'a command which is too long'])
+    self.assertEqual(batches,
+                     [interpreter.EC_BATCH + b'000f%02x&rw 0x10\nrw 0x14' %
+                      interpreter.Crc8(b'rw 0x10\nrw 0x14'),
+                      self.itpr.PackCommand(b'rw 0x18'),
+                      self.itpr.PackCommand(b'a command which is too long')])
+
+  @mock.patch('interpreter.os')
+  def test_SendBatchesWhenSupported(self, mock_os):
+    """Verify that the EC is asked about batches, and sent them if it can.
+
+    Args:
+      mock_os: MagicMock object replacing the 'os' module for this test
+        case.
+    """
+    self.itpr.enhanced_ec = True
+    expected_ec_calls = [mock.call(self.tempfile.name, 'ab+')]
+
+    # The first time several commands come at once, ask the EC if it supports
+    # batches, and send the commands one at a time.
+    self.cmd_pipe_user.send(b'rw 0x10\nrw 0x14\n')
+    self.itpr.HandleUserData()
+    for cmd in [interpreter.EC_BATCH_SYN, self.itpr.PackCommand(b'rw 0x10'),
+                self.itpr.PackCommand(b'rw 0x14')]:
+      self.itpr.SendCmdToEC()
+      expected_ec_calls.extend([mock.call().write(cmd), mock.call().flush()])
+
+    # The answer isn't forwarded to the user.
+    mock_os.read.side_effect = [b'debug' + interpreter.EC_BATCH_ACK + b'0100']
+    self.itpr.HandleECData()
+    expected_ec_calls.append(mock.call().fileno())
+    self.assertEqual(self.itpr.batch_size, 0x100)
+    self.assertFalse(self.itpr.batch_probing)
+    self.assertEqual(self.dbg_pipe_user.recv(), b'debug')
+
+    # Now, send a batch.
+    self.cmd_pipe_user.send(b'rw 0x10\nrw 0x14\n')
+    self.itpr.HandleUserData()
+    self.itpr.SendCmdToEC()
+    expected_ec_calls.extend([
+        mock.call().write(self.itpr.PackBatches([b'rw 0x10', b'rw 0x14'])[0]),
+        mock.call().flush()])
+    self.assertEqual(self.itpr.batches_pending, 1)
+
+    self.ec_uart_pty.assert_has_calls(expected_ec_calls)
+
+  @mock.patch('interpreter.os')
+  def test_UnpackBatchOutput(self, mock_os):
+    """Verify that batch output is unpacked from its frames.
+
+    Args:
+      mock_os: MagicMock object replacing the 'os' module for this test
+        case.
+    """
+    self.itpr.enhanced_ec = True
+    self.itpr.batches_pending = 1
+
+    def Frame(index, output):
+      return b'&&O%02x%02x%02x&' % (index, len(output),
+                                    interpreter.Crc8(output)) + output
+
+    # Frames may be split between reads, and have other output between them.
+    # Output starting with 'E' doesn't look like an error.
+    data = (Frame(0, b'Error 1\n') + b'&&R000001&' + b'[1.000 debug]\n' +
+            Frame(1, b'& && 2\n') + b'&&R010000&&&Z02&')
+    mock_os.read.side_effect = [data[:5], data[5:24], data[24:]]
+    output = []
+    for _ in range(3):
+      self.itpr.HandleECData()
+      while self.dbg_pipe_user.poll():
+        output.append(self.dbg_pipe_user.recv())
+
+    self.assertEqual(b''.join(output), b'Error 1\n[1.000 debug]\n& && 2\n')
+    self.assertEqual(self.itpr.batches_pending, 0)
+    self.assertEqual(self.itpr.cmd_retries, interpreter.COMMAND_RETRIES)
+
+    # Once the batch is done, output is forwarded as it comes.
+    mock_os.read.side_effect = [b'&&']
+    self.itpr.HandleECData()
+    self.assertEqual(self.dbg_pipe_user.recv(), b'&&')
+
+  @mock.patch('interpreter.os')
+  def test_RetryCorruptedBatch(self, mock_os):
+    """Verify that a batch is sent again if the EC says it was corrupted.
+
+    Args:
+      mock_os: MagicMock object replacing the 'os' module for this test
+        case.
+    """
+    self.itpr.enhanced_ec = True
+    self.itpr.batch_size = 0x100
+    self.cmd_pipe_user.send(b'rw 0x10\nrw 0x14')
+    self.itpr.HandleUserData()
+    self.itpr.SendCmdToEC()
+    batch = self.itpr.last_cmd
+    self.assertTrue(batch.startswith(interpreter.EC_BATCH))
+
+    mock_os.read.side_effect = [b'&&EE\r\n']
+    self.itpr.HandleECData()
+    self.assertEqual(self.itpr.cmd_retries, interpreter.COMMAND_RETRIES - 1)
+    self.assertEqual(self.itpr.batches_pending, 0)
+    self.itpr.SendCmdToEC()
+    self.ec_uart_pty.assert_has_calls([mock.call().write(batch),
+                                       mock.call().flush(),
+                                       mock.call().fileno(),
+                                       mock.call().write(batch)])
+
+  @mock.patch('interpreter.os')
+  def test_RetryBatchWithBadOutput(self, mock_os):
+    """Verify that a batch whose output is corrupted is sent again.
+
+    Args:
+      mock_os: MagicMock object replacing the 'os' module for this test
+        case.
+    """
+    self.itpr.enhanced_ec = True
+    self.itpr.batch_size = 0x100
+    self.cmd_pipe_user.send(b'rw 0x10\nrw 0x14')
+    self.itpr.HandleUserData()
+    self.itpr.SendCmdToEC()
+
+    # The corrupted output is dropped, and the batch retried once it's done.
+    crc = interpreter.Crc8(b'ok\n') ^ 0xff
+    mock_os.read.side_effect = [b'&&O0003%02x&ok\n&&R000000&' % crc +
+                                b'&&R010000&&&Z02&']
+    self.itpr.HandleECData()
+    self.assertFalse(self.dbg_pipe_user.poll())
+    self.assertEqual(self.itpr.batches_pending, 0)
+    self.assertFalse(self.itpr.batch_failed)
+    self.assertEqual(self.itpr.cmd_retries, interpreter.COMMAND_RETRIES - 1)
+    self.assertIn(self.itpr.ec_uart_pty, self.itpr.outputs)
+
+  @mock.patch('interpreter.time')
+  @mock.patch('interpreter.os')
+  def test_BatchTimeout(self, mock_os, mock_time):
+    """Verify that a batch the EC stops replying to is given up on.
+
+    Args:
+      mock_os: MagicMock object replacing the 'os' module for this test
+        case.
+      mock_time: MagicMock object replacing the 'time' module for this test
+        case.
+    """
+    self.itpr.enhanced_ec = True
+    self.itpr.batch_size = 0x100
+    mock_time.time.return_value = 100
+    self.assertIsNone(self.itpr.BatchTimeout())
+    self.cmd_pipe_user.send(b'rw 0x10\nrw 0x14')
+    self.itpr.HandleUserData()
+    self.itpr.SendCmdToEC()
+    self.assertEqual(self.itpr.BatchTimeout(), interpreter.BATCH_TIMEOUT)
+
+    # Output from the batch pushes the deadline back.
+    mock_time.time.return_value = 103
+    mock_os.read.side_effect = [b'&&O0003%02x&ok\n&&' %
+                                interpreter.Crc8(b'ok\n')]
+    self.itpr.HandleECData()
+    self.assertEqual(self.dbg_pipe_user.recv(), b'ok\n')
+    self.itpr.CheckBatchTimeout()
+    self.assertEqual(self.itpr.batches_pending, 1)
+
+    # Once it passes, the held back data is forwarded and the batch retried.
+    mock_time.time.return_value = 103 + interpreter.BATCH_TIMEOUT
+    self.assertEqual(self.itpr.BatchTimeout(), 0)
+    self.itpr.CheckBatchTimeout()
+    self.assertEqual(self.dbg_pipe_user.recv(), b'&&')
+    self.assertEqual(self.itpr.batches_pending, 0)
+    self.assertEqual(self.itpr.batch_data, b'')
+    self.assertEqual(self.itpr.cmd_retries, interpreter.COMMAND_RETRIES - 1)
+    self.assertIsNone(self.itpr.BatchTimeout())
+
+
 class TestUARTDisconnection(unittest.TestCase):
   """Test case to verify interpreter disconnection/reconnection."""
   def setUp(self):
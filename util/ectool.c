@@ -166,10 +166,14 @@ const char help_str[] =
 	"      Set the value of GPIO signal\n"
 	"  hangdetect <flags> <event_msec> <reboot_msec> | stop | start\n"
 	"      Configure or start/stop the hang detect timer\n"
+	"  hcstats [reset]\n"
+	"      Prints host command latency statistics, optionally clearing them\n"
 	"  hello\n"
 	"      Checks for basic communication with EC\n"
 	"  hibdelay [sec]\n"
 	"      Set the delay before going into hibernation\n"
+	"  hookwake [reset]\n"
+	"      Prints hook task wakeup counts, optionally clearing them\n"
 	"  hostsleepstate\n"
 	"      Report host sleep state to the EC\n"
 	"  hostevent\n"
@@ -186,6 +190,9 @@ const char help_str[] =
 	"      Get info about USB type-C accessory attached to port\n"
 	"  inventory\n"
 	"      Return the list of supported features\n"
+	"  irqprof [reset]\n"
+	"      Prints the longest interrupt-disabled regions, optionally clearing\n"
+	"      them\n"
 	"  kbfactorytest\n"
 	"      Scan out keyboard if any pins are shorted\n"
 	"  kbid\n"
@@ -218,6 +225,9 @@ const char help_str[] =
 	"      Get PD chip information\n"
 	"  pdlog\n"
 	"      Prints the PD event log entries\n"
+	"  pdtrace <port> [<pcapng file>]\n"
+	"      Prints the USB-PD messages sent and received on <port>, or\n"
+	"      writes them to a pcapng file\n"
 	"  pdwritelog <type> <port>\n"
 	"      Writes a PD event log of the given <type>\n"
 	"  pdgetmode <port>\n"
@@ -288,6 +298,8 @@ const char help_str[] =
 	"      Run RW signature verification and get status.\n"
 	"  sertest\n"
 	"      Serial output test for COM2\n"
+	"  shmemtrace [reset]\n"
+	"      Print recent shared memory allocations and per-task peak usage\n"
 	"  smartdischarge\n"
 	"      Set/Get smart discharge parameters\n"
 	"  stress [reboot] [help]\n"
@@ -296,6 +308,8 @@ const char help_str[] =
 	"      Display system info.\n"
 	"  switches\n"
 	"      Prints current EC switch positions\n"
+	"  taskstats [reset]\n"
+	"      Prints per-task scheduler statistics, optionally clearing them\n"
 	"  temps <sensorid>\n"
 	"      Print temperature.\n"
 	"  tempsinfo <sensorid>\n"
@@ -304,6 +318,8 @@ const char help_str[] =
 	"      Get the threshold temperature values from the thermal engine.\n"
 	"  thermalset <platform-specific args>\n"
 	"      Set the threshold temperature values for the thermal engine.\n"
+	"  tlog <outfile>\n"
+	"      Save the tokenized console log; decode it with tlog_decode.py\n"
 	"  tpselftest\n"
 	"      Run touchpad self test.\n"
 	"  tpframeget\n"
@@ -562,6 +578,164 @@ int cmd_hibdelay(int argc, char *argv[])
 	return 0;
 }
 
+int cmd_hook_wake(int argc, char *argv[])
+{
+	struct ec_params_hook_wake_stats p = {0};
+	struct ec_response_hook_wake_stats r;
+	int rv;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "reset")) {
+			fprintf(stderr, "Usage: %s [reset]\n", argv[0]);
+			return -1;
+		}
+		p.flags = EC_HOOK_WAKE_STATS_RESET;
+	}
+
+	rv = ec_command(EC_CMD_HOOK_WAKE_STATS, 0, &p, sizeof(p),
+			&r, sizeof(r));
+	if (rv < 0)
+		return rv;
+
+	printf("Wakeups:   %u\n", r.wakeups);
+	printf("  Tick:      %u (slack %u us)\n", r.tick, r.tick_slack_us);
+	printf("  Second:    %u (slack %u us)\n", r.second, r.second_slack_us);
+	printf("  Deferred:  %u\n", r.deferred);
+	printf("  Coalesced: %u\n", r.coalesced);
+	printf("  Idle:      %u\n", r.idle);
+	return 0;
+}
+
+int cmd_task_stats(int argc, char *argv[])
+{
+	struct ec_params_task_sched_stats p = {0};
+	struct ec_response_task_sched_stats r;
+	int reset = 0;
+	int i, j, rv;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "reset")) {
+			fprintf(stderr, "Usage: %s [reset]\n", argv[0]);
+			return -1;
+		}
+		reset = 1;
+	}
+
+	printf("Task Name             Runtime (us) Switches   MaxLat  "
+	       "Latency <16/64/256/1k/4k/16k/64k/more us\n");
+	r.task_count = 1;
+	for (i = 0; i < r.task_count; i++) {
+		p.task_id = i;
+		rv = ec_command(EC_CMD_TASK_SCHED_STATS, 0, &p, sizeof(p),
+				&r, sizeof(r));
+		if (rv < 0)
+			return rv;
+
+		r.name[sizeof(r.name) - 1] = '\0';
+		printf("%4d %-16s %12" PRIu64 " %8u %8u ", i, r.name,
+		       r.runtime_us, r.switches, r.latency_max_us);
+		for (j = 0; j < EC_TASK_SCHED_LATENCY_BUCKETS; j++)
+			printf(" %u", r.latency[j]);
+		printf("\n");
+	}
+
+	/* Clear the statistics once all tasks have been read */
+	if (reset) {
+		p.task_id = 0;
+		p.flags = EC_TASK_SCHED_STATS_RESET;
+		rv = ec_command(EC_CMD_TASK_SCHED_STATS, 0, &p, sizeof(p),
+				&r, sizeof(r));
+		if (rv < 0)
+			return rv;
+	}
+
+	return 0;
+}
+
+int cmd_irq_profile(int argc, char *argv[])
+{
+	struct ec_params_irq_profile p = {0};
+	struct ec_response_irq_profile *r = ec_inbuf;
+	int i, rv;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "reset")) {
+			fprintf(stderr, "Usage: %s [reset]\n", argv[0]);
+			return -1;
+		}
+		p.flags = EC_IRQ_PROFILE_RESET;
+	}
+
+	rv = ec_command(EC_CMD_IRQ_PROFILE, 0, &p, sizeof(p),
+			ec_inbuf, ec_max_insize);
+	if (rv < 0)
+		return rv;
+
+	printf("Regions: %u, longest %u us\n", r->count, r->max_us);
+	printf("Length <4/16/64/256/1k/4k/16k/more us:");
+	for (i = 0; i < EC_IRQ_PROFILE_BUCKETS; i++)
+		printf(" %u", r->histogram[i]);
+	printf("\n\n    Time (us)  Caller\n");
+	for (i = 0; i < r->top_count; i++)
+		printf("%13u  %08x\n", r->top[i].us, r->top[i].caller);
+
+	return 0;
+}
+
+int cmd_host_command_stats(int argc, char *argv[])
+{
+	struct ec_params_host_command_stats p = {0};
+	struct ec_response_host_command_stats *r = ec_inbuf;
+	const struct ec_host_command_stats *e;
+	int reset = 0;
+	int i, j, rv;
+
+	if (argc > 1) {
+		if (strcasecmp(argv[1], "reset")) {
+			fprintf(stderr, "Usage: %s [reset]\n", argv[0]);
+			return -1;
+		}
+		reset = 1;
+	}
+
+	printf("Cmd      Count   Rate/s  Avg (us)  Max (us)  "
+	       "Latency <16/64/256/1k/4k/16k/64k/more us\n");
+	do {
+		rv = ec_command(EC_CMD_HOST_COMMAND_STATS, 0, &p, sizeof(p),
+				ec_inbuf, ec_max_insize);
+		if (rv < 0)
+			return rv;
+
+		for (i = 0; i < r->count; i++) {
+			e = &r->stats[i];
+			if (!e->count)
+				continue;
+			printf("0x%04x %8u %8u %9" PRIu64 " %9u ", e->command,
+			       e->count,
+			       r->elapsed_ms ? (uint32_t)((uint64_t)e->count *
+							  1000 / r->elapsed_ms)
+					     : 0,
+			       e->total_us / e->count, e->max_us);
+			for (j = 0; j < EC_HOST_COMMAND_STATS_BUCKETS; j++)
+				printf(" %u", e->latency[j]);
+			printf("\n");
+		}
+		p.index += r->count;
+	} while (r->count && p.index < r->total);
+
+	/* Clear the statistics once all commands have been read */
+	if (reset) {
+		p.index = 0;
+		p.flags = EC_HOST_COMMAND_STATS_RESET;
+		rv = ec_command(EC_CMD_HOST_COMMAND_STATS, 0, &p, sizeof(p),
+				ec_inbuf, ec_max_insize);
+		if (rv < 0)
+			return rv;
+	}
+
+	return 0;
+}
+
 static void cmd_hostevent_help(char *cmd)
 {
 	fprintf(stderr,
@@ -8580,6 +8754,107 @@ int cmd_console(int argc, char *argv[])
 	printf("\n");
 	return 0;
 }
+
+int cmd_tokenized_log(int argc, char *argv[])
+{
+	struct ec_params_console_read_tokenized p;
+	struct ec_response_console_read_tokenized *r = ec_inbuf;
+	char *buf = NULL, *tmp;
+	int size = 0, n, rv;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <outfile>\n", argv[0]);
+		return -1;
+	}
+
+	/* Read pages of entries, starting with the oldest, until caught up */
+	p.pos = 0;
+	while (1) {
+		rv = ec_command(EC_CMD_CONSOLE_READ_TOKENIZED, 0, &p, sizeof(p),
+				ec_inbuf, ec_max_insize);
+		if (rv < 0)
+			goto out;
+		n = r->next - r->pos;
+		if (n <= 0)
+			break;
+		if (rv < (int)sizeof(*r) + n) {
+			fprintf(stderr, "Short response.\n");
+			rv = -1;
+			goto out;
+		}
+
+		tmp = realloc(buf, size + n);
+		if (!tmp) {
+			fprintf(stderr, "Unable to allocate buffer.\n");
+			rv = -1;
+			goto out;
+		}
+		buf = tmp;
+		memcpy(buf + size, r->data, n);
+		size += n;
+		p.pos = r->next;
+	}
+
+	rv = write_file(argv[1], buf, size);
+	if (!rv)
+		printf("Saved %d bytes of log entries.\n", size);
+out:
+	free(buf);
+	return rv < 0 ? rv : 0;
+}
+
+int cmd_shared_mem_trace(int argc, char *argv[])
+{
+	struct ec_params_shared_mem_trace p = { 0 };
+	struct ec_response_shared_mem_trace_usage *u = ec_inbuf;
+	struct ec_response_shared_mem_trace_records *r = ec_inbuf;
+	const struct ec_shared_mem_trace_record *t;
+	int i, rv;
+
+	if (argc > 2 || (argc == 2 && strcasecmp(argv[1], "reset"))) {
+		fprintf(stderr, "Usage: %s [reset]\n", argv[0]);
+		return -1;
+	}
+
+	p.type = EC_SHARED_MEM_TRACE_USAGE;
+	if (argc == 2)
+		p.flags = EC_SHARED_MEM_TRACE_RESET;
+	rv = ec_command(EC_CMD_SHARED_MEM_TRACE, 0, &p, sizeof(p),
+			ec_inbuf, ec_max_insize);
+	if (rv < 0)
+		return rv;
+
+	printf("Task Current   Peak\n");
+	for (i = 0; i < u->task_count; i++)
+		if (u->usage[i].peak)
+			printf("%4d %7u %6u\n", i, u->usage[i].current,
+			       u->usage[i].peak);
+
+	/* Read pages of records, newest first, until all have been read */
+	printf("\nCaller      Task   Size  Held (us)\n");
+	p.type = EC_SHARED_MEM_TRACE_RECORDS;
+	p.flags = 0;
+	do {
+		rv = ec_command(EC_CMD_SHARED_MEM_TRACE, 0, &p, sizeof(p),
+				ec_inbuf, ec_max_insize);
+		if (rv < 0)
+			return rv;
+
+		for (i = 0; i < r->count; i++) {
+			t = &r->records[i];
+			printf("%08x %4d %6u %10u%s\n", t->caller, t->task_id,
+			       t->size, t->held_us,
+			       (t->flags & EC_SHARED_MEM_TRACE_HELD) ?
+				       " held" :
+			       (t->flags & EC_SHARED_MEM_TRACE_FAILED) ?
+				       " failed" : "");
+		}
+		p.index += r->count;
+	} while (r->count && p.index < r->total);
+
+	return 0;
+}
+
 struct param_info {
 	const char *name;	/* name of this parameter */
 	const char *help;	/* help message */
@@ -9617,6 +9892,224 @@ int cmd_pd_write_log(int argc, char *argv[])
 	return ec_command(EC_CMD_PD_WRITE_LOG_ENTRY, 0, &p, sizeof(p), NULL, 0);
 }
 
+static const char * const pd_trace_events[] = {
+	[EC_PD_TRACE_RX] = "RX",
+	[EC_PD_TRACE_TX_SUCCESS] = "TX",
+	[EC_PD_TRACE_TX_DISCARDED] = "TX discarded",
+	[EC_PD_TRACE_TX_FAILED] = "TX failed",
+	[EC_PD_TRACE_TX_TIMEOUT] = "TX timeout",
+};
+
+static const char * const pd_trace_sops[] = {
+	[TCPC_TX_SOP] = "SOP",
+	[TCPC_TX_SOP_PRIME] = "SOP'",
+	[TCPC_TX_SOP_PRIME_PRIME] = "SOP''",
+	[TCPC_TX_SOP_DEBUG_PRIME] = "SOP'_Debug",
+	[TCPC_TX_SOP_DEBUG_PRIME_PRIME] = "SOP''_Debug",
+	[TCPC_TX_HARD_RESET] = "Hard Reset",
+	[TCPC_TX_CABLE_RESET] = "Cable Reset",
+	[TCPC_TX_BIST_MODE_2] = "BIST Mode 2",
+};
+
+/*
+ * The trace is written as a pcapng file, with one interface.  There's no
+ * link-layer type for USB PD, so the interface is LINKTYPE_USER0.  Each
+ * packet is just the message header and data objects, as they are on the
+ * wire (little-endian).  Its epb_flags give the direction, and its comment
+ * the SOP* and the event, e.g. "SOP' TX failed".  Hard Reset and Cable Reset
+ * signaling have a zero header.
+ */
+#define PCAPNG_BLOCK_SHB 0x0a0d0d0a
+#define PCAPNG_BLOCK_IDB 0x00000001
+#define PCAPNG_BLOCK_EPB 0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1a2b3c4d
+#define PCAPNG_OPT_ENDOFOPT 0
+#define PCAPNG_OPT_COMMENT 1
+#define PCAPNG_OPT_EPB_FLAGS 2
+#define PCAPNG_EPB_FLAGS_INBOUND 1
+#define PCAPNG_EPB_FLAGS_OUTBOUND 2
+#define PCAP_LINKTYPE_USER0 147
+
+/* Largest EPB body: fixed fields, padded packet, then the options */
+#define PCAPNG_EPB_MAX (20 + 32 + 8 + (4 + 32) + 4)
+
+/* Append an option to a block body, padded to 32 bits */
+static int pcapng_add_option(uint8_t *body, int len, uint16_t code,
+			     const void *value, uint16_t size)
+{
+	memcpy(body + len, &code, sizeof(code));
+	memcpy(body + len + 2, &size, sizeof(size));
+	memcpy(body + len + 4, value, size);
+	len += 4 + size;
+	while (len & 3)
+		body[len++] = 0;
+
+	return len;
+}
+
+/* Write a block, whose body is padded to 32 bits */
+static int pcapng_write_block(FILE *f, uint32_t type, const void *body,
+			      int len)
+{
+	uint32_t total = 12 + len;
+
+	if (fwrite(&type, sizeof(type), 1, f) != 1 ||
+	    fwrite(&total, sizeof(total), 1, f) != 1 ||
+	    fwrite(body, len, 1, f) != 1 ||
+	    fwrite(&total, sizeof(total), 1, f) != 1)
+		return -1;
+
+	return 0;
+}
+
+static int pd_trace_write_pcapng_header(FILE *f)
+{
+	struct {
+		uint32_t byte_order_magic;
+		uint16_t major_version;
+		uint16_t minor_version;
+		int64_t section_length;
+	} shb = {
+		.byte_order_magic = PCAPNG_BYTE_ORDER_MAGIC,
+		.major_version = 1,
+		.minor_version = 0,
+		.section_length = -1,
+	};
+	/* Microsecond timestamps are the default resolution */
+	struct {
+		uint16_t linktype;
+		uint16_t reserved;
+		uint32_t snaplen;
+	} idb = {
+		.linktype = PCAP_LINKTYPE_USER0,
+		.snaplen = 2 + sizeof(((struct ec_pd_trace_record *)0)->data),
+	};
+
+	if (pcapng_write_block(f, PCAPNG_BLOCK_SHB, &shb, sizeof(shb)) ||
+	    pcapng_write_block(f, PCAPNG_BLOCK_IDB, &idb, sizeof(idb)))
+		return -1;
+
+	return 0;
+}
+
+static int pd_trace_write_pcapng(FILE *f, const struct ec_pd_trace_record *t)
+{
+	uint8_t body[PCAPNG_EPB_MAX];
+	uint64_t us = (uint64_t)t->time_hi << 32 | t->time_lo;
+	uint32_t flags = t->event == EC_PD_TRACE_RX ?
+		PCAPNG_EPB_FLAGS_INBOUND : PCAPNG_EPB_FLAGS_OUTBOUND;
+	uint32_t fixed[5];
+	char comment[32];
+	int packet_len = 2 + 4 * PD_HEADER_CNT(t->header);
+	int len = sizeof(fixed);
+	int i;
+
+	fixed[0] = 0; /* Interface */
+	fixed[1] = us >> 32;
+	fixed[2] = us;
+	fixed[3] = packet_len;
+	fixed[4] = packet_len;
+	memcpy(body, fixed, sizeof(fixed));
+
+	body[len++] = t->header & 0xff;
+	body[len++] = t->header >> 8;
+	for (i = 0; i < PD_HEADER_CNT(t->header); i++) {
+		body[len++] = t->data[i] & 0xff;
+		body[len++] = (t->data[i] >> 8) & 0xff;
+		body[len++] = (t->data[i] >> 16) & 0xff;
+		body[len++] = t->data[i] >> 24;
+	}
+	while (len & 3)
+		body[len++] = 0;
+
+	snprintf(comment, sizeof(comment), "%s %s",
+		 t->sop < ARRAY_SIZE(pd_trace_sops) ?
+			 pd_trace_sops[t->sop] : "?",
+		 t->event < ARRAY_SIZE(pd_trace_events) ?
+			 pd_trace_events[t->event] : "?");
+	len = pcapng_add_option(body, len, PCAPNG_OPT_EPB_FLAGS, &flags,
+				sizeof(flags));
+	len = pcapng_add_option(body, len, PCAPNG_OPT_COMMENT, comment,
+				strlen(comment));
+	len = pcapng_add_option(body, len, PCAPNG_OPT_ENDOFOPT, "", 0);
+
+	return pcapng_write_block(f, PCAPNG_BLOCK_EPB, body, len);
+}
+
+int cmd_pd_trace(int argc, char *argv[])
+{
+	struct ec_params_pd_trace p = { 0 };
+	struct ec_response_pd_trace *r = ec_inbuf;
+	const struct ec_pd_trace_record *t;
+	FILE *f = NULL;
+	int count = 0;
+	char *e;
+	int i, j, rv;
+
+	if (argc < 2 || argc > 3) {
+		fprintf(stderr, "Usage: %s <port> [<pcapng file>]\n", argv[0]);
+		return -1;
+	}
+
+	p.port = strtol(argv[1], &e, 0);
+	if (e && *e) {
+		fprintf(stderr, "Bad port parameter.\n");
+		return -1;
+	}
+
+	if (argc == 3) {
+		f = fopen(argv[2], "wb");
+		if (!f || pd_trace_write_pcapng_header(f)) {
+			perror(argv[2]);
+			rv = -1;
+			goto out;
+		}
+	}
+
+	do {
+		rv = ec_command(EC_CMD_PD_TRACE, 0, &p, sizeof(p),
+				ec_inbuf, ec_max_insize);
+		if (rv < 0)
+			goto out;
+
+		if (r->first_seq != p.seq && count)
+			fprintf(stderr, "%u messages lost\n",
+				r->first_seq - p.seq);
+
+		for (i = 0; i < r->count; i++) {
+			t = &r->records[i];
+			if (f) {
+				rv = pd_trace_write_pcapng(f, t);
+				if (rv) {
+					perror(argv[2]);
+					goto out;
+				}
+				continue;
+			}
+
+			printf("%5u %11" PRIu64 " %d %04x %-12s",
+			       r->first_seq + i,
+			       (uint64_t)t->time_hi << 32 | t->time_lo,
+			       t->sop, t->header,
+			       t->event < ARRAY_SIZE(pd_trace_events) ?
+				       pd_trace_events[t->event] : "?");
+			for (j = 0; j < PD_HEADER_CNT(t->header); j++)
+				printf(" %08x", t->data[j]);
+			printf("\n");
+		}
+		count += r->count;
+		p.seq = r->next_seq;
+	} while (r->count);
+
+	if (f)
+		printf("Wrote %d messages to %s\n", count, argv[2]);
+	rv = 0;
+out:
+	if (f)
+		fclose(f);
+	return rv;
+}
+
 int cmd_typec_control(int argc, char *argv[])
 {
 	struct ec_params_typec_control p;
@@ -10341,8 +10834,10 @@ const struct command commands[] = {
 	{"gpioget", cmd_gpio_get},
 	{"gpioset", cmd_gpio_set},
 	{"hangdetect", cmd_hang_detect},
+	{"hcstats", cmd_host_command_stats},
 	{"hello", cmd_hello},
 	{"hibdelay", cmd_hibdelay},
+	{"hookwake", cmd_hook_wake},
 	{"hostevent", cmd_hostevent},
 	{"hostsleepstate", cmd_hostsleepstate},
 	{"locatechip", cmd_locate_chip},
@@ -10352,6 +10847,7 @@ const struct command commands[] = {
 	{"i2cxfer", cmd_i2c_xfer},
 	{"infopddev", cmd_pd_device_info},
 	{"inventory", cmd_inventory},
+	{"irqprof", cmd_irq_profile},
 	{"led", cmd_led},
 	{"lightbar", cmd_lightbar},
 	{"kbfactorytest", cmd_keyboard_factory_test},
@@ -10373,6 +10869,7 @@ const struct command commands[] = {
 	{"pdlog", cmd_pd_log},
 	{"pdcontrol", cmd_pd_control},
 	{"pdchipinfo", cmd_pd_chip_info},
+	{"pdtrace", cmd_pd_trace},
 	{"pdwritelog", cmd_pd_write_log},
 	{"powerinfo", cmd_power_info},
 	{"protoinfo", cmd_proto_info},
@@ -10400,16 +10897,19 @@ const struct command commands[] = {
 	{"rwsigaction", cmd_rwsig_action_legacy},
 	{"rwsigstatus", cmd_rwsig_status},
 	{"sertest", cmd_serial_test},
+	{"shmemtrace", cmd_shared_mem_trace},
 	{"smartdischarge", cmd_smart_discharge},
 	{"stress", cmd_stress_test},
 	{"sysinfo", cmd_sysinfo},
 	{"port80flood", cmd_port_80_flood},
 	{"switches", cmd_switches},
+	{"taskstats", cmd_task_stats},
 	{"temps", cmd_temperature},
 	{"tempsinfo", cmd_temp_sensor_info},
 	{"test", cmd_test},
 	{"thermalget", cmd_thermal_get_threshold},
 	{"thermalset", cmd_thermal_set_threshold},
+	{"tlog", cmd_tokenized_log},
 	{"tpselftest", cmd_tp_self_test},
 	{"tpframeget", cmd_tp_frame_get},
 	{"tmp006cal", cmd_tmp006cal},
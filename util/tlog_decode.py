@@ -0,0 +1,328 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+# Copyright 2020 The Chromium OS Authors. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be
+# found in the LICENSE file.
+
+"""Decode a tokenized console log saved with 'ectool tlog'.
+
+Entries hold the address of their format string and the raw arguments (see
+include/tokenized_log.h).  The format strings are looked up in the EC image
+the log came from, and formatted the way the EC's vfnprintf() would have.
+
+  ectool tlog /tmp/tlog.bin
+  tlog_decode.py build/<board>/RW/ec.RW.elf /tmp/tlog.bin
+"""
+
+from __future__ import print_function
+
+import argparse
+import struct
+import sys
+
+# Entry flags, from include/tokenized_log.h
+TOKENIZED_LOG_CPRINTS = 1 << 0
+TOKENIZED_LOG_TRUNCATED = 1 << 1
+
+# ELF section header values
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+
+# Largest width or precision vfnprintf() accepts
+MAX_FORMAT = 1024
+
+
+class Truncated(Exception):
+  """The entry ran out of arguments."""
+
+
+class BadFormat(Exception):
+  """The format string has a conversion vfnprintf() can't print."""
+
+
+class Elf(object):
+  """Just enough of an ELF file to read strings by address."""
+
+  def __init__(self, path):
+    with open(path, 'rb') as f:
+      self.data = f.read()
+    if self.data[:4] != b'\x7fELF':
+      raise ValueError('%s is not an ELF file' % path)
+    self.is64 = self.data[4] == 2
+    self.endian = '<' if self.data[5] == 1 else '>'
+
+    if self.is64:
+      shoff, = struct.unpack_from(self.endian + 'Q', self.data, 0x28)
+      shentsize, shnum = struct.unpack_from(self.endian + 'HH', self.data,
+                                            0x3a)
+      fmt = 'IIQQQQ'
+    else:
+      shoff, = struct.unpack_from(self.endian + 'I', self.data, 0x20)
+      shentsize, shnum = struct.unpack_from(self.endian + 'HH', self.data,
+                                            0x2e)
+      fmt = 'IIIIII'
+
+    # (address, size, file offset) of each section loaded from the file
+    self.sections = []
+    for i in range(shnum):
+      _, sh_type, flags, addr, offset, size = struct.unpack_from(
+          self.endian + fmt, self.data, shoff + i * shentsize)
+      if flags & SHF_ALLOC and sh_type != SHT_NOBITS and size:
+        self.sections.append((addr, size, offset))
+
+  @property
+  def pointer_size(self):
+    return 8 if self.is64 else 4
+
+  def string(self, addr):
+    for start, size, offset in self.sections:
+      if start <= addr < start + size:
+        pos = offset + addr - start
+        end = self.data.index(b'\0', pos, offset + size)
+        return self.data[pos:end].decode('utf-8', 'replace')
+    return None
+
+
+class Reader(object):
+  """Pulls the arguments out of an entry."""
+
+  def __init__(self, data, endian):
+    self.data = data
+    self.pos = 0
+    self.endian = endian
+
+  def get(self, fmt):
+    fmt = self.endian + fmt
+    if self.pos + struct.calcsize(fmt) > len(self.data):
+      raise Truncated()
+    value, = struct.unpack_from(fmt, self.data, self.pos)
+    self.pos += struct.calcsize(fmt)
+    return value
+
+  def get_bytes(self, size):
+    if self.pos + size > len(self.data):
+      raise Truncated()
+    value = self.data[self.pos:self.pos + size]
+    self.pos += size
+    return value
+
+  def get_str(self):
+    try:
+      end = self.data.index(b'\0', self.pos)
+    except ValueError:
+      raise Truncated()
+    value = self.data[self.pos:end].decode('utf-8', 'replace')
+    self.pos = end + 1
+    return value
+
+
+def format_int(v, base, upper, sign, precision):
+  """Digits of an integer, with precision meaning fixed point."""
+  digits = '0123456789ABCDEF' if upper else '0123456789abcdef'
+  out = ''
+  for _ in range(max(precision, 0)):
+    out = digits[v % 10] + out
+    v //= 10
+  if precision >= 0:
+    out = '.' + out
+  if not v:
+    out = '0' + out
+  while v:
+    out = digits[v % base] + out
+    v //= base
+  return sign + out
+
+
+def pad(s, width, left, zero, precision=-1):
+  """Pad a converted value the way vfnprintf() does."""
+  if precision >= 0:
+    s = s[:precision]
+    width = min(width, precision)
+  if len(s) >= width:
+    return s
+  if left:
+    return s + ' ' * (width - len(s))
+  return ('0' if zero else ' ') * (width - len(s)) + s
+
+
+def vfnprintf(fmt, r, long64, verbose):
+  """Format an entry's arguments; returns (text, truncated)."""
+  out = []
+  i = 0
+  n = len(fmt)
+
+  def next_char():
+    nonlocal i
+    c = fmt[i] if i < n else ''
+    i += 1
+    return c
+
+  try:
+    while i < n:
+      c = next_char()
+      if c != '%':
+        out.append(c)
+        continue
+
+      c = next_char()
+      if c == '%':
+        out.append('%')
+        continue
+      if c == '':
+        break
+      if c == 'c':
+        out.append(chr(r.get('I') & 0xff))
+        continue
+
+      left = sign_flag = zero = False
+      if c == '-':
+        left = True
+        c = next_char()
+      if c == '+':
+        sign_flag = True
+        c = next_char()
+      if c == '0':
+        zero = True
+        c = next_char()
+
+      width = 0
+      if c == '*':
+        width = r.get('i')
+        c = next_char()
+      else:
+        while c.isdigit():
+          width = width * 10 + int(c)
+          c = next_char()
+      if width < 0 or width > MAX_FORMAT:
+        raise BadFormat()
+
+      precision = -1
+      if c == '.':
+        c = next_char()
+        if c == '*':
+          precision = r.get('i')
+          c = next_char()
+        else:
+          precision = 0
+          while c.isdigit():
+            precision = precision * 10 + int(c)
+            c = next_char()
+        if precision < 0 or precision > MAX_FORMAT:
+          raise BadFormat()
+
+      if c == 's':
+        out.append(pad(r.get_str(), width, left, zero, precision))
+        continue
+
+      is64 = False
+      if c == 'l':
+        is64 = long64
+        c = next_char()
+        if c == 'l':
+          is64 = True
+          c = next_char()
+        if not is64:
+          raise BadFormat()
+      elif c == 'z':
+        is64 = long64
+        c = next_char()
+
+      base = 10
+      sign = ''
+      if c == 'p':
+        spec = next_char()
+        if spec == 'T':
+          v = r.get('Q')
+          if not verbose:
+            v //= 1000
+          precision = 6 if verbose else 3
+        elif spec == 'P':
+          v = r.get('Q' if long64 else 'I')
+          base = 16
+        elif spec == 'h':
+          data = r.get_bytes(r.get('B'))
+          out.append(data.hex())
+          continue
+        elif spec == 'b':
+          v = r.get('I')
+          count = r.get('B')
+          if count == 0xff:
+            continue
+          width = count
+          zero = True
+          base = 2
+        else:
+          raise BadFormat()
+      elif c in 'duxXT':
+        v = r.get('Q' if is64 else 'I')
+        bits = 64 if is64 else 32
+        if c == 'd':
+          if v >> (bits - 1):
+            sign = '-'
+            v = (1 << bits) - v
+          elif sign_flag:
+            sign = '+'
+        elif c in 'xX':
+          base = 16
+      else:
+        raise BadFormat()
+
+      s = format_int(v, base, c == 'X', sign, precision)
+      out.append(pad(s, width, left, zero))
+  except BadFormat:
+    out.append('ERROR')
+  except Truncated:
+    return ''.join(out), True
+
+  return ''.join(out), False
+
+
+def decode(elf, data, verbose):
+  """Yield the text of each entry in a saved log."""
+  ptr = 'Q' if elf.pointer_size == 8 else 'I'
+  header = struct.Struct(elf.endian + 'BBBI' + ptr)
+  pos = 0
+
+  while pos + header.size <= len(data):
+    size, _, flags, timestamp, addr = header.unpack_from(data, pos)
+    if size < header.size or pos + size > len(data):
+      print('Bad entry at offset %d' % pos, file=sys.stderr)
+      return
+    args = data[pos + header.size:pos + size]
+    pos += size
+
+    fmt = elf.string(addr)
+    if fmt is None:
+      yield '<unknown format 0x%x>\n' % addr
+      continue
+
+    text, truncated = vfnprintf(fmt, Reader(args, elf.endian),
+                                elf.pointer_size == 8, verbose)
+    if truncated and flags & TOKENIZED_LOG_TRUNCATED:
+      text += '...'
+    if flags & TOKENIZED_LOG_CPRINTS:
+      stamp = format_int(timestamp if verbose else timestamp // 1000, 10,
+                         False, '', 6 if verbose else 3)
+      text = '[%s %s]\n' % (stamp, text)
+    yield text
+
+
+def main(argv):
+  parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+  parser.add_argument('elf', help='EC image the log is from')
+  parser.add_argument('log', help="Log saved with 'ectool tlog'")
+  parser.add_argument('--verbose', action='store_true',
+                      help='The image was built with CONFIG_CONSOLE_VERBOSE')
+  opts = parser.parse_args(argv)
+
+  elf = Elf(opts.elf)
+  with open(opts.log, 'rb') as f:
+    data = f.read()
+
+  for text in decode(elf, data, opts.verbose):
+    sys.stdout.write(text)
+  return 0
+
+
+if __name__ == '__main__':
+  sys.exit(main(sys.argv[1:]))
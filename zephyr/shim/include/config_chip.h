@@ -129,6 +129,11 @@ enum battery_type {
 #define CONFIG_POWER_PP5000_CONTROL
 #endif
 
+#undef CONFIG_QUEUE_SPSC
+#ifdef CONFIG_PLATFORM_EC_QUEUE_SPSC
+#define CONFIG_QUEUE_SPSC
+#endif
+
 #ifdef CONFIG_PLATFORM_EC_TIMER
 #define CONFIG_HWTIMER_64BIT
 #define CONFIG_HW_SPECIFIC_UDELAY
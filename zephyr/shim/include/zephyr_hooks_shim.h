@@ -86,3 +86,10 @@ void zephyr_shim_setup_hook(enum hook_type type, void (*routine)(void),
 		return 0;                                                  \
 	}                                                                  \
 	SYS_INIT(_setup_hook_##line, APPLICATION, 1)
+
+/**
+ * See include/hooks.h for documentation.  Slack is not supported, so periodic
+ * hooks are always called on time.
+ */
+#define DECLARE_HOOK_SLACK(hooktype, routine, priority, slack_us) \
+	DECLARE_HOOK(hooktype, routine, priority)